@@ -0,0 +1,255 @@
+
+#include <dekaf2/kcache.h>
+#include <dekaf2/kprof.h>
+#include <dekaf2/kformat.h>
+#include <dekaf2/kreader.h>
+#include <dekaf2/ksystem.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace dekaf2;
+
+namespace {
+
+constexpr std::size_t iThreadCounts[] { 1, 2, 4, 8, 16, 32, 64 };
+
+// KProf keeps the label pointers
+constexpr const char* sLabels[2][7]
+{
+	{
+		"KSharedCache hits,  1 thread",
+		"KSharedCache hits,  2 threads",
+		"KSharedCache hits,  4 threads",
+		"KSharedCache hits,  8 threads",
+		"KSharedCache hits, 16 threads",
+		"KSharedCache hits, 32 threads",
+		"KSharedCache hits, 64 threads"
+	},
+	{
+		"KShardedCache hits,  1 thread",
+		"KShardedCache hits,  2 threads",
+		"KShardedCache hits,  4 threads",
+		"KShardedCache hits,  8 threads",
+		"KShardedCache hits, 16 threads",
+		"KShardedCache hits, 32 threads",
+		"KShardedCache hits, 64 threads"
+	}
+};
+
+constexpr std::size_t iKeys    = 256;
+constexpr std::size_t iLookups = 2000000;
+
+//-----------------------------------------------------------------------------
+/// iThreads threads look up keys that are all in the cache
+template<class Cache>
+void contention(Cache& cache, const std::vector<KString>& Keys, std::size_t iThreads, const char* sLabel)
+//-----------------------------------------------------------------------------
+{
+	auto iPerThread = iLookups / iThreads;
+	std::atomic<std::size_t> iLength { 0 };
+	std::vector<std::thread> Threads;
+
+	KProf prof(sLabel);
+	prof.SetMultiplier(iPerThread * iThreads);
+
+	for (std::size_t t = 0; t < iThreads; ++t)
+	{
+		Threads.emplace_back([&cache, &Keys, &iLength, iPerThread, t]()
+		{
+			std::size_t iSum { 0 };
+
+			for (std::size_t i = 0; i < iPerThread; ++i)
+			{
+				iSum += cache.Get(Keys[(i + t * 7) % Keys.size()])->size();
+			}
+
+			iLength.fetch_add(iSum, std::memory_order_relaxed);
+		});
+	}
+
+	for (auto& Thread : Threads)
+	{
+		Thread.join();
+	}
+
+	KProf::Force(&iLength);
+}
+
+constexpr std::size_t iCapacity    = 1000;
+constexpr std::size_t iTraceLength = 1000000;
+
+//-----------------------------------------------------------------------------
+/// iLength keys out of iKeys with a Zipf distribution, key 0 is the most popular
+std::vector<uint64_t> zipf_trace(std::size_t iKeys, std::size_t iLength, double fSkew)
+//-----------------------------------------------------------------------------
+{
+	std::vector<double> Distribution(iKeys);
+	double fSum { 0 };
+
+	for (std::size_t i = 0; i < iKeys; ++i)
+	{
+		fSum += 1.0 / std::pow(static_cast<double>(i + 1), fSkew);
+		Distribution[i] = fSum;
+	}
+
+	std::mt19937_64 Random(4711);
+	std::uniform_real_distribution<double> Uniform(0, fSum);
+	std::vector<uint64_t> Trace;
+	Trace.reserve(iLength);
+
+	for (std::size_t i = 0; i < iLength; ++i)
+	{
+		auto it = std::lower_bound(Distribution.begin(), Distribution.end(), Uniform(Random));
+		Trace.push_back(std::min<std::size_t>(it - Distribution.begin(), iKeys - 1));
+	}
+
+	return Trace;
+}
+
+//-----------------------------------------------------------------------------
+/// the Zipf trace, interrupted by scans over keys that are never used again
+std::vector<uint64_t> scan_trace()
+//-----------------------------------------------------------------------------
+{
+	auto Zipf = zipf_trace(100000, iTraceLength / 2, 0.9);
+	std::vector<uint64_t> Trace;
+	uint64_t iScanKey = 1000000;
+
+	for (std::size_t i = 0; i < Zipf.size(); ++i)
+	{
+		Trace.push_back(Zipf[i]);
+
+		if (i % 5000 == 4999)
+		{
+			for (std::size_t j = 0; j < 5000; ++j)
+			{
+				Trace.push_back(iScanKey++);
+			}
+		}
+	}
+
+	return Trace;
+}
+
+//-----------------------------------------------------------------------------
+/// a loop over slightly more keys than fit into the cache
+std::vector<uint64_t> loop_trace()
+//-----------------------------------------------------------------------------
+{
+	std::vector<uint64_t> Trace;
+	Trace.reserve(iTraceLength);
+
+	for (std::size_t i = 0; i < iTraceLength; ++i)
+	{
+		Trace.push_back(i % (iCapacity + iCapacity / 5));
+	}
+
+	return Trace;
+}
+
+//-----------------------------------------------------------------------------
+/// a recorded trace with one key per line, from the file named in
+/// the environment variable DEKAF2_CACHE_TRACE
+std::vector<KString> recorded_trace()
+//-----------------------------------------------------------------------------
+{
+	std::vector<KString> Trace;
+	auto sFile = kGetEnv("DEKAF2_CACHE_TRACE");
+
+	if (!sFile.empty())
+	{
+		KInFile File(sFile);
+		KString sLine;
+
+		while (File.ReadLine(sLine))
+		{
+			Trace.push_back(sLine);
+		}
+	}
+
+	return Trace;
+}
+
+//-----------------------------------------------------------------------------
+/// replay a trace and print the hit ratio
+template<class Policy, class Key>
+void replay(const std::vector<Key>& Trace, const char* sTrace, const char* sPolicy, const char* sLabel)
+//-----------------------------------------------------------------------------
+{
+	KCache<Key, uint8_t, detail::LoadByConstruction<uint8_t>, Policy> Cache(iCapacity);
+	std::size_t iHits { 0 };
+
+	{
+		KProf prof(sLabel);
+		prof.SetMultiplier(Trace.size());
+
+		for (const auto& TraceKey : Trace)
+		{
+			if (Cache.Find(TraceKey))
+			{
+				++iHits;
+			}
+			else
+			{
+				Cache.Set(TraceKey, 1);
+			}
+		}
+	}
+
+	kPrintLine("{:<12} {:<8} hit ratio {:6.2f}%", sTrace, sPolicy, 100.0 * iHits / Trace.size());
+}
+
+//-----------------------------------------------------------------------------
+template<class Key>
+void replay_all(const std::vector<Key>& Trace, const char* sTrace)
+//-----------------------------------------------------------------------------
+{
+	replay<KLRUPolicy>    (Trace, sTrace, "LRU",     "LRU replay");
+	replay<KClockPolicy>  (Trace, sTrace, "CLOCK",   "CLOCK replay");
+	replay<KSievePolicy>  (Trace, sTrace, "SIEVE",   "SIEVE replay");
+	replay<KTinyLFUPolicy>(Trace, sTrace, "TinyLFU", "W-TinyLFU replay");
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+void kcache_bench()
+//-----------------------------------------------------------------------------
+{
+	dekaf2::KProf ps("-KCache");
+
+	std::vector<KString> Keys;
+
+	for (std::size_t i = 0; i < iKeys; ++i)
+	{
+		Keys.push_back(kFormat("key number {}", i));
+	}
+
+	for (std::size_t i = 0; i < std::size(iThreadCounts); ++i)
+	{
+		{
+			KSharedCache<KString, KString> Cache(iKeys);
+			contention(Cache, Keys, iThreadCounts[i], sLabels[0][i]);
+		}
+		{
+			KShardedCache<KString, KString> Cache(iKeys);
+			contention(Cache, Keys, iThreadCounts[i], sLabels[1][i]);
+		}
+	}
+
+	replay_all(zipf_trace(100000, iTraceLength, 0.9), "zipf");
+	replay_all(scan_trace(), "zipf + scans");
+	replay_all(loop_trace(), "loop");
+
+	auto Recorded = recorded_trace();
+
+	if (!Recorded.empty())
+	{
+		replay_all(Recorded, "recorded");
+	}
+}
@@ -0,0 +1,128 @@
+
+#include <dekaf2/kparallel.h>
+#include <dekaf2/kprof.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+using namespace dekaf2;
+
+namespace {
+
+constexpr std::size_t iElements = 4000000;
+
+//-----------------------------------------------------------------------------
+std::vector<uint32_t> random_vector()
+//-----------------------------------------------------------------------------
+{
+	std::vector<uint32_t> vec(iElements);
+	uint32_t iSeed = 4711;
+
+	for (auto& i : vec)
+	{
+		iSeed = iSeed * 1103515245 + 12345;
+		i = iSeed >> 8;
+	}
+
+	return vec;
+}
+
+//-----------------------------------------------------------------------------
+void transform_bench(const std::vector<uint32_t>& Input)
+//-----------------------------------------------------------------------------
+{
+	std::vector<double> Output(Input.size());
+
+	auto Calc = [](uint32_t i)
+	{
+		return std::sqrt(static_cast<double>(i)) * 1.5;
+	};
+
+	{
+		KProf prof("std::transform");
+		prof.SetMultiplier(Input.size());
+		std::transform(Input.begin(), Input.end(), Output.begin(), Calc);
+		KProf::Force(Output.data());
+	}
+	{
+		KProf prof("kParallelTransform");
+		prof.SetMultiplier(Input.size());
+		kParallelTransform(Input.begin(), Input.end(), Output.begin(), Calc);
+		KProf::Force(Output.data());
+	}
+	{
+		KProf prof("kParallelForEach");
+		prof.SetMultiplier(Input.size());
+		kParallelForEach(Output, [](double& d) { d *= 0.5; });
+		KProf::Force(Output.data());
+	}
+}
+
+//-----------------------------------------------------------------------------
+void reduce_bench(const std::vector<uint32_t>& Input)
+//-----------------------------------------------------------------------------
+{
+	uint64_t iSum { 0 };
+
+	{
+		KProf prof("std::accumulate");
+		prof.SetMultiplier(Input.size());
+		iSum = std::accumulate(Input.begin(), Input.end(), uint64_t(0));
+		KProf::Force(&iSum);
+	}
+	{
+		KProf prof("kParallelReduce");
+		prof.SetMultiplier(Input.size());
+		iSum = kParallelReduce(Input.begin(), Input.end(), uint64_t(0));
+		KProf::Force(&iSum);
+	}
+	{
+		KProf prof("kParallelTransformReduce");
+		prof.SetMultiplier(Input.size());
+		iSum = kParallelTransformReduce(Input.begin(), Input.end(), uint64_t(0), std::plus<>(), [](uint32_t i)
+		{
+			return uint64_t(i) * i;
+		});
+		KProf::Force(&iSum);
+	}
+}
+
+//-----------------------------------------------------------------------------
+void sort_bench(const std::vector<uint32_t>& Input)
+//-----------------------------------------------------------------------------
+{
+	{
+		auto vec = Input;
+		KProf prof("std::sort");
+		prof.SetMultiplier(vec.size());
+		std::sort(vec.begin(), vec.end());
+		KProf::Force(vec.data());
+	}
+	{
+		auto vec = Input;
+		KProf prof("kParallelSort");
+		prof.SetMultiplier(vec.size());
+		kParallelSort(vec.begin(), vec.end());
+		KProf::Force(vec.data());
+	}
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+void kparallel_bench()
+//-----------------------------------------------------------------------------
+{
+	dekaf2::KProf ps("-KParallel");
+
+	auto Input = random_vector();
+
+	// start the shared pool outside of the measurements
+	kParallelPool();
+
+	transform_bench(Input);
+	reduce_bench(Input);
+	sort_bench(Input);
+}
@@ -0,0 +1,248 @@
+#include <dekaf2/kthreadpool.h>
+#include <dekaf2/kprof.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+using namespace dekaf2;
+
+namespace {
+
+constexpr std::size_t iThreadCounts[] { 1, 2, 4, 8, 16, 32, 64 };
+
+// KProf keeps the label pointers
+constexpr const char* sExternalLabels[2][7]
+{
+	{
+		"shared queue,  1 thread",
+		"shared queue,  2 threads",
+		"shared queue,  4 threads",
+		"shared queue,  8 threads",
+		"shared queue, 16 threads",
+		"shared queue, 32 threads",
+		"shared queue, 64 threads"
+	},
+	{
+		"work stealing,  1 thread",
+		"work stealing,  2 threads",
+		"work stealing,  4 threads",
+		"work stealing,  8 threads",
+		"work stealing, 16 threads",
+		"work stealing, 32 threads",
+		"work stealing, 64 threads"
+	}
+};
+
+constexpr const char* sInternalLabels[2][7]
+{
+	{
+		"shared queue,  1 thread, nested",
+		"shared queue,  2 threads, nested",
+		"shared queue,  4 threads, nested",
+		"shared queue,  8 threads, nested",
+		"shared queue, 16 threads, nested",
+		"shared queue, 32 threads, nested",
+		"shared queue, 64 threads, nested"
+	},
+	{
+		"work stealing,  1 thread, nested",
+		"work stealing,  2 threads, nested",
+		"work stealing,  4 threads, nested",
+		"work stealing,  8 threads, nested",
+		"work stealing, 16 threads, nested",
+		"work stealing, 32 threads, nested",
+		"work stealing, 64 threads, nested"
+	}
+};
+
+constexpr std::size_t iTasks = 200000;
+
+//-----------------------------------------------------------------------------
+void wait_for(const std::atomic<std::size_t>& iDone, std::size_t iExpected)
+//-----------------------------------------------------------------------------
+{
+	while (iDone.load(std::memory_order_relaxed) < iExpected)
+	{
+		std::this_thread::yield();
+	}
+}
+
+//-----------------------------------------------------------------------------
+/// all tiny tasks are pushed from outside the pool
+void tiny_tasks_external(KThreadPool::Scheduling scheduling, std::size_t iThreads, const char* sLabel)
+//-----------------------------------------------------------------------------
+{
+	KThreadPool Pool(iThreads, scheduling);
+	std::atomic<std::size_t> iDone { 0 };
+
+	KProf prof(sLabel);
+	prof.SetMultiplier(iTasks);
+
+	for (std::size_t i = 0; i < iTasks; ++i)
+	{
+		Pool.push([&iDone]()
+		{
+			iDone.fetch_add(1, std::memory_order_relaxed);
+		});
+	}
+
+	wait_for(iDone, iTasks);
+}
+
+//-----------------------------------------------------------------------------
+/// one task per thread is pushed from outside, and pushes the tiny tasks
+/// from inside the pool
+void tiny_tasks_internal(KThreadPool::Scheduling scheduling, std::size_t iThreads, const char* sLabel)
+//-----------------------------------------------------------------------------
+{
+	KThreadPool Pool(iThreads, scheduling);
+	std::atomic<std::size_t> iDone { 0 };
+	auto iPerRoot = iTasks / iThreads;
+
+	KProf prof(sLabel);
+	prof.SetMultiplier(iPerRoot * iThreads);
+
+	for (std::size_t iRoot = 0; iRoot < iThreads; ++iRoot)
+	{
+		Pool.push([&Pool, &iDone, iPerRoot]()
+		{
+			for (std::size_t i = 0; i < iPerRoot; ++i)
+			{
+				Pool.push([&iDone]()
+				{
+					iDone.fetch_add(1, std::memory_order_relaxed);
+				});
+			}
+		});
+	}
+
+	wait_for(iDone, iPerRoot * iThreads);
+}
+
+constexpr std::size_t iQueueItems = 1000000;
+
+//-----------------------------------------------------------------------------
+/// iThreads producers push, iThreads consumers pop until all items are through
+template<typename Push, typename Pop>
+void queue_throughput(std::size_t iThreads, const char* sLabel, Push push, Pop pop)
+//-----------------------------------------------------------------------------
+{
+	std::atomic<std::size_t> iPopped { 0 };
+	auto iPerThread = iQueueItems / iThreads;
+	std::vector<std::thread> Threads;
+
+	KProf prof(sLabel);
+	prof.SetMultiplier(iPerThread * iThreads);
+
+	for (std::size_t t = 0; t < iThreads; ++t)
+	{
+		Threads.emplace_back([&push, iPerThread]()
+		{
+			for (std::size_t i = 0; i < iPerThread; ++i)
+			{
+				while (!push())
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+
+		Threads.emplace_back([&pop, &iPopped, iPerThread, iThreads]()
+		{
+			while (iPopped.load(std::memory_order_relaxed) < iPerThread * iThreads)
+			{
+				if (pop())
+				{
+					iPopped.fetch_add(1, std::memory_order_relaxed);
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	for (auto& Thread : Threads)
+	{
+		Thread.join();
+	}
+}
+
+//-----------------------------------------------------------------------------
+/// the lock free ring with small buffer tasks against a locked std::queue of
+/// std::function, as it was used for the task queue before
+void queue_bench(std::size_t iThreads, const char* sRingLabel, const char* sLockedLabel)
+//-----------------------------------------------------------------------------
+{
+	{
+		detail::threadpool::MPMCRing<detail::threadpool::SmallTask> Ring(1024);
+		std::size_t iCalled { 0 };
+
+		queue_throughput(iThreads, sRingLabel, [&Ring, &iCalled]()
+		{
+			detail::threadpool::SmallTask Task([&iCalled]() { ++iCalled; });
+			return Ring.try_push(Task);
+		},
+		[&Ring]()
+		{
+			detail::threadpool::SmallTask Task;
+			return Ring.try_pop(Task);
+		});
+	}
+	{
+		std::mutex Mutex;
+		std::queue<std::function<void()>> Queue;
+		std::size_t iCalled { 0 };
+
+		queue_throughput(iThreads, sLockedLabel, [&Mutex, &Queue, &iCalled]()
+		{
+			std::function<void()> Task([&iCalled]() { ++iCalled; });
+			std::lock_guard<std::mutex> Lock(Mutex);
+			Queue.push(std::move(Task));
+			return true;
+		},
+		[&Mutex, &Queue]()
+		{
+			std::function<void()> Task;
+			std::lock_guard<std::mutex> Lock(Mutex);
+
+			if (Queue.empty())
+			{
+				return false;
+			}
+
+			Task = std::move(Queue.front());
+			Queue.pop();
+			return true;
+		});
+	}
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+void kthreadpool_bench()
+//-----------------------------------------------------------------------------
+{
+	dekaf2::KProf ps("-KThreadPool");
+
+	queue_bench(1, "mpmc ring, 1+1 threads",     "locked queue, 1+1 threads");
+	queue_bench(2, "mpmc ring, 2+2 threads",     "locked queue, 2+2 threads");
+	queue_bench(4, "mpmc ring, 4+4 threads",     "locked queue, 4+4 threads");
+
+	for (std::size_t i = 0; i < std::size(iThreadCounts); ++i)
+	{
+		tiny_tasks_external(KThreadPool::Scheduling::SharedQueue,  iThreadCounts[i], sExternalLabels[0][i]);
+		tiny_tasks_external(KThreadPool::Scheduling::WorkStealing, iThreadCounts[i], sExternalLabels[1][i]);
+	}
+
+	for (std::size_t i = 0; i < std::size(iThreadCounts); ++i)
+	{
+		tiny_tasks_internal(KThreadPool::Scheduling::SharedQueue,  iThreadCounts[i], sInternalLabels[0][i]);
+		tiny_tasks_internal(KThreadPool::Scheduling::WorkStealing, iThreadCounts[i], sInternalLabels[1][i]);
+	}
+}
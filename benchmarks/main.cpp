@@ -11,10 +11,13 @@ extern void kreader_bench();
 extern void std_string_bench();
 extern void kstring_bench();
 extern void kstringview_bench();
+extern void kcache_bench();
 extern void kcasestring_bench();
 extern void kxml_bench();
 extern void khtmlparser_bench();
 extern void kutf8_bench();
+extern void kthreadpool_bench();
+extern void kparallel_bench();
 
 using namespace dekaf2;
 
@@ -34,9 +37,12 @@ int main()
 	std_string_bench();
 	kstring_bench();
 	kstringview_bench();
+	kcache_bench();
 	kcasestring_bench();
  	other_bench();
 	kutf8_bench();
+	kthreadpool_bench();
+	kparallel_bench();
 
 	kProfFinalize();
 
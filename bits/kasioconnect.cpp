@@ -0,0 +1,354 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#include "kasioconnect.h"
+#include "../klog.h"
+#include <memory>
+#include <functional>
+#include <cerrno>
+#if DEKAF2_HAS_COROUTINES && !defined(DEKAF2_IS_WINDOWS)
+	#include <sys/socket.h>
+#endif
+
+namespace dekaf2 {
+namespace detail {
+
+namespace {
+
+//-----------------------------------------------------------------------------
+/// interleave the endpoints by address family, keeping the order inside the families
+std::vector<boost::asio::ip::tcp::endpoint> InterleaveByFamily(const std::vector<boost::asio::ip::tcp::endpoint>& Endpoints)
+//-----------------------------------------------------------------------------
+{
+	if (Endpoints.size() < 2)
+	{
+		return Endpoints;
+	}
+
+	bool bFirstIsV6 = Endpoints.front().address().is_v6();
+
+	std::vector<boost::asio::ip::tcp::endpoint> Preferred;
+	std::vector<boost::asio::ip::tcp::endpoint> Other;
+
+	for (const auto& Endpoint : Endpoints)
+	{
+		if (Endpoint.address().is_v6() == bFirstIsV6)
+		{
+			Preferred.push_back(Endpoint);
+		}
+		else
+		{
+			Other.push_back(Endpoint);
+		}
+	}
+
+	std::vector<boost::asio::ip::tcp::endpoint> Interleaved;
+	Interleaved.reserve(Endpoints.size());
+
+	for (std::size_t i = 0; i < Preferred.size() || i < Other.size(); ++i)
+	{
+		if (i < Preferred.size())
+		{
+			Interleaved.push_back(Preferred[i]);
+		}
+
+		if (i < Other.size())
+		{
+			Interleaved.push_back(Other[i]);
+		}
+	}
+
+	return Interleaved;
+
+} // InterleaveByFamily
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+boost::asio::ip::tcp::endpoint kAsioConnect(boost::asio::io_service& IOService,
+                                            boost::asio::ip::tcp::socket& Socket,
+                                            const std::vector<boost::asio::ip::tcp::endpoint>& Endpoints,
+                                            KDuration Timeout,
+                                            boost::system::error_code& ec,
+                                            KDuration AttemptDelay)
+//-----------------------------------------------------------------------------
+{
+	using tcp = boost::asio::ip::tcp;
+
+	ec.clear();
+
+	if (Endpoints.empty())
+	{
+		ec = boost::asio::error::host_not_found;
+		return {};
+	}
+
+	auto Candidates = InterleaveByFamily(Endpoints);
+
+	std::vector<std::unique_ptr<tcp::socket>> Attempts;
+	Attempts.reserve(Candidates.size());
+
+	boost::asio::deadline_timer Deadline(IOService);
+	boost::asio::deadline_timer NextAttempt(IOService);
+
+	std::size_t iOutstanding { 0 };   // number of async operations that did not yet call their handler
+	std::size_t iPending     { 0 };   // number of pending connection attempts
+	std::size_t iWinner      { Candidates.size() };
+	bool        bDone        { false };
+	boost::system::error_code LastError = boost::asio::error::host_unreachable;
+
+	auto Finish = [&]()
+	{
+		bDone = true;
+
+		boost::system::error_code ignore;
+		Deadline.cancel(ignore);
+		NextAttempt.cancel(ignore);
+
+		for (std::size_t i = 0; i < Attempts.size(); ++i)
+		{
+			if (i != iWinner && Attempts[i]->is_open())
+			{
+				Attempts[i]->close(ignore);
+			}
+		}
+	};
+
+	std::function<void()> StartNext;
+
+	StartNext = [&]()
+	{
+		if (bDone || Attempts.size() >= Candidates.size())
+		{
+			return;
+		}
+
+		auto iAttempt = Attempts.size();
+		Attempts.push_back(std::make_unique<tcp::socket>(IOService));
+
+		kDebug(2, "connection attempt {} to {}", iAttempt + 1, Candidates[iAttempt].address().to_string());
+
+		++iOutstanding;
+		++iPending;
+
+		Attempts[iAttempt]->async_connect(Candidates[iAttempt], [&, iAttempt](const boost::system::error_code& error)
+		{
+			--iOutstanding;
+			--iPending;
+
+			if (bDone)
+			{
+				return;
+			}
+
+			if (!error)
+			{
+				iWinner = iAttempt;
+				Finish();
+				return;
+			}
+
+			kDebug(2, "connection attempt to {} failed: {}", Candidates[iAttempt].address().to_string(), error.message());
+
+			LastError = error;
+			boost::system::error_code ignore;
+			Attempts[iAttempt]->close(ignore);
+
+			if (Attempts.size() < Candidates.size())
+			{
+				// do not wait for the attempt delay after a failure
+				NextAttempt.cancel(ignore);
+				StartNext();
+			}
+			else if (!iPending)
+			{
+				Finish();
+			}
+		});
+
+		if (Attempts.size() < Candidates.size())
+		{
+			++iOutstanding;
+
+			NextAttempt.expires_from_now(boost::posix_time::microseconds(AttemptDelay.microseconds().count()));
+			NextAttempt.async_wait([&](const boost::system::error_code& error)
+			{
+				--iOutstanding;
+
+				if (!error && !bDone)
+				{
+					StartNext();
+				}
+			});
+		}
+	};
+
+	++iOutstanding;
+
+	Deadline.expires_from_now(boost::posix_time::microseconds(Timeout.microseconds().count()));
+	Deadline.async_wait([&](const boost::system::error_code& error)
+	{
+		--iOutstanding;
+
+		if (!error && !bDone)
+		{
+			kDebug(2, "connection timeout after {}", Timeout);
+			LastError = boost::asio::error::timed_out;
+			Finish();
+		}
+	});
+
+	StartNext();
+
+	// run until all our handlers were called, as they reference this stack frame
+	while (iOutstanding)
+	{
+		IOService.run_one();
+	}
+
+	if (iWinner < Attempts.size())
+	{
+		Socket = std::move(*Attempts[iWinner]);
+		return Candidates[iWinner];
+	}
+
+	ec = LastError;
+
+	return {};
+
+} // kAsioConnect
+
+#if DEKAF2_HAS_COROUTINES && !defined(DEKAF2_IS_WINDOWS)
+//-----------------------------------------------------------------------------
+KTask<boost::asio::ip::tcp::endpoint> kAsioConnectAsync(boost::asio::ip::tcp::socket& Socket,
+                                                        std::vector<boost::asio::ip::tcp::endpoint> Endpoints,
+                                                        KDuration Timeout,
+                                                        boost::system::error_code& ec)
+//-----------------------------------------------------------------------------
+{
+	ec.clear();
+
+	if (Endpoints.empty())
+	{
+		ec = boost::asio::error::host_not_found;
+		co_return boost::asio::ip::tcp::endpoint();
+	}
+
+	auto Candidates = InterleaveByFamily(Endpoints);
+	auto Deadline   = std::chrono::steady_clock::now() + Timeout.duration();
+
+	for (std::size_t iAttempt = 0; iAttempt < Candidates.size(); ++iAttempt)
+	{
+		const auto& Candidate = Candidates[iAttempt];
+		auto Now = std::chrono::steady_clock::now();
+
+		if (Now >= Deadline)
+		{
+			ec = boost::asio::error::timed_out;
+			break;
+		}
+
+		KDuration Wait = (Deadline - Now) / (Candidates.size() - iAttempt);
+
+		kDebug(2, "connection attempt {} to {}", iAttempt + 1, Candidate.address().to_string());
+
+		boost::system::error_code ignore;
+		Socket.close(ignore);
+		Socket.open(Candidate.protocol(), ec);
+
+		if (!ec)
+		{
+			// the socket has to be non-blocking for the connect, so that
+			// we can wait for the connection in the reactor
+			Socket.non_blocking(true, ec);
+		}
+
+		if (!ec && ::connect(Socket.native_handle(), Candidate.data(), static_cast<socklen_t>(Candidate.size())) != 0)
+		{
+			if (errno != EINPROGRESS)
+			{
+				ec.assign(errno, boost::system::system_category());
+			}
+			else if (!co_await KAwaitSocket(Socket.native_handle(), KAwaitSocket::Write, Wait))
+			{
+				ec = boost::asio::error::timed_out;
+			}
+			else
+			{
+				int iError { 0 };
+				socklen_t iLen = sizeof(iError);
+
+				if (::getsockopt(Socket.native_handle(), SOL_SOCKET, SO_ERROR, &iError, &iLen) != 0)
+				{
+					iError = errno;
+				}
+
+				if (iError)
+				{
+					ec.assign(iError, boost::system::system_category());
+				}
+			}
+		}
+
+		if (!ec)
+		{
+			// switch back for the blocking reads and writes of the stream
+			Socket.non_blocking(false, ec);
+		}
+
+		if (!ec)
+		{
+			co_return Candidate;
+		}
+
+		kDebug(2, "connection attempt to {} failed: {}", Candidate.address().to_string(), ec.message());
+	}
+
+	boost::system::error_code ignore;
+	Socket.close(ignore);
+
+	co_return boost::asio::ip::tcp::endpoint();
+
+} // kAsioConnectAsync
+#endif
+
+} // end of namespace detail
+} // end of namespace dekaf2
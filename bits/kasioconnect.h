@@ -0,0 +1,103 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#pragma once
+
+/// @file kasioconnect.h
+/// staggered parallel connection attempts to a list of endpoints ("happy eyeballs")
+
+#include "kasio.h"
+#include "../kduration.h"
+#include "../kcoroutine.h"
+#include <vector>
+
+namespace dekaf2 {
+namespace detail {
+
+/// RFC 8305 recommends 250 milliseconds between two connection attempts
+constexpr chrono::milliseconds DefaultConnectionAttemptDelay { 250 };
+
+//-----------------------------------------------------------------------------
+/// Connect a socket to the first endpoint of a list that accepts the connection,
+/// following RFC 8305 ("happy eyeballs"): the endpoints are interleaved by address
+/// family (starting with the family of the first endpoint, which is the preferred
+/// one after getaddrinfo() sorted them), and a new connection attempt is started
+/// every AttemptDelay while the previous attempts are still pending, or immediately
+/// when a previous attempt failed. The first successful attempt wins, all others
+/// are cancelled. A single blackholed address therefore only costs AttemptDelay,
+/// and not the full timeout.
+/// @param IOService the io service the socket belongs to - must not be run concurrently
+/// @param Socket the socket to connect - will be replaced by the winning socket
+/// @param Endpoints the resolved endpoints
+/// @param Timeout the overall timeout for the connection
+/// @param ec receives the error code - either the last connection error or timed_out
+/// @param AttemptDelay the delay before starting the next connection attempt
+/// @return the connected endpoint, or a default constructed endpoint on error
+DEKAF2_PUBLIC
+boost::asio::ip::tcp::endpoint kAsioConnect(boost::asio::io_service& IOService,
+                                            boost::asio::ip::tcp::socket& Socket,
+                                            const std::vector<boost::asio::ip::tcp::endpoint>& Endpoints,
+                                            KDuration Timeout,
+                                            boost::system::error_code& ec,
+                                            KDuration AttemptDelay = DefaultConnectionAttemptDelay);
+//-----------------------------------------------------------------------------
+
+#if DEKAF2_HAS_COROUTINES && !defined(DEKAF2_IS_WINDOWS)
+//-----------------------------------------------------------------------------
+/// Coroutine version of kAsioConnect(), which suspends the coroutine while a
+/// connection attempt is pending instead of running an io service. The endpoints
+/// are interleaved by address family as above, but tried one after the other,
+/// each with its share of the remaining timeout.
+/// @param Socket the socket to connect, will be opened for the protocol of the endpoint
+/// @param Endpoints the resolved endpoints
+/// @param Timeout the overall timeout for the connection
+/// @param ec receives the error code - either the last connection error or timed_out
+/// @return the connected endpoint, or a default constructed endpoint on error
+DEKAF2_PUBLIC
+KTask<boost::asio::ip::tcp::endpoint> kAsioConnectAsync(boost::asio::ip::tcp::socket& Socket,
+                                                        std::vector<boost::asio::ip::tcp::endpoint> Endpoints,
+                                                        KDuration Timeout,
+                                                        boost::system::error_code& ec);
+//-----------------------------------------------------------------------------
+#endif
+
+} // end of namespace detail
+} // end of namespace dekaf2
@@ -0,0 +1,154 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#include "kcachemaps.h"
+#include <algorithm>
+
+namespace dekaf2 {
+namespace detail {
+
+//-----------------------------------------------------------------------------
+KCountMinSketch::KCountMinSketch(std::size_t iExpectedElements)
+//-----------------------------------------------------------------------------
+{
+	Resize(iExpectedElements);
+}
+
+//-----------------------------------------------------------------------------
+void KCountMinSketch::Resize(std::size_t iExpectedElements)
+//-----------------------------------------------------------------------------
+{
+	std::size_t iWidth = 16;
+
+	while (iWidth < iExpectedElements && iWidth < (std::size_t(1) << 26))
+	{
+		iWidth <<= 1;
+	}
+
+	m_Counters.assign(iWidth * iDepth, 0);
+	m_iMask         = iWidth - 1;
+	m_iAdditions    = 0;
+	m_iSamplePeriod = iWidth * 10;
+
+} // Resize
+
+//-----------------------------------------------------------------------------
+std::size_t KCountMinSketch::Position(uint64_t iHash, std::size_t iRow) const
+//-----------------------------------------------------------------------------
+{
+	static constexpr uint64_t Seeds[iDepth]
+	{
+		UINT64_C(0x9E3779B97F4A7C15),
+		UINT64_C(0xC2B2AE3D27D4EB4F),
+		UINT64_C(0x165667B19E3779F9),
+		UINT64_C(0xD6E8FEB86659FD93)
+	};
+
+	iHash  = (iHash + Seeds[iRow]) * Seeds[(iRow + 1) % iDepth];
+	iHash ^= iHash >> 32;
+
+	return iRow * (m_iMask + 1) + (static_cast<std::size_t>(iHash) & m_iMask);
+
+} // Position
+
+//-----------------------------------------------------------------------------
+void KCountMinSketch::Increment(uint64_t iHash)
+//-----------------------------------------------------------------------------
+{
+	bool bAdded { false };
+
+	for (std::size_t iRow = 0; iRow < iDepth; ++iRow)
+	{
+		auto& iCount = m_Counters[Position(iHash, iRow)];
+
+		if (iCount < iMaxCount)
+		{
+			++iCount;
+			bAdded = true;
+		}
+	}
+
+	if (bAdded && ++m_iAdditions >= m_iSamplePeriod)
+	{
+		Age();
+	}
+
+} // Increment
+
+//-----------------------------------------------------------------------------
+uint8_t KCountMinSketch::Frequency(uint64_t iHash) const
+//-----------------------------------------------------------------------------
+{
+	uint8_t iFrequency { iMaxCount };
+
+	for (std::size_t iRow = 0; iRow < iDepth; ++iRow)
+	{
+		iFrequency = std::min(iFrequency, m_Counters[Position(iHash, iRow)]);
+	}
+
+	return iFrequency;
+
+} // Frequency
+
+//-----------------------------------------------------------------------------
+void KCountMinSketch::Age()
+//-----------------------------------------------------------------------------
+{
+	for (auto& iCount : m_Counters)
+	{
+		iCount >>= 1;
+	}
+
+	m_iAdditions /= 2;
+
+} // Age
+
+//-----------------------------------------------------------------------------
+void KCountMinSketch::Clear()
+//-----------------------------------------------------------------------------
+{
+	std::fill(m_Counters.begin(), m_Counters.end(), 0);
+	m_iAdditions = 0;
+
+} // Clear
+
+} // end of namespace detail
+} // end of namespace dekaf2
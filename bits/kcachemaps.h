@@ -0,0 +1,925 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#pragma once
+
+/// @file kcachemaps.h
+/// size limited maps with different eviction strategies, used as the storage of caches
+
+#include "kcppcompat.h"
+#include "kmutable_pair.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dekaf2 {
+namespace detail {
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// common storage of the cache maps: the elements live in a list, and a hash
+/// index points into the list. The element order and the eviction are managed
+/// by the derived maps.
+template <typename Key, typename Value, typename Node>
+class KCacheMapBase
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+protected:
+//----------
+
+	using Storage = std::list<Node>;
+	using Index   = std::unordered_map<Key, typename Storage::iterator>;
+
+//----------
+public:
+//----------
+
+	using element_type = KMutablePair<Key, Value>;
+	using iterator     = typename Storage::iterator;
+
+	//-----------------------------------------------------------------------------
+	KCacheMapBase(std::size_t iMaxElements)
+	//-----------------------------------------------------------------------------
+	: m_iMaxElements(iMaxElements)
+	{
+	}
+
+	KCacheMapBase(const KCacheMapBase&) = delete;
+	KCacheMapBase& operator=(const KCacheMapBase&) = delete;
+
+	//-----------------------------------------------------------------------------
+	/// returns the maximum element count
+	std::size_t GetMaxSize() const
+	//-----------------------------------------------------------------------------
+	{
+		return m_iMaxElements;
+	}
+
+	//-----------------------------------------------------------------------------
+	iterator begin()
+	//-----------------------------------------------------------------------------
+	{
+		return m_Storage.begin();
+	}
+
+	//-----------------------------------------------------------------------------
+	iterator end()
+	//-----------------------------------------------------------------------------
+	{
+		return m_Storage.end();
+	}
+
+	//-----------------------------------------------------------------------------
+	std::size_t size() const
+	//-----------------------------------------------------------------------------
+	{
+		return m_Index.size();
+	}
+
+	//-----------------------------------------------------------------------------
+	bool empty() const
+	//-----------------------------------------------------------------------------
+	{
+		return m_Index.empty();
+	}
+
+	//-----------------------------------------------------------------------------
+	/// returns true if an element with the given key exists, does not count as access
+	template<class K>
+	bool contains(const K& key) const
+	//-----------------------------------------------------------------------------
+	{
+		return m_Index.find(key) != m_Index.end();
+	}
+
+	//-----------------------------------------------------------------------------
+	/// returns the element with the given key or nullptr, does not count as access
+	template<class K>
+	const element_type* peek(const K& key) const
+	//-----------------------------------------------------------------------------
+	{
+		auto it = m_Index.find(key);
+		return (it != m_Index.end()) ? &*it->second : nullptr;
+	}
+
+//----------
+protected:
+//----------
+
+	//-----------------------------------------------------------------------------
+	/// add a new element at the given position of the storage
+	iterator Link(iterator pos, element_type&& element)
+	//-----------------------------------------------------------------------------
+	{
+		auto node = m_Storage.emplace(pos, std::move(element));
+
+		try
+		{
+			m_Index.emplace(node->first, node);
+		}
+		catch (...)
+		{
+			m_Storage.erase(node);
+			throw;
+		}
+
+		return node;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// remove an element from index and storage
+	void Unlink(typename Index::iterator it)
+	//-----------------------------------------------------------------------------
+	{
+		auto node = it->second;
+		m_Index.erase(it);
+		m_Storage.erase(node);
+	}
+
+	//-----------------------------------------------------------------------------
+	void Clear()
+	//-----------------------------------------------------------------------------
+	{
+		m_Index.clear();
+		m_Storage.clear();
+	}
+
+	Storage     m_Storage;
+	Index       m_Index;
+	std::size_t m_iMaxElements { 0 };
+
+}; // KCacheMapBase
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// element of the CLOCK and SIEVE maps, with an atomic access bit
+template <typename Key, typename Value>
+struct KCacheBitNode : public KMutablePair<Key, Value>
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	KCacheBitNode(KMutablePair<Key, Value>&& element)
+	: KMutablePair<Key, Value>(std::move(element))
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	void Touch() const
+	//-----------------------------------------------------------------------------
+	{
+		// do not write to the cache line of hot elements if not needed
+		if (!bAccessed.load(std::memory_order_relaxed))
+		{
+			bAccessed.store(true, std::memory_order_relaxed);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// returns the access bit and clears it
+	bool Consume() const
+	//-----------------------------------------------------------------------------
+	{
+		if (bAccessed.load(std::memory_order_relaxed))
+		{
+			bAccessed.store(false, std::memory_order_relaxed);
+			return true;
+		}
+
+		return false;
+	}
+
+	mutable std::atomic<bool> bAccessed { false };
+
+}; // KCacheBitNode
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// A size limited map with CLOCK (second chance) eviction. A hit only sets an
+/// atomic access bit on the element instead of relinking it like an LRU list,
+/// therefore concurrent find() calls may share a lock. On eviction the clock
+/// hand sweeps over the elements, clears the access bits it finds set, and
+/// removes the first element that was not accessed since the last sweep.
+template <typename Key, typename Value>
+class KClockMap : public KCacheMapBase<Key, Value, KCacheBitNode<Key, Value>>
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	using base_type = KCacheMapBase<Key, Value, KCacheBitNode<Key, Value>>;
+	using base_type::m_Storage;
+	using base_type::m_Index;
+	using base_type::m_iMaxElements;
+
+//----------
+public:
+//----------
+
+	using typename base_type::element_type;
+	using typename base_type::iterator;
+
+	//-----------------------------------------------------------------------------
+	KClockMap(std::size_t iMaxElements)
+	//-----------------------------------------------------------------------------
+	: base_type(iMaxElements)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	/// set the maximum element count, evicts elements if there are now too many
+	void SetMaxSize(std::size_t iMaxElements)
+	//-----------------------------------------------------------------------------
+	{
+		m_iMaxElements = iMaxElements;
+
+		while (this->size() > m_iMaxElements && evict()) {}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// insert an element - if the key already exists, the existing element is
+	/// marked as accessed and returned, and the new element is dropped
+	iterator insert(element_type element)
+	//-----------------------------------------------------------------------------
+	{
+		auto it = m_Index.find(element.first);
+
+		if (it != m_Index.end())
+		{
+			it->second->Touch();
+			return it->second;
+		}
+
+		while (this->size() >= m_iMaxElements && evict()) {}
+
+		// new elements are inserted right behind the hand, so they are
+		// the last ones to be visited by the next sweep
+		return this->Link(m_Hand, std::move(element));
+	}
+
+	//-----------------------------------------------------------------------------
+	/// erase an element by its key
+	template<class K>
+	bool erase(const K& key)
+	//-----------------------------------------------------------------------------
+	{
+		auto it = m_Index.find(key);
+
+		if (it == m_Index.end())
+		{
+			return false;
+		}
+
+		Erase(it);
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// evict one element with the CLOCK strategy
+	/// @return false if the map was empty
+	bool evict()
+	//-----------------------------------------------------------------------------
+	{
+		if (m_Storage.empty())
+		{
+			return false;
+		}
+
+		for (;;)
+		{
+			if (m_Hand == m_Storage.end())
+			{
+				m_Hand = m_Storage.begin();
+			}
+
+			if (m_Hand->Consume())
+			{
+				// second chance
+				++m_Hand;
+			}
+			else
+			{
+				Erase(m_Index.find(m_Hand->first));
+				return true;
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// find an element by its key and mark it as accessed - this only modifies
+	/// the atomic access bit, and may therefore be called concurrently
+	template<class K>
+	iterator find(const K& key)
+	//-----------------------------------------------------------------------------
+	{
+		auto it = m_Index.find(key);
+
+		if (it == m_Index.end())
+		{
+			return this->end();
+		}
+
+		it->second->Touch();
+
+		return it->second;
+	}
+
+	//-----------------------------------------------------------------------------
+	void clear()
+	//-----------------------------------------------------------------------------
+	{
+		this->Clear();
+		m_Hand = m_Storage.end();
+	}
+
+//----------
+private:
+//----------
+
+	//-----------------------------------------------------------------------------
+	void Erase(typename base_type::Index::iterator it)
+	//-----------------------------------------------------------------------------
+	{
+		if (it->second == m_Hand)
+		{
+			++m_Hand;
+		}
+
+		this->Unlink(it);
+	}
+
+	iterator m_Hand { m_Storage.end() };
+
+}; // KClockMap
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// A size limited map with SIEVE eviction. Like CLOCK, a hit only sets an
+/// atomic access bit, but new elements are queued at the head of a FIFO, and
+/// the hand moves from the tail towards the head, removing the first element that
+/// was not accessed. Accessed elements keep their position in the queue, which
+/// lets new elements that are not accessed again (like those of a scan) be
+/// evicted quickly, while popular elements stay in the older part of the queue.
+template <typename Key, typename Value>
+class KSieveMap : public KCacheMapBase<Key, Value, KCacheBitNode<Key, Value>>
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	using base_type = KCacheMapBase<Key, Value, KCacheBitNode<Key, Value>>;
+	using base_type::m_Storage;
+	using base_type::m_Index;
+	using base_type::m_iMaxElements;
+
+//----------
+public:
+//----------
+
+	using typename base_type::element_type;
+	using typename base_type::iterator;
+
+	//-----------------------------------------------------------------------------
+	KSieveMap(std::size_t iMaxElements)
+	//-----------------------------------------------------------------------------
+	: base_type(iMaxElements)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	/// set the maximum element count, evicts elements if there are now too many
+	void SetMaxSize(std::size_t iMaxElements)
+	//-----------------------------------------------------------------------------
+	{
+		m_iMaxElements = iMaxElements;
+
+		while (this->size() > m_iMaxElements && evict()) {}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// insert an element - if the key already exists, the existing element is
+	/// marked as accessed and returned, and the new element is dropped
+	iterator insert(element_type element)
+	//-----------------------------------------------------------------------------
+	{
+		auto it = m_Index.find(element.first);
+
+		if (it != m_Index.end())
+		{
+			it->second->Touch();
+			return it->second;
+		}
+
+		while (this->size() >= m_iMaxElements && evict()) {}
+
+		return this->Link(m_Storage.begin(), std::move(element));
+	}
+
+	//-----------------------------------------------------------------------------
+	/// erase an element by its key
+	template<class K>
+	bool erase(const K& key)
+	//-----------------------------------------------------------------------------
+	{
+		auto it = m_Index.find(key);
+
+		if (it == m_Index.end())
+		{
+			return false;
+		}
+
+		Erase(it);
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// evict one element with the SIEVE strategy
+	/// @return false if the map was empty
+	bool evict()
+	//-----------------------------------------------------------------------------
+	{
+		if (m_Storage.empty())
+		{
+			return false;
+		}
+
+		if (m_Hand == m_Storage.end())
+		{
+			m_Hand = std::prev(m_Storage.end());
+		}
+
+		while (m_Hand->Consume())
+		{
+			m_Hand = Newer(m_Hand);
+		}
+
+		Erase(m_Index.find(m_Hand->first));
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// find an element by its key and mark it as accessed - this only modifies
+	/// the atomic access bit, and may therefore be called concurrently
+	template<class K>
+	iterator find(const K& key)
+	//-----------------------------------------------------------------------------
+	{
+		auto it = m_Index.find(key);
+
+		if (it == m_Index.end())
+		{
+			return this->end();
+		}
+
+		it->second->Touch();
+
+		return it->second;
+	}
+
+	//-----------------------------------------------------------------------------
+	void clear()
+	//-----------------------------------------------------------------------------
+	{
+		this->Clear();
+		m_Hand = m_Storage.end();
+	}
+
+//----------
+private:
+//----------
+
+	//-----------------------------------------------------------------------------
+	/// returns the next newer element, wraps around to the tail after the head
+	iterator Newer(iterator it)
+	//-----------------------------------------------------------------------------
+	{
+		return (it == m_Storage.begin()) ? std::prev(m_Storage.end()) : std::prev(it);
+	}
+
+	//-----------------------------------------------------------------------------
+	void Erase(typename base_type::Index::iterator it)
+	//-----------------------------------------------------------------------------
+	{
+		if (it->second == m_Hand)
+		{
+			// the hand continues with the next newer element, or restarts
+			// at the tail once it passed the head
+			m_Hand = (m_Hand == m_Storage.begin()) ? m_Storage.end() : std::prev(m_Hand);
+		}
+
+		this->Unlink(it);
+	}
+
+	// the storage is ordered from the newest (begin) to the oldest (end) element,
+	// end() means that the hand starts at the tail
+	iterator m_Hand { m_Storage.end() };
+
+}; // KSieveMap
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// A count-min sketch with four rows of saturating 4 bit counters, used to
+/// estimate the access frequency of keys by their hash. All counters are
+/// halved after a sample period of ten times the width, so that the estimate
+/// follows changes of popularity.
+class DEKAF2_PUBLIC KCountMinSketch
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	/// construct for an expected count of distinct keys
+	KCountMinSketch(std::size_t iExpectedElements = 16);
+
+	/// resize for an expected count of distinct keys, resets all counters
+	void Resize(std::size_t iExpectedElements);
+
+	/// count one access for a hash
+	void Increment(uint64_t iHash);
+
+	/// returns the estimated access frequency for a hash, from 0 to 15
+	uint8_t Frequency(uint64_t iHash) const;
+
+	/// reset all counters
+	void Clear();
+
+//----------
+private:
+//----------
+
+	static constexpr std::size_t iDepth   = 4;
+	static constexpr uint8_t     iMaxCount = 15;
+
+	std::size_t Position(uint64_t iHash, std::size_t iRow) const;
+	void Age();
+
+	std::vector<uint8_t> m_Counters;
+	std::size_t          m_iMask        { 0 };
+	std::size_t          m_iAdditions   { 0 };
+	std::size_t          m_iSamplePeriod { 0 };
+
+}; // KCountMinSketch
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// element of the W-TinyLFU map - the segments are intrusive lists
+template <typename Key, typename Value>
+struct KTinyLFUNode : public KMutablePair<Key, Value>
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	enum SegmentType : uint8_t { Window, Probation, Protected };
+
+	KTinyLFUNode(KMutablePair<Key, Value>&& element)
+	: KMutablePair<Key, Value>(std::move(element))
+	{
+	}
+
+	KTinyLFUNode* pPrev    { nullptr };
+	KTinyLFUNode* pNext    { nullptr };
+	SegmentType   Segment  { Window };
+
+}; // KTinyLFUNode
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// A size limited map with W-TinyLFU eviction. New elements enter a small LRU
+/// window (1% of the capacity). Elements leaving the window compete with the
+/// eviction candidate of the main segmented LRU (probation and protected), and
+/// only the one with the higher access frequency, as estimated by a count-min
+/// sketch, stays. Elements of the probation segment that are accessed again move
+/// into the protected segment (80% of the main capacity). This keeps frequently
+/// used elements in the cache when it is flooded by elements that are accessed
+/// only once. find() records the access frequency, and is therefore not safe to
+/// call concurrently.
+template <typename Key, typename Value>
+class KTinyLFUMap : public KCacheMapBase<Key, Value, KTinyLFUNode<Key, Value>>
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	using Node      = KTinyLFUNode<Key, Value>;
+	using base_type = KCacheMapBase<Key, Value, Node>;
+	using base_type::m_Index;
+	using base_type::m_iMaxElements;
+
+//----------
+public:
+//----------
+
+	using typename base_type::element_type;
+	using typename base_type::iterator;
+
+	//-----------------------------------------------------------------------------
+	KTinyLFUMap(std::size_t iMaxElements)
+	//-----------------------------------------------------------------------------
+	: base_type(iMaxElements)
+	, m_Sketch(iMaxElements)
+	{
+		SetSegmentSizes();
+	}
+
+	//-----------------------------------------------------------------------------
+	/// set the maximum element count, evicts elements if there are now too many
+	void SetMaxSize(std::size_t iMaxElements)
+	//-----------------------------------------------------------------------------
+	{
+		m_iMaxElements = iMaxElements;
+		m_Sketch.Resize(iMaxElements);
+		SetSegmentSizes();
+
+		while (m_Protected.iSize > m_iMaxProtected)
+		{
+			Demote();
+		}
+
+		Rebalance();
+
+		while (this->size() > m_iMaxElements && evict()) {}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// insert an element - if the key already exists, the existing element is
+	/// marked as accessed and returned, and the new element is dropped
+	iterator insert(element_type element)
+	//-----------------------------------------------------------------------------
+	{
+		auto it = m_Index.find(element.first);
+
+		if (it != m_Index.end())
+		{
+			OnHit(*it->second);
+			return it->second;
+		}
+
+		auto node = this->Link(this->end(), std::move(element));
+
+		node->Segment = Node::Window;
+		m_Window.PushFront(&*node);
+
+		Rebalance();
+
+		return node;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// erase an element by its key
+	template<class K>
+	bool erase(const K& key)
+	//-----------------------------------------------------------------------------
+	{
+		auto it = m_Index.find(key);
+
+		if (it == m_Index.end())
+		{
+			return false;
+		}
+
+		Erase(it);
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// evict one element: the oldest of the probation segment, else of the window,
+	/// else of the protected segment
+	/// @return false if the map was empty
+	bool evict()
+	//-----------------------------------------------------------------------------
+	{
+		for (auto* pSegment : { &m_Probation, &m_Window, &m_Protected })
+		{
+			if (pSegment->pTail)
+			{
+				Erase(m_Index.find(pSegment->pTail->first));
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// find an element by its key, counts the access for the key
+	template<class K>
+	iterator find(const K& key)
+	//-----------------------------------------------------------------------------
+	{
+		auto it = m_Index.find(key);
+
+		if (it == m_Index.end())
+		{
+			m_Sketch.Increment(Hash(key));
+			return this->end();
+		}
+
+		m_Sketch.Increment(Hash(it->first));
+		OnHit(*it->second);
+
+		return it->second;
+	}
+
+	//-----------------------------------------------------------------------------
+	void clear()
+	//-----------------------------------------------------------------------------
+	{
+		this->Clear();
+		m_Window    = Segment();
+		m_Probation = Segment();
+		m_Protected = Segment();
+		m_Sketch.Clear();
+	}
+
+//----------
+private:
+//----------
+
+	//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	/// intrusive LRU list, the head is the most recently used element
+	struct Segment
+	//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	{
+		void PushFront(Node* pNode)
+		{
+			pNode->pPrev = nullptr;
+			pNode->pNext = pHead;
+
+			if (pHead) pHead->pPrev = pNode;
+			else       pTail = pNode;
+
+			pHead = pNode;
+			++iSize;
+		}
+
+		void Remove(Node* pNode)
+		{
+			if (pNode->pPrev) pNode->pPrev->pNext = pNode->pNext;
+			else              pHead = pNode->pNext;
+
+			if (pNode->pNext) pNode->pNext->pPrev = pNode->pPrev;
+			else              pTail = pNode->pPrev;
+
+			pNode->pPrev = nullptr;
+			pNode->pNext = nullptr;
+			--iSize;
+		}
+
+		Node*       pHead { nullptr };
+		Node*       pTail { nullptr };
+		std::size_t iSize { 0 };
+
+	}; // Segment
+
+	//-----------------------------------------------------------------------------
+	template<class K>
+	static uint64_t Hash(const K& key)
+	//-----------------------------------------------------------------------------
+	{
+		return std::hash<Key>()(key);
+	}
+
+	//-----------------------------------------------------------------------------
+	Segment& GetSegment(const Node& node)
+	//-----------------------------------------------------------------------------
+	{
+		switch (node.Segment)
+		{
+			case Node::Window:    return m_Window;
+			case Node::Probation: return m_Probation;
+			case Node::Protected: break;
+		}
+
+		return m_Protected;
+	}
+
+	//-----------------------------------------------------------------------------
+	void SetSegmentSizes()
+	//-----------------------------------------------------------------------------
+	{
+		m_iMaxWindow    = std::max(m_iMaxElements / 100, std::size_t(1));
+		auto iMain      = (m_iMaxElements > m_iMaxWindow) ? m_iMaxElements - m_iMaxWindow : 0;
+		m_iMaxProtected = iMain * 8 / 10;
+		m_iMaxMain      = iMain;
+	}
+
+	//-----------------------------------------------------------------------------
+	void OnHit(Node& node)
+	//-----------------------------------------------------------------------------
+	{
+		GetSegment(node).Remove(&node);
+
+		if (node.Segment == Node::Probation)
+		{
+			node.Segment = Node::Protected;
+		}
+
+		GetSegment(node).PushFront(&node);
+
+		while (m_Protected.iSize > m_iMaxProtected)
+		{
+			Demote();
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// move the oldest protected element back into probation
+	void Demote()
+	//-----------------------------------------------------------------------------
+	{
+		auto* pNode = m_Protected.pTail;
+		m_Protected.Remove(pNode);
+		pNode->Segment = Node::Probation;
+		m_Probation.PushFront(pNode);
+	}
+
+	//-----------------------------------------------------------------------------
+	/// move elements from the window into the main segments, and let them
+	/// compete with the main eviction candidate if the main segments are full
+	void Rebalance()
+	//-----------------------------------------------------------------------------
+	{
+		while (m_Window.iSize > m_iMaxWindow)
+		{
+			auto* pCandidate = m_Window.pTail;
+			m_Window.Remove(pCandidate);
+			pCandidate->Segment = Node::Probation;
+			m_Probation.PushFront(pCandidate);
+
+			if (m_Probation.iSize + m_Protected.iSize > m_iMaxMain)
+			{
+				auto* pVictim = m_Probation.pTail;
+
+				if (pVictim == pCandidate && m_Protected.pTail)
+				{
+					pVictim = m_Protected.pTail;
+				}
+
+				if (pVictim != pCandidate &&
+					m_Sketch.Frequency(Hash(pCandidate->first)) > m_Sketch.Frequency(Hash(pVictim->first)))
+				{
+					Erase(m_Index.find(pVictim->first));
+				}
+				else
+				{
+					Erase(m_Index.find(pCandidate->first));
+				}
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	void Erase(typename base_type::Index::iterator it)
+	//-----------------------------------------------------------------------------
+	{
+		auto& node = *it->second;
+		GetSegment(node).Remove(&node);
+		this->Unlink(it);
+	}
+
+	Segment         m_Window;
+	Segment         m_Probation;
+	Segment         m_Protected;
+	KCountMinSketch m_Sketch;
+	std::size_t     m_iMaxWindow    { 1 };
+	std::size_t     m_iMaxMain      { 0 };
+	std::size_t     m_iMaxProtected { 0 };
+
+}; // KTinyLFUMap
+
+} // end of namespace detail
+} // end of namespace dekaf2
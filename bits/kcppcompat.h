@@ -713,6 +713,13 @@ static constexpr std::size_t KDefaultCopyBufSize = 4096;
 	#endif
 #endif
 
+#ifndef DEKAF2_HAS_COROUTINES
+	#if DEKAF2_HAS_CPP_20 && defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && \
+		DEKAF2_HAS_INCLUDE(<coroutine>)
+		#define DEKAF2_HAS_COROUTINES 1
+	#endif
+#endif
+
 
 // Helper macros to make an enum type a "flag" type, that is, bit operations with enum values are permitted
 // in a type-safe fashion.
@@ -0,0 +1,302 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#include "kepochreclaim.h"
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace dekaf2 {
+namespace detail {
+
+namespace {
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// the epoch announcement of one thread - records are never freed, but
+/// reused by new threads after their owning thread ended
+struct alignas(64) ThreadRecord
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	std::atomic<uint64_t> iEpoch  { 0 };     // 0 = not inside a read section
+	std::atomic<bool>     bInUse  { true };
+	ThreadRecord*         pNext   { nullptr };
+	std::size_t           iNesting { 0 };    // only accessed by the owning thread
+	std::size_t           iLeaves  { 0 };    // only accessed by the owning thread
+
+}; // ThreadRecord
+
+// readers help collecting on every n-th leave of their outermost section
+constexpr std::size_t iCollectInterval = 64;
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+struct Retired
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	void*                     pObject;
+	KEpochReclaimer::Deleter  Delete;
+	uint64_t                  iEpoch;
+
+}; // Retired
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+struct Domain
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	std::atomic<ThreadRecord*> Records  { nullptr };
+	std::atomic<uint64_t>      iEpoch   { 1 };
+	std::atomic<std::size_t>   iPending { 0 };
+	std::mutex                 RetireMutex;
+	std::vector<Retired>       RetiredObjects;
+
+}; // Domain
+
+//-----------------------------------------------------------------------------
+Domain& GetDomain()
+//-----------------------------------------------------------------------------
+{
+	// never destructed, threads may leave their sections during static destruction
+	static Domain* s_Domain = new Domain;
+	return *s_Domain;
+
+} // GetDomain
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// gives the record of a thread free for reuse when the thread ends
+struct LocalRecord
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	~LocalRecord()
+	{
+		if (pRecord)
+		{
+			pRecord->iEpoch.store(0, std::memory_order_release);
+			pRecord->bInUse.store(false, std::memory_order_release);
+		}
+	}
+
+	ThreadRecord* pRecord { nullptr };
+
+}; // LocalRecord
+
+thread_local LocalRecord t_Record;
+
+//-----------------------------------------------------------------------------
+ThreadRecord& GetThreadRecord()
+//-----------------------------------------------------------------------------
+{
+	if (DEKAF2_LIKELY(t_Record.pRecord != nullptr))
+	{
+		return *t_Record.pRecord;
+	}
+
+	auto& Domain = GetDomain();
+
+	// try to reuse the record of an ended thread
+	for (auto pRecord = Domain.Records.load(std::memory_order_acquire); pRecord; pRecord = pRecord->pNext)
+	{
+		bool bExpected = false;
+
+		if (!pRecord->bInUse.load(std::memory_order_relaxed) &&
+		    pRecord->bInUse.compare_exchange_strong(bExpected, true, std::memory_order_acquire))
+		{
+			pRecord->iNesting = 0;
+			pRecord->iLeaves  = 0;
+			t_Record.pRecord  = pRecord;
+			return *pRecord;
+		}
+	}
+
+	auto pRecord = new ThreadRecord;
+	pRecord->pNext = Domain.Records.load(std::memory_order_relaxed);
+
+	while (!Domain.Records.compare_exchange_weak(pRecord->pNext, pRecord, std::memory_order_release, std::memory_order_relaxed))
+	{
+	}
+
+	t_Record.pRecord = pRecord;
+	return *pRecord;
+
+} // GetThreadRecord
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+void KEpochReclaimer::Enter()
+//-----------------------------------------------------------------------------
+{
+	auto& Record = GetThreadRecord();
+
+	if (Record.iNesting++ == 0)
+	{
+		// a stale epoch only makes us more conservative
+		Record.iEpoch.store(GetDomain().iEpoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		// the announcement has to be visible before we load any shared pointer -
+		// pairs with the fence in Collect()
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+
+} // Enter
+
+//-----------------------------------------------------------------------------
+void KEpochReclaimer::Leave()
+//-----------------------------------------------------------------------------
+{
+	auto& Record = GetThreadRecord();
+
+	if (--Record.iNesting == 0)
+	{
+		Record.iEpoch.store(0, std::memory_order_release);
+
+		// collecting walks the records of all threads, therefore readers only
+		// do it now and then - writers collect on each Retire()
+		if (++Record.iLeaves % iCollectInterval == 0 &&
+		    GetDomain().iPending.load(std::memory_order_relaxed) > 0)
+		{
+			// do not wait if another thread is collecting
+			Collect(false);
+		}
+	}
+
+} // Leave
+
+//-----------------------------------------------------------------------------
+void KEpochReclaimer::Retire(void* pObject, Deleter Delete)
+//-----------------------------------------------------------------------------
+{
+	if (!pObject)
+	{
+		return;
+	}
+
+	auto& Domain = GetDomain();
+
+	{
+		std::lock_guard<std::mutex> Lock(Domain.RetireMutex);
+		// readers that enter after this point can no longer see the object
+		auto iEpoch = Domain.iEpoch.fetch_add(1, std::memory_order_seq_cst);
+		Domain.RetiredObjects.push_back({ pObject, Delete, iEpoch });
+		++Domain.iPending;
+	}
+
+	Collect(true);
+
+} // Retire
+
+//-----------------------------------------------------------------------------
+std::size_t KEpochReclaimer::Collect()
+//-----------------------------------------------------------------------------
+{
+	return Collect(true);
+
+} // Collect
+
+//-----------------------------------------------------------------------------
+std::size_t KEpochReclaimer::Pending()
+//-----------------------------------------------------------------------------
+{
+	return GetDomain().iPending.load(std::memory_order_relaxed);
+
+} // Pending
+
+//-----------------------------------------------------------------------------
+std::size_t KEpochReclaimer::Collect(bool bWait)
+//-----------------------------------------------------------------------------
+{
+	auto& Domain = GetDomain();
+	std::vector<Retired> Expired;
+
+	{
+		std::unique_lock<std::mutex> Lock(Domain.RetireMutex, std::defer_lock);
+
+		if (bWait)
+		{
+			Lock.lock();
+		}
+		else if (!Lock.try_lock())
+		{
+			return Domain.iPending.load(std::memory_order_relaxed);
+		}
+
+		if (Domain.RetiredObjects.empty())
+		{
+			return 0;
+		}
+
+		// pairs with the fence in Enter(): either we see the announcement
+		// of a reader, or the reader sees the replaced pointers
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		auto iOldest = std::numeric_limits<uint64_t>::max();
+
+		for (auto pRecord = Domain.Records.load(std::memory_order_acquire); pRecord; pRecord = pRecord->pNext)
+		{
+			auto iEpoch = pRecord->iEpoch.load(std::memory_order_relaxed);
+
+			if (iEpoch && iEpoch < iOldest)
+			{
+				iOldest = iEpoch;
+			}
+		}
+
+		// a reader that announced epoch E may see objects retired in epoch E or later
+		auto it = std::partition(Domain.RetiredObjects.begin(), Domain.RetiredObjects.end(), [iOldest](const Retired& Object)
+		{
+			return Object.iEpoch >= iOldest;
+		});
+
+		Expired.assign(it, Domain.RetiredObjects.end());
+		Domain.RetiredObjects.erase(it, Domain.RetiredObjects.end());
+		Domain.iPending = Domain.RetiredObjects.size();
+	}
+
+	// delete outside of the lock, destructors may retire more objects
+	for (auto& Object : Expired)
+	{
+		Object.Delete(Object.pObject);
+	}
+
+	return Domain.iPending.load(std::memory_order_relaxed);
+
+} // Collect
+
+} // end of namespace detail
+} // end of namespace dekaf2
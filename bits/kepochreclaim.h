@@ -0,0 +1,140 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#pragma once
+
+/// @file kepochreclaim.h
+/// epoch based reclamation of objects that may still be accessed by lock free readers
+
+#include "kcppcompat.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace dekaf2 {
+namespace detail {
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// Epoch based reclamation: readers announce the global epoch while they
+/// access shared objects, writers retire replaced objects with the epoch of
+/// their retirement, and an object is deleted once no reader announced an
+/// epoch up to that of its retirement. Entering and leaving are wait free,
+/// and do not allocate after the first call of a thread.
+class DEKAF2_PUBLIC KEpochReclaimer
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	/// RAII guard for a read section - guards can be nested
+	class Guard
+	//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	{
+
+	//----------
+	public:
+	//----------
+
+		Guard()  { Enter(); }
+		~Guard() { Leave(); }
+
+		Guard(const Guard&) = delete;
+		Guard& operator=(const Guard&) = delete;
+
+	}; // Guard
+
+	using Deleter = void (*)(void*);
+
+	//-----------------------------------------------------------------------------
+	/// enter a read section of this thread - all objects that are retired after
+	/// this call stay alive until the matching Leave()
+	static void Enter();
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// leave a read section of this thread - every 64th outermost Leave() of a
+	/// thread also deletes retired objects that are no longer visible to any reader
+	static void Leave();
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// retire an object that has been made unreachable for new readers - it will
+	/// be deleted as soon as all readers that may still see it left their sections
+	static void Retire(void* pObject, Deleter Delete);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// retire an object of type T, see above
+	template<class T>
+	static void Retire(T* pObject)
+	//-----------------------------------------------------------------------------
+	{
+		Retire(const_cast<void*>(static_cast<const void*>(pObject)), [](void* p)
+		{
+			delete static_cast<T*>(p);
+		});
+	}
+
+	//-----------------------------------------------------------------------------
+	/// delete all retired objects that are no longer visible to any reader
+	/// @return the count of retired objects that are still waiting for readers
+	static std::size_t Collect();
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// @return the count of retired objects that are still waiting for readers
+	static std::size_t Pending();
+	//-----------------------------------------------------------------------------
+
+//----------
+private:
+//----------
+
+	DEKAF2_PRIVATE
+	static std::size_t Collect(bool bWait);
+
+}; // KEpochReclaimer
+
+} // end of namespace detail
+} // end of namespace dekaf2
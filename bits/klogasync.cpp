@@ -0,0 +1,333 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#include "klogasync.h"
+#include "../dekaf2.h"
+#include "../kformat.h"
+#include "../ksystem.h"
+#include <algorithm>
+
+namespace dekaf2
+{
+
+namespace {
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// the ring buffer of the current thread, marks it closed at thread exit
+struct ThreadRingBuffer
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	~ThreadRingBuffer()
+	{
+		Close();
+	}
+
+	void Close()
+	{
+		if (RingBuffer)
+		{
+			RingBuffer->m_bClosed.store(true, std::memory_order_release);
+		}
+	}
+
+	std::shared_ptr<KLogRingBuffer> RingBuffer;
+	uint64_t iInstance { 0 };
+
+}; // ThreadRingBuffer
+
+thread_local ThreadRingBuffer t_RingBuffer;
+
+// every queue instance gets a unique id, so that a thread notices if its
+// ring buffer belongs to a previous queue
+std::atomic<uint64_t> s_iQueueInstances { 0 };
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+KLogRingBuffer::KLogRingBuffer(std::size_t iCapacity)
+//---------------------------------------------------------------------------
+{
+	std::size_t iSize { 2 };
+
+	while (iSize < iCapacity)
+	{
+		iSize <<= 1;
+	}
+
+	m_Records.resize(iSize);
+	m_iMask = iSize - 1;
+
+} // ctor
+
+//---------------------------------------------------------------------------
+KLogAsyncQueue::KLogAsyncQueue(Output Out, std::size_t iRecordsPerThread, Overflow OverflowPolicy)
+//---------------------------------------------------------------------------
+: m_Output(std::move(Out))
+, m_iRecordsPerThread(iRecordsPerThread)
+, m_Overflow(OverflowPolicy)
+, m_iInstance(++s_iQueueInstances)
+, m_Thread(&KLogAsyncQueue::Run, this)
+{
+} // ctor
+
+//---------------------------------------------------------------------------
+KLogAsyncQueue::~KLogAsyncQueue()
+//---------------------------------------------------------------------------
+{
+	{
+		std::lock_guard<std::mutex> Lock(m_WaitMutex);
+		m_bStop = true;
+		m_WaitCondition.notify_one();
+	}
+
+	if (m_Thread.joinable())
+	{
+		m_Thread.join();
+	}
+
+} // dtor
+
+//---------------------------------------------------------------------------
+KLogRingBuffer* KLogAsyncQueue::GetRingBuffer()
+//---------------------------------------------------------------------------
+{
+	if (DEKAF2_UNLIKELY(t_RingBuffer.iInstance != m_iInstance))
+	{
+		// first log record of this thread for this queue
+		t_RingBuffer.Close();
+		t_RingBuffer.RingBuffer = std::make_shared<KLogRingBuffer>(m_iRecordsPerThread.load(std::memory_order_relaxed));
+		t_RingBuffer.iInstance  = m_iInstance;
+
+		std::lock_guard<std::mutex> Lock(m_RegistryMutex);
+		m_RingBuffers.push_back(t_RingBuffer.RingBuffer);
+	}
+
+	return t_RingBuffer.RingBuffer.get();
+
+} // GetRingBuffer
+
+//---------------------------------------------------------------------------
+bool KLogAsyncQueue::Push(int iLevel, KStringView sFunction, KStringView sMessage, KStringView sFormat, KStringView sArgs)
+//---------------------------------------------------------------------------
+{
+	auto RingBuffer = GetRingBuffer();
+	auto Record     = RingBuffer->GetFreeSlot();
+
+	if (DEKAF2_UNLIKELY(!Record))
+	{
+		if (m_Overflow.load(std::memory_order_relaxed) != Overflow::BLOCK)
+		{
+			m_iDropped.fetch_add(1, std::memory_order_relaxed);
+			Wakeup();
+			return false;
+		}
+
+		for (;;)
+		{
+			if (m_bStop)
+			{
+				// nobody will make room anymore
+				m_iDropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+
+			Wakeup();
+			std::this_thread::sleep_for(chrono::microseconds(50));
+
+			Record = RingBuffer->GetFreeSlot();
+
+			if (Record)
+			{
+				break;
+			}
+		}
+	}
+
+	// assign() reuses the capacity of the slot's strings
+	Record->sFunction.assign(sFunction.data(), sFunction.size());
+	Record->sMessage.assign(sMessage.data(), sMessage.size());
+	Record->sFormat.assign(sFormat.data(), sFormat.size());
+	Record->sArgs.assign(sArgs.data(), sArgs.size());
+	Record->Time   = Dekaf::getInstance().GetCurrentTime();
+	Record->Tid    = kGetTid();
+	Record->Pid    = kGetPid();
+	Record->iLevel = iLevel;
+
+	RingBuffer->Push();
+
+	if (m_bSleeping.load(std::memory_order_relaxed))
+	{
+		Wakeup();
+	}
+
+	return true;
+
+} // Push
+
+//---------------------------------------------------------------------------
+void KLogAsyncQueue::Wakeup()
+//---------------------------------------------------------------------------
+{
+	if (m_bSleeping.exchange(false))
+	{
+		std::lock_guard<std::mutex> Lock(m_WaitMutex);
+		m_WaitCondition.notify_one();
+	}
+
+} // Wakeup
+
+//---------------------------------------------------------------------------
+bool KLogAsyncQueue::Drain()
+//---------------------------------------------------------------------------
+{
+	std::lock_guard<std::mutex> DrainLock(m_DrainMutex);
+
+	std::vector<std::shared_ptr<KLogRingBuffer>> RingBuffers;
+
+	{
+		std::lock_guard<std::mutex> Lock(m_RegistryMutex);
+
+		// remove the buffers of ended threads once they are empty
+		m_RingBuffers.erase(std::remove_if(m_RingBuffers.begin(), m_RingBuffers.end(), [](const std::shared_ptr<KLogRingBuffer>& RingBuffer)
+		{
+			return RingBuffer->m_bClosed.load(std::memory_order_acquire) && !RingBuffer->Front();
+		}), m_RingBuffers.end());
+
+		RingBuffers = m_RingBuffers;
+	}
+
+	bool bHadRecords { false };
+
+	for (auto& RingBuffer : RingBuffers)
+	{
+		// take at most one buffer's capacity from each thread per round,
+		// so that one busy thread cannot starve the others
+		for (auto iCount = RingBuffer->capacity(); iCount > 0; --iCount)
+		{
+			auto Record = RingBuffer->Front();
+
+			if (!Record)
+			{
+				break;
+			}
+
+			bHadRecords = true;
+
+			try
+			{
+				m_Output(*Record);
+			}
+			catch (...)
+			{
+				// a failing writer must not stop the queue
+			}
+
+			RingBuffer->Pop();
+		}
+	}
+
+	auto iDropped = m_iDropped.load(std::memory_order_relaxed);
+
+	if (iDropped != m_iReportedDrops)
+	{
+		if (m_Overflow.load(std::memory_order_relaxed) == Overflow::DROP_AND_REPORT)
+		{
+			KLogRecord Report;
+			Report.iLevel    = -1;
+			Report.sFunction = "KLogAsyncQueue";
+			Report.sMessage  = kFormat("dropped {} log records because of full buffers", iDropped - m_iReportedDrops);
+			Report.Time      = Dekaf::getInstance().GetCurrentTime();
+			Report.Tid       = kGetTid();
+			Report.Pid       = kGetPid();
+
+			try
+			{
+				m_Output(Report);
+			}
+			catch (...)
+			{
+			}
+		}
+
+		m_iReportedDrops = iDropped;
+	}
+
+	return bHadRecords;
+
+} // Drain
+
+//---------------------------------------------------------------------------
+void KLogAsyncQueue::Flush()
+//---------------------------------------------------------------------------
+{
+	while (Drain()) {}
+
+} // Flush
+
+//---------------------------------------------------------------------------
+void KLogAsyncQueue::Run()
+//---------------------------------------------------------------------------
+{
+	while (!m_bStop)
+	{
+		if (!Drain())
+		{
+			std::unique_lock<std::mutex> Lock(m_WaitMutex);
+
+			m_bSleeping = true;
+
+			// a producer that pushed right before we set m_bSleeping did not
+			// wake us up - the timeout limits the latency for that case
+			m_WaitCondition.wait_for(Lock, chrono::milliseconds(20), [this]()
+			{
+				return !m_bSleeping || m_bStop;
+			});
+
+			m_bSleeping = false;
+		}
+	}
+
+	// write all what is left
+	Flush();
+
+} // Run
+
+} // end of namespace dekaf2
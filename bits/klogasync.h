@@ -0,0 +1,231 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#pragma once
+
+/// @file klogasync.h
+/// asynchronous backend for the logging framework: per-thread lock free ring
+/// buffers that are drained by one background thread
+
+#include "../kstring.h"
+#include "../kstringview.h"
+#include "../ktime.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dekaf2
+{
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// One raw, not yet serialized log record. The strings keep their capacity
+/// when a ring buffer slot gets reused, so that in steady state pushing a
+/// record does not allocate.
+struct DEKAF2_PRIVATE KLogRecord
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	KString     sFunction;
+	KString     sMessage;
+	/// if not empty, the record was not yet formatted: sFormat holds a copy
+	/// of the format string, and sArgs holds the encoded arguments
+	KString     sFormat;
+	KString     sArgs;
+	KUnixTime   Time { 0 };
+	uint64_t    Tid  { 0 };
+	pid_t       Pid  { 0 };
+	int         iLevel { 0 };
+
+}; // KLogRecord
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// Single producer / single consumer lock free ring buffer of log records.
+/// The producer is the thread owning the buffer, the consumer is the
+/// background thread of KLogAsyncQueue.
+class DEKAF2_PRIVATE KLogRingBuffer
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	/// construct with a capacity, which will be rounded up to the next power of two
+	KLogRingBuffer(std::size_t iCapacity);
+
+	/// producer: returns the next free slot, or nullptr if the buffer is full
+	KLogRecord* GetFreeSlot()
+	{
+		auto iHead = m_iHead.load(std::memory_order_relaxed);
+		if (iHead - m_iTail.load(std::memory_order_acquire) > m_iMask) return nullptr;
+		return &m_Records[iHead & m_iMask];
+	}
+
+	/// producer: publish the slot returned by GetFreeSlot()
+	void Push()
+	{
+		m_iHead.store(m_iHead.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/// consumer: returns the oldest record, or nullptr if the buffer is empty
+	const KLogRecord* Front() const
+	{
+		auto iTail = m_iTail.load(std::memory_order_relaxed);
+		if (iTail == m_iHead.load(std::memory_order_acquire)) return nullptr;
+		return &m_Records[iTail & m_iMask];
+	}
+
+	/// consumer: release the record returned by Front()
+	void Pop()
+	{
+		m_iTail.store(m_iTail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/// returns the capacity of the buffer
+	std::size_t capacity() const { return m_Records.size(); }
+
+	/// set by the producer when its thread ends
+	std::atomic<bool> m_bClosed { false };
+
+//----------
+private:
+//----------
+
+	std::vector<KLogRecord>  m_Records;
+	std::size_t              m_iMask;
+	// keep head and tail on separate cache lines
+	alignas(64) std::atomic<std::size_t> m_iHead { 0 };
+	alignas(64) std::atomic<std::size_t> m_iTail { 0 };
+
+}; // KLogRingBuffer
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// Collects log records from any number of threads without a common lock,
+/// and hands them over to an output callback that is called from one single
+/// background thread. Each producing thread gets its own ring buffer on
+/// its first push.
+class DEKAF2_PRIVATE KLogAsyncQueue
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	/// what to do when the ring buffer of a thread is full
+	enum class Overflow
+	{
+		BLOCK,           ///< wait until the background thread made room
+		DROP,            ///< drop the record, only count it
+		DROP_AND_REPORT  ///< drop the record, and log the count of dropped records
+	};
+
+	/// the output callback, always called from one thread only
+	using Output = std::function<void(const KLogRecord&)>;
+
+	/// construct and start the background thread
+	/// @param Out the output callback
+	/// @param iRecordsPerThread the capacity of each thread's ring buffer
+	/// @param OverflowPolicy what to do when a ring buffer is full
+	KLogAsyncQueue(Output Out, std::size_t iRecordsPerThread, Overflow OverflowPolicy);
+	/// stops the background thread after writing all pending records
+	~KLogAsyncQueue();
+
+	/// push a log record into the calling thread's ring buffer
+	/// @return false if the record was dropped
+	bool Push(int iLevel, KStringView sFunction, KStringView sMessage)
+	{
+		return Push(iLevel, sFunction, sMessage, KStringView{}, KStringView{});
+	}
+
+	/// push a log record with a static format string and encoded arguments
+	/// into the calling thread's ring buffer - the formatting is done by the
+	/// output callback
+	/// @return false if the record was dropped
+	bool PushDeferred(int iLevel, KStringView sFunction, KStringView sFormat, KStringView sArgs)
+	{
+		return Push(iLevel, sFunction, KStringView{}, sFormat, sArgs);
+	}
+
+	/// synchronously write all pending records, returns when done
+	void Flush();
+
+	/// returns the count of dropped records since construction
+	std::size_t GetDropped() const { return m_iDropped.load(std::memory_order_relaxed); }
+
+	/// set the overflow policy
+	void SetOverflow(Overflow OverflowPolicy) { m_Overflow.store(OverflowPolicy, std::memory_order_relaxed); }
+
+	/// set the capacity of ring buffers for threads that did not yet log
+	void SetRecordsPerThread(std::size_t iRecordsPerThread) { m_iRecordsPerThread.store(iRecordsPerThread, std::memory_order_relaxed); }
+
+//----------
+private:
+//----------
+
+	bool Push(int iLevel, KStringView sFunction, KStringView sMessage, KStringView sFormat, KStringView sArgs);
+	KLogRingBuffer* GetRingBuffer();
+	bool Drain();
+	void Wakeup();
+	void Run();
+
+	Output                                       m_Output;
+	std::mutex                                   m_RegistryMutex;
+	std::vector<std::shared_ptr<KLogRingBuffer>> m_RingBuffers;
+	std::mutex                                   m_DrainMutex;
+	std::mutex                                   m_WaitMutex;
+	std::condition_variable                      m_WaitCondition;
+	std::atomic<std::size_t>                     m_iRecordsPerThread;
+	std::atomic<std::size_t>                     m_iDropped { 0 };
+	std::size_t                                  m_iReportedDrops { 0 };
+	std::atomic<Overflow>                        m_Overflow;
+	uint64_t                                     m_iInstance;
+	std::atomic<bool>                            m_bSleeping { false };
+	std::atomic<bool>                            m_bStop { false };
+	// the thread needs to be constructed last
+	std::thread                                  m_Thread;
+
+}; // KLogAsyncQueue
+
+} // end of namespace dekaf2
@@ -0,0 +1,446 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#include "klogbinary.h"
+#include "klogasync.h"
+#include "../kformat.h"
+#include "../kfilesystem.h"
+#include <cstring>
+#include <vector>
+
+namespace dekaf2
+{
+
+namespace {
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// one decoded argument
+struct DecodedArg
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	KLogBinaryArgs::Tag Tag { KLogBinaryArgs::NONE };
+	union
+	{
+		bool     bValue;
+		char     chValue;
+		int64_t  iValue;
+		uint64_t uValue;
+		float    fValue;
+		double   dValue;
+	};
+	KStringView sValue;
+
+}; // DecodedArg
+
+//-----------------------------------------------------------------------------
+template<class T>
+bool ReadRaw(KStringView& sArgs, T& value)
+//-----------------------------------------------------------------------------
+{
+	if (sArgs.size() < sizeof(T))
+	{
+		return false;
+	}
+
+	std::memcpy(&value, sArgs.data(), sizeof(T));
+	sArgs.remove_prefix(sizeof(T));
+
+	return true;
+
+} // ReadRaw
+
+//-----------------------------------------------------------------------------
+bool Decode(KStringView sArgs, std::vector<DecodedArg>& Args)
+//-----------------------------------------------------------------------------
+{
+	while (!sArgs.empty())
+	{
+		DecodedArg Arg;
+		Arg.Tag = static_cast<KLogBinaryArgs::Tag>(sArgs.front());
+		sArgs.remove_prefix(1);
+
+		switch (Arg.Tag)
+		{
+			case KLogBinaryArgs::BOOL:
+			case KLogBinaryArgs::CHAR:
+				if (sArgs.empty()) return false;
+				if (Arg.Tag == KLogBinaryArgs::BOOL) Arg.bValue = sArgs.front() != 0;
+				else Arg.chValue = sArgs.front();
+				sArgs.remove_prefix(1);
+				break;
+
+			case KLogBinaryArgs::INT:
+				if (!ReadRaw(sArgs, Arg.iValue)) return false;
+				break;
+
+			case KLogBinaryArgs::UINT:
+				if (!ReadRaw(sArgs, Arg.uValue)) return false;
+				break;
+
+			case KLogBinaryArgs::FLOAT:
+				if (!ReadRaw(sArgs, Arg.fValue)) return false;
+				break;
+
+			case KLogBinaryArgs::DOUBLE:
+				if (!ReadRaw(sArgs, Arg.dValue)) return false;
+				break;
+
+			case KLogBinaryArgs::STRING:
+			{
+				uint32_t iSize;
+				if (!ReadRaw(sArgs, iSize) || sArgs.size() < iSize) return false;
+				Arg.sValue = sArgs.substr(0, iSize);
+				sArgs.remove_prefix(iSize);
+				break;
+			}
+
+			default:
+				return false;
+		}
+
+		Args.push_back(Arg);
+	}
+
+	return true;
+
+} // Decode
+
+//-----------------------------------------------------------------------------
+KString FormatOne(KStringView sSpec, const DecodedArg& Arg)
+//-----------------------------------------------------------------------------
+{
+	KString sFormat = "{";
+
+	if (!sSpec.empty())
+	{
+		sFormat += ':';
+		sFormat += sSpec;
+	}
+
+	sFormat += '}';
+
+	switch (Arg.Tag)
+	{
+		case KLogBinaryArgs::BOOL:   return kFormat(sFormat, Arg.bValue);
+		case KLogBinaryArgs::CHAR:   return kFormat(sFormat, Arg.chValue);
+		case KLogBinaryArgs::INT:    return kFormat(sFormat, Arg.iValue);
+		case KLogBinaryArgs::UINT:   return kFormat(sFormat, Arg.uValue);
+		case KLogBinaryArgs::FLOAT:  return kFormat(sFormat, Arg.fValue);
+		case KLogBinaryArgs::DOUBLE: return kFormat(sFormat, Arg.dValue);
+		case KLogBinaryArgs::STRING: return kFormat(sFormat, Arg.sValue);
+		default:                     return {};
+	}
+
+} // FormatOne
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+KString KLogBinaryArgs::Format(KStringView sFormat, KStringView sArgs)
+//-----------------------------------------------------------------------------
+{
+	std::vector<DecodedArg> Args;
+
+	if (!Decode(sArgs, Args))
+	{
+		return kFormat("{} [damaged arguments]", sFormat);
+	}
+
+	// we expand each replacement field on its own, as a format_args
+	// object cannot be constructed from runtime types
+	KString sOut;
+	std::size_t iNextArg { 0 };
+
+	for (std::size_t iPos = 0; iPos < sFormat.size(); ++iPos)
+	{
+		auto ch = sFormat[iPos];
+
+		if (ch == '}')
+		{
+			// "}}" is an escaped brace
+			if (iPos + 1 < sFormat.size() && sFormat[iPos + 1] == '}') ++iPos;
+			sOut += '}';
+			continue;
+		}
+
+		if (ch != '{')
+		{
+			sOut += ch;
+			continue;
+		}
+
+		if (iPos + 1 < sFormat.size() && sFormat[iPos + 1] == '{')
+		{
+			// "{{" is an escaped brace
+			sOut += '{';
+			++iPos;
+			continue;
+		}
+
+		auto iEnd = sFormat.find('}', iPos + 1);
+
+		if (iEnd == KStringView::npos)
+		{
+			sOut += sFormat.substr(iPos);
+			break;
+		}
+
+		auto sField = sFormat.substr(iPos + 1, iEnd - iPos - 1);
+		auto iColon = sField.find(':');
+		auto sIndex = sField.substr(0, iColon);
+		auto sSpec  = (iColon == KStringView::npos) ? KStringView{} : sField.substr(iColon + 1);
+
+		std::size_t iArg = sIndex.empty() ? iNextArg++ : sIndex.UInt32();
+
+		if (iArg >= Args.size() || sSpec.contains('{'))
+		{
+			// no such argument, or nested replacement fields - output verbatim
+			sOut += sFormat.substr(iPos, iEnd - iPos + 1);
+		}
+		else
+		{
+			sOut += FormatOne(sSpec, Args[iArg]);
+		}
+
+		iPos = iEnd;
+	}
+
+	return sOut;
+
+} // Format
+
+#ifdef DEKAF2_REPEAT_CONSTEXPR_VARIABLE
+constexpr KStringView KLogBinaryFileWriter::MAGIC;
+#endif
+
+//-----------------------------------------------------------------------------
+KLogBinaryFileWriter::KLogBinaryFileWriter(KStringViewZ sFileName, KStringView sShortName, KStringView sPathName)
+//-----------------------------------------------------------------------------
+: m_OutFile(sFileName, std::ios::app | std::ios::binary)
+{
+	if (m_OutFile.is_open())
+	{
+		if (kFileSize(sFileName) == 0)
+		{
+			m_OutFile.Write(MAGIC);
+		}
+
+		// the names may change from one writer to the next
+		m_OutFile.Write('N');
+		WriteString(sShortName);
+		WriteString(sPathName);
+		m_OutFile.Flush();
+	}
+
+} // ctor
+
+//-----------------------------------------------------------------------------
+void KLogBinaryFileWriter::WriteString(KStringView sString)
+//-----------------------------------------------------------------------------
+{
+	WriteRaw(static_cast<uint32_t>(sString.size()));
+	m_OutFile.Write(sString);
+
+} // WriteString
+
+//-----------------------------------------------------------------------------
+bool KLogBinaryFileWriter::Write(const KLogRecord& Record)
+//-----------------------------------------------------------------------------
+{
+	uint32_t iFormat { 0 };
+
+	if (!Record.sFormat.empty())
+	{
+		auto it = m_Formats.find(Record.sFormat);
+
+		if (it == m_Formats.end())
+		{
+			iFormat = static_cast<uint32_t>(m_Formats.size() + 1);
+			m_Formats.emplace(Record.sFormat, iFormat);
+			// define the format string before its first use
+			m_OutFile.Write('F');
+			WriteRaw(iFormat);
+			WriteString(Record.sFormat);
+		}
+		else
+		{
+			iFormat = it->second;
+		}
+	}
+
+	m_OutFile.Write('R');
+	WriteRaw(static_cast<int32_t>(Record.iLevel));
+	WriteRaw(static_cast<int32_t>(Record.Pid));
+	WriteRaw(static_cast<uint64_t>(Record.Tid));
+	WriteRaw(static_cast<int64_t>(chrono::duration_cast<chrono::microseconds>(Record.Time.time_since_epoch()).count()));
+	WriteRaw(iFormat);
+	WriteString(Record.sFunction);
+	// either the encoded arguments or the formatted message
+	WriteString(iFormat ? KStringView(Record.sArgs) : KStringView(Record.sMessage));
+
+	return m_OutFile.Flush().Good();
+
+} // Write
+
+//-----------------------------------------------------------------------------
+KLogBinaryFileReader::KLogBinaryFileReader(KStringViewZ sFileName)
+//-----------------------------------------------------------------------------
+: m_InFile(sFileName, std::ios::in | std::ios::binary)
+{
+	KString sMagic;
+
+	m_bGood = m_InFile.is_open()
+	       && m_InFile.Read(sMagic, KLogBinaryFileWriter::MAGIC.size()) == KLogBinaryFileWriter::MAGIC.size()
+	       && sMagic == KLogBinaryFileWriter::MAGIC;
+
+} // ctor
+
+//-----------------------------------------------------------------------------
+bool KLogBinaryFileReader::ReadString(KStringRef& sString)
+//-----------------------------------------------------------------------------
+{
+	uint32_t iSize;
+
+	if (!ReadRaw(iSize))
+	{
+		return false;
+	}
+
+	sString.clear();
+
+	return m_InFile.Read(sString, iSize) == iSize;
+
+} // ReadString
+
+//-----------------------------------------------------------------------------
+bool KLogBinaryFileReader::Next(Entry& entry)
+//-----------------------------------------------------------------------------
+{
+	if (!m_bGood)
+	{
+		return false;
+	}
+
+	for (;;)
+	{
+		char chType;
+
+		if (!ReadRaw(chType))
+		{
+			return false;
+		}
+
+		switch (chType)
+		{
+			case 'N':
+				if (!ReadString(m_sShortName) || !ReadString(m_sPathName))
+				{
+					return m_bGood = false;
+				}
+				// a new writer starts a new format id sequence
+				m_Formats.clear();
+				break;
+
+			case 'F':
+			{
+				uint32_t iFormat;
+				KString  sFormat;
+
+				if (!ReadRaw(iFormat) || !ReadString(sFormat))
+				{
+					return m_bGood = false;
+				}
+
+				m_Formats[iFormat] = std::move(sFormat);
+				break;
+			}
+
+			case 'R':
+			{
+				int32_t  iLevel;
+				int32_t  iPid;
+				uint64_t iTid;
+				int64_t  iTime;
+				uint32_t iFormat;
+				KString  sData;
+
+				if (!ReadRaw(iLevel) || !ReadRaw(iPid) || !ReadRaw(iTid) || !ReadRaw(iTime)
+					|| !ReadRaw(iFormat) || !ReadString(entry.sFunction) || !ReadString(sData))
+				{
+					return m_bGood = false;
+				}
+
+				entry.iLevel     = iLevel;
+				entry.Pid        = iPid;
+				entry.Tid        = iTid;
+				entry.Time       = KUnixTime(chrono::microseconds(iTime));
+				entry.sShortName = m_sShortName;
+				entry.sPathName  = m_sPathName;
+
+				if (iFormat)
+				{
+					auto it = m_Formats.find(iFormat);
+
+					if (it == m_Formats.end())
+					{
+						entry.sMessage = kFormat("[unknown format id {}]", iFormat);
+					}
+					else
+					{
+						entry.sMessage = KLogBinaryArgs::Format(it->second, sData);
+					}
+				}
+				else
+				{
+					entry.sMessage = std::move(sData);
+				}
+
+				return true;
+			}
+
+			default:
+				return m_bGood = false;
+		}
+	}
+
+} // Next
+
+} // end of namespace dekaf2
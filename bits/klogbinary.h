@@ -0,0 +1,156 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#pragma once
+
+/// @file klogbinary.h
+/// binary log files with deferred formatting
+
+#include "klogbinaryargs.h"
+#include "../kstring.h"
+#include "../kstringview.h"
+#include "../ktime.h"
+#include "../kwriter.h"
+#include "../kreader.h"
+#include <unordered_map>
+
+namespace dekaf2
+{
+
+struct KLogRecord;
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// Writes raw log records into a binary log file. Deferred format strings are
+/// written only once per file, and referenced by an id afterwards. Numbers
+/// are written in host byte order.
+class DEKAF2_PUBLIC KLogBinaryFileWriter
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	/// the magic bytes at the start of each binary log file
+	static constexpr KStringView MAGIC = "KLOGBIN1";
+
+	/// open sFileName for appending, and record the program names
+	KLogBinaryFileWriter(KStringViewZ sFileName, KStringView sShortName, KStringView sPathName);
+
+	/// write one record
+	bool Write(const KLogRecord& Record);
+
+	/// returns true if the file is writable
+	bool Good() const { return m_OutFile.Good(); }
+
+//----------
+private:
+//----------
+
+	void WriteString(KStringView sString);
+
+	template<class T>
+	void WriteRaw(T value)
+	{
+		m_OutFile.Write(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+
+	KOutFile m_OutFile;
+	// the records carry copies of the format strings in reused ring buffer
+	// slots, therefore the content, not the address, identifies a format
+	std::unordered_map<KString, uint32_t> m_Formats;
+
+}; // KLogBinaryFileWriter
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// Reads a binary log file written by KLogBinaryFileWriter, and expands the
+/// deferred format strings
+class DEKAF2_PUBLIC KLogBinaryFileReader
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	/// one decoded log record
+	struct Entry
+	{
+		KString   sShortName;
+		KString   sPathName;
+		KString   sFunction;
+		KString   sMessage;
+		KUnixTime Time { 0 };
+		uint64_t  Tid  { 0 };
+		pid_t     Pid  { 0 };
+		int       iLevel { 0 };
+	};
+
+	/// open sFileName for reading
+	KLogBinaryFileReader(KStringViewZ sFileName);
+
+	/// returns true if the file could be opened and has the right magic bytes
+	bool Good() const { return m_bGood; }
+
+	/// read the next record, returns false at end of file or on a damaged file
+	bool Next(Entry& entry);
+
+//----------
+private:
+//----------
+
+	bool ReadString(KStringRef& sString);
+
+	template<class T>
+	bool ReadRaw(T& value)
+	{
+		return m_InFile.Read(reinterpret_cast<char*>(&value), sizeof(value)) == sizeof(value);
+	}
+
+	KInFile m_InFile;
+	std::unordered_map<uint32_t, KString> m_Formats;
+	KString m_sShortName;
+	KString m_sPathName;
+	bool m_bGood { false };
+
+}; // KLogBinaryFileReader
+
+} // end of namespace dekaf2
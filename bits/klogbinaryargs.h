@@ -0,0 +1,221 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#pragma once
+
+/// @file klogbinaryargs.h
+/// compact binary encoding of log format arguments for deferred formatting
+
+#include "../kstring.h"
+#include "../kstringview.h"
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace dekaf2
+{
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// Encodes the arguments of a log format call into a compact binary buffer,
+/// and expands them later with the format string. Strings are copied,
+/// arithmetic values are stored raw. Only types that can be stored without
+/// loss of formatting semantics are accepted, see IsEncodable() - enums and
+/// other types with their own formatter are formatted synchronously.
+class DEKAF2_PUBLIC KLogBinaryArgs
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	/// type tags of the binary encoding
+	enum Tag : char
+	{
+		NONE   = 0,
+		BOOL   = 'b',
+		CHAR   = 'c',
+		INT    = 'i',
+		UINT   = 'u',
+		FLOAT  = 'f',
+		DOUBLE = 'd',
+		STRING = 's'
+	};
+
+	//---------------------------------------------------------------------------
+	/// returns the encoding tag for type T, or NONE if T cannot be encoded
+	template<class T>
+	static constexpr Tag GetTag()
+	//---------------------------------------------------------------------------
+	{
+		using D = typename std::decay<T>::type;
+
+		if constexpr (std::is_same<D, bool>::value)
+		{
+			return BOOL;
+		}
+		else if constexpr (std::is_same<D, char>::value)
+		{
+			return CHAR;
+		}
+		else if constexpr (std::is_enum<D>::value)
+		{
+			// enums may have their own formatter
+			return NONE;
+		}
+		else if constexpr (std::is_same<D, wchar_t>::value  ||
+		                   std::is_same<D, char16_t>::value ||
+		                   std::is_same<D, char32_t>::value)
+		{
+			return NONE;
+		}
+		else if constexpr (std::is_integral<D>::value)
+		{
+			return std::is_signed<D>::value ? INT : UINT;
+		}
+		else if constexpr (std::is_same<D, float>::value)
+		{
+			// a float widened to double would print with more digits
+			return FLOAT;
+		}
+		else if constexpr (std::is_same<D, double>::value)
+		{
+			return DOUBLE;
+		}
+		else if constexpr (std::is_same<D, const char*>::value      ||
+		                   std::is_same<D, char*>::value            ||
+		                   std::is_same<D, KString>::value          ||
+		                   std::is_same<D, KStringView>::value      ||
+		                   std::is_same<D, KStringViewZ>::value     ||
+		                   std::is_same<D, std::string>::value      ||
+		                   std::is_same<D, std::string_view>::value)
+		{
+			return STRING;
+		}
+		else
+		{
+			return NONE;
+		}
+	}
+
+	//---------------------------------------------------------------------------
+	/// returns true if all types in Args can be encoded
+	template<class... Args>
+	static constexpr bool IsEncodable()
+	//---------------------------------------------------------------------------
+	{
+		return ((GetTag<Args>() != NONE) && ...);
+	}
+
+	//---------------------------------------------------------------------------
+	/// append the encoded args to sBuffer - only call if IsEncodable<Args...>() is true
+	template<class... Args>
+	static void Encode(KStringRef& sBuffer, const Args&... args)
+	//---------------------------------------------------------------------------
+	{
+		(EncodeOne(sBuffer, args), ...);
+	}
+
+	//---------------------------------------------------------------------------
+	/// expand the format string sFormat with the arguments encoded in sArgs
+	static KString Format(KStringView sFormat, KStringView sArgs);
+	//---------------------------------------------------------------------------
+
+//----------
+private:
+//----------
+
+	template<class T>
+	static void AppendRaw(KStringRef& sBuffer, Tag tag, T value)
+	{
+		sBuffer += static_cast<char>(tag);
+		sBuffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+
+	static void AppendString(KStringRef& sBuffer, KStringView sValue)
+	{
+		AppendRaw(sBuffer, STRING, static_cast<uint32_t>(sValue.size()));
+		sBuffer.append(sValue.data(), sValue.size());
+	}
+
+	template<class T>
+	static void EncodeOne(KStringRef& sBuffer, const T& value)
+	{
+		constexpr Tag tag = GetTag<T>();
+
+		if constexpr (tag == BOOL || tag == CHAR)
+		{
+			sBuffer += static_cast<char>(tag);
+			sBuffer += static_cast<char>(value);
+		}
+		else if constexpr (tag == INT)
+		{
+			AppendRaw(sBuffer, tag, static_cast<int64_t>(value));
+		}
+		else if constexpr (tag == UINT)
+		{
+			AppendRaw(sBuffer, tag, static_cast<uint64_t>(value));
+		}
+		else if constexpr (tag == FLOAT)
+		{
+			AppendRaw(sBuffer, tag, static_cast<float>(value));
+		}
+		else if constexpr (tag == DOUBLE)
+		{
+			AppendRaw(sBuffer, tag, static_cast<double>(value));
+		}
+		else if constexpr (std::is_array<T>::value)
+		{
+			AppendString(sBuffer, KStringView(value));
+		}
+		else if constexpr (std::is_pointer<typename std::decay<T>::type>::value)
+		{
+			AppendString(sBuffer, value ? KStringView(value) : KStringView());
+		}
+		else
+		{
+			AppendString(sBuffer, KStringView(value.data(), value.size()));
+		}
+	}
+
+}; // KLogBinaryArgs
+
+} // end of namespace dekaf2
@@ -78,6 +78,14 @@ public:
 	{
 		m_sBacktrace = sBacktrace;
 	}
+	/// overwrite process id, thread id and time set by Set() - used when
+	/// serializing a record that was created earlier by another thread
+	void SetOrigin(pid_t Pid, uint64_t Tid, KUnixTime Time)
+	{
+		m_Pid  = Pid;
+		m_Tid  = Tid;
+		m_Time = Time;
+	}
 	int GetLevel() const
 	{
 		return m_iLevel;
@@ -116,6 +124,8 @@ public:
 	virtual operator KStringView();
 	virtual void Set(int iLevel, KStringView sShortName, KStringView sPathName, KStringView sFunction, KStringView sMessage) override;
 	bool IsMultiline() const { return m_bIsMultiline; }
+	/// returns true if the records are serialized as JSON objects
+	virtual bool IsJSON() const { return false; }
 	/// returns true if either function name or message contain or do not contain (bInverted)
 	/// the grep expression
 	bool Matches(bool bEgrep, bool bInverted, KStringView sGrepExpression);
@@ -207,6 +217,12 @@ class DEKAF2_PUBLIC KLogJSONSerializer : public KLogSerializer
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 {
 
+//----------
+public:
+//----------
+
+	virtual bool IsJSON() const override { return true; }
+
 //----------
 protected:
 //----------
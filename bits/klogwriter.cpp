@@ -61,6 +61,12 @@
 	#include "../kconnection.h"
 	#include "../kmime.h"
 	#include "../khttp_header.h" // for LogToRESTResponse()
+	#include "../khttpcompression.h"
+	#include "../kcompression.h"
+	#include "../kreader.h"
+	#include "../ksystem.h"
+	#include "../klog.h"
+	#include <algorithm>
 #endif
 
 namespace dekaf2
@@ -187,10 +193,278 @@ bool KLogSyslogWriter::Write(int iLevel, bool bIsMultiline, KStringViewZ sOut)
 
 #ifdef DEKAF2_KLOG_WITH_TCP
 
+namespace {
+
+//---------------------------------------------------------------------------
+/// returns the size of the leading records of sRecords that fit into iMaxSize,
+/// but at least the size of the first record
+std::size_t LeadingRecords(KStringView sRecords, std::size_t iMaxSize)
+//---------------------------------------------------------------------------
+{
+	if (sRecords.size() <= iMaxSize)
+	{
+		return sRecords.size();
+	}
+
+	// cut at a record boundary
+	auto iPos = sRecords.rfind('\n', iMaxSize - 1);
+
+	if (iPos == KStringView::npos)
+	{
+		// a single record larger than iMaxSize
+		iPos = sRecords.find('\n');
+	}
+
+	return (iPos == KStringView::npos) ? sRecords.size() : iPos + 1;
+
+} // LeadingRecords
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+KLogBatchShipper::KLogBatchShipper(KStringView sURL, ShipFunc Ship, Options Opts)
+//---------------------------------------------------------------------------
+    : m_Ship(std::move(Ship))
+	, m_Options(std::move(Opts))
+{
+	if (m_Options.sSpillFile.empty())
+	{
+		// each process needs its own spill file, as they would otherwise
+		// ship and remove each other's records
+		m_Options.sSpillFile = kFormat("{}/klog-{:x}-{}.spill", kGetTemp(), sURL.Hash(), kGetPid());
+	}
+
+	// a previous run may have left records that it could not ship
+	auto iSpilled = kFileSize(m_Options.sSpillFile);
+	m_bHaveSpill  = iSpilled != npos && iSpilled > 0;
+
+	m_Thread = std::thread(&KLogBatchShipper::Run, this);
+
+} // ctor
+
+//---------------------------------------------------------------------------
+KLogBatchShipper::~KLogBatchShipper()
+//---------------------------------------------------------------------------
+{
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_bStop = true;
+	}
+
+	m_NewRecords.notify_one();
+
+	if (m_Thread.joinable())
+	{
+		// ships the last batch
+		m_Thread.join();
+	}
+
+} // dtor
+
+//---------------------------------------------------------------------------
+bool KLogBatchShipper::Add(KStringView sRecord)
+//---------------------------------------------------------------------------
+{
+	if (sRecord.empty())
+	{
+		return true;
+	}
+
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+
+	if (m_sBatch.size() >= m_Options.iMaxBuffered)
+	{
+		// the shipping thread does not keep up
+		m_iDropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	bool bWasEmpty = m_sBatch.empty();
+
+	if (bWasEmpty)
+	{
+		m_FirstRecord = std::chrono::steady_clock::now();
+	}
+
+	m_sBatch += sRecord;
+
+	if (sRecord.back() != '\n')
+	{
+		m_sBatch += '\n';
+	}
+
+	++m_iAdded;
+
+	// only wake up the shipping thread when it has to start its delay
+	// timer or when the batch is full
+	bool bNotify = bWasEmpty || m_sBatch.size() >= m_Options.iMaxBatchSize;
+
+	Lock.unlock();
+
+	if (bNotify)
+	{
+		m_NewRecords.notify_one();
+	}
+
+	return true;
+
+} // Add
+
+//---------------------------------------------------------------------------
+bool KLogBatchShipper::Flush()
+//---------------------------------------------------------------------------
+{
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+
+	auto iAdded = m_iAdded;
+
+	if (m_iShipped < iAdded)
+	{
+		m_bFlush = true;
+		m_NewRecords.notify_one();
+
+		if (!m_Shipped.wait_for(Lock, m_Options.FlushTimeout, [&]() { return m_iShipped >= iAdded; }))
+		{
+			// the collector is slow - the records are still shipped in the background
+			return false;
+		}
+	}
+
+	return m_bLastOK;
+
+} // Flush
+
+//---------------------------------------------------------------------------
+void KLogBatchShipper::Run()
+//---------------------------------------------------------------------------
+{
+	// the network classes log themselves - in this thread that output would
+	// be added to the next batch, and create new output when shipping it
+	KLog::PreventRecursion PR;
+
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+
+	for (;;)
+	{
+		m_NewRecords.wait(Lock, [this]()
+		{
+			return m_bStop || m_bFlush || !m_sBatch.empty();
+		});
+
+		if (!m_bStop && !m_bFlush)
+		{
+			m_NewRecords.wait_until(Lock, m_FirstRecord + m_Options.MaxDelay, [this]()
+			{
+				return m_bStop || m_bFlush || m_sBatch.size() >= m_Options.iMaxBatchSize;
+			});
+		}
+
+		KString sBatch;
+		sBatch.swap(m_sBatch);
+		auto iAdded = m_iAdded;
+		auto bStop  = m_bStop;
+		m_bFlush    = false;
+
+		// ship without holding the lock, so that new records can be added
+		Lock.unlock();
+
+		bool bOK = sBatch.empty() || Ship(sBatch);
+
+		Lock.lock();
+
+		m_bLastOK  = bOK;
+		m_iShipped = iAdded;
+		m_Shipped.notify_all();
+
+		if (bStop && m_sBatch.empty())
+		{
+			break;
+		}
+	}
+
+} // Run
+
+//---------------------------------------------------------------------------
+bool KLogBatchShipper::Ship(KStringView sBatch)
+//---------------------------------------------------------------------------
+{
+	// spilled records are older, they have to be shipped first
+	std::size_t iShipped = (!m_bHaveSpill || ShipSpillFile()) ? m_Ship(sBatch) : 0;
+
+	if (iShipped >= sBatch.size())
+	{
+		return true;
+	}
+
+	// only spill what was not yet shipped
+	Spill(sBatch.substr(iShipped));
+
+	return false;
+
+} // Ship
+
+//---------------------------------------------------------------------------
+bool KLogBatchShipper::ShipSpillFile()
+//---------------------------------------------------------------------------
+{
+	KString sSpilled = kReadAll(m_Options.sSpillFile);
+	KStringView sRemaining = sSpilled;
+
+	while (!sRemaining.empty())
+	{
+		auto iSize    = LeadingRecords(sRemaining, m_Options.iMaxBatchSize);
+		auto iShipped  = m_Ship(sRemaining.substr(0, iSize));
+
+		if (iShipped < iSize)
+		{
+			sRemaining.remove_prefix(iShipped);
+
+			if (sRemaining.size() != sSpilled.size())
+			{
+				// do not ship the same records twice
+				kWriteFile(m_Options.sSpillFile, sRemaining);
+			}
+
+			return false;
+		}
+
+		sRemaining.remove_prefix(iSize);
+	}
+
+	kRemoveFile(m_Options.sSpillFile);
+	m_bHaveSpill = false;
+
+	return true;
+
+} // ShipSpillFile
+
+//---------------------------------------------------------------------------
+void KLogBatchShipper::Spill(KStringView sBatch)
+//---------------------------------------------------------------------------
+{
+	std::size_t iSpilled = m_bHaveSpill ? kFileSize(m_Options.sSpillFile) : 0;
+
+	if (iSpilled == npos)
+	{
+		iSpilled = 0;
+	}
+
+	if (iSpilled + sBatch.size() > m_Options.iMaxSpillSize
+	    || !kAppendFile(m_Options.sSpillFile, sBatch))
+	{
+		m_iDropped.fetch_add(std::count(sBatch.begin(), sBatch.end(), '\n'), std::memory_order_relaxed);
+		return;
+	}
+
+	m_bHaveSpill = true;
+
+} // Spill
+
 //---------------------------------------------------------------------------
-KLogTCPWriter::KLogTCPWriter(KStringView sURL)
+KLogTCPWriter::KLogTCPWriter(KStringView sURL, KLogBatchShipper::Options Options)
 //---------------------------------------------------------------------------
     : m_sURL(sURL)
+	, m_Shipper(sURL, [this](KStringView sBatch) { return Ship(sBatch); }, std::move(Options))
 {
 } // ctor
 
@@ -204,9 +478,9 @@ KLogTCPWriter::~KLogTCPWriter()
 bool KLogTCPWriter::Good() const
 //---------------------------------------------------------------------------
 {
-	// this is special: we always return true if we have not (yet) created
-	// the tcp client
-	return !m_OutStream || m_OutStream->Good();
+	// this is special: records that cannot be shipped are spilled into a
+	// file and shipped later, therefore we always return true
+	return true;
 
 } // Good
 
@@ -214,7 +488,23 @@ bool KLogTCPWriter::Good() const
 bool KLogTCPWriter::Write(int iLevel, bool bIsMultiline, KStringViewZ sOut)
 //---------------------------------------------------------------------------
 {
-	if (!Good())
+	return m_Shipper.Add(sOut);
+
+} // Write
+
+//---------------------------------------------------------------------------
+bool KLogTCPWriter::Flush()
+//---------------------------------------------------------------------------
+{
+	return m_Shipper.Flush();
+
+} // Flush
+
+//---------------------------------------------------------------------------
+std::size_t KLogTCPWriter::Ship(KStringView sBatch)
+//---------------------------------------------------------------------------
+{
+	if (m_OutStream && !m_OutStream->Good())
 	{
 		// we try one reconnect should the connection have gone stale
 		m_OutStream.reset();
@@ -224,21 +514,81 @@ bool KLogTCPWriter::Write(int iLevel, bool bIsMultiline, KStringViewZ sOut)
 	{
 		m_OutStream = KConnection::Create(m_sURL);
 
-		if (!m_OutStream->Good())
+		if (!m_OutStream || !m_OutStream->Good())
 		{
-			return false;
+			m_OutStream.reset();
+			return 0;
 		}
 	}
 
-	return m_OutStream != nullptr
-	        && m_OutStream->Stream().Write(sOut).Flush().Good();
+	// write the batch in chunks of whole records, so that after a failed
+	// write only the records of the failed and the following chunks have
+	// to be spilled
+	static constexpr std::size_t iChunkSize = 16 * 1024;
 
-} // Write
+	std::size_t iShipped { 0 };
+
+	while (iShipped < sBatch.size())
+	{
+		auto sChunk = sBatch.substr(iShipped);
+		sChunk = sChunk.substr(0, LeadingRecords(sChunk, iChunkSize));
+
+		if (!m_OutStream->Stream().Write(sChunk).Flush().Good())
+		{
+			m_OutStream.reset();
+			break;
+		}
 
+		iShipped += sChunk.size();
+	}
+
+	return iShipped;
+
+} // Ship
+
+namespace {
+
+//---------------------------------------------------------------------------
+KCompressOStream::COMPRESSION ToStreamCompression(KHTTPCompression::COMP Compression)
 //---------------------------------------------------------------------------
-KLogHTTPWriter::KLogHTTPWriter(KStringView sURL)
+{
+	switch (Compression)
+	{
+		case KHTTPCompression::GZIP:
+			return KCompressOStream::GZIP;
+
+		case KHTTPCompression::ZLIB:
+			return KCompressOStream::ZLIB;
+
+		case KHTTPCompression::BZIP2:
+			return KCompressOStream::BZIP2;
+
+#ifdef DEKAF2_HAS_LIBZSTD
+		case KHTTPCompression::ZSTD:
+			return KCompressOStream::ZSTD;
+#endif
+#ifdef DEKAF2_HAS_LIBBROTLI
+		case KHTTPCompression::BROTLI:
+			return KCompressOStream::BROTLI;
+#endif
+#ifdef DEKAF2_HAS_LIBLZMA
+		case KHTTPCompression::XZ:
+			return KCompressOStream::LZMA;
+#endif
+		default:
+			return KCompressOStream::NONE;
+	}
+
+} // ToStreamCompression
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+KLogHTTPWriter::KLogHTTPWriter(KStringView sURL, KStringView sCompression, KLogBatchShipper::Options Options)
 //---------------------------------------------------------------------------
     : m_sURL(sURL)
+	, m_sCompression(KHTTPCompression::ToString(KHTTPCompression::FromString(sCompression)))
+	, m_Shipper(sURL, [this](KStringView sBatch) { return Ship(sBatch); }, std::move(Options))
 {
 } // ctor
 
@@ -252,9 +602,9 @@ KLogHTTPWriter::~KLogHTTPWriter()
 bool KLogHTTPWriter::Good() const
 //---------------------------------------------------------------------------
 {
-	// this is special: we always return true if we have not (yet) created
-	// the http client
-	return !m_OutStream || m_OutStream->Good();
+	// this is special: records that cannot be shipped are spilled into a
+	// file and shipped later, therefore we always return true
+	return true;
 
 } // Good
 
@@ -262,7 +612,23 @@ bool KLogHTTPWriter::Good() const
 bool KLogHTTPWriter::Write(int iLevel, bool bIsMultiline, KStringViewZ sOut)
 //---------------------------------------------------------------------------
 {
-	if (!Good())
+	return m_Shipper.Add(sOut);
+
+} // Write
+
+//---------------------------------------------------------------------------
+bool KLogHTTPWriter::Flush()
+//---------------------------------------------------------------------------
+{
+	return m_Shipper.Flush();
+
+} // Flush
+
+//---------------------------------------------------------------------------
+std::size_t KLogHTTPWriter::Ship(KStringView sBatch)
+//---------------------------------------------------------------------------
+{
+	if (m_OutStream && !m_OutStream->Good())
 	{
 		// we try one reconnect should the connection have gone stale
 		m_OutStream.reset();
@@ -271,18 +637,50 @@ bool KLogHTTPWriter::Write(int iLevel, bool bIsMultiline, KStringViewZ sOut)
 	if (!m_OutStream)
 	{
 		m_OutStream = std::make_unique<KWebClient>();
+		// we compress the batches ourselves, to send the right content length
+		m_OutStream->AllowCompression(false);
+	}
+
+	KString sBody;
+	KMIME   Mime;
+
+	if (m_bJSON)
+	{
+		// JSON records - serialized JSON never contains a raw newline, so
+		// the record separators can be turned into array separators
+		sBody.reserve(sBatch.size() + 1);
+		sBody += '[';
+		sBody += sBatch;
+		sBody.back() = ']';
+		std::replace(sBody.begin() + 1, sBody.end() - 1, '\n', ',');
+		Mime = KMIME::JSON;
+	}
+	else
+	{
+		sBody = sBatch;
+		Mime  = KMIME::TEXT_PLAIN;
+	}
 
-		if (!m_OutStream->Good())
+	if (!m_sCompression.empty())
+	{
+		KString sCompressed;
 		{
-			return false;
+			KCompressOStream Compressor(sCompressed, ToStreamCompression(KHTTPCompression::FromString(m_sCompression)));
+			Compressor.write(sBody.data(), sBody.size());
 		}
+		sBody = std::move(sCompressed);
+		m_OutStream->AddHeader(KHTTPHeader::CONTENT_ENCODING, m_sCompression);
 	}
 
-	m_OutStream->Post(m_sURL, sOut, KMIME::JSON);
+	m_OutStream->Post(m_sURL, sBody, Mime);
 
-	return m_OutStream->HttpSuccess();
+	auto iStatus = m_OutStream->GetStatusCode();
 
-} // Write
+	// a 4xx status means the collector rejected the batch - shipping it
+	// again would not help
+	return (m_OutStream->HttpSuccess() || (iStatus >= 400 && iStatus < 500)) ? sBatch.size() : 0;
+
+} // Ship
 
 //---------------------------------------------------------------------------
 KLogHTTPHeaderWriter::KLogHTTPHeaderWriter(KHTTPHeaders& HTTPHeaders, KStringView sHeader)
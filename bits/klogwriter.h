@@ -56,6 +56,12 @@
 
 #ifdef DEKAF2_KLOG_WITH_TCP
 	#include "../kjson.h"
+	#include <chrono>
+	#include <condition_variable>
+	#include <functional>
+	#include <mutex>
+	#include <thread>
+	#include <atomic>
 #endif
 
 namespace dekaf2
@@ -82,6 +88,10 @@ public:
 	virtual ~KLogWriter();
 	virtual bool Write(int iLevel, bool bIsMultiline, KStringViewZ sOut) = 0;
 	virtual bool Good() const = 0;
+	/// writes all buffered output, returns false if not all output could be delivered
+	virtual bool Flush() { return true; }
+	/// tells the writer if the serialized records are JSON objects
+	virtual void SetJSONRecords(bool bJSON) {}
 
 }; // KLogWriter
 
@@ -225,7 +235,87 @@ public:
 #ifdef DEKAF2_KLOG_WITH_TCP
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
-/// Logwriter that writes to any TCP endpoint
+/// Collects serialized log records and ships them in batches from a background
+/// thread, so that the logging thread never waits for the network. A batch is
+/// shipped once it reached its maximum size, or once its first record waited
+/// for the maximum delay. Records that cannot be shipped are appended to a
+/// spill file, which is shipped first as soon as the collector is reachable again.
+class DEKAF2_PUBLIC KLogBatchShipper
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	/// ships one batch of newline separated records, returns the count of bytes
+	/// that were shipped - less than the batch size if the collector could not
+	/// be reached
+	using ShipFunc = std::function<std::size_t(KStringView sBatch)>;
+
+	struct Options
+	{
+		/// ship a batch once it has reached this size in bytes
+		std::size_t iMaxBatchSize { 64 * 1024 };
+		/// ship a batch latest after this delay
+		std::chrono::milliseconds MaxDelay { 500 };
+		/// drop new records while this many bytes wait for shipping
+		std::size_t iMaxBuffered { 4 * 1024 * 1024 };
+		/// the file for batches that could not be shipped - if empty, a
+		/// name in the temp directory is derived from the collector's URL
+		/// and the process id
+		KString sSpillFile;
+		/// drop batches that would grow the spill file beyond this size
+		std::size_t iMaxSpillSize { 64 * 1024 * 1024 };
+		/// Flush() waits at most this long for the shipping
+		std::chrono::milliseconds FlushTimeout { 5000 };
+	};
+
+	KLogBatchShipper(KStringView sURL, ShipFunc Ship, Options Opts);
+	~KLogBatchShipper();
+
+	/// add one record to the current batch
+	bool Add(KStringView sRecord);
+	/// ship all records added so far, and wait until done - returns false
+	/// if records had to be spilled, or if shipping did not complete within
+	/// the flush timeout
+	bool Flush();
+	/// returns the count of records that were dropped because of full buffers
+	std::size_t GetDropped() const { return m_iDropped.load(std::memory_order_relaxed); }
+	/// returns the name of the spill file
+	const KString& GetSpillFile() const { return m_Options.sSpillFile; }
+
+//----------
+private:
+//----------
+
+	void Run();
+	bool Ship(KStringView sBatch);
+	bool ShipSpillFile();
+	void Spill(KStringView sBatch);
+
+	ShipFunc                              m_Ship;
+	Options                               m_Options;
+	std::mutex                            m_Mutex;
+	std::condition_variable               m_NewRecords;
+	std::condition_variable               m_Shipped;
+	KString                               m_sBatch;
+	std::chrono::steady_clock::time_point m_FirstRecord;
+	uint64_t                              m_iAdded     { 0 };
+	uint64_t                              m_iShipped   { 0 };
+	std::atomic<std::size_t>              m_iDropped   { 0 };
+	bool                                  m_bFlush     { false };
+	bool                                  m_bStop      { false };
+	bool                                  m_bLastOK    { true  };
+	bool                                  m_bHaveSpill { false };
+	// the thread has to be constructed last
+	std::thread                           m_Thread;
+
+}; // KLogBatchShipper
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// Logwriter that writes to any TCP endpoint - records are shipped in batches
+/// from a background thread
 class DEKAF2_PUBLIC KLogTCPWriter : public KLogWriter
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 {
@@ -234,22 +324,31 @@ class DEKAF2_PUBLIC KLogTCPWriter : public KLogWriter
 public:
 //----------
 
-	KLogTCPWriter(KStringView sURL);
+	KLogTCPWriter(KStringView sURL, KLogBatchShipper::Options Options = KLogBatchShipper::Options{});
 	virtual ~KLogTCPWriter();
 	virtual bool Write(int iLevel, bool bIsMultiline, KStringViewZ sOut) override;
 	virtual bool Good() const override;
+	virtual bool Flush() override;
+	/// returns the count of records that were dropped because of full buffers
+	std::size_t GetDropped() const { return m_Shipper.GetDropped(); }
 
 //----------
 protected:
 //----------
 
+	std::size_t Ship(KStringView sBatch);
+
 	std::unique_ptr<KConnection> m_OutStream;
 	KString m_sURL;
+	// the shipper has to be destructed first, it calls Ship()
+	KLogBatchShipper m_Shipper;
 
 }; // KLogTCPWriter
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
-/// Logwriter that writes to any TCP endpoint using the HTTP(s) protocol
+/// Logwriter that writes to any TCP endpoint using the HTTP(s) protocol - records
+/// are shipped in batches from a background thread, as a JSON array if the
+/// serializer creates JSON objects, or else as plain text lines
 class DEKAF2_PUBLIC KLogHTTPWriter : public KLogWriter
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 {
@@ -258,17 +357,34 @@ class DEKAF2_PUBLIC KLogHTTPWriter : public KLogWriter
 public:
 //----------
 
-	KLogHTTPWriter(KStringView sURL);
+	/// @param sURL the URL to POST the batches to
+	/// @param sCompression the content encoding for the batches, like "zstd" or "gzip"
+	/// - falls back to no compression if the encoding is not supported
+	/// @param Options the batching options
+	KLogHTTPWriter(KStringView sURL,
+	               KStringView sCompression = "zstd",
+	               KLogBatchShipper::Options Options = KLogBatchShipper::Options{});
 	virtual ~KLogHTTPWriter();
 	virtual bool Write(int iLevel, bool bIsMultiline, KStringViewZ sOut) override;
 	virtual bool Good() const override;
+	virtual bool Flush() override;
+	virtual void SetJSONRecords(bool bJSON) override { m_bJSON = bJSON; }
+	/// returns the count of records that were dropped because of full buffers
+	std::size_t GetDropped() const { return m_Shipper.GetDropped(); }
 
 //----------
 protected:
 //----------
 
+	std::size_t Ship(KStringView sBatch);
+
 	std::unique_ptr<KWebClient> m_OutStream;
 	KString m_sURL;
+	KString m_sCompression;
+	// set by the logging thread, read by the shipping thread
+	std::atomic<bool> m_bJSON { false };
+	// the shipper has to be destructed first, it calls Ship()
+	KLogBatchShipper m_Shipper;
 
 }; // KLogHTTPWriter
 
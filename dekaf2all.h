@@ -66,6 +66,7 @@
 #include "kchunkedtransfer.h"
 #include "kcompression.h"
 #include "kconnection.h"
+#include "kconnectionpool.h"
 #include "kcookie.h"
 #include "kcountingstreambuf.h"
 #include "kcrashexit.h"
@@ -132,6 +133,7 @@
 #include "kreader.h"
 #include "kregex.h"
 #include "kreplacer.h"
+#include "kresolvercache.h"
 #include "krest.h"
 #include "krestclient.h"
 #include "krestroute.h"
@@ -142,6 +144,7 @@
 #include "krsasign.h"
 #include "kscopeguard.h"
 #include "ksharedmemory.h"
+#include "ksharedmemorycache.h"
 #include "ksharedptr.h"
 #include "ksharedref.h"
 #include "ksignals.h"
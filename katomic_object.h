@@ -43,10 +43,12 @@
 #pragma once
 
 /// @file katomic_object.h
-/// generic atomic wrapping for larger objects through an atomic pointer - access on the object is read only,
-/// and updates must happen less frequent than maximum lifetime of the unwrapped object
+/// generic atomic wrapping for larger objects through an atomic pointer - access on the object is read only.
+/// Readers either hold a read guard, which makes updates safe at any frequency, or access the object
+/// unguarded, in which case updates must happen less frequent than maximum lifetime of the unwrapped object
 
 #include "kthreadsafe.h"
+#include "bits/kepochreclaim.h"
 #include <memory>
 #include <mutex>
 #include <atomic>
@@ -54,8 +56,10 @@
 namespace dekaf2 {
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
-/// generic atomic wrapping for larger objects through an atomic pointer - access on the object is read only,
-/// and updates must happen less frequent than maximum lifetime of the unwrapped object
+/// generic atomic wrapping for larger objects through an atomic pointer - access on the object is read only.
+/// Readers that hold a ReadGuard from read() may access their version of the object for any time, and
+/// updates may happen at any frequency - replaced objects are deleted once the last guard that may see them
+/// is gone. Unguarded access through get() or getRef() is only valid until the next but one reset().
 template<class Object>
 class KAtomicObject
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
@@ -105,8 +109,48 @@ public:
 	KAtomicObject& operator=(const KAtomicObject&) = delete;
 	KAtomicObject& operator=(KAtomicObject&&) = default;
 
+	//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	/// keeps the version of the object that was current at construction alive
+	/// for the lifetime of the guard - wait free, and does not allocate
+	class ReadGuard
+	//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	{
+
+	//----------
+	public:
+	//----------
+
+		explicit ReadGuard(const std::atomic<Object*>& pObject)
+		: m_pObject(pObject.load(std::memory_order_acquire)) // m_Guard is constructed first
+		{
+		}
+
+		ReadGuard(const ReadGuard&) = delete;
+		ReadGuard& operator=(const ReadGuard&) = delete;
+
+		const Object* get()        const { return m_pObject;  }
+		const Object* operator->() const { return m_pObject;  }
+		const Object& operator*()  const { return *m_pObject; }
+
+	//----------
+	private:
+	//----------
+
+		detail::KEpochReclaimer::Guard m_Guard;
+		const Object*                  m_pObject;
+
+	}; // ReadGuard
+
+	//-----------------------------------------------------------------------------
+	/// get a guarded read access on the current Object: auto Object = Atomic.read(); Object->..
+	ReadGuard read() const
+	//-----------------------------------------------------------------------------
+	{
+		return ReadGuard(m_pObject);
+	}
+
 	//-----------------------------------------------------------------------------
-	/// get pointer on Object
+	/// get pointer on Object - unguarded, see read() for a guarded access
 	const Object* get(bool bRelaxed = true) const
 	//-----------------------------------------------------------------------------
 	{
@@ -114,7 +158,7 @@ public:
 	}
 
 	//-----------------------------------------------------------------------------
-	/// get reference on Object
+	/// get reference on Object - unguarded, see read() for a guarded access
 	const Object& getRef(bool bRelaxed = true) const
 	//-----------------------------------------------------------------------------
 	{
@@ -141,11 +185,20 @@ public:
 	void reset(Args&&... args)
 	//-----------------------------------------------------------------------------
 	{
-		auto NewObject            = std::make_unique<Object>(std::forward<Args>(args)...);
-		auto Objects              = m_Objects.unique();
-		m_pObject                 = NewObject.get();
-		Objects->m_DecayingObject = std::move(Objects->m_ActiveObject);
-		Objects->m_ActiveObject   = std::move(NewObject);
+		auto NewObject = std::make_unique<Object>(std::forward<Args>(args)...);
+		std::unique_ptr<Object> ExpiredObject;
+
+		{
+			auto Objects              = m_Objects.unique();
+			m_pObject                 = NewObject.get();
+			ExpiredObject             = std::move(Objects->m_DecayingObject);
+			Objects->m_DecayingObject = std::move(Objects->m_ActiveObject);
+			Objects->m_ActiveObject   = std::move(NewObject);
+		}
+
+		// the expired object is no longer visible for unguarded readers, but
+		// read guards may still hold it
+		detail::KEpochReclaimer::Retire(ExpiredObject.release());
 
 	} // reset
 
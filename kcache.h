@@ -43,12 +43,30 @@
 #pragma once
 
 /// @file kcache.h
-/// a generic cache with LRU removal
+/// a generic cache with selectable removal strategy, expiry and cost limit, and a sharded
+/// cache with CLOCK removal
 
 #include "bits/kcppcompat.h"
+#include "bits/kcachemaps.h"
 #include "dekaf2.h"
 #include "ksharedref.h"
 #include "kmru.h"
+#include "kduration.h"
+#include "kthreadpool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 
 namespace dekaf2 {
@@ -65,34 +83,255 @@ struct LoadByConstruction
 	}
 };
 
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// The cost of a cache entry, which is added to a total while the entry
+/// exists. Entries are moved inside the maps, therefore only the last owner
+/// removes the cost from the total, on destruction.
+class KCacheCost
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	KCacheCost() = default;
+
+	//-----------------------------------------------------------------------------
+	KCacheCost(std::size_t iCost, std::size_t* pTotal) noexcept
+	//-----------------------------------------------------------------------------
+	: m_iCost(iCost)
+	, m_pTotal(pTotal)
+	{
+		*m_pTotal += m_iCost;
+	}
+
+	//-----------------------------------------------------------------------------
+	KCacheCost(KCacheCost&& other) noexcept
+	//-----------------------------------------------------------------------------
+	: m_iCost(other.m_iCost)
+	, m_pTotal(other.m_pTotal)
+	{
+		other.m_pTotal = nullptr;
+	}
+
+	//-----------------------------------------------------------------------------
+	KCacheCost& operator=(KCacheCost&& other) noexcept
+	//-----------------------------------------------------------------------------
+	{
+		if (this != &other)
+		{
+			Release();
+			m_iCost        = other.m_iCost;
+			m_pTotal       = other.m_pTotal;
+			other.m_pTotal = nullptr;
+		}
+
+		return *this;
+	}
+
+	//-----------------------------------------------------------------------------
+	~KCacheCost()
+	//-----------------------------------------------------------------------------
+	{
+		Release();
+	}
+
+	//-----------------------------------------------------------------------------
+	std::size_t get() const
+	//-----------------------------------------------------------------------------
+	{
+		return m_iCost;
+	}
+
+//----------
+private:
+//----------
+
+	//-----------------------------------------------------------------------------
+	void Release() noexcept
+	//-----------------------------------------------------------------------------
+	{
+		if (m_pTotal)
+		{
+			*m_pTotal -= m_iCost;
+			m_pTotal   = nullptr;
+		}
+	}
+
+	std::size_t  m_iCost  { 0 };
+	std::size_t* m_pTotal { nullptr };
+
+}; // KCacheCost
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// A cached value with its expiry time and cost
+template<class Value>
+struct KCacheEntry
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	using Clock = KStopTime::Clock;
+
+	//-----------------------------------------------------------------------------
+	template<class V, typename std::enable_if<!std::is_same<typename std::decay<V>::type, KCacheEntry>::value, int>::type = 0>
+	explicit KCacheEntry(V&& value)
+	//-----------------------------------------------------------------------------
+	: Data(std::forward<V>(value))
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	bool IsExpired(Clock::time_point tNow) const
+	//-----------------------------------------------------------------------------
+	{
+		return tNow >= tExpires;
+	}
+
+	//-----------------------------------------------------------------------------
+	bool IsExpired() const
+	//-----------------------------------------------------------------------------
+	{
+		// do not query the clock for entries without expiry
+		return tExpires != Clock::time_point::max() && IsExpired(Clock::now());
+	}
+
+	Value             Data;
+	Clock::time_point tExpires { Clock::time_point::max() };
+	KCacheCost        Cost;
+
+}; // KCacheEntry
+
 } // of namespace detail
 
+/// Cache removal policy: Least Recently Used. A hit moves the element to the
+/// front of a list. This is the default.
+struct KLRUPolicy
+{
+	template<class Key, class Value>
+	using map_type = KMRUMap<Key, Value>;
+};
+
+/// Cache removal policy: CLOCK. A hit only sets an access bit, and elements
+/// get a second chance if their bit is set when the clock hand passes.
+struct KClockPolicy
+{
+	template<class Key, class Value>
+	using map_type = detail::KClockMap<Key, Value>;
+};
+
+/// Cache removal policy: SIEVE. Like CLOCK, but new elements are queued in
+/// FIFO order, which removes elements that are only used once (scans) faster.
+struct KSievePolicy
+{
+	template<class Key, class Value>
+	using map_type = detail::KSieveMap<Key, Value>;
+};
+
+/// Cache removal policy: W-TinyLFU. New elements only replace old ones if they
+/// were requested more often, as estimated by a count-min sketch. Keeps popular
+/// elements when the cache is flooded with elements that are used only once.
+struct KTinyLFUPolicy
+{
+	template<class Key, class Value>
+	using map_type = detail::KTinyLFUMap<Key, Value>;
+};
+
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 /// Implements a generic cache.
-/// For cache size management it uses a Least Recently Used removal strategy.
+/// For cache size management it uses per default a Least Recently Used removal
+/// strategy. Other strategies can be selected with the Policy template argument:
+/// KClockPolicy, KSievePolicy, or KTinyLFUPolicy. Optionally, elements expire
+/// after a time to live, and the total cost of the elements (like their size in
+/// bytes) is limited.
 /// To load a new value per default it calls the constructor of Value() with
 /// the new Key, but you can also add a class with call operator Key to the
 /// template.
-template<class Key, class Value, class Load = detail::LoadByConstruction<Value> >
+template<class Key, class Value, class Load = detail::LoadByConstruction<Value>, class Policy = KLRUPolicy>
 class KCache
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 {
 
+//----------
+public:
+//----------
+
+	/// returns the cost of an element, e.g. its size in bytes
+	using CostFunction = std::function<std::size_t(const Key&, const Value&)>;
+
 //----------
 protected:
 //----------
 
-	using map_type = KMRUMap<Key, Value>;
+	using entry_type = detail::KCacheEntry<Value>;
+	using Clock      = typename entry_type::Clock;
+
+	// the cost total has to outlive the map, as the entries remove their cost
+	// from it on destruction
+	std::size_t  m_iCost     { 0 };
+	std::size_t  m_iMaxCost  { 0 };
+	KDuration    m_TimeToLive;
+	CostFunction m_CostFunction;
+
+	using map_type = typename Policy::template map_type<Key, entry_type>;
 	map_type m_map;
 
 	//-----------------------------------------------------------------------------
 	/// Creates a new cache entry.
 	template<class K = Key, class V = Value>
-	Value& Create(K&& key, V&& value)
+	Value& Create(K&& key, V&& value, KDuration TimeToLive)
 	//-----------------------------------------------------------------------------
 	{
-		auto it = m_map.insert(detail::KMutablePair<Key, Value>(std::forward<K>(key), std::forward<V>(value)));
-		return it->second;
+		Key kk(std::forward<K>(key));
+
+		// insert() keeps an existing element, so drop an expired one first -
+		// peek() does not count as an access for the eviction policy
+		auto pExisting = m_map.peek(kk);
+
+		if (pExisting && pExisting->second.IsExpired())
+		{
+			m_map.erase(kk);
+		}
+
+		entry_type Entry(std::forward<V>(value));
+
+		if (TimeToLive > KDuration::zero())
+		{
+			Entry.tExpires = Clock::now() + TimeToLive;
+		}
+
+		if (m_CostFunction)
+		{
+			auto iCost = m_CostFunction(kk, Entry.Data);
+
+			if (m_iMaxCost && !m_map.contains(kk))
+			{
+				// make room before the insertion, so that the new entry is never
+				// selected for eviction
+				while (m_iCost + iCost > m_iMaxCost && m_map.evict()) {}
+			}
+
+			Entry.Cost = detail::KCacheCost(iCost, &m_iCost);
+		}
+
+		auto it = m_map.insert(detail::KMutablePair<Key, entry_type>(std::move(kk), std::move(Entry)));
+		return it->second.Data;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Returns the map iterator for a key, erases expired entries
+	template<class K>
+	typename map_type::iterator Lookup(const K& key)
+	//-----------------------------------------------------------------------------
+	{
+		auto it = m_map.find(key);
+
+		if (it != m_map.end() && it->second.IsExpired())
+		{
+			m_map.erase(key);
+			return m_map.end();
+		}
+
+		return it;
 	}
 
 //----------
@@ -102,9 +341,12 @@ public:
 	enum { DEFAULT_MAX_CACHE_SIZE = 1000 };
 
 	//-----------------------------------------------------------------------------
-	KCache(size_t iMaxSize = DEFAULT_MAX_CACHE_SIZE)
+	/// Construct with a maximum count of elements, and optionally a time to live
+	/// for new elements (zero = no expiry).
+	KCache(size_t iMaxSize = DEFAULT_MAX_CACHE_SIZE, KDuration TimeToLive = KDuration::zero())
 	//-----------------------------------------------------------------------------
-	    : m_map(iMaxSize)
+	    : m_TimeToLive(TimeToLive)
+	    , m_map(iMaxSize)
 	{
 	}
 
@@ -119,7 +361,16 @@ public:
 	Value& Set(K&& key, V&& value)
 	//-----------------------------------------------------------------------------
 	{
-		return Create(std::forward<K>(key), std::forward<V>(value));
+		return Create(std::forward<K>(key), std::forward<V>(value), m_TimeToLive);
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Add a new key value pair to the cache, which expires after TimeToLive.
+	template<class K = Key, class V = Value>
+	Value& Set(K&& key, V&& value, KDuration TimeToLive)
+	//-----------------------------------------------------------------------------
+	{
+		return Create(std::forward<K>(key), std::forward<V>(value), TimeToLive);
 	}
 
 	//-----------------------------------------------------------------------------
@@ -128,38 +379,38 @@ public:
 	/// cache. For this to be possible, the Value type needs to be constructible
 	/// from the Key type (so, have a constructor Value(Key)). Alternatively,
 	/// additional parameters can be given in args... which will be supplied
-	/// to a Load type.
+	/// to a Load type. Expired values are loaded again.
 	template<class K = Key, typename...Args>
 	Value& Get(K&& key, Args&&...args)
 	//-----------------------------------------------------------------------------
 	{
-		auto it = m_map.find(std::forward<K>(key));
+		auto it = Lookup(key);
 
 		if (it != m_map.end())
 		{
-			return it->second;
+			return it->second.Data;
 		}
 
 		// Create a copy of the key and move it into Create(), as the loader could
 		// also consume the key. Do not use a temporary, as we do not know which parameter
 		// is consumed first.
 		Key kk(key);
-		return Create(std::move(kk), Load()(std::forward<K>(key), std::forward<Args>(args)...));
+		return Create(std::move(kk), Load()(std::forward<K>(key), std::forward<Args>(args)...), m_TimeToLive);
 	}
 
 	//-----------------------------------------------------------------------------
 	// cannot be const, as the rank is changed..
 	/// Get a pointer on a value for a key from the cache. If the key does not exist,
-	/// a nullptr will be returned.
+	/// or is expired, a nullptr will be returned.
 	template<class K = Key>
 	Value* Find(const K& key)
 	//-----------------------------------------------------------------------------
 	{
-		auto it = m_map.find(key);
+		auto it = Lookup(key);
 
 		if (it != m_map.end())
 		{
-			return &it->second;
+			return &it->second.Data;
 		}
 
 		return nullptr;
@@ -186,10 +437,33 @@ public:
 		}
 	}
 
+	//-----------------------------------------------------------------------------
+	/// Erase all expired elements. Expired elements are also removed when they
+	/// are accessed.
+	/// @return count of erased elements
+	std::size_t EraseExpired()
+	//-----------------------------------------------------------------------------
+	{
+		auto tNow = Clock::now();
+		std::vector<Key> Expired;
+
+		for (auto it = m_map.begin(); it != m_map.end(); ++it)
+		{
+			if (it->second.IsExpired(tNow))
+			{
+				Expired.push_back(it->first);
+			}
+		}
+
+		Erase(Expired);
+
+		return Expired.size();
+	}
+
 	//-----------------------------------------------------------------------------
 	/// Set a new maximum cache size. When the cache was filled with more elements,
-	/// it is reduced by the amount of excess elements that were the least recently
-	/// used.
+	/// it is reduced by the amount of excess elements, selected by the removal
+	/// policy.
 	void SetMaxSize(size_t iMaxSize)
 	//-----------------------------------------------------------------------------
 	{
@@ -204,6 +478,60 @@ public:
 		return m_map.GetMaxSize();
 	}
 
+	//-----------------------------------------------------------------------------
+	/// Set the time to live for new elements, zero means no expiry.
+	void SetTimeToLive(KDuration TimeToLive)
+	//-----------------------------------------------------------------------------
+	{
+		m_TimeToLive = TimeToLive;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Returns the time to live for new elements.
+	KDuration GetTimeToLive() const
+	//-----------------------------------------------------------------------------
+	{
+		return m_TimeToLive;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Set the function that computes the cost of new elements, like their size
+	/// in bytes. Elements that were added before are not recomputed.
+	void SetCostFunction(CostFunction Cost)
+	//-----------------------------------------------------------------------------
+	{
+		m_CostFunction = std::move(Cost);
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Set the maximum total cost of all elements, zero means no limit. Elements
+	/// are removed by the removal policy until the total cost fits into the limit.
+	/// A single element that exceeds the limit on its own is still stored. Needs
+	/// a cost function.
+	void SetMaxCost(std::size_t iMaxCost)
+	//-----------------------------------------------------------------------------
+	{
+		m_iMaxCost = iMaxCost;
+
+		while (m_iMaxCost && m_iCost > m_iMaxCost && m_map.evict()) {}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Returns the maximum total cost of all elements.
+	std::size_t GetMaxCost() const
+	//-----------------------------------------------------------------------------
+	{
+		return m_iMaxCost;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Returns the total cost of all elements.
+	std::size_t GetCost() const
+	//-----------------------------------------------------------------------------
+	{
+		return m_iCost;
+	}
+
 	//-----------------------------------------------------------------------------
 	/// Clears the cache.
 	void clear()
@@ -246,8 +574,8 @@ public:
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 /// KSharedCache wraps the Value type into a shared pointer (KSharedRef)
 /// and enables shared locking
-template<class Key, class Value, class Load = detail::LoadByConstruction<KSharedRef<Value, true> > >
-class KSharedCache : public KCache<Key, KSharedRef<Value, true>, Load>
+template<class Key, class Value, class Load = detail::LoadByConstruction<KSharedRef<Value, true> >, class Policy = KLRUPolicy>
+class KSharedCache : public KCache<Key, KSharedRef<Value, true>, Load, Policy>
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 {
 
@@ -256,13 +584,28 @@ public:
 //----------
 
 	using value_type = KSharedRef<Value, true>;
-	using base_type  = KCache<Key, value_type, Load>;
+	using base_type  = KCache<Key, value_type, Load, Policy>;
+
+	enum { MAX_BACKGROUND_LOADS = 4 };
+
+	//-----------------------------------------------------------------------------
+	/// Construct with a maximum count of elements, and optionally a time to live
+	/// for new elements (zero = no expiry).
+	KSharedCache(size_t iMaxSize = base_type::DEFAULT_MAX_CACHE_SIZE, KDuration TimeToLive = KDuration::zero())
+	//-----------------------------------------------------------------------------
+	: base_type(iMaxSize, TimeToLive)
+	{
+	}
 
 	//-----------------------------------------------------------------------------
-	KSharedCache(size_t iMaxSize = base_type::DEFAULT_MAX_CACHE_SIZE)
+	~KSharedCache()
 	//-----------------------------------------------------------------------------
-	: base_type(iMaxSize)
 	{
+		StopSweeper();
+
+		// wait for background loads
+		std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+		m_LoadFinished.wait(Lock, [this]() { return m_InFlight.empty(); });
 	}
 
 	//-----------------------------------------------------------------------------
@@ -276,6 +619,17 @@ public:
 		return base_type::Set(std::forward<K>(key), value_type(std::forward<V>(value)));
 	}
 
+	//-----------------------------------------------------------------------------
+	/// Add a new key value pair to the cache, which expires after TimeToLive.
+	template<class K = Key, class V = Value>
+	value_type Set(K&& key, V&& value, KDuration TimeToLive)
+	//-----------------------------------------------------------------------------
+	{
+		std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+
+		return base_type::Set(std::forward<K>(key), value_type(std::forward<V>(value)), TimeToLive);
+	}
+
 	//-----------------------------------------------------------------------------
 	// need to reimplement Get() from scratch to accomodate the share logic
 	/// Get a value for a key from the cache. If the key does not exist, a new
@@ -283,7 +637,12 @@ public:
 	/// cache. For this to be possible, the Value type needs to be constructible
 	/// from the Key type (so, have a constructor Value(Key)). Alternatively,
 	/// additional parameters can be given in args... which will be supplied
-	/// to a Load type.
+	/// to a Load type. The value is loaded without holding the cache lock, and
+	/// concurrent requests for the same key wait for the one load in flight
+	/// instead of loading again. If the load throws, the exception is rethrown in
+	/// all waiting threads. If stale-while-revalidate is enabled, expired values
+	/// are returned while a background thread loads the new value - in that
+	/// case args... are copied.
 	template<class K = Key, typename...Args>
 	value_type Get(K&& key, Args&&...args)
 	//-----------------------------------------------------------------------------
@@ -292,7 +651,67 @@ public:
 		// rank is changed!
 		std::unique_lock<std::shared_mutex> Lock(m_Mutex);
 
-		return base_type::Get(std::forward<K>(key), std::forward<Args>(args)...);
+		auto it = this->m_map.find(key);
+
+		if (it != this->m_map.end())
+		{
+			const auto& Entry = it->second;
+
+			if (!Entry.IsExpired())
+			{
+				return Entry.Data;
+			}
+
+			if (m_MaxStale > KDuration::zero() && !Entry.IsExpired(KStopTime::Clock::now() - m_MaxStale))
+			{
+				value_type Stale = Entry.Data;
+				Revalidate(Key(key), std::forward<Args>(args)...);
+				return Stale;
+			}
+
+			this->m_map.erase(key);
+		}
+
+		auto Loading = m_InFlight.find(key);
+
+		if (Loading != m_InFlight.end())
+		{
+			auto Future = Loading->second;
+			Lock.unlock();
+			return Future.get();
+		}
+
+		Key kk(key);
+		std::promise<value_type> Promise;
+		m_InFlight.emplace(kk, Promise.get_future().share());
+
+		Lock.unlock();
+
+		try
+		{
+			value_type Loaded(Load()(std::forward<K>(key), std::forward<Args>(args)...));
+
+			Lock.lock();
+			Loaded = base_type::Set(kk, std::move(Loaded));
+			FinishLoad(kk, Lock);
+
+			Promise.set_value(Loaded);
+
+			return Loaded;
+		}
+		catch (...)
+		{
+			if (!Lock.owns_lock())
+			{
+				Lock.lock();
+			}
+
+			FinishLoad(kk, Lock);
+
+			Promise.set_exception(std::current_exception());
+
+			throw;
+		}
 	}
 
 	//-----------------------------------------------------------------------------
@@ -341,10 +760,62 @@ public:
 		base_type::Erase(keys);
 	}
 
+	//-----------------------------------------------------------------------------
+	/// Erase all expired elements.
+	/// @return count of erased elements
+	std::size_t EraseExpired()
+	//-----------------------------------------------------------------------------
+	{
+		std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+
+		return base_type::EraseExpired();
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Start a background thread that erases expired elements every Interval.
+	/// Restarts the thread if it was already running.
+	void StartSweeper(KDuration Interval)
+	//-----------------------------------------------------------------------------
+	{
+		StopSweeper();
+
+		m_bStopSweeper = false;
+
+		m_Sweeper = std::make_unique<std::thread>([this, Interval]()
+		{
+			std::unique_lock<std::mutex> Lock(m_SweeperMutex);
+
+			while (!m_SweeperWakeUp.wait_for(Lock, Interval, [this]() { return m_bStopSweeper; }))
+			{
+				Lock.unlock();
+				EraseExpired();
+				Lock.lock();
+			}
+		});
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Stop the background thread that erases expired elements.
+	void StopSweeper()
+	//-----------------------------------------------------------------------------
+	{
+		if (m_Sweeper)
+		{
+			{
+				std::lock_guard<std::mutex> Lock(m_SweeperMutex);
+				m_bStopSweeper = true;
+			}
+
+			m_SweeperWakeUp.notify_all();
+			m_Sweeper->join();
+			m_Sweeper.reset();
+		}
+	}
+
 	//-----------------------------------------------------------------------------
 	/// Set a new maximum cache size. When the cache was filled with more elements,
-	/// it is reduced by the amount of excess elements that were the least recently
-	/// used.
+	/// it is reduced by the amount of excess elements, selected by the removal
+	/// policy.
 	void SetMaxSize(size_t iMaxSize)
 	//-----------------------------------------------------------------------------
 	{
@@ -364,54 +835,651 @@ public:
 	}
 
 	//-----------------------------------------------------------------------------
-	/// Clears the cache.
-	void clear()
+	/// Set the time to live for new elements, zero means no expiry.
+	void SetTimeToLive(KDuration TimeToLive)
 	//-----------------------------------------------------------------------------
 	{
 		std::unique_lock<std::shared_mutex> Lock(m_Mutex);
 
-		base_type::clear();
+		base_type::SetTimeToLive(TimeToLive);
 	}
 
 	//-----------------------------------------------------------------------------
-	/// Returns count of cached elements.
-	size_t size() const
+	/// Returns the time to live for new elements.
+	KDuration GetTimeToLive() const
 	//-----------------------------------------------------------------------------
 	{
 		std::shared_lock<std::shared_mutex> Lock(m_Mutex);
 
-		return base_type::size();
+		return base_type::GetTimeToLive();
 	}
 
 	//-----------------------------------------------------------------------------
-	/// Returns true if no cached elements.
-	bool empty() const
+	/// Enable stale-while-revalidate: expired values that expired at most MaxStale
+	/// ago are still returned by Get(), while a background thread loads the new
+	/// value. At most MAX_BACKGROUND_LOADS values are loaded at the same time, further
+	/// loads wait in a queue. Zero disables it, which is the default.
+	void SetStaleWhileRevalidate(KDuration MaxStale)
 	//-----------------------------------------------------------------------------
 	{
-		std::shared_lock<std::shared_mutex> Lock(m_Mutex);
+		std::unique_lock<std::shared_mutex> Lock(m_Mutex);
 
-		return base_type::empty();
+		m_MaxStale = MaxStale;
 	}
 
 	//-----------------------------------------------------------------------------
-	/// Get a value for a key from the cache. If the key does not exist, a new
-	/// value will be created and the key value pair will be inserted into the
-	/// cache. For this to be possible, the Value type needs to be constructible
-	/// from the Key type (so, have a constructor Value(Key) ).
-	template<class K = Key>
-	value_type operator[](K&& key)
+	/// Returns the maximum time since expiry for which values are returned
+	/// while they are revalidated.
+	KDuration GetStaleWhileRevalidate() const
 	//-----------------------------------------------------------------------------
 	{
-		return Get(std::forward<K>(key));
+		std::shared_lock<std::shared_mutex> Lock(m_Mutex);
+
+		return m_MaxStale;
 	}
 
-//----------
-private:
-//----------
+	//-----------------------------------------------------------------------------
+	/// Set the function that computes the cost of new elements, like their size
+	/// in bytes.
+	void SetCostFunction(typename base_type::CostFunction Cost)
+	//-----------------------------------------------------------------------------
+	{
+		std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+
+		base_type::SetCostFunction(std::move(Cost));
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Set the maximum total cost of all elements, zero means no limit.
+	void SetMaxCost(std::size_t iMaxCost)
+	//-----------------------------------------------------------------------------
+	{
+		std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+
+		base_type::SetMaxCost(iMaxCost);
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Returns the maximum total cost of all elements.
+	std::size_t GetMaxCost() const
+	//-----------------------------------------------------------------------------
+	{
+		std::shared_lock<std::shared_mutex> Lock(m_Mutex);
+
+		return base_type::GetMaxCost();
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Returns the total cost of all elements.
+	std::size_t GetCost() const
+	//-----------------------------------------------------------------------------
+	{
+		std::shared_lock<std::shared_mutex> Lock(m_Mutex);
+
+		return base_type::GetCost();
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Clears the cache.
+	void clear()
+	//-----------------------------------------------------------------------------
+	{
+		std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+
+		base_type::clear();
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Returns count of cached elements.
+	size_t size() const
+	//-----------------------------------------------------------------------------
+	{
+		std::shared_lock<std::shared_mutex> Lock(m_Mutex);
+
+		return base_type::size();
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Returns true if no cached elements.
+	bool empty() const
+	//-----------------------------------------------------------------------------
+	{
+		std::shared_lock<std::shared_mutex> Lock(m_Mutex);
+
+		return base_type::empty();
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Get a value for a key from the cache. If the key does not exist, a new
+	/// value will be created and the key value pair will be inserted into the
+	/// cache. For this to be possible, the Value type needs to be constructible
+	/// from the Key type (so, have a constructor Value(Key) ).
+	template<class K = Key>
+	value_type operator[](K&& key)
+	//-----------------------------------------------------------------------------
+	{
+		return Get(std::forward<K>(key));
+	}
+
+//----------
+private:
+//----------
+
+	//-----------------------------------------------------------------------------
+	/// start a background load for an expired key, unless one is already in flight
+	/// - needs the cache lock
+	template<typename...Args>
+	void Revalidate(Key key, Args&&...args)
+	//-----------------------------------------------------------------------------
+	{
+		if (m_InFlight.find(key) != m_InFlight.end())
+		{
+			return;
+		}
+
+		std::promise<value_type> Promise;
+		m_InFlight.emplace(key, Promise.get_future().share());
+
+		if (!m_Loader)
+		{
+			m_Loader = std::make_unique<KThreadPool>(MAX_BACKGROUND_LOADS);
+		}
+
+		m_Loader->push([this,
+		             key     = std::move(key),
+		             Promise = std::move(Promise),
+		             Params  = std::make_tuple(typename std::decay<Args>::type(std::forward<Args>(args))...)]() mutable
+		{
+			std::unique_lock<std::shared_mutex> Lock(m_Mutex, std::defer_lock);
+
+			try
+			{
+				value_type Loaded(std::apply([&key](auto&... Param)
+				{
+					return Load()(key, Param...);
+
+				}, Params));
+
+				Lock.lock();
+				// replace the expired value
+				this->m_map.erase(key);
+				Loaded = base_type::Set(key, std::move(Loaded));
+				FinishLoad(key, Lock);
+
+				Promise.set_value(std::move(Loaded));
+			}
+			catch (...)
+			{
+				if (!Lock.owns_lock())
+				{
+					Lock.lock();
+				}
 
-	mutable std::shared_mutex m_Mutex;
+				FinishLoad(key, Lock);
+
+				Promise.set_exception(std::current_exception());
+			}
+
+		});
+	}
+
+	//-----------------------------------------------------------------------------
+	/// remove a load from the loads in flight, and release the lock
+	void FinishLoad(const Key& key, std::unique_lock<std::shared_mutex>& Lock)
+	//-----------------------------------------------------------------------------
+	{
+		m_InFlight.erase(key);
+		// this may be the last access on the cache object if it is waiting for
+		// its destruction
+		m_LoadFinished.notify_all();
+		Lock.unlock();
+	}
+
+	mutable std::shared_mutex    m_Mutex;
+	std::unordered_map<Key, std::shared_future<value_type>> m_InFlight;
+	std::condition_variable_any  m_LoadFinished;
+	KDuration                    m_MaxStale;
+	std::unique_ptr<std::thread> m_Sweeper;
+	std::mutex                   m_SweeperMutex;
+	std::condition_variable      m_SweeperWakeUp;
+	bool                         m_bStopSweeper { false };
+	// the threads for the background loads - the destructor waits for the
+	// loads in flight, and the pool joins its threads before the members
+	// above are destructed
+	std::unique_ptr<KThreadPool> m_Loader;
 
 }; // KSharedCache
 
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// KShardedCache has the same interface as KSharedCache, but splits the cache
+/// into independently locked shards, selected by the hash of the key. Each
+/// shard uses a CLOCK eviction, so that a cache hit only sets an access bit and
+/// can be served under a shared lock. Concurrent hits therefore scale with the
+/// number of cores, where KSharedCache serializes all lookups. Values are loaded
+/// outside of the shard lock. The maximum size is shared by all shards: when it is
+/// exceeded, elements are evicted from the shard of the inserted key first.
+/// Concurrent requests for a key that is not cached wait for the one load in
+/// flight instead of loading again.
+template<class Key, class Value, class Load = detail::LoadByConstruction<KSharedRef<Value, true> > >
+class KShardedCache
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	using value_type = KSharedRef<Value, true>;
+
+	enum { DEFAULT_MAX_CACHE_SIZE = 1000 };
+
+	//-----------------------------------------------------------------------------
+	/// construct with a maximum size and a shard count - the shard count is rounded up
+	/// to the next power of two, and defaults to twice the hardware concurrency
+	KShardedCache(std::size_t iMaxSize = DEFAULT_MAX_CACHE_SIZE, std::size_t iShards = 0)
+	//-----------------------------------------------------------------------------
+	: m_iMaxSize(iMaxSize)
+	{
+		if (!iShards)
+		{
+			iShards = std::max(std::thread::hardware_concurrency(), 1u) * 2;
+		}
+
+		std::size_t iSize = 1;
+
+		while (iSize < iShards && iSize < 1024)
+		{
+			iSize <<= 1;
+		}
+
+		m_Shards = std::make_unique<Shard[]>(iSize);
+		m_iMask  = iSize - 1;
+	}
+
+	KShardedCache(const KShardedCache&) = delete;
+	KShardedCache& operator=(const KShardedCache&) = delete;
+	KShardedCache(KShardedCache&&) = delete;
+	KShardedCache& operator=(KShardedCache&&) = delete;
+
+	//-----------------------------------------------------------------------------
+	/// Add a new key value pair to the cache.
+	template<class K = Key, class V = Value>
+	value_type Set(K&& key, V&& value)
+	//-----------------------------------------------------------------------------
+	{
+		return Insert(Key(std::forward<K>(key)), value_type(std::forward<V>(value)));
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Get a value for a key from the cache. If the key does not exist, a new
+	/// value will be created and the key value pair will be inserted into the
+	/// cache. For this to be possible, the Value type needs to be constructible
+	/// from the Key type (so, have a constructor Value(Key)). Alternatively,
+	/// additional parameters can be given in args... which will be supplied
+	/// to a Load type.
+	template<class K = Key, typename...Args>
+	value_type Get(K&& key, Args&&...args)
+	//-----------------------------------------------------------------------------
+	{
+		if constexpr (std::is_same<typename std::decay<K>::type, Key>::value)
+		{
+			return GetKey(key, std::forward<Args>(args)...);
+		}
+		else
+		{
+			return GetKey(Key(std::forward<K>(key)), std::forward<Args>(args)...);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Get a value for a key from the cache. If the key does not exist,
+	/// a default constructed value will be returned.
+	template<class K = Key>
+	value_type Find(const K& key)
+	//-----------------------------------------------------------------------------
+	{
+		if constexpr (std::is_same<K, Key>::value)
+		{
+			return FindKey(key);
+		}
+		else
+		{
+			return FindKey(Key(key));
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Erase a key and its corresponding value from the cache.
+	template<class K = Key>
+	bool Erase(const K& key)
+	//-----------------------------------------------------------------------------
+	{
+		if constexpr (std::is_same<K, Key>::value)
+		{
+			return EraseKey(key);
+		}
+		else
+		{
+			return EraseKey(Key(key));
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Erase a vector of keys and their corresponding values from the cache.
+	template<class K = Key>
+	void Erase(const std::vector<K>& keys)
+	//-----------------------------------------------------------------------------
+	{
+		for (const auto& key : keys)
+		{
+			Erase(key);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Set a new maximum cache size. When the cache was filled with more elements,
+	/// it is reduced by the amount of excess elements.
+	void SetMaxSize(std::size_t iMaxSize)
+	//-----------------------------------------------------------------------------
+	{
+		m_iMaxSize.store(iMaxSize, std::memory_order_relaxed);
+		Trim(0);
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Returns the maximum cache size.
+	std::size_t GetMaxSize() const
+	//-----------------------------------------------------------------------------
+	{
+		return m_iMaxSize.load(std::memory_order_relaxed);
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Clears the cache.
+	void clear()
+	//-----------------------------------------------------------------------------
+	{
+		for (std::size_t iShard = 0; iShard <= m_iMask; ++iShard)
+		{
+			auto& Shard = m_Shards[iShard];
+
+			std::unique_lock<std::shared_mutex> Lock(Shard.Mutex);
+
+			m_iSize.fetch_sub(Shard.Map.size(), std::memory_order_relaxed);
+			Shard.Map.clear();
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Returns count of cached elements.
+	std::size_t size() const
+	//-----------------------------------------------------------------------------
+	{
+		return m_iSize.load(std::memory_order_relaxed);
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Returns true if no cached elements.
+	bool empty() const
+	//-----------------------------------------------------------------------------
+	{
+		return !size();
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Returns the count of shards
+	std::size_t Shards() const
+	//-----------------------------------------------------------------------------
+	{
+		return m_iMask + 1;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Get a value for a key from the cache. If the key does not exist, a new
+	/// value will be created and the key value pair will be inserted into the
+	/// cache. For this to be possible, the Value type needs to be constructible
+	/// from the Key type (so, have a constructor Value(Key) ).
+	template<class K = Key>
+	value_type operator[](K&& key)
+	//-----------------------------------------------------------------------------
+	{
+		return Get(std::forward<K>(key));
+	}
+
+//----------
+private:
+//----------
+
+	using map_type = detail::KClockMap<Key, value_type>;
+
+	// keep the shard locks on separate cache lines
+	struct alignas(64) Shard
+	{
+		mutable std::shared_mutex Mutex;
+		// the size limit is applied across all shards
+		map_type                  Map { std::size_t(-1) };
+		// loads in flight, other threads wait for them
+		std::unordered_map<Key, std::shared_future<value_type>> InFlight;
+	};
+
+	//-----------------------------------------------------------------------------
+	std::size_t GetShard(const Key& key) const
+	//-----------------------------------------------------------------------------
+	{
+		// the maps inside the shards use the lower bits of the same hash,
+		// therefore select the shard by the upper bits of a mixed hash
+		uint64_t iHash = std::hash<Key>()(key);
+		iHash *= UINT64_C(0x9E3779B97F4A7C15);
+		return static_cast<std::size_t>(iHash >> 40) & m_iMask;
+	}
+
+	//-----------------------------------------------------------------------------
+	template<typename...Args>
+	value_type GetKey(const Key& key, Args&&...args)
+	//-----------------------------------------------------------------------------
+	{
+		auto iShard = GetShard(key);
+		auto& Shard = m_Shards[iShard];
+
+		{
+			std::shared_lock<std::shared_mutex> Lock(Shard.Mutex);
+
+			auto it = Shard.Map.find(key);
+
+			if (it != Shard.Map.end())
+			{
+				return it->second;
+			}
+		}
+
+		std::unique_lock<std::shared_mutex> Lock(Shard.Mutex);
+
+		// the value may have been inserted in the meantime
+		auto it = Shard.Map.find(key);
+
+		if (it != Shard.Map.end())
+		{
+			return it->second;
+		}
+
+		// wait for a load in flight
+		auto Loading = Shard.InFlight.find(key);
+
+		if (Loading != Shard.InFlight.end())
+		{
+			auto Future = Loading->second;
+			Lock.unlock();
+			return Future.get();
+		}
+
+		std::promise<value_type> Promise;
+		Shard.InFlight.emplace(key, Promise.get_future().share());
+
+		// load outside of the lock
+		Lock.unlock();
+
+		try
+		{
+			value_type NewValue(Load()(key, std::forward<Args>(args)...));
+
+			NewValue = Insert(key, std::move(NewValue), iShard);
+
+			Lock.lock();
+			Shard.InFlight.erase(key);
+			Lock.unlock();
+
+			Promise.set_value(NewValue);
+
+			return NewValue;
+		}
+		catch (...)
+		{
+			if (!Lock.owns_lock())
+			{
+				Lock.lock();
+			}
+
+			Shard.InFlight.erase(key);
+			Lock.unlock();
+
+			Promise.set_exception(std::current_exception());
+
+			throw;
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	value_type FindKey(const Key& key)
+	//-----------------------------------------------------------------------------
+	{
+		auto& Shard = m_Shards[GetShard(key)];
+
+		std::shared_lock<std::shared_mutex> Lock(Shard.Mutex);
+
+		auto it = Shard.Map.find(key);
+
+		if (it == Shard.Map.end())
+		{
+			return value_type{};
+		}
+
+		return it->second;
+	}
+
+	//-----------------------------------------------------------------------------
+	bool EraseKey(const Key& key)
+	//-----------------------------------------------------------------------------
+	{
+		auto& Shard = m_Shards[GetShard(key)];
+
+		std::unique_lock<std::shared_mutex> Lock(Shard.Mutex);
+
+		if (!Shard.Map.erase(key))
+		{
+			return false;
+		}
+
+		m_iSize.fetch_sub(1, std::memory_order_relaxed);
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	value_type Insert(const Key& key, value_type NewValue)
+	//-----------------------------------------------------------------------------
+	{
+		return Insert(key, std::move(NewValue), GetShard(key));
+	}
+
+	//-----------------------------------------------------------------------------
+	value_type Insert(const Key& key, value_type NewValue, std::size_t iShard)
+	//-----------------------------------------------------------------------------
+	{
+		auto& Shard = m_Shards[iShard];
+
+		std::unique_lock<std::shared_mutex> Lock(Shard.Mutex);
+
+		auto it = Shard.Map.find(key);
+
+		if (it != Shard.Map.end())
+		{
+			return it->second;
+		}
+
+		if (m_iSize.load(std::memory_order_relaxed) >= m_iMaxSize.load(std::memory_order_relaxed))
+		{
+			// make room in this shard first, so that the new element is not the
+			// first candidate for eviction
+			if (Shard.Map.evict())
+			{
+				m_iSize.fetch_sub(1, std::memory_order_relaxed);
+			}
+		}
+
+		NewValue = Shard.Map.insert(typename map_type::element_type(key, std::move(NewValue)))->second;
+		m_iSize.fetch_add(1, std::memory_order_relaxed);
+
+		Lock.unlock();
+
+		// this shard may have been empty
+		Trim((iShard + 1) & m_iMask);
+
+		return NewValue;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// evict elements until the size limit is met, starting with the given shard
+	void Trim(std::size_t iShard)
+	//-----------------------------------------------------------------------------
+	{
+		auto iSize = m_iSize.load(std::memory_order_relaxed);
+
+		while (iSize > m_iMaxSize.load(std::memory_order_relaxed))
+		{
+			// reserve one eviction, so that concurrent inserts do not evict too much
+			if (!m_iSize.compare_exchange_weak(iSize, iSize - 1, std::memory_order_relaxed))
+			{
+				continue;
+			}
+
+			if (!EvictOne(iShard))
+			{
+				m_iSize.fetch_add(1, std::memory_order_relaxed);
+				break;
+			}
+
+			iSize = m_iSize.load(std::memory_order_relaxed);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	bool EvictOne(std::size_t iShard)
+	//-----------------------------------------------------------------------------
+	{
+		for (std::size_t iCount = 0; iCount <= m_iMask; ++iCount)
+		{
+			auto& Shard = m_Shards[iShard];
+
+			std::unique_lock<std::shared_mutex> Lock(Shard.Mutex);
+
+			if (Shard.Map.evict())
+			{
+				return true;
+			}
+
+			iShard = (iShard + 1) & m_iMask;
+		}
+
+		return false;
+	}
+
+	std::unique_ptr<Shard[]> m_Shards;
+	std::size_t              m_iMask { 0 };
+	std::atomic<std::size_t> m_iSize { 0 };
+	std::atomic<std::size_t> m_iMaxSize;
+
+}; // KShardedCache
+
 } // of namespace dekaf2
 
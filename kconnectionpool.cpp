@@ -0,0 +1,411 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#include "kconnectionpool.h"
+#include "klog.h"
+
+namespace dekaf2 {
+
+std::atomic<bool> KConnectionPool::s_bUseByDefault { false };
+
+//-----------------------------------------------------------------------------
+KConnectionPool::KConnectionPool()
+//-----------------------------------------------------------------------------
+: KConnectionPool(Config{})
+{
+} // ctor
+
+//-----------------------------------------------------------------------------
+KConnectionPool::KConnectionPool(Config config)
+//-----------------------------------------------------------------------------
+{
+	m_Storage.unique()->config = std::move(config);
+
+} // ctor
+
+//-----------------------------------------------------------------------------
+KConnectionPool& KConnectionPool::GetInstance()
+//-----------------------------------------------------------------------------
+{
+	static KConnectionPool s_Pool;
+	return s_Pool;
+
+} // GetInstance
+
+//-----------------------------------------------------------------------------
+KString KConnectionPool::CreateKey(const KURL& URL, bool bForceSSL, bool bVerifyCerts)
+//-----------------------------------------------------------------------------
+{
+#ifdef DEKAF2_HAS_UNIX_SOCKETS
+	if (URL.Protocol == url::KProtocol::UNIX)
+	{
+		return kFormat("unix:{}", URL.Path.get());
+	}
+#endif
+
+	url::KPort Port = URL.Port;
+
+	if (Port.empty())
+	{
+		Port = KString::to_string(URL.Protocol.DefaultPort());
+	}
+
+	bool bIsTLS = (URL.Protocol == url::KProtocol::UNDEFINED && Port.get() == 443)
+	           || URL.Protocol == url::KProtocol::HTTPS
+	           || bForceSSL;
+
+	if (bIsTLS)
+	{
+		return kFormat("tls:{}:{}:{}", URL.Domain.get(), Port.get(), bVerifyCerts ? "verify" : "noverify");
+	}
+	else
+	{
+		return kFormat("tcp:{}:{}", URL.Domain.get(), Port.get());
+	}
+
+} // CreateKey
+
+//-----------------------------------------------------------------------------
+std::size_t KConnectionPool::MoveExpired(IdleList& List, Clock::time_point tOldest, IdleList& Closed)
+//-----------------------------------------------------------------------------
+{
+	// the list is sorted by return time, so we only have to find the
+	// first connection that is still young enough
+	auto it = std::find_if(List.begin(), List.end(), [tOldest](const IdleConnection& Idle)
+	{
+		return Idle.tReturned >= tOldest;
+	});
+
+	auto iCount = static_cast<std::size_t>(it - List.begin());
+
+	if (iCount)
+	{
+		std::move(List.begin(), it, std::back_inserter(Closed));
+		List.erase(List.begin(), it);
+	}
+
+	return iCount;
+
+} // MoveExpired
+
+//-----------------------------------------------------------------------------
+std::unique_ptr<KConnection> KConnectionPool::Borrow(const KString& sKey)
+//-----------------------------------------------------------------------------
+{
+	std::unique_ptr<KConnection> Connection;
+
+	// we close connections only after releasing the lock
+	IdleList Closed;
+
+	{
+		auto Storage = m_Storage.unique();
+
+		auto it = Storage->Hosts.find(sKey);
+
+		if (it == Storage->Hosts.end())
+		{
+			return Connection;
+		}
+
+		auto& List = it->second;
+
+		auto iExpired = MoveExpired(List, Clock::now() - Storage->config.IdleTimeout, Closed);
+		ma_iExpired += iExpired;
+		Storage->iIdle -= iExpired;
+
+		while (!List.empty())
+		{
+			auto Idle = std::move(List.back());
+			List.pop_back();
+			--Storage->iIdle;
+
+			if (Idle.Connection && Idle.Connection->Good())
+			{
+				Connection = std::move(Idle.Connection);
+				break;
+			}
+
+			Closed.push_back(std::move(Idle));
+			++ma_iRejected;
+		}
+
+		if (List.empty())
+		{
+			Storage->Hosts.erase(it);
+		}
+	}
+
+	if (Connection)
+	{
+		++ma_iReused;
+		kDebug(2, "reusing pooled connection to {}", sKey);
+	}
+
+	return Connection;
+
+} // Borrow
+
+//-----------------------------------------------------------------------------
+std::unique_ptr<KConnection> KConnectionPool::Create(const KURL& URL, bool bForceSSL, bool bVerifyCerts, int iSecondsTimeout)
+//-----------------------------------------------------------------------------
+{
+	auto Connection = KConnection::Create(URL, bForceSSL, bVerifyCerts, iSecondsTimeout);
+
+	if (Connection && Connection->Good())
+	{
+		++ma_iCreated;
+	}
+
+	return Connection;
+
+} // Create
+
+//-----------------------------------------------------------------------------
+std::unique_ptr<KConnection> KConnectionPool::Get(const KURL& URL, bool bForceSSL, bool bVerifyCerts, int iSecondsTimeout)
+//-----------------------------------------------------------------------------
+{
+	auto Connection = Borrow(CreateKey(URL, bForceSSL, bVerifyCerts));
+
+	if (!Connection)
+	{
+		Connection = Create(URL, bForceSSL, bVerifyCerts, iSecondsTimeout);
+	}
+
+	return Connection;
+
+} // Get
+
+//-----------------------------------------------------------------------------
+bool KConnectionPool::Return(const KString& sKey, std::unique_ptr<KConnection> Connection)
+//-----------------------------------------------------------------------------
+{
+	if (!Connection || !Connection->Good() || sKey.empty())
+	{
+		++ma_iRejected;
+		return false;
+	}
+
+	// we close connections only after releasing the lock
+	IdleList Closed;
+	bool bAccepted { false };
+
+	{
+		auto Storage = m_Storage.unique();
+
+		auto tNow  = Clock::now();
+		auto& List = Storage->Hosts[sKey];
+
+		auto iExpired = MoveExpired(List, tNow - Storage->config.IdleTimeout, Closed);
+		ma_iExpired += iExpired;
+		Storage->iIdle -= iExpired;
+
+		if (Storage->iIdle >= Storage->config.iMaxIdleTotal)
+		{
+			// check all other hosts for expired connections
+			for (auto it = Storage->Hosts.begin(); it != Storage->Hosts.end();)
+			{
+				iExpired = MoveExpired(it->second, tNow - Storage->config.IdleTimeout, Closed);
+				ma_iExpired += iExpired;
+				Storage->iIdle -= iExpired;
+
+				if (it->second.empty() && it->first != sKey)
+				{
+					it = Storage->Hosts.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+
+		if (Storage->config.iMaxIdlePerHost && Storage->iIdle < Storage->config.iMaxIdleTotal)
+		{
+			if (List.size() >= Storage->config.iMaxIdlePerHost)
+			{
+				// drop the oldest connection of this host in favour of the new one
+				Closed.push_back(std::move(List.front()));
+				List.erase(List.begin());
+				--Storage->iIdle;
+				++ma_iRejected;
+			}
+
+			List.push_back(IdleConnection { std::move(Connection), tNow });
+			++Storage->iIdle;
+			bAccepted = true;
+		}
+		else if (List.empty())
+		{
+			Storage->Hosts.erase(sKey);
+		}
+	}
+
+	if (bAccepted)
+	{
+		++ma_iReturned;
+		kDebug(2, "returned connection to {} into pool", sKey);
+	}
+	else
+	{
+		++ma_iRejected;
+		kDebug(2, "pool limit reached, closing connection to {}", sKey);
+	}
+
+	return bAccepted;
+
+} // Return
+
+//-----------------------------------------------------------------------------
+std::size_t KConnectionPool::Purge()
+//-----------------------------------------------------------------------------
+{
+	IdleList Closed;
+
+	{
+		auto Storage = m_Storage.unique();
+
+		auto tOldest = Clock::now() - Storage->config.IdleTimeout;
+
+		for (auto it = Storage->Hosts.begin(); it != Storage->Hosts.end();)
+		{
+			Storage->iIdle -= MoveExpired(it->second, tOldest, Closed);
+
+			if (it->second.empty())
+			{
+				it = Storage->Hosts.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	ma_iExpired += Closed.size();
+
+	return Closed.size();
+
+} // Purge
+
+//-----------------------------------------------------------------------------
+std::size_t KConnectionPool::Purge(const KString& sKey)
+//-----------------------------------------------------------------------------
+{
+	IdleList Closed;
+
+	{
+		auto Storage = m_Storage.unique();
+
+		auto it = Storage->Hosts.find(sKey);
+
+		if (it != Storage->Hosts.end())
+		{
+			Closed = std::move(it->second);
+			Storage->iIdle -= Closed.size();
+			Storage->Hosts.erase(it);
+		}
+	}
+
+	if (!Closed.empty())
+	{
+		kDebug(2, "closed {} idle connections to {}", Closed.size(), sKey);
+	}
+
+	return Closed.size();
+
+} // Purge
+
+//-----------------------------------------------------------------------------
+void KConnectionPool::clear()
+//-----------------------------------------------------------------------------
+{
+	std::unordered_map<KString, IdleList> Closed;
+
+	{
+		auto Storage = m_Storage.unique();
+
+		Closed = std::move(Storage->Hosts);
+		Storage->Hosts.clear();
+		Storage->iIdle = 0;
+	}
+
+} // clear
+
+//-----------------------------------------------------------------------------
+void KConnectionPool::SetConfig(Config config)
+//-----------------------------------------------------------------------------
+{
+	m_Storage.unique()->config = std::move(config);
+
+} // SetConfig
+
+//-----------------------------------------------------------------------------
+KConnectionPool::Config KConnectionPool::GetConfig() const
+//-----------------------------------------------------------------------------
+{
+	return m_Storage.shared()->config;
+
+} // GetConfig
+
+//-----------------------------------------------------------------------------
+KConnectionPool::Stats KConnectionPool::GetStats() const
+//-----------------------------------------------------------------------------
+{
+	Stats stats;
+
+	{
+		auto Storage = m_Storage.shared();
+
+		stats.iIdle  = Storage->iIdle;
+		stats.iHosts = Storage->Hosts.size();
+	}
+
+	stats.iCreated  = ma_iCreated;
+	stats.iReused   = ma_iReused;
+	stats.iReturned = ma_iReturned;
+	stats.iRejected = ma_iRejected;
+	stats.iExpired  = ma_iExpired;
+
+	return stats;
+
+} // GetStats
+
+} // end of namespace dekaf2
@@ -0,0 +1,229 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#pragma once
+
+/// @file kconnectionpool.h
+/// process wide pool of idle keep-alive connections
+
+#include "kconnection.h"
+#include "kduration.h"
+#include "kurl.h"
+#include "kthreadsafe.h"
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <atomic>
+
+namespace dekaf2 {
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// A thread safe pool of idle keep-alive connections, keyed by protocol, host,
+/// port and TLS parameters. Clients borrow a connection for one or more requests
+/// and return it when done, so that subsequent clients to the same host can skip
+/// the TCP and TLS handshakes. Idle connections expire after a configurable time.
+class DEKAF2_PUBLIC KConnectionPool
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//------
+public:
+//------
+
+	struct Config
+	{
+		KDuration   IdleTimeout     { chrono::seconds(15) }; ///< max time a connection may stay idle in the pool
+		std::size_t iMaxIdlePerHost { 8   };                 ///< max number of idle connections per host key
+		std::size_t iMaxIdleTotal   { 256 };                 ///< max number of idle connections in total
+
+	}; // Config
+
+	struct Stats
+	{
+		std::size_t iCreated  { 0 }; ///< number of connections created through the pool
+		std::size_t iReused   { 0 }; ///< number of connections handed out again from the pool
+		std::size_t iReturned { 0 }; ///< number of connections accepted back into the pool
+		std::size_t iRejected { 0 }; ///< number of returned connections dropped because of limits or bad state
+		std::size_t iExpired  { 0 }; ///< number of idle connections dropped after the idle timeout
+		std::size_t iIdle     { 0 }; ///< current number of idle connections
+		std::size_t iHosts    { 0 }; ///< current number of host keys with idle connections
+
+	}; // Stats
+
+	//-----------------------------------------------------------------------------
+	/// construct a pool with the default configuration
+	KConnectionPool();
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// construct a pool with the given configuration
+	KConnectionPool(Config config);
+	//-----------------------------------------------------------------------------
+
+	KConnectionPool(const KConnectionPool&) = delete;
+	KConnectionPool(KConnectionPool&&) = delete;
+	KConnectionPool& operator=(const KConnectionPool&) = delete;
+	KConnectionPool& operator=(KConnectionPool&&) = delete;
+
+	//-----------------------------------------------------------------------------
+	/// returns the process wide connection pool
+	static KConnectionPool& GetInstance();
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// shall new KHTTPClient instances use the process wide connection pool? Default is false
+	static void SetUseByDefault(bool bYesNo)
+	//-----------------------------------------------------------------------------
+	{
+		s_bUseByDefault = bYesNo;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// do new KHTTPClient instances use the process wide connection pool?
+	static bool GetUseByDefault()
+	//-----------------------------------------------------------------------------
+	{
+		return s_bUseByDefault;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// create the pool key for a connection target - uses the same rules to decide
+	/// for TLS and the default port as KConnection::Create()
+	static KString CreateKey(const KURL& URL, bool bForceSSL = false, bool bVerifyCerts = false);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// get an idle connection for sKey from the pool, or nullptr if there is none
+	std::unique_ptr<KConnection> Borrow(const KString& sKey);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// create a new connection that may later be returned into the pool
+	std::unique_ptr<KConnection> Create(const KURL& URL, bool bForceSSL = false, bool bVerifyCerts = false, int iSecondsTimeout = 15);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// get an idle connection from the pool, or create a new one if there is none
+	std::unique_ptr<KConnection> Get(const KURL& URL, bool bForceSSL = false, bool bVerifyCerts = false, int iSecondsTimeout = 15);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// return a connection into the pool - the connection must be in a state that
+	/// permits the start of a new request (that is, any previous response must have
+	/// been read completely)
+	/// @return true if the connection was accepted, false if it was closed
+	bool Return(const KString& sKey, std::unique_ptr<KConnection> Connection);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// close all idle connections that exceeded the idle timeout
+	/// @return count of closed connections
+	std::size_t Purge();
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// close all idle connections for sKey
+	/// @return count of closed connections
+	std::size_t Purge(const KString& sKey);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// close all idle connections
+	void clear();
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// set a new configuration - existing idle connections are adapted lazily
+	void SetConfig(Config config);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// get the current configuration
+	Config GetConfig() const;
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// query pool statistics
+	Stats GetStats() const;
+	//-----------------------------------------------------------------------------
+
+//------
+private:
+//------
+
+	using Clock = KStopTime::Clock;
+
+	struct IdleConnection
+	{
+		std::unique_ptr<KConnection> Connection;
+		Clock::time_point            tReturned;
+	};
+
+	// the connections per host are kept in order of their return time, the
+	// most recently returned connection is at the back and will be reused first
+	using IdleList = std::vector<IdleConnection>;
+
+	struct Storage
+	{
+		std::unordered_map<KString, IdleList> Hosts;
+		Config      config;
+		std::size_t iIdle { 0 };
+	};
+
+	//-----------------------------------------------------------------------------
+	/// move expired connections of one host into Closed, returns count
+	DEKAF2_PRIVATE
+	static std::size_t MoveExpired(IdleList& List, Clock::time_point tOldest, IdleList& Closed);
+	//-----------------------------------------------------------------------------
+
+	KThreadSafe<Storage> m_Storage;
+
+	std::atomic<std::size_t> ma_iCreated  { 0 };
+	std::atomic<std::size_t> ma_iReused   { 0 };
+	std::atomic<std::size_t> ma_iReturned { 0 };
+	std::atomic<std::size_t> ma_iRejected { 0 };
+	std::atomic<std::size_t> ma_iExpired  { 0 };
+
+	static std::atomic<bool> s_bUseByDefault;
+
+}; // KConnectionPool
+
+} // end of namespace dekaf2
@@ -0,0 +1,273 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#include "kcoroutine.h"
+
+#if DEKAF2_HAS_COROUTINES
+
+#ifndef DEKAF2_IS_WINDOWS
+	#include "bits/kasio.h"
+	#include "klog.h"
+	#include <cerrno>
+	#include <cstring>
+	#include <memory>
+	#include <thread>
+	#include <poll.h>
+	#include <unistd.h>
+#endif
+
+namespace dekaf2 {
+
+#ifndef DEKAF2_IS_WINDOWS
+
+namespace {
+
+//-----------------------------------------------------------------------------
+/// continue a coroutine on the pool it was running on, or right here
+void Resume(KThreadPool* Pool, std::coroutine_handle<> Handle)
+//-----------------------------------------------------------------------------
+{
+	if (Pool)
+	{
+		Pool->push([Handle]()
+		{
+			Handle.resume();
+		});
+	}
+	else
+	{
+		Handle.resume();
+	}
+
+} // Resume
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// one shared io context with a background thread that waits for the
+/// readiness of sockets on behalf of suspended coroutines
+class IOReactor
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	//-----------------------------------------------------------------------------
+	static IOReactor& GetInstance()
+	//-----------------------------------------------------------------------------
+	{
+		static IOReactor s_Reactor;
+		return s_Reactor;
+	}
+
+	//-----------------------------------------------------------------------------
+	void Wait(int iSocket, KAwaitSocket::Direction direction, KDuration Timeout,
+	          KThreadPool* Pool, std::coroutine_handle<> Handle, bool& bTimedOut)
+	//-----------------------------------------------------------------------------
+	{
+		// all operations on the wait objects run on the reactor thread
+		boost::asio::post(m_IOContext, [this, iSocket, direction, Timeout, Pool, Handle, &bTimedOut]()
+		{
+			// we watch a duplicate of the socket handle, so that the reactor's
+			// registration does not interfere with the io service of the stream
+			auto fd = ::dup(iSocket);
+
+			if (fd < 0)
+			{
+				// the following I/O operation will report the error
+				kDebug(2, "cannot duplicate socket {}: {}", iSocket, strerror(errno));
+				Resume(Pool, Handle);
+				return;
+			}
+
+			auto waiter = std::make_shared<Waiter>(m_IOContext);
+
+			boost::system::error_code ec;
+			waiter->Descriptor.assign(fd, ec);
+
+			if (ec)
+			{
+				::close(fd);
+				kDebug(2, "cannot watch socket {}: {}", iSocket, ec.message());
+				Resume(Pool, Handle);
+				return;
+			}
+
+			waiter->Descriptor.async_wait(direction == KAwaitSocket::Read
+			                              ? boost::asio::posix::stream_descriptor::wait_read
+			                              : boost::asio::posix::stream_descriptor::wait_write,
+			[waiter, Pool, Handle](const boost::system::error_code& ec)
+			{
+				if (!waiter->bDone)
+				{
+					// errors are reported by the following I/O operation
+					waiter->bDone = true;
+					boost::system::error_code ignore;
+					waiter->Timer.cancel(ignore);
+					Resume(Pool, Handle);
+				}
+			});
+
+			if (Timeout > KDuration::zero())
+			{
+				waiter->Timer.expires_after(std::chrono::duration_cast<boost::asio::steady_timer::duration>(Timeout));
+				waiter->Timer.async_wait([waiter, Pool, Handle, &bTimedOut](const boost::system::error_code& ec)
+				{
+					if (!ec && !waiter->bDone)
+					{
+						waiter->bDone = true;
+						bTimedOut     = true;
+						boost::system::error_code ignore;
+						waiter->Descriptor.cancel(ignore);
+						Resume(Pool, Handle);
+					}
+				});
+			}
+		});
+	}
+
+//----------
+private:
+//----------
+
+	//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	/// the wait objects of one suspended coroutine - they live until both
+	/// handlers were called
+	struct Waiter
+	//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	{
+		Waiter(boost::asio::io_context& IOContext)
+		: Descriptor (IOContext)
+		, Timer      (IOContext)
+		{
+		}
+
+		boost::asio::posix::stream_descriptor Descriptor;
+		boost::asio::steady_timer             Timer;
+		bool                                  bDone { false };
+	};
+
+	//-----------------------------------------------------------------------------
+	IOReactor()
+	//-----------------------------------------------------------------------------
+	: m_Work   (boost::asio::make_work_guard(m_IOContext))
+	, m_Thread ([this]()
+	{
+		for (;;)
+		{
+			try
+			{
+				m_IOContext.run();
+				return;
+			}
+			catch (const std::exception& ex)
+			{
+				kException(ex);
+			}
+		}
+	})
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	~IOReactor()
+	//-----------------------------------------------------------------------------
+	{
+		m_Work.reset();
+		m_IOContext.stop();
+		m_Thread.join();
+	}
+
+	boost::asio::io_context m_IOContext;
+	boost::asio::executor_work_guard<boost::asio::io_context::executor_type> m_Work;
+	std::thread             m_Thread;
+
+}; // IOReactor
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+bool KAwaitSocket::await_ready() const noexcept
+//-----------------------------------------------------------------------------
+{
+	pollfd Poll;
+	Poll.fd      = m_iSocket;
+	Poll.events  = (m_Direction == Read) ? POLLIN : POLLOUT;
+	Poll.revents = 0;
+
+	// a socket with an error or hangup is ready as well, the
+	// following I/O operation will report it
+	return ::poll(&Poll, 1, 0) > 0;
+
+} // await_ready
+
+//-----------------------------------------------------------------------------
+void KAwaitSocket::await_suspend(std::coroutine_handle<> Handle)
+//-----------------------------------------------------------------------------
+{
+	IOReactor::GetInstance().Wait(m_iSocket, m_Direction, m_Timeout, KThreadPool::get_current_pool(), Handle, m_bTimedOut);
+
+} // await_suspend
+
+#else // DEKAF2_IS_WINDOWS
+
+//-----------------------------------------------------------------------------
+bool KAwaitSocket::await_ready() const noexcept
+//-----------------------------------------------------------------------------
+{
+	// we have no reactor on Windows, the following I/O operation blocks
+	return true;
+
+} // await_ready
+
+//-----------------------------------------------------------------------------
+void KAwaitSocket::await_suspend(std::coroutine_handle<> Handle)
+//-----------------------------------------------------------------------------
+{
+	Handle.resume();
+
+} // await_suspend
+
+#endif // DEKAF2_IS_WINDOWS
+
+} // end of namespace dekaf2
+
+#endif // DEKAF2_HAS_COROUTINES
@@ -0,0 +1,484 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#pragma once
+
+/// @file kcoroutine.h
+/// C++20 coroutine task type that runs on KThreadPool workers, and an awaitable
+/// that suspends a coroutine until a socket is ready for I/O
+
+#include "bits/kcppcompat.h"
+
+#if DEKAF2_HAS_COROUTINES
+
+#include "kthreadpool.h"
+#include "kduration.h"
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace dekaf2
+{
+
+template<typename T = void>
+class KTask;
+
+namespace detail {
+namespace coroutine {
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// the common part of the promise types of KTask
+class DEKAF2_PUBLIC PromiseBase
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	/// at the end of the task, continue with the coroutine that awaited it
+	struct FinalAwaiter
+	//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	{
+		bool await_ready() const noexcept { return false; }
+
+		template<typename Promise>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> Handle) noexcept
+		{
+			auto Continuation = Handle.promise().GetContinuation();
+			return Continuation ? Continuation : std::noop_coroutine();
+		}
+
+		void await_resume() const noexcept {}
+	};
+
+	// tasks are lazy, they start when they are awaited
+	std::suspend_always initial_suspend() const noexcept { return {}; }
+	FinalAwaiter        final_suspend()   const noexcept { return {}; }
+	void                unhandled_exception() noexcept   { m_Exception = std::current_exception(); }
+
+	void SetContinuation(std::coroutine_handle<> Continuation) { m_Continuation = Continuation; }
+	std::coroutine_handle<> GetContinuation() const            { return m_Continuation;         }
+
+//----------
+protected:
+//----------
+
+	void Rethrow() const
+	{
+		if (m_Exception)
+		{
+			std::rethrow_exception(m_Exception);
+		}
+	}
+
+//----------
+private:
+//----------
+
+	std::coroutine_handle<> m_Continuation;
+	std::exception_ptr      m_Exception;
+
+}; // PromiseBase
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// promise type of KTask<T>
+template<typename T>
+class Promise : public PromiseBase
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	KTask<T> get_return_object() noexcept;
+
+	template<typename U>
+	void return_value(U&& Value)
+	{
+		m_Value.emplace(std::forward<U>(Value));
+	}
+
+	T Result()
+	{
+		Rethrow();
+		return std::move(*m_Value);
+	}
+
+//----------
+private:
+//----------
+
+	std::optional<T> m_Value;
+
+}; // Promise
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// promise type of KTask<void>
+template<>
+class Promise<void> : public PromiseBase
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	KTask<void> get_return_object() noexcept;
+
+	void return_void() const noexcept {}
+
+	void Result() const
+	{
+		Rethrow();
+	}
+
+}; // Promise<void>
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// awaitable that continues the coroutine on a worker of a KThreadPool
+class ResumeOnPool
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	explicit ResumeOnPool(KThreadPool& Pool) noexcept : m_Pool(Pool) {}
+
+	bool await_ready() const noexcept { return false; }
+
+	void await_suspend(std::coroutine_handle<> Handle)
+	{
+		m_Pool.push([Handle]()
+		{
+			Handle.resume();
+		});
+	}
+
+	void await_resume() const noexcept {}
+
+//----------
+private:
+//----------
+
+	KThreadPool& m_Pool;
+
+}; // ResumeOnPool
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// a coroutine that starts immediately and destroys itself when it finishes
+struct Detached
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	struct promise_type
+	{
+		Detached            get_return_object()   const noexcept { return {}; }
+		std::suspend_never  initial_suspend()     const noexcept { return {}; }
+		std::suspend_never  final_suspend()       const noexcept { return {}; }
+		void                return_void()         const noexcept {}
+		void                unhandled_exception() const noexcept { std::terminate(); }
+	};
+
+}; // Detached
+
+} // end of namespace coroutine
+} // end of namespace detail
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// A lazily started coroutine task with a result of type T. Write a coroutine
+/// by returning a KTask<T> from a function that uses co_await or co_return. The
+/// task starts when it is awaited with co_await from another coroutine, or when
+/// it is handed over to kCoSpawn(), which runs it on a KThreadPool.
+///
+/// Do not pass references to temporaries into a coroutine - parameters should be
+/// taken by value, as the coroutine outlives the full expression that created it.
+template<typename T>
+class KTask
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	using promise_type = detail::coroutine::Promise<T>;
+	using handle_type  = std::coroutine_handle<promise_type>;
+
+	KTask() = default;
+	explicit KTask(handle_type Handle) noexcept : m_Handle(Handle) {}
+	KTask(const KTask&) = delete;
+	KTask& operator=(const KTask&) = delete;
+
+	//-----------------------------------------------------------------------------
+	KTask(KTask&& other) noexcept
+	//-----------------------------------------------------------------------------
+	: m_Handle(std::exchange(other.m_Handle, nullptr))
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	KTask& operator=(KTask&& other) noexcept
+	//-----------------------------------------------------------------------------
+	{
+		if (this != &other)
+		{
+			Destroy();
+			m_Handle = std::exchange(other.m_Handle, nullptr);
+		}
+
+		return *this;
+	}
+
+	//-----------------------------------------------------------------------------
+	~KTask()
+	//-----------------------------------------------------------------------------
+	{
+		Destroy();
+	}
+
+	//-----------------------------------------------------------------------------
+	/// returns true if this task holds a coroutine
+	bool IsValid() const noexcept
+	//-----------------------------------------------------------------------------
+	{
+		return static_cast<bool>(m_Handle);
+	}
+
+	//-----------------------------------------------------------------------------
+	/// returns true if the coroutine ran to its end
+	bool IsDone() const noexcept
+	//-----------------------------------------------------------------------------
+	{
+		return m_Handle && m_Handle.done();
+	}
+
+	//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	/// starts the task when awaited, and continues the awaiting coroutine with
+	/// the result (or exception) when the task finished
+	struct Awaiter
+	//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	{
+		bool await_ready() const noexcept
+		{
+			return m_Handle.done();
+		}
+
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> Awaiting) noexcept
+		{
+			m_Handle.promise().SetContinuation(Awaiting);
+			// symmetric transfer into the task
+			return m_Handle;
+		}
+
+		T await_resume()
+		{
+			return m_Handle.promise().Result();
+		}
+
+		handle_type m_Handle;
+	};
+
+	//-----------------------------------------------------------------------------
+	Awaiter operator co_await() const noexcept
+	//-----------------------------------------------------------------------------
+	{
+		return Awaiter { m_Handle };
+	}
+
+//----------
+private:
+//----------
+
+	//-----------------------------------------------------------------------------
+	void Destroy()
+	//-----------------------------------------------------------------------------
+	{
+		if (m_Handle)
+		{
+			m_Handle.destroy();
+			m_Handle = nullptr;
+		}
+	}
+
+	handle_type m_Handle;
+
+}; // KTask
+
+namespace detail {
+namespace coroutine {
+
+template<typename T>
+KTask<T> Promise<T>::get_return_object() noexcept
+{
+	return KTask<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline
+KTask<void> Promise<void>::get_return_object() noexcept
+{
+	return KTask<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+//-----------------------------------------------------------------------------
+/// runs a task on a pool and sets the promise from its result
+template<typename T>
+Detached RunDetached(KThreadPool& Pool, KTask<T> Task, std::promise<T> Result)
+//-----------------------------------------------------------------------------
+{
+	co_await ResumeOnPool(Pool);
+
+	try
+	{
+		if constexpr (std::is_void<T>::value)
+		{
+			co_await Task;
+			Result.set_value();
+		}
+		else
+		{
+			Result.set_value(co_await Task);
+		}
+	}
+	catch (...)
+	{
+		Result.set_exception(std::current_exception());
+	}
+
+} // RunDetached
+
+} // end of namespace coroutine
+} // end of namespace detail
+
+//-----------------------------------------------------------------------------
+/// Continue the calling coroutine on a worker of Pool: co_await kResumeOn(Pool);
+inline
+detail::coroutine::ResumeOnPool kResumeOn(KThreadPool& Pool)
+//-----------------------------------------------------------------------------
+{
+	return detail::coroutine::ResumeOnPool(Pool);
+}
+
+//-----------------------------------------------------------------------------
+/// Start a task on a worker of Pool. When the task suspends for I/O, the worker
+/// is free for other tasks, and the task is continued later on any of the workers.
+/// @param Pool the thread pool to run the task on
+/// @param Task the task to run - it is owned by the pool until it finishes
+/// @return a future for the result of the task - exceptions of the task are
+/// rethrown by its get()
+template<typename T>
+std::future<T> kCoSpawn(KThreadPool& Pool, KTask<T> Task)
+//-----------------------------------------------------------------------------
+{
+	std::promise<T> Result;
+	auto Future = Result.get_future();
+	detail::coroutine::RunDetached(Pool, std::move(Task), std::move(Result));
+	return Future;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// Awaitable that suspends the coroutine until a socket is ready for reading
+/// or writing, or until the timeout expired. While suspended no thread is
+/// blocked - one shared reactor thread watches all waiting sockets. The
+/// coroutine is then continued on the KThreadPool it was running on, or on the
+/// reactor thread if it was not running on a pool.
+/// co_await returns true if the socket is ready, and false on timeout. If the
+/// socket is ready right away, the coroutine is not suspended. On Windows, the
+/// awaitable never suspends and always returns true, so that the following I/O
+/// operation blocks.
+class DEKAF2_PUBLIC KAwaitSocket
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	enum Direction { Read, Write };
+
+	//-----------------------------------------------------------------------------
+	/// @param iSocket the native socket handle
+	/// @param direction wait for Read or Write readiness
+	/// @param Timeout max time to wait, KDuration::zero() for no timeout
+	KAwaitSocket(int iSocket, Direction direction, KDuration Timeout) noexcept
+	//-----------------------------------------------------------------------------
+	: m_Timeout   (Timeout)
+	, m_iSocket   (iSocket)
+	, m_Direction (direction)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	/// does not suspend if the socket is ready right now
+	bool await_ready() const noexcept;
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	void await_suspend(std::coroutine_handle<> Handle);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	bool await_resume() const noexcept
+	//-----------------------------------------------------------------------------
+	{
+		return !m_bTimedOut;
+	}
+
+//----------
+private:
+//----------
+
+	KDuration m_Timeout;
+	int       m_iSocket;
+	Direction m_Direction;
+	bool      m_bTimedOut { false };
+
+}; // KAwaitSocket
+
+} // end of namespace dekaf2
+
+#endif // DEKAF2_HAS_COROUTINES
@@ -69,6 +69,14 @@ const KString& KHTTPClient::BasicAuthenticator::GetAuthHeader(const KOutHTTPRequ
 
 } // BasicAuthenticator::GetAuthHeader
 
+//-----------------------------------------------------------------------------
+std::unique_ptr<KHTTPClient::Authenticator> KHTTPClient::BasicAuthenticator::Clone() const
+//-----------------------------------------------------------------------------
+{
+	return std::make_unique<BasicAuthenticator>(*this);
+
+} // BasicAuthenticator::Clone
+
 //-----------------------------------------------------------------------------
 KHTTPClient::DigestAuthenticator::DigestAuthenticator(KString _sUsername,
 													  KString _sPassword,
@@ -260,10 +268,96 @@ KHTTPClient::KHTTPClient(std::unique_ptr<KConnection> stream)
 
 } // Ctor
 
+//-----------------------------------------------------------------------------
+KHTTPClient::~KHTTPClient()
+//-----------------------------------------------------------------------------
+{
+	ReturnConnectionToPool();
+
+} // dtor
+
+//-----------------------------------------------------------------------------
+KHTTPClient& KHTTPClient::UseConnectionPool(KConnectionPool* Pool)
+//-----------------------------------------------------------------------------
+{
+	if (Pool != m_ConnectionPool)
+	{
+		// hand an existing connection back to the pool it came from
+		ReturnConnectionToPool();
+		m_ConnectionPool = Pool;
+	}
+
+	return *this;
+
+} // UseConnectionPool
+
+//-----------------------------------------------------------------------------
+void KHTTPClient::ReturnConnectionToPool()
+//-----------------------------------------------------------------------------
+{
+	if (m_ConnectionPool && m_Connection && !m_sPoolKey.empty())
+	{
+		// only return connections that are ready for a new request
+		if (m_bKeepAlive           &&
+			m_bResponseComplete    &&
+			!m_bUseHTTPProxyProtocol &&
+			m_Connection->Good())
+		{
+			// tear down the filters while we still own the stream
+			Response.reset();
+			Request.reset();
+			Response.ResetInputStream();
+			Request.ResetOutputStream();
+
+			m_ConnectionPool->Return(m_sPoolKey, std::move(m_Connection));
+		}
+	}
+
+	m_sPoolKey.clear();
+	m_bConnectedFromPool = false;
+
+} // ReturnConnectionToPool
+
+//-----------------------------------------------------------------------------
+bool KHTTPClient::ConnectDirect(const KURL& url)
+//-----------------------------------------------------------------------------
+{
+	if (!m_ConnectionPool)
+	{
+		return Connect(KConnection::Create(url, false, m_bVerifyCerts));
+	}
+
+	// return the current connection before borrowing a new one
+	ReturnConnectionToPool();
+
+	auto sKey       = KConnectionPool::CreateKey(url, false, m_bVerifyCerts);
+	auto Connection = m_ConnectionPool->Borrow(sKey);
+	bool bFromPool  = Connection != nullptr;
+
+	if (!bFromPool)
+	{
+		Connection = m_ConnectionPool->Create(url, false, m_bVerifyCerts);
+	}
+
+	if (!Connect(std::move(Connection)))
+	{
+		return false;
+	}
+
+	m_sPoolKey           = std::move(sKey);
+	m_bConnectedFromPool = bFromPool;
+
+	return true;
+
+} // ConnectDirect
+
 //-----------------------------------------------------------------------------
 bool KHTTPClient::Connect(std::unique_ptr<KConnection> Connection)
 //-----------------------------------------------------------------------------
 {
+	// a previous connection may be reusable by others
+	ReturnConnectionToPool();
+
 	SetError(KStringView{});
 
 	// clear the response object, otherwise a previous
@@ -372,7 +466,7 @@ bool KHTTPClient::Connect(const KURL& url)
 		}
 	}
 
-	return Connect(KConnection::Create(url, false, m_bVerifyCerts));
+	return ConnectDirect(url);
 
 } // Connect
 
@@ -382,7 +476,7 @@ bool KHTTPClient::Connect(const KURL& url, const KURL& Proxy)
 {
 	if (Proxy.empty())
 	{
-		return Connect(KConnection::Create(url, false, m_bVerifyCerts));
+		return ConnectDirect(url);
 	}
 
 	// which protocol on which connection segment?
@@ -503,6 +597,8 @@ bool KHTTPClient::Disconnect()
 	}
 
 	m_Connection.reset();
+	m_sPoolKey.clear();
+	m_bConnectedFromPool = false;
 
 	return true;
 
@@ -713,6 +809,8 @@ bool KHTTPClient::SendRequest(KStringView* svPostData, KInStream* PostDataStream
 {
 	Response.clear();
 
+	m_bResponseComplete = false;
+
 	// remove remaining automatic headers from previous requests
 	Request.Headers.Remove(KHTTPHeader::CONTENT_LENGTH);
 	Request.Headers.Remove(KHTTPHeader::CONTENT_TYPE);
@@ -838,6 +936,10 @@ bool KHTTPClient::Serialize()
 		return SetNetworkError(false, Request.Error());
 	}
 
+	// the output filter is reset when serializing the headers, but is only
+	// built on the first write of the body - now is the time to veto compression
+	Request.AllowCompression(m_bAllowCompression);
+
 	return true;
 
 } // Serialize
@@ -891,6 +993,14 @@ bool KHTTPClient::Parse()
 		m_bKeepAlive = Response.HasKeepAlive();
 	}
 
+	// responses without a body are complete after the header
+	if (Request.Method == KHTTPMethod::HEAD ||
+		Response.GetStatusCode() == KHTTPError::H2xx_NO_CONTENT ||
+		Response.GetStatusCode() == KHTTPError::H304_NOT_MODIFIED)
+	{
+		m_bResponseComplete = true;
+	}
+
 	kDebug(2, "HTTP-{} {}", Response.GetStatusCode(), Response.GetStatusString());
 
 	return true;
@@ -1032,6 +1142,13 @@ bool KHTTPClient::SetNetworkError(bool bRead, KString sError)
 
 	m_bKeepAlive = false;
 
+	if (m_bConnectedFromPool && m_ConnectionPool)
+	{
+		// other idle connections to this host have likely been
+		// closed by the server as well
+		m_ConnectionPool->Purge(m_sPoolKey);
+	}
+
 	return SetError(std::move(sError));
 
 } // SetNetworkError
@@ -47,6 +47,7 @@
 #include "kstring.h"
 #include "kstringview.h"
 #include "kconnection.h"
+#include "kconnectionpool.h"
 #include "khttp_response.h"
 #include "khttp_request.h"
 #include "khttp_method.h"
@@ -93,6 +94,9 @@ public:
 		/// check if this authenticator needs the content data to compute
 		/// @return true if it needs content data, false otherwise
 		virtual bool NeedsContentData() const { return false; }
+		/// return a copy of this authenticator for use in another client
+		/// @return the copy, or nullptr if this authenticator cannot be copied
+		virtual std::unique_ptr<Authenticator> Clone() const { return nullptr; }
 
 	}; // Authenticator
 
@@ -113,6 +117,7 @@ public:
 		/// @param _sPassword the password for basic auth
 		BasicAuthenticator(KString _sUsername, KString _sPassword);
 		virtual const KString& GetAuthHeader(const KOutHTTPRequest& Request, KStringView sBody) override;
+		virtual std::unique_ptr<Authenticator> Clone() const override;
 
 		/// the username
 		KString sUsername;
@@ -148,6 +153,8 @@ public:
 							KString _sQoP);
 		virtual const KString& GetAuthHeader(const KOutHTTPRequest& Request, KStringView sBody) override;
 		virtual bool NeedsContentData() const override;
+		// no Clone(), as copies would reuse the nonce counts
+		virtual std::unique_ptr<Authenticator> Clone() const override { return nullptr; }
 
 		KString sRealm;
 		KString sNonce;
@@ -200,6 +207,11 @@ public:
 	KHTTPClient& operator=(KHTTPClient&&) = delete;
 	//-----------------------------------------------------------------------------
 
+	//-----------------------------------------------------------------------------
+	/// dtor, returns a reusable connection into the connection pool if one is in use
+	~KHTTPClient();
+	//-----------------------------------------------------------------------------
+
 	//-----------------------------------------------------------------------------
 	/// Connect with a KConnection object
 	bool Connect(std::unique_ptr<KConnection> Connection);
@@ -276,7 +288,15 @@ public:
 	size_t Read(KOutStream& stream, size_t len = npos)
 	//-----------------------------------------------------------------------------
 	{
-		return Response.Read(stream, len);
+		auto iRead = Response.Read(stream, len);
+
+		if (len == npos)
+		{
+			// a completely read response permits the reuse of the connection
+			m_bResponseComplete = !Response.Fail();
+		}
+
+		return iRead;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -284,7 +304,15 @@ public:
 	size_t Read(KStringRef& sBuffer, size_t len = npos)
 	//-----------------------------------------------------------------------------
 	{
-		return Response.Read(sBuffer, len);
+		auto iRead = Response.Read(sBuffer, len);
+
+		if (len == npos)
+		{
+			// a completely read response permits the reuse of the connection
+			m_bResponseComplete = !Response.Fail();
+		}
+
+		return iRead;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -389,6 +417,14 @@ public:
 	self& SetTimeout(int iSeconds);
 	//-----------------------------------------------------------------------------
 
+	//-----------------------------------------------------------------------------
+	/// Get the connection timeout in seconds
+	int GetTimeout() const
+	//-----------------------------------------------------------------------------
+	{
+		return m_Timeout;
+	}
+
 	//-----------------------------------------------------------------------------
 	/// Request response compression. Default is true.
 	/// @param bYesNo if true, request response compression
@@ -407,14 +443,39 @@ public:
 	}
 
 	//-----------------------------------------------------------------------------
-	/// Compress outgoing request? Default is true
+	/// Compress outgoing request? Default is true. Switch it off if the request body
+	/// is already compressed, and only the Content-Encoding header shall be sent.
 	self& AllowCompression(bool bYesNo)
 	//-----------------------------------------------------------------------------
 	{
-		Request.AllowCompression(bYesNo);
+		m_bAllowCompression = bYesNo;
 		return *this;
 	}
 
+	//-----------------------------------------------------------------------------
+	/// Borrow connections from and return them to the process wide KConnectionPool?
+	/// Default is taken from KConnectionPool::GetUseByDefault(), which is false.
+	/// Connections through proxies are never pooled.
+	self& UseConnectionPool(bool bYesNo = true)
+	//-----------------------------------------------------------------------------
+	{
+		return UseConnectionPool(bYesNo ? &KConnectionPool::GetInstance() : nullptr);
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Borrow connections from and return them to the given KConnectionPool, or switch
+	/// pooling off with nullptr. The pool has to outlive this client.
+	self& UseConnectionPool(KConnectionPool* Pool);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// Get the connection pool in use, or nullptr if none
+	KConnectionPool* GetConnectionPool() const
+	//-----------------------------------------------------------------------------
+	{
+		return m_ConnectionPool;
+	}
+
 	//-----------------------------------------------------------------------------
 	/// Allow auto configuration of proxy server from environment variables?
 	self& AutoConfigureProxy(bool bYes = true)
@@ -507,6 +568,23 @@ protected:
 	bool SendRequest(KStringView* svPostData, KInStream* PostDataStream, size_t len, const KMIME& Mime);
 	//-----------------------------------------------------------------------------
 
+	//-----------------------------------------------------------------------------
+	/// Returns the authenticator, or nullptr if none is set
+	const Authenticator* GetAuthenticator() const
+	//-----------------------------------------------------------------------------
+	{
+		return m_Authenticator.get();
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Returns true if the current connection was borrowed from the connection pool
+	/// and not newly created
+	bool ConnectedFromPool() const
+	//-----------------------------------------------------------------------------
+	{
+		return m_bConnectedFromPool;
+	}
+
 //------
 private:
 //------
@@ -516,8 +594,20 @@ private:
 	DEKAF2_PRIVATE bool SetHostHeader(const KURL& url, bool bForcePort = false);
 	//-----------------------------------------------------------------------------
 
+	//-----------------------------------------------------------------------------
+	/// connects directly to url, either by a new connection or by one from the pool
+	DEKAF2_PRIVATE bool ConnectDirect(const KURL& url);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// hands the current connection back to the pool if it is reusable
+	DEKAF2_PRIVATE void ReturnConnectionToPool();
+	//-----------------------------------------------------------------------------
+
 	std::unique_ptr<KConnection>   m_Connection;
 	std::unique_ptr<Authenticator> m_Authenticator;
+	KConnectionPool* m_ConnectionPool { KConnectionPool::GetUseByDefault() ? &KConnectionPool::GetInstance() : nullptr };
+	KString          m_sPoolKey;
 	mutable KString  m_sError;
 	KString          m_sForcedHost;
 	KString          m_sCompressors;
@@ -525,10 +615,13 @@ private:
 	int              m_Timeout { 30 };
 	bool             m_bVerifyCerts { false };
 	bool             m_bRequestCompression { true };
+	bool             m_bAllowCompression { true };
 	bool             m_bAutoProxy { false };
 	bool             m_bUseHTTPProxyProtocol { false };
 	bool             m_bKeepAlive { true };
 	bool             m_bHaveHostSet { false };
+	bool             m_bConnectedFromPool { false };
+	bool             m_bResponseComplete { false };
 
 //------
 public:
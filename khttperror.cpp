@@ -92,6 +92,7 @@ KStringView KHTTPError::GetStatusString(uint16_t iStatusCode)
 		case H2xx_CREATED:            return "CREATED";
 		case H2xx_ACCEPTED:           return "ACCEPTED";
 		case H2xx_NO_CONTENT:         return "NO CONTENT";
+		case H2xx_PARTIAL_CONTENT:    return "PARTIAL CONTENT";
 		case H2xx_UPDATED:            return "UPDATED";
 		case H2xx_DELETED:            return "DELETED";
 		case H2xx_ALREADY:            return "ALREADY DONE";
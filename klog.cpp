@@ -127,6 +127,8 @@ void KLog::IntException(KStringView sWhat, KStringView sFunction, KStringView sC
 
 #include "bits/klogwriter.h"
 #include "bits/klogserializer.h"
+#include "bits/klogasync.h"
+#include "bits/klogbinary.h"
 #include "dekaf2.h"
 #include "kstring.h"
 #include "kgetruntimestack.h"
@@ -167,6 +169,7 @@ thread_local bool KLog::s_bPrintTimeStampOnClose { false };
 #endif
 thread_local bool KLog::s_bPerThreadEGrep { false };
 thread_local bool KLog::PreventRecursion::s_bCalledFromInsideKlog { false };
+thread_local KString KLog::s_sDeferredArgs;
 
 // do not initialize this static var - it risks to override a value set by KLog()'s
 // initialization before..
@@ -176,6 +179,74 @@ int KLog::s_iLogLevel;
 // the current global log level
 thread_local int KLog::s_iThreadLogLevel { s_iLogLevel };
 
+std::atomic<uint32_t> KLogCallSite::s_iMaxPerInterval { 0 };
+std::atomic<uint32_t> KLogCallSite::s_iSampleOneIn { 0 };
+std::atomic<KLogCallSite*> KLogCallSite::s_pFirst { nullptr };
+
+//---------------------------------------------------------------------------
+KLogCallSite::KLogCallSite(const char* sFile, uint32_t iLine) noexcept
+//---------------------------------------------------------------------------
+: m_sFile(sFile)
+, m_iLine(iLine)
+{
+	// push ourself to the front of the list of all call sites
+	m_pNext = s_pFirst.load(std::memory_order_relaxed);
+
+	while (!s_pFirst.compare_exchange_weak(m_pNext, this, std::memory_order_release, std::memory_order_relaxed))
+	{
+	}
+
+} // ctor
+
+//---------------------------------------------------------------------------
+bool KLogCallSite::Admit() noexcept
+//---------------------------------------------------------------------------
+{
+	auto iMaxPerInterval = s_iMaxPerInterval.load(std::memory_order_relaxed);
+
+	if (!iMaxPerInterval)
+	{
+		return true;
+	}
+
+	auto iCount = m_iCount.fetch_add(1, std::memory_order_relaxed);
+
+	if (iCount < iMaxPerInterval)
+	{
+		return true;
+	}
+
+	auto iSampleOneIn = s_iSampleOneIn.load(std::memory_order_relaxed);
+
+	if (iSampleOneIn && (iCount - iMaxPerInterval + 1) % iSampleOneIn == 0)
+	{
+		return true;
+	}
+
+	m_iSuppressed.fetch_add(1, std::memory_order_relaxed);
+
+	return false;
+
+} // Admit
+
+//---------------------------------------------------------------------------
+void KLogCallSite::EndInterval(const Callback& Report)
+//---------------------------------------------------------------------------
+{
+	for (auto CallSite = s_pFirst.load(std::memory_order_acquire); CallSite; CallSite = CallSite->m_pNext)
+	{
+		CallSite->m_iCount.store(0, std::memory_order_relaxed);
+
+		auto iSuppressed = CallSite->m_iSuppressed.exchange(0, std::memory_order_relaxed);
+
+		if (iSuppressed && Report)
+		{
+			Report(*CallSite, iSuppressed);
+		}
+	}
+
+} // EndInterval
+
 //---------------------------------------------------------------------------
 KLog::KLog()
 //---------------------------------------------------------------------------
@@ -247,7 +318,7 @@ KLog::KLog()
 
 	Dekaf::getInstance().AddToOneSecTimer([this]()
 	{
-		this->CheckDebugFlag();
+		this->OnOneSecTimer();
 	});
 
 } // ctor
@@ -259,8 +330,64 @@ dekaf2::KLog::~KLog()
 	// we need the dtor in the cpp, as otherwise the compiler would not have
 	// access to KLogWriter / KLogSerializer type information..
 
+	// stop the async queue while the writer and serializer still exist - this
+	// writes all pending records
+	m_bAsync = false;
+	m_AsyncQueue.reset();
+	m_BinaryLog.reset();
+
 } // dtor
 
+//---------------------------------------------------------------------------
+void KLog::OnOneSecTimer()
+//---------------------------------------------------------------------------
+{
+	CheckDebugFlag();
+
+	if (KLogCallSite::s_iMaxPerInterval.load(std::memory_order_relaxed))
+	{
+		if (++m_iRateLimitSeconds >= m_iRateLimitInterval.load(std::memory_order_relaxed))
+		{
+			m_iRateLimitSeconds = 0;
+			EndRateLimitInterval();
+		}
+	}
+
+} // OnOneSecTimer
+
+//---------------------------------------------------------------------------
+KLog& KLog::SetRateLimit(uint32_t iMaxPerInterval, uint32_t iSampleOneIn, chrono::seconds Interval)
+//---------------------------------------------------------------------------
+{
+	m_iRateLimitInterval = static_cast<uint32_t>(std::max(Interval.count(), chrono::seconds::rep(1)));
+	KLogCallSite::s_iSampleOneIn    = iSampleOneIn;
+	KLogCallSite::s_iMaxPerInterval = iMaxPerInterval;
+
+	if (!iMaxPerInterval)
+	{
+		// report what was suppressed until now, and reset the counters
+		EndRateLimitInterval();
+	}
+
+	return *this;
+
+} // SetRateLimit
+
+//---------------------------------------------------------------------------
+KLog& KLog::EndRateLimitInterval()
+//---------------------------------------------------------------------------
+{
+	KLogCallSite::EndInterval([this](const KLogCallSite& CallSite, std::size_t iSuppressed)
+	{
+		IntDebug(-1,
+		         kFormat("{}:{}", kBasename(CallSite.GetFile()), CallSite.GetLine()),
+		         kFormat("suppressed {} log messages", iSuppressed));
+	});
+
+	return *this;
+
+} // EndRateLimitInterval
+
 //---------------------------------------------------------------------------
 KLog& KLog::SetDefaults()
 //---------------------------------------------------------------------------
@@ -292,6 +419,7 @@ KLog& KLog::SetDefaults()
 	std::lock_guard<std::recursive_mutex> Lock(m_LogMutex);
 
 	m_Traces.clear();
+	m_bHaveTraces = false;
 
 	return *this;
 
@@ -517,7 +645,15 @@ bool KLog::SetDebugLog(KStringView sLogfile)
 KLog& KLog::SetWriter(std::unique_ptr<KLogWriter> logger)
 //---------------------------------------------------------------------------
 {
+	// the async writer thread may use the writer right now
+	std::lock_guard<std::recursive_mutex> Lock(m_LogMutex);
 	m_Logger = std::move(logger);
+
+	if (m_Logger && m_Serializer)
+	{
+		m_Logger->SetJSONRecords(m_Serializer->IsJSON());
+	}
+
 	return *this;
 
 } // SetWriter
@@ -534,7 +670,15 @@ KLog& KLog::SetWriter(Writer writer, KStringViewZ sLogname)
 KLog& KLog::SetSerializer(std::unique_ptr<KLogSerializer> serializer)
 //---------------------------------------------------------------------------
 {
+	// the async writer thread may use the serializer right now
+	std::lock_guard<std::recursive_mutex> Lock(m_LogMutex);
 	m_Serializer = std::move(serializer);
+
+	if (m_Logger && m_Serializer)
+	{
+		m_Logger->SetJSONRecords(m_Serializer->IsJSON());
+	}
+
 	return *this;
 
 } // SetSerializer
@@ -842,6 +986,7 @@ void KLog::CheckDebugFlag(bool bForce/*=false*/)
 							if (bNewTrace)
 							{
 								m_Traces.push_back(it.second);
+								m_bHaveTraces = true;
 							}
 						}
 
@@ -884,6 +1029,188 @@ KLog& KLog::LogWithGrepExpression(bool bEGrep, bool bInverted, KStringView sGrep
 
 } // LogWithGrepExpression
 
+//---------------------------------------------------------------------------
+KLog& KLog::SetAsync(bool bYesNo, std::size_t iRecordsPerThread, AsyncOverflow Overflow)
+//---------------------------------------------------------------------------
+{
+	if (bYesNo)
+	{
+		{
+			std::lock_guard<std::recursive_mutex> Lock(m_LogMutex);
+
+			if (!m_AsyncQueue)
+			{
+				m_AsyncQueue = std::make_unique<KLogAsyncQueue>([this](const KLogRecord& Record)
+				{
+					IntWriteRecord(Record);
+				},
+				iRecordsPerThread,
+				static_cast<KLogAsyncQueue::Overflow>(Overflow));
+			}
+			else
+			{
+				m_AsyncQueue->SetRecordsPerThread(iRecordsPerThread);
+				m_AsyncQueue->SetOverflow(static_cast<KLogAsyncQueue::Overflow>(Overflow));
+			}
+		}
+
+		m_bAsync.store(true, std::memory_order_release);
+	}
+	else if (m_bAsync.exchange(false))
+	{
+		// the queue stays alive, as other threads may just be pushing
+		// into it - but we write all pending records now.
+		// Never call Flush() with the log mutex held, the writer thread
+		// takes the mutex while holding its own lock
+		Flush();
+	}
+
+	return *this;
+
+} // SetAsync
+
+//---------------------------------------------------------------------------
+KLog& KLog::Flush()
+//---------------------------------------------------------------------------
+{
+	if (m_AsyncQueue)
+	{
+		m_AsyncQueue->Flush();
+	}
+
+	std::shared_ptr<KLogWriter> Logger;
+
+	{
+		std::lock_guard<std::recursive_mutex> Lock(m_LogMutex);
+		Logger = m_Logger;
+	}
+
+	if (Logger)
+	{
+		// network writers ship their records in batches - we wait for them
+		// without the log mutex, so that other threads can continue logging,
+		// and the shared pointer keeps the writer alive should it be replaced
+		// in the meantime
+		Logger->Flush();
+	}
+
+	return *this;
+
+} // Flush
+
+//---------------------------------------------------------------------------
+std::size_t KLog::GetDroppedRecords() const
+//---------------------------------------------------------------------------
+{
+	return m_AsyncQueue ? m_AsyncQueue->GetDropped() : 0;
+
+} // GetDroppedRecords
+
+//---------------------------------------------------------------------------
+void KLog::IntWriteRecord(const KLogRecord& Record)
+//---------------------------------------------------------------------------
+{
+	// this is called from the async writer thread - log output created
+	// by the writers or serializers would only end up in this thread's
+	// own ring buffer, so switch it off
+	PreventRecursion PR;
+
+	std::lock_guard<std::recursive_mutex> Lock(m_LogMutex);
+
+	if (!Available())
+	{
+		return;
+	}
+
+	if (m_BinaryLog)
+	{
+		// deferred records stay unformatted
+		m_BinaryLog->Write(Record);
+		return;
+	}
+
+	KString sFormatted;
+	KStringView sMessage = Record.sMessage;
+
+	if (!Record.sFormat.empty())
+	{
+		sFormatted = KLogBinaryArgs::Format(Record.sFormat, Record.sArgs);
+		sMessage   = sFormatted;
+	}
+
+	m_Serializer->Set(Record.iLevel, m_sShortName, m_sPathName, Record.sFunction, sMessage);
+	m_Serializer->SetOrigin(Record.Pid, Record.Tid, Record.Time);
+
+	if (m_Serializer->Matches(m_bEGrep, m_bInvertedGrep, m_sGrepExpression))
+	{
+		m_Logger->Write(Record.iLevel, m_Serializer->IsMultiline(), m_Serializer->Get());
+	}
+
+} // IntWriteRecord
+
+//---------------------------------------------------------------------------
+bool KLog::SetBinaryLog(KStringViewZ sFileName)
+//---------------------------------------------------------------------------
+{
+	// write pending records into the current destination
+	Flush();
+
+	std::lock_guard<std::recursive_mutex> Lock(m_LogMutex);
+
+	if (sFileName.empty())
+	{
+		m_BinaryLog.reset();
+		return true;
+	}
+
+	auto BinaryLog = std::make_unique<KLogBinaryFileWriter>(sFileName, m_sShortName, m_sPathName);
+
+	if (!BinaryLog->Good())
+	{
+		return false;
+	}
+
+	m_BinaryLog = std::move(BinaryLog);
+
+	return true;
+
+} // SetBinaryLog
+
+//---------------------------------------------------------------------------
+bool KLog::CanPushAsync(int iLevel) const
+//---------------------------------------------------------------------------
+{
+	// records that need a stack trace or per-thread logging are
+	// output synchronously
+	return m_bAsync.load(std::memory_order_acquire)
+	    && iLevel <= s_iLogLevel
+	    && iLevel >  m_iBackTrace
+	    && !m_bHaveTraces.load(std::memory_order_relaxed)
+	    && !s_PerThreadWriter;
+
+} // CanPushAsync
+
+//---------------------------------------------------------------------------
+bool KLog::IntDebugEncoded(int iLevel, KStringView sFunction, KStringView sFormat, KStringView sArgs)
+//---------------------------------------------------------------------------
+{
+	if (CanPushAsync(iLevel) && Available() && Dekaf::IsStarted() && !Dekaf::IsShutDown())
+	{
+		PreventRecursion PR;
+
+		if (!PR.IsRecursive())
+		{
+			m_AsyncQueue->PushDeferred(iLevel, sFunction, sFormat, sArgs);
+		}
+
+		return true;
+	}
+
+	// this record cannot be deferred, format it now
+	return IntDebug(iLevel, sFunction, KLogBinaryArgs::Format(sFormat, sArgs));
+
+} // IntDebugEncoded
+
 //---------------------------------------------------------------------------
 bool KLog::IntDebug(int iLevel, KStringView sFunction, KStringView sMessage)
 //---------------------------------------------------------------------------
@@ -923,6 +1250,14 @@ bool KLog::IntDebug(int iLevel, KStringView sFunction, KStringView sMessage)
 		return false;
 	}
 
+	if (CanPushAsync(iLevel))
+	{
+		// async mode: hand the raw record over to the writer thread,
+		// without taking the log mutex
+		m_AsyncQueue->Push(iLevel, sFunction, sMessage);
+		return true;
+	}
+
 	// We need a lock if we run in multithreading, as the serializers
 	// have data members. We use a recursive mutex because we want to
 	// protect multiple entry points that eventually call this function.
@@ -47,11 +47,15 @@
 
 #include "kconfiguration.h"
 #include "bits/kcppcompat.h"
+#include "bits/klogbinaryargs.h"
 #include "kstring.h"
 #include "kstringview.h"
 #include "kformat.h"
 #include "ktime.h"
 
+#include <atomic>
+#include <cstring>
+#include <functional>
 #include <memory>
 #include <exception>
 #include <mutex>
@@ -66,11 +70,73 @@ namespace dekaf2
 
 class KLogWriter;
 class KLogSerializer;
+class KLogAsyncQueue;
+class KLogBinaryFileWriter;
+class KLogBatchShipper;
+struct KLogRecord;
 
 #ifdef DEKAF2_KLOG_WITH_TCP
 class KHTTPHeaders;
 #endif
 
+#ifdef DEKAF2_WITH_KLOG
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// Counts the log messages of one call site (file:line) for rate limiting
+/// and sampling, see KLog::SetRateLimit(). The logging macros create one
+/// static instance per call site. Counting does not take any lock.
+class DEKAF2_PUBLIC KLogCallSite
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	using Callback = std::function<void(const KLogCallSite& CallSite, std::size_t iSuppressed)>;
+
+	/// registers the call site in a global list
+	KLogCallSite(const char* sFile, uint32_t iLine) noexcept;
+
+	//---------------------------------------------------------------------------
+	/// returns true if rate limiting is switched on
+	static bool IsActive() noexcept
+	//---------------------------------------------------------------------------
+	{
+		return s_iMaxPerInterval.load(std::memory_order_relaxed) != 0;
+	}
+
+	/// counts a message, and returns true if it shall be output
+	bool Admit() noexcept;
+
+	/// returns the source file of the call site
+	const char* GetFile() const { return m_sFile; }
+	/// returns the source line of the call site
+	uint32_t    GetLine() const { return m_iLine; }
+
+	/// resets the counters of all call sites, and calls Report for each call
+	/// site that suppressed messages since the last call
+	static void EndInterval(const Callback& Report);
+
+	/// max messages per call site and interval, 0 switches rate limiting off
+	static std::atomic<uint32_t> s_iMaxPerInterval;
+	/// after reaching the max, let every n'th message pass, 0 for none
+	static std::atomic<uint32_t> s_iSampleOneIn;
+
+//----------
+private:
+//----------
+
+	static std::atomic<KLogCallSite*> s_pFirst;
+
+	const char*           m_sFile;
+	KLogCallSite*         m_pNext { nullptr };
+	std::atomic<uint32_t> m_iCount { 0 };
+	std::atomic<uint32_t> m_iSuppressed { 0 };
+	uint32_t              m_iLine;
+
+}; // KLogCallSite
+#endif
+
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 /// Primary logging facility for dekaf2.
 /// The logging logics in dekaf historically follows the idea that the log
@@ -268,6 +334,140 @@ public:
 		return m_sPathName;
 	}
 
+	/// What to do in async mode when the log buffer of a thread is full
+	enum class AsyncOverflow
+	{
+		BLOCK,           ///< wait until the background thread made room
+		DROP,            ///< drop the log record, only count it
+		DROP_AND_REPORT  ///< drop the log record, and log the count of dropped records
+	};
+
+	//---------------------------------------------------------------------------
+	/// Switch asynchronous logging on or off. In async mode every thread pushes
+	/// its log records into its own lock free ring buffer, and one background
+	/// thread serializes and writes them. Log calls then neither wait for the
+	/// log mutex nor for the output device. Records that need a stack trace,
+	/// and per-thread logging, are still output synchronously. Records of
+	/// different threads may appear in a different order than they were created.
+	/// @param bYesNo true to switch async mode on, false to switch it off
+	/// @param iRecordsPerThread the capacity of the ring buffer of each thread,
+	/// only affects threads that did not yet log in async mode
+	/// @param Overflow what to do when the ring buffer of a thread is full
+	self& SetAsync(bool bYesNo, std::size_t iRecordsPerThread = 4096, AsyncOverflow Overflow = AsyncOverflow::DROP_AND_REPORT)
+	//---------------------------------------------------------------------------
+#ifdef DEKAF2_WITH_KLOG
+	;
+#else
+	{ return *this; }
+#endif
+
+	//---------------------------------------------------------------------------
+	/// Returns true if async mode is switched on
+	bool GetAsync() const
+	//---------------------------------------------------------------------------
+	{
+#ifdef DEKAF2_WITH_KLOG
+		return m_bAsync.load(std::memory_order_relaxed);
+#else
+		return false;
+#endif
+	}
+
+	//---------------------------------------------------------------------------
+	/// Writes all pending log records of async mode and of batching writers, returns when done
+	self& Flush()
+	//---------------------------------------------------------------------------
+#ifdef DEKAF2_WITH_KLOG
+	;
+#else
+	{ return *this; }
+#endif
+
+	//---------------------------------------------------------------------------
+	/// Returns the count of log records that were dropped in async mode
+	std::size_t GetDroppedRecords() const
+	//---------------------------------------------------------------------------
+#ifdef DEKAF2_WITH_KLOG
+	;
+#else
+	{ return 0; }
+#endif
+
+	//---------------------------------------------------------------------------
+	/// Switch deferred formatting on or off. Only has an effect in async mode,
+	/// see SetAsync(). With deferred formatting, log calls with a string literal
+	/// as format string and only arithmetic or string arguments do not format
+	/// on the calling thread: the arguments are copied into a compact binary
+	/// record, and formatted by the background thread - or not at all when
+	/// writing into a binary log, see SetBinaryLog(). All other log calls are
+	/// formatted immediately, as usual.
+	self& SetDeferredFormatting(bool bYesNo)
+	//---------------------------------------------------------------------------
+	{
+#ifdef DEKAF2_WITH_KLOG
+		m_bDeferFormatting = bYesNo;
+#endif
+		return *this;
+	}
+
+	//---------------------------------------------------------------------------
+	/// Returns true if deferred formatting is switched on
+	bool GetDeferredFormatting() const
+	//---------------------------------------------------------------------------
+	{
+#ifdef DEKAF2_WITH_KLOG
+		return m_bDeferFormatting.load(std::memory_order_relaxed);
+#else
+		return false;
+#endif
+	}
+
+	//---------------------------------------------------------------------------
+	/// Write all records that pass through the async queue into a binary log
+	/// file instead of the regular log, without formatting deferred records.
+	/// Records that are output synchronously (like stack traces) still go into
+	/// the regular log. Decode binary logs with "klog decode <file>".
+	/// @param sFileName the binary log file, an empty name switches binary
+	/// logging off again
+	/// @return false if the file could not be opened
+	bool SetBinaryLog(KStringViewZ sFileName)
+	//---------------------------------------------------------------------------
+#ifdef DEKAF2_WITH_KLOG
+	;
+#else
+	{ return false; }
+#endif
+
+	//---------------------------------------------------------------------------
+	/// Limit the output of each call site (file:line) of kDebug(), kDebugLog(),
+	/// kWarning() and kWarningLog() to iMaxPerInterval messages per interval,
+	/// and after that to every iSampleOneIn'th message. Suppressed messages are
+	/// not even formatted. At the end of each interval a warning reports the
+	/// count of suppressed messages per call site.
+	/// @param iMaxPerInterval max messages per call site and interval, 0 switches
+	/// rate limiting off (the default)
+	/// @param iSampleOneIn output every n'th message after reaching the max,
+	/// 0 suppresses all
+	/// @param Interval the interval, in whole seconds
+	self& SetRateLimit(uint32_t iMaxPerInterval, uint32_t iSampleOneIn = 0, chrono::seconds Interval = chrono::seconds(1))
+	//---------------------------------------------------------------------------
+#ifdef DEKAF2_WITH_KLOG
+	;
+#else
+	{ return *this; }
+#endif
+
+	//---------------------------------------------------------------------------
+	/// Report the count of suppressed messages per call site, and start a new
+	/// rate limiting interval. Called by a timer at the end of each interval.
+	self& EndRateLimitInterval()
+	//---------------------------------------------------------------------------
+#ifdef DEKAF2_WITH_KLOG
+	;
+#else
+	{ return *this; }
+#endif
+
 	//---------------------------------------------------------------------------
 	/// Set the output file (or tcp stream) for the log.
 	bool SetDebugLog(KStringView sLogfile)
@@ -418,7 +618,7 @@ public:
 	inline bool debug(int iLevel, Args&&... args)
 	//---------------------------------------------------------------------------
 	{
-		return IntDebug(iLevel, KStringView(), kFormat(std::forward<Args>(args)...));
+		return debug_fun(iLevel, KStringView(), std::forward<Args>(args)...);
 	}
 
 	//---------------------------------------------------------------------------
@@ -436,6 +636,12 @@ public:
 	inline bool debug_fun(int iLevel, KStringView sFunction, Args&&... args)
 	//---------------------------------------------------------------------------
 	{
+#ifdef DEKAF2_WITH_KLOG
+		if (m_bDeferFormatting.load(std::memory_order_relaxed) && m_bAsync.load(std::memory_order_relaxed))
+		{
+			return IntDebugDeferred(iLevel, sFunction, std::forward<Args>(args)...);
+		}
+#endif
 		return IntDebug(iLevel, sFunction, kFormat(std::forward<Args>(args)...));
 	}
 
@@ -619,6 +825,35 @@ private:
 	bool IntDebug (int iLevel, KStringView sFunction, KStringView sMessage);
 	void IntException (KStringView sWhat, KStringView sFunction, KStringView sClass);
 
+#ifdef DEKAF2_WITH_KLOG
+	bool IntDebugEncoded (int iLevel, KStringView sFunction, KStringView sFormat, KStringView sArgs);
+
+	//---------------------------------------------------------------------------
+	template<class Format, class... Args>
+	bool IntDebugDeferred(int iLevel, KStringView sFunction, Format&& sFormat, Args&&... args)
+	//---------------------------------------------------------------------------
+	{
+		using F = typename std::remove_reference<Format>::type;
+
+		// format strings from char arrays are copied into the log record, as they
+		// may as well be stack buffers as literals
+		if constexpr (std::is_array<F>::value
+		              && std::is_same<typename std::remove_extent<F>::type, const char>::value
+		              && KLogBinaryArgs::IsEncodable<Args...>())
+		{
+			s_sDeferredArgs.clear();
+			KLogBinaryArgs::Encode(s_sDeferredArgs, args...);
+			return IntDebugEncoded(iLevel, sFunction, KStringView(sFormat, ::strnlen(sFormat, sizeof(F))), s_sDeferredArgs);
+		}
+		else
+		{
+			return IntDebug(iLevel, sFunction, kFormat(std::forward<Format>(sFormat), std::forward<Args>(args)...));
+		}
+	}
+
+	static thread_local KString s_sDeferredArgs;
+#endif
+
 #ifndef DEKAF2_WITH_KLOG
 
 	static KString s_sEmpty;
@@ -627,6 +862,9 @@ private:
 
 #else
 
+	// the shipping thread of the network writers switches off its own logging
+	friend class KLogBatchShipper;
+
 	//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 	class DEKAF2_PRIVATE PreventRecursion
 	//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
@@ -652,6 +890,9 @@ private:
 	}; // PreventRecursion
 
 	bool IntOpenLog ();
+	void IntWriteRecord (const KLogRecord& Record);
+	bool CanPushAsync (int iLevel) const;
+	void OnOneSecTimer ();
 
 	static thread_local std::unique_ptr<KLogSerializer> s_PerThreadSerializer;
 	static thread_local std::unique_ptr<KLogWriter> s_PerThreadWriter;
@@ -677,9 +918,21 @@ private:
 	int m_iBackTrace { -2 };
 	KUnixTime m_sTimestampFlagfile { 0 };
 	std::unique_ptr<KLogSerializer> m_Serializer;
-	std::unique_ptr<KLogWriter> m_Logger;
+	// shared, so that Flush() can wait for the writer without holding m_LogMutex
+	std::shared_ptr<KLogWriter> m_Logger;
 	// the m_Traces vector is protected by the s_LogMutex
 	std::vector<KString> m_Traces;
+	// created on first use of async mode, lives until the end of KLog
+	std::unique_ptr<KLogAsyncQueue> m_AsyncQueue;
+	// lets IntDebug() check for traces without the mutex
+	std::atomic<bool> m_bHaveTraces { false };
+	std::atomic<bool> m_bAsync { false };
+	std::atomic<bool> m_bDeferFormatting { false };
+	std::atomic<uint32_t> m_iRateLimitInterval { 1 };
+	// only used by the timer thread
+	uint32_t m_iRateLimitSeconds { 0 };
+	// protected by m_LogMutex
+	std::unique_ptr<KLogBinaryFileWriter> m_BinaryLog;
 
 	bool m_bBackTraceAlreadyCalled { false };
 #ifdef NDEBUG
@@ -721,6 +974,16 @@ private:
 // outputs appropriately. The only bad thing that can happen is that we miss
 // a debug output in the initialization phase of the program.
 
+#ifdef DEKAF2_WITH_KLOG
+//---------------------------------------------------------------------------
+/// checks the rate limit of the call site - the static call site counter is
+/// wrapped into a lambda, as the log macros are also used in constexpr functions
+#define DEKAF2_KLOG_ADMIT() \
+	(DEKAF2_LIKELY(!dekaf2::KLogCallSite::IsActive()) || \
+	[]() -> dekaf2::KLogCallSite& { static dekaf2::KLogCallSite s_CallSite(__FILE__, __LINE__); return s_CallSite; }().Admit())
+//---------------------------------------------------------------------------
+#endif
+
 #ifdef kDebug
 #undef kDebug
 #endif
@@ -731,7 +994,10 @@ private:
 { \
 	if (DEKAF2_UNLIKELY(iLevel <= dekaf2::KLog::s_iThreadLogLevel)) \
 	{ \
-		dekaf2::KLog::getInstance().debug_fun(iLevel, DEKAF2_FUNCTION_NAME, __VA_ARGS__); \
+		if (DEKAF2_KLOG_ADMIT()) \
+		{ \
+			dekaf2::KLog::getInstance().debug_fun(iLevel, DEKAF2_FUNCTION_NAME, __VA_ARGS__); \
+		} \
 	} \
 }
 //---------------------------------------------------------------------------
@@ -749,7 +1015,10 @@ private:
 { \
 	if (DEKAF2_UNLIKELY(iLevel <= dekaf2::KLog::s_iThreadLogLevel)) \
 	{ \
-		dekaf2::KLog::getInstance().debug(iLevel, __VA_ARGS__); \
+		if (DEKAF2_KLOG_ADMIT()) \
+		{ \
+			dekaf2::KLog::getInstance().debug(iLevel, __VA_ARGS__); \
+		} \
 	} \
 }
 //---------------------------------------------------------------------------
@@ -760,6 +1029,18 @@ private:
 #ifdef kWarning
 #undef kWarning
 #endif
+#ifdef DEKAF2_WITH_KLOG
+//---------------------------------------------------------------------------
+/// log a warning message, automatically provide function name.
+#define kWarning(...) \
+{ \
+	if (DEKAF2_KLOG_ADMIT()) \
+	{ \
+		dekaf2::KLog::getInstance().debug_fun(-1, DEKAF2_FUNCTION_NAME, __VA_ARGS__); \
+	} \
+}
+//---------------------------------------------------------------------------
+#else
 //---------------------------------------------------------------------------
 /// log a warning message, automatically provide function name.
 #define kWarning(...) \
@@ -767,10 +1048,23 @@ private:
 	dekaf2::KLog::getInstance().debug_fun(-1, DEKAF2_FUNCTION_NAME, __VA_ARGS__); \
 }
 //---------------------------------------------------------------------------
+#endif
 
 #ifdef kWarningLog
 #undef kWarningLog
 #endif
+#ifdef DEKAF2_WITH_KLOG
+//---------------------------------------------------------------------------
+/// log a warning message, do NOT automatically provide function name.
+#define kWarningLog(...) \
+{ \
+	if (DEKAF2_KLOG_ADMIT()) \
+	{ \
+		dekaf2::KLog::getInstance().debug(-1, __VA_ARGS__); \
+	} \
+}
+//---------------------------------------------------------------------------
+#else
 //---------------------------------------------------------------------------
 /// log a warning message, do NOT automatically provide function name.
 #define kWarningLog(...) \
@@ -778,6 +1072,7 @@ private:
 	dekaf2::KLog::getInstance().debug(-1, __VA_ARGS__); \
 }
 //---------------------------------------------------------------------------
+#endif
 
 #ifdef kException
 #undef kException
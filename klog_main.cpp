@@ -59,6 +59,8 @@
 #include "kconfiguration.h"
 #include "khtmlentities.h"
 #include "kcrashexit.h"
+#include "bits/klogbinary.h"
+#include "bits/klogserializer.h"
 #include <csignal>
 
 using namespace dekaf2;
@@ -86,6 +88,7 @@ constexpr KStringView g_Synopsis[] = {
 	"  setlog            : set global debug log file",
 	"  getlog            : get global debug log file",
 	"  listen <port>     : start a klog listener (netcat) on given port",
+	"  decode <file>     : print a binary log file as text (can be combined with grep)",
 	"  tracelevel <val>  : set the backtrace threshold to val",
 	"  tracejson <val>   : set JSON trace to either off, short, or full",
 	"  trace <val>       : set a debug message string that triggers a trace",
@@ -135,6 +138,7 @@ struct Actions
 	bool        bFollowFlag { false };
 	bool        bCompleted { false };
 	KString     sGrepString;
+	KString     sDecodeFile;
 
 }; // Actions
 
@@ -385,6 +389,38 @@ void RemoveFlagFile()
 
 } // RemoveFlagFile
 
+//-----------------------------------------------------------------------------
+int DecodeBinaryLog(KStringViewZ sFileName, KStringView sGrepString)
+//-----------------------------------------------------------------------------
+{
+	KLogBinaryFileReader Reader(sFileName);
+
+	if (!Reader.Good())
+	{
+		err->FormatLine("klog: {} is not a binary log file", sFileName);
+		return 1;
+	}
+
+	// the serializer emulates the output of the regular text log
+	KLogTTYSerializer Serializer;
+	KLogBinaryFileReader::Entry Entry;
+	KString sGrepLower = sGrepString.ToLower();
+
+	while (Reader.Next(Entry))
+	{
+		Serializer.Set(Entry.iLevel, Entry.sShortName, Entry.sPathName, Entry.sFunction, Entry.sMessage);
+		Serializer.SetOrigin(Entry.Pid, Entry.Tid, Entry.Time);
+
+		if (Serializer.Matches(true, false, sGrepLower))
+		{
+			out->Write(Serializer.Get());
+		}
+	}
+
+	return 0;
+
+} // DecodeBinaryLog
+
 //-----------------------------------------------------------------------------
 void TestBacktraces()
 //-----------------------------------------------------------------------------
@@ -462,6 +498,12 @@ void SetupOptions (KOptions& Options, Actions& Actions)
 			Actions.iPort = sPort.UInt16();
 		});
 
+		Options.Command("decode", "binary log file").Type(KOptions::File)
+		([&](KStringViewZ sFile)
+		{
+			Actions.sDecodeFile = sFile;
+		});
+
 		Options.Command("crash")([&]()
 		{
 			TestBacktraces();
@@ -811,6 +853,11 @@ int main (int argc, char* argv[])
 		return iErrors; // either error or completed
 	}
 
+	if (!Actions.sDecodeFile.empty())
+	{
+		return DecodeBinaryLog(Actions.sDecodeFile, Actions.sGrepString);
+	}
+
 	KString sLogFile = KLog::getInstance().GetDebugLog();
 
     if ((Actions.bFollowFlag || Actions.iDumpLines) && ((sLogFile == "stdout") || (sLogFile == "stderr")))
@@ -191,6 +191,44 @@ public:
 		}
 	}
 
+	//-----------------------------------------------------------------------------
+	/// Returns true if the container has an element with the given key. Does not
+	/// change the MRU sequence.
+	template<class K>
+	bool contains(const K& key) const
+	//-----------------------------------------------------------------------------
+	{
+		auto& KeyView = m_Elements.template get<KeyIdx>();
+		return KeyView.find(key) != KeyView.end();
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Returns a pointer to the element with the given key, or nullptr if not found.
+	/// Does not change the MRU sequence.
+	template<class K>
+	const element_type* peek(const K& key) const
+	//-----------------------------------------------------------------------------
+	{
+		auto& KeyView = m_Elements.template get<KeyIdx>();
+		auto it = KeyView.find(key);
+		return (it != KeyView.end()) ? &*it : nullptr;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Erase the least recently used element.
+	/// @return false if the container was empty
+	bool evict()
+	//-----------------------------------------------------------------------------
+	{
+		if (m_Elements.empty())
+		{
+			return false;
+		}
+
+		m_Elements.pop_back();
+		return true;
+	}
+
 	//-----------------------------------------------------------------------------
 	/// Return an iterator on the first element in the MRU sequence.
 	iterator begin()
@@ -40,6 +40,10 @@
 */
 
 #include "kparallel.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <memory>
 
 namespace dekaf2 {
 
@@ -82,6 +86,169 @@ std::thread::id KRunThreads::Store(std::thread thread)
 
 } // Store
 
+//-----------------------------------------------------------------------------
+std::size_t KParallelOptions::GetThreads(std::size_t iSize) const
+//-----------------------------------------------------------------------------
+{
+	auto iThreads = iMaxThreads ? iMaxThreads : std::thread::hardware_concurrency();
+
+	if (iGrainSize)
+	{
+		// there is no use in more threads than chunks
+		iSize = (iSize + iGrainSize - 1) / iGrainSize;
+	}
+
+	return std::max(std::size_t(1), std::min(iThreads, iSize));
+
+} // GetThreads
+
+//-----------------------------------------------------------------------------
+std::size_t KParallelOptions::GetGrainSize(std::size_t iSize, std::size_t iThreads) const
+//-----------------------------------------------------------------------------
+{
+	if (iGrainSize)
+	{
+		return iGrainSize;
+	}
+
+	iThreads = std::max(std::size_t(1), iThreads);
+
+	if (Mode == Static)
+	{
+		// one contiguous block per thread
+		return std::max(std::size_t(1), (iSize + iThreads - 1) / iThreads);
+	}
+
+	// dynamic: enough chunks per thread to balance uneven work, but
+	// large enough that the atomic counter is not contended
+	return std::max(std::size_t(1), iSize / (iThreads * 8));
+
+} // GetGrainSize
+
+//-----------------------------------------------------------------------------
+KThreadPool& kParallelPool()
+//-----------------------------------------------------------------------------
+{
+	static KThreadPool s_Pool(std::max(1U, std::thread::hardware_concurrency()), KThreadPool::Scheduling::WorkStealing);
+	return s_Pool;
+
+} // kParallelPool
+
+namespace detail {
+
+namespace {
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// shared state of one ParallelRun() call - pool tasks may start after the
+/// call returned, therefore it is held by a shared_ptr
+struct ParallelRunState
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	ParallelRunState(std::size_t iTasks, const std::function<void(std::size_t)>& Task)
+	: m_iTasks(iTasks)
+	, m_Task(Task)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	/// claim and run tasks until none is left
+	void Work()
+	//-----------------------------------------------------------------------------
+	{
+		for (;;)
+		{
+			auto iTask = m_iNext.fetch_add(1, std::memory_order_relaxed);
+
+			if (iTask >= m_iTasks)
+			{
+				// m_Task may already be gone
+				return;
+			}
+
+			try
+			{
+				m_Task(iTask);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> Lock(m_Mutex);
+
+				if (!m_Exception)
+				{
+					m_Exception = std::current_exception();
+				}
+			}
+
+			if (m_iDone.fetch_add(1, std::memory_order_acq_rel) + 1 == m_iTasks)
+			{
+				std::lock_guard<std::mutex> Lock(m_Mutex);
+				m_Finished.notify_all();
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// wait until all tasks are done, and rethrow the first exception
+	void Wait()
+	//-----------------------------------------------------------------------------
+	{
+		std::unique_lock<std::mutex> Lock(m_Mutex);
+
+		m_Finished.wait(Lock, [this]()
+		{
+			return m_iDone.load(std::memory_order_acquire) == m_iTasks;
+		});
+
+		if (m_Exception)
+		{
+			std::rethrow_exception(m_Exception);
+		}
+	}
+
+	const std::size_t                        m_iTasks;
+	const std::function<void(std::size_t)>&  m_Task;
+	std::atomic<std::size_t>                 m_iNext { 0 };
+	std::atomic<std::size_t>                 m_iDone { 0 };
+	std::mutex                               m_Mutex;
+	std::condition_variable                  m_Finished;
+	std::exception_ptr                       m_Exception;
+
+}; // ParallelRunState
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+void ParallelRun(std::size_t iTasks, std::size_t iThreads, const std::function<void(std::size_t)>& Task)
+//-----------------------------------------------------------------------------
+{
+	if (!iTasks)
+	{
+		return;
+	}
+
+	auto State = std::make_shared<ParallelRunState>(iTasks, Task);
+
+	if (iThreads > 1 && iTasks > 1)
+	{
+		auto& Pool = kParallelPool();
+
+		for (std::size_t i = 1, iEnd = std::min(iThreads, iTasks); i < iEnd; ++i)
+		{
+			Pool.push([State]()
+			{
+				State->Work();
+			});
+		}
+	}
+
+	// the calling thread works as well
+	State->Work();
+	State->Wait();
+
+} // ParallelRun
+
+} // end of namespace detail
+
 //-----------------------------------------------------------------------------
 void KBlockOnID::Data::Lock(std::size_t ID)
 //-----------------------------------------------------------------------------
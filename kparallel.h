@@ -47,8 +47,17 @@
 #include <thread>
 #include <utility>
 #include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+#include <functional>
+#include <optional>
+#include <vector>
 #include "kthreads.h"
 #include "kthreadsafe.h"
+#include "kthreadpool.h"
 #include "klog.h"
 
 namespace dekaf2
@@ -150,6 +159,39 @@ private:
 
 }; // KRunThreads
 
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// Options for the parallel algorithms. The partitioning and grain size are
+/// only used for random access ranges, all other ranges are iterated element
+/// by element.
+struct DEKAF2_PUBLIC KParallelOptions
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	/// how a range is split into chunks for the threads
+	enum Partitioning
+	{
+		Dynamic, ///< threads fetch the next chunk from an atomic counter - best for uneven cost per element
+		Static   ///< chunks are assigned round robin to the threads upfront - best for even, cheap cost per element
+	};
+
+	/// number of threads to start at most, 0 = count of CPU cores
+	std::size_t  iMaxThreads { 0 };
+	/// number of elements per chunk, 0 = auto tuned from size of range and count of threads
+	std::size_t  iGrainSize  { 0 };
+	/// the partitioning mode
+	Partitioning Mode        { Dynamic };
+
+	//-----------------------------------------------------------------------------
+	/// returns the count of threads to use for a range of iSize elements
+	std::size_t GetThreads(std::size_t iSize) const;
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// returns the count of elements per chunk for a range of iSize elements and iThreads threads
+	std::size_t GetGrainSize(std::size_t iSize, std::size_t iThreads) const;
+	//-----------------------------------------------------------------------------
+
+}; // KParallelOptions
+
 namespace detail {
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
@@ -167,16 +209,214 @@ public:
 
 }; // KParallelForEachNoProgressPrinter
 
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// Collects the progress of the worker threads in an atomic counter, and
+/// forwards it to the progress printer from whichever thread is not
+/// blocked by another one doing so. Compiles to nothing for the dummy printer.
+template<typename Progress>
+class KParallelProgress
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	static constexpr bool s_bHasPrinter = !std::is_same<typename std::decay<Progress>::type, KParallelForEachNoProgressPrinter>::value;
+
+public:
+
+	KParallelProgress(Progress& p) : m_Progress(p) {}
+
+	//-----------------------------------------------------------------------------
+	/// add iDelta finished elements
+	void Add(std::size_t iDelta)
+	//-----------------------------------------------------------------------------
+	{
+		if constexpr (s_bHasPrinter)
+		{
+			m_iPending.fetch_add(iDelta, std::memory_order_relaxed);
+
+			if (m_Mutex.try_lock())
+			{
+				Report();
+				m_Mutex.unlock();
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// forward the remaining count to the progress printer
+	void Flush()
+	//-----------------------------------------------------------------------------
+	{
+		if constexpr (s_bHasPrinter)
+		{
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+			Report();
+		}
+	}
+
+private:
+
+	void Report()
+	{
+		auto iDelta = m_iPending.exchange(0, std::memory_order_relaxed);
+
+		if (iDelta)
+		{
+			m_Progress.Move(iDelta);
+		}
+	}
+
+	Progress&                m_Progress;
+	std::atomic<std::size_t> m_iPending { 0 };
+	std::mutex               m_Mutex;
+
+}; // KParallelProgress
+
+//-----------------------------------------------------------------------------
+/// run f on all elements of a random access range, split into chunks
+template<typename RandomIterator, typename Func, typename Progress>
+void ParallelForEachChunked(std::size_t iSize, RandomIterator first, Func& f, const KParallelOptions& Options, Progress& p)
+//-----------------------------------------------------------------------------
+{
+	auto iThreads   = Options.GetThreads(iSize);
+	auto iGrainSize = Options.GetGrainSize(iSize, iThreads);
+	auto iChunks    = (iSize + iGrainSize - 1) / iGrainSize;
+
+	if (iThreads > iChunks)
+	{
+		iThreads = iChunks;
+	}
+
+	KParallelProgress<Progress> Counter(p);
+
+	auto RunChunk = [&](std::size_t iChunk)
+	{
+		auto iStart = iChunk * iGrainSize;
+		auto iEnd   = std::min(iStart + iGrainSize, iSize);
+		auto it     = first + static_cast<typename std::iterator_traits<RandomIterator>::difference_type>(iStart);
+
+		for (auto i = iStart; i < iEnd; ++i, ++it)
+		{
+			f(*it);
+		}
+
+		Counter.Add(iEnd - iStart);
+	};
+
+	if (iThreads <= 1)
+	{
+		for (std::size_t iChunk = 0; iChunk < iChunks; ++iChunk)
+		{
+			RunChunk(iChunk);
+		}
+	}
+	else if (Options.Mode == KParallelOptions::Static)
+	{
+		auto loop = [&](std::size_t iThread)
+		{
+			for (auto iChunk = iThread; iChunk < iChunks; iChunk += iThreads)
+			{
+				RunChunk(iChunk);
+			}
+		};
+
+		KRunThreads threads(iThreads - 1);
+
+		for (std::size_t iThread = 1; iThread < iThreads; ++iThread)
+		{
+			threads.CreateOne(loop, iThread);
+		}
+
+		// the initial thread takes the first share
+		loop(0);
+	}
+	else
+	{
+		std::atomic<std::size_t> iNextChunk { 0 };
+
+		auto loop = [&]()
+		{
+			for (;;)
+			{
+				auto iChunk = iNextChunk.fetch_add(1, std::memory_order_relaxed);
+
+				if (iChunk >= iChunks)
+				{
+					return;
+				}
+
+				RunChunk(iChunk);
+			}
+		};
+
+		KRunThreads threads(iThreads - 1);
+
+		// create the additional threads
+		threads.Create(std::ref(loop));
+
+		// and finally run the loop in the initial thread as well
+		loop();
+	}
+
+	Counter.Flush();
+
+} // ParallelForEachChunked
+
+//-----------------------------------------------------------------------------
+/// run f on all elements of a range that is not random access, advancing
+/// the shared iterator under a lock
+template<typename InputIterator, typename Func, typename Progress>
+void ParallelForEachLocked(std::size_t iSize, InputIterator first, InputIterator last, Func& f, std::size_t iMaxThreads, Progress& p)
+//-----------------------------------------------------------------------------
+{
+	std::mutex m_IterMutex;
+
+	auto loop = [&]()
+	{
+		for (;;)
+		{
+			InputIterator it;
+
+			{
+				std::lock_guard<std::mutex> lock(m_IterMutex);
+
+				if (DEKAF2_UNLIKELY(first == last))
+				{
+					return;
+				}
+
+				it = first;
+
+				++first;
+
+				p.Move();
+			}
+
+			f(*it);
+		}
+	};
+
+	KRunThreads threads(iMaxThreads - 1, iSize - 1);
+
+	// create the additional threads
+	threads.Create(std::ref(loop));
+
+	// and finally run the loop in the initial thread as well
+	loop();
+
+} // ParallelForEachLocked
+
 } // namespace detail
 
 //-----------------------------------------------------------------------------
 /// Iterate with parallel threads over all elements of a range. Expects the size
-/// of the range as the first element.
+/// of the range as the first element. Random access ranges are split into
+/// chunks that are fetched by the threads from an atomic counter (or assigned
+/// upfront with KParallelOptions::Static), other ranges are iterated element
+/// by element under a lock.
 /// @param iSize size of the iterable range
 /// @param first iterator on the first element
 /// @param last iterator past the last element
 /// @param f functor to call with reference on one element of the range
-/// @param iMaxThreads number of threads to start at most, 0/default = count of CPU cores
+/// @param Options count of threads, partitioning and grain size
 /// @param p progress output class, defaults to dummy printer. Use e.g. KBAR for real output to a terminal
 template<typename InputIterator,
          typename Func,
@@ -184,7 +424,7 @@ template<typename InputIterator,
 void kParallelForEach(std::size_t iSize,
                       InputIterator first, InputIterator last,
                       Func&& f,
-                      std::size_t iMaxThreads = std::thread::hardware_concurrency(),
+                      const KParallelOptions& Options,
                       Progress&& p = detail::KParallelForEachNoProgressPrinter())
 //-----------------------------------------------------------------------------
 {
@@ -192,12 +432,9 @@ void kParallelForEach(std::size_t iSize,
 	{
 		p.Start(iSize);
 
-		if (!iMaxThreads)
-		{
-			iMaxThreads = std::thread::hardware_concurrency();
-		}
+		auto iMaxThreads = Options.GetThreads(iSize);
 
-		if (iMaxThreads <= 1 || iSize == 1)
+		if (iMaxThreads <= 1)
 		{
 			// just run single threaded ..
 			for (auto it = first; it != last; ++it)
@@ -206,42 +443,14 @@ void kParallelForEach(std::size_t iSize,
 				f(*it);
 			}
 		}
+		else if constexpr (std::is_base_of<std::random_access_iterator_tag,
+		                                   typename std::iterator_traits<InputIterator>::iterator_category>::value)
+		{
+			detail::ParallelForEachChunked(iSize, first, f, Options, p);
+		}
 		else
 		{
-			std::mutex m_IterMutex;
-
-			auto loop = [&]()
-			{
-				for (;;)
-				{
-					InputIterator it;
-
-					{
-						std::lock_guard<std::mutex> lock(m_IterMutex);
-
-						if (DEKAF2_UNLIKELY(first == last))
-						{
-							return;
-						}
-
-						it = first;
-
-						++first;
-
-						p.Move();
-					}
-
-					f(*it);
-				}
-			};
-
-			KRunThreads threads(iMaxThreads - 1, iSize - 1);
-
-			// create the additional threads
-			threads.Create(std::ref(loop));
-
-			// and finally run the loop in the initial thread as well
-			loop();
+			detail::ParallelForEachLocked(iSize, first, last, f, iMaxThreads, p);
 		}
 
 		p.Finish();
@@ -249,6 +458,30 @@ void kParallelForEach(std::size_t iSize,
 
 } // kParallelForEach
 
+//-----------------------------------------------------------------------------
+/// Iterate with parallel threads over all elements of a range. Expects the size
+/// of the range as the first element.
+/// @param iSize size of the iterable range
+/// @param first iterator on the first element
+/// @param last iterator past the last element
+/// @param f functor to call with reference on one element of the range
+/// @param iMaxThreads number of threads to start at most, 0/default = count of CPU cores
+/// @param p progress output class, defaults to dummy printer. Use e.g. KBAR for real output to a terminal
+template<typename InputIterator,
+         typename Func,
+         typename Progress = detail::KParallelForEachNoProgressPrinter>
+void kParallelForEach(std::size_t iSize,
+                      InputIterator first, InputIterator last,
+                      Func&& f,
+                      std::size_t iMaxThreads = std::thread::hardware_concurrency(),
+                      Progress&& p = detail::KParallelForEachNoProgressPrinter())
+//-----------------------------------------------------------------------------
+{
+	KParallelOptions Options;
+	Options.iMaxThreads = iMaxThreads;
+	kParallelForEach(iSize, first, last, f, Options, p);
+}
+
 //-----------------------------------------------------------------------------
 /// Iterate with parallel threads over all elements of a range. If the iterator
 /// type is not a RandomAccessIterator, the count of elements from first to last
@@ -273,6 +506,25 @@ void kParallelForEach(InputIterator first, InputIterator last,
 	kParallelForEach(std::distance(first, last), first, last, f, iMaxThreads, p);
 }
 
+//-----------------------------------------------------------------------------
+/// Iterate with parallel threads over all elements of a range, see above
+/// @param first iterator on the first element
+/// @param last iterator past the last element
+/// @param f functor to call with reference on one element of the range
+/// @param Options count of threads, partitioning and grain size
+/// @param p progress output class, defaults to dummy printer. Use e.g. KBAR for real output to a terminal
+template<typename InputIterator,
+         typename Func,
+         typename Progress = detail::KParallelForEachNoProgressPrinter>
+void kParallelForEach(InputIterator first, InputIterator last,
+                      Func&& f,
+                      const KParallelOptions& Options,
+                      Progress&& p = detail::KParallelForEachNoProgressPrinter())
+//-----------------------------------------------------------------------------
+{
+	kParallelForEach(std::distance(first, last), first, last, f, Options, p);
+}
+
 //-----------------------------------------------------------------------------
 /// Iterate over all elements of a container c and call function f with a ref on the element
 /// @param c any container that has a begin(), end(), and size() member function
@@ -291,6 +543,240 @@ void kParallelForEach(Container& c,
 	kParallelForEach(c.size(), c.begin(), c.end(), f, iMaxThreads, p);
 }
 
+//-----------------------------------------------------------------------------
+/// Iterate over all elements of a container c and call function f with a ref on the element
+/// @param c any container that has a begin(), end(), and size() member function
+/// @param f functor to call with reference on one element of the range
+/// @param Options count of threads, partitioning and grain size
+/// @param p progress output class, defaults to dummy printer. Use e.g. KBAR for real output to a terminal
+template<typename Container,
+         typename Func,
+         typename Progress = detail::KParallelForEachNoProgressPrinter>
+void kParallelForEach(Container& c,
+                      Func&& f,
+                      const KParallelOptions& Options,
+                      Progress&& p = detail::KParallelForEachNoProgressPrinter())
+//-----------------------------------------------------------------------------
+{
+	kParallelForEach(c.size(), c.begin(), c.end(), f, Options, p);
+}
+
+//-----------------------------------------------------------------------------
+/// Returns the shared worker pool of the parallel algorithms. It is created at
+/// first use, with one thread per CPU core and work stealing scheduling.
+DEKAF2_PUBLIC
+KThreadPool& kParallelPool();
+//-----------------------------------------------------------------------------
+
+namespace detail {
+
+//-----------------------------------------------------------------------------
+/// Calls Task(i) for all i in [0, iTasks) on at most iThreads threads of the
+/// shared pool, including the calling thread. Indexes are claimed from an
+/// atomic counter, the calling thread only waits for tasks that are already
+/// running, therefore nested calls from inside the pool can not deadlock. The
+/// first exception thrown by a task is rethrown after all tasks finished.
+DEKAF2_PUBLIC
+void ParallelRun(std::size_t iTasks, std::size_t iThreads, const std::function<void(std::size_t)>& Task);
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+/// Splits iSize elements into chunks as defined by Options, and calls
+/// Chunk(iStart, iEnd) for each of them on the shared pool
+template<typename Func>
+void ParallelChunks(std::size_t iSize, const KParallelOptions& Options, Func&& Chunk)
+//-----------------------------------------------------------------------------
+{
+	auto iThreads   = Options.GetThreads(iSize);
+	auto iGrainSize = Options.GetGrainSize(iSize, iThreads);
+	auto iChunks    = (iSize + iGrainSize - 1) / iGrainSize;
+
+	ParallelRun(iChunks, iThreads, [&](std::size_t iChunk)
+	{
+		auto iStart = iChunk * iGrainSize;
+		Chunk(iStart, std::min(iStart + iGrainSize, iSize));
+	});
+
+} // ParallelChunks
+
+} // namespace detail
+
+//-----------------------------------------------------------------------------
+/// Parallel version of std::transform() on random access ranges, running on
+/// the shared pool kParallelPool()
+/// @param first iterator on the first element
+/// @param last iterator past the last element
+/// @param d_first iterator on the first element of the output range, which must
+/// have room for all elements
+/// @param f functor to call with a reference on one element of the input range,
+/// returning the element of the output range
+/// @param Options count of threads and grain size
+/// @return iterator past the last element written to the output range
+template<typename RandomIterator, typename OutputIterator, typename Func>
+OutputIterator kParallelTransform(RandomIterator first, RandomIterator last,
+                                  OutputIterator d_first,
+                                  Func&& f,
+                                  const KParallelOptions& Options = KParallelOptions())
+//-----------------------------------------------------------------------------
+{
+	auto iSize = static_cast<std::size_t>(std::distance(first, last));
+
+	detail::ParallelChunks(iSize, Options, [&](std::size_t iStart, std::size_t iEnd)
+	{
+		std::transform(first + iStart, first + iEnd, d_first + iStart, f);
+	});
+
+	return d_first + iSize;
+
+} // kParallelTransform
+
+//-----------------------------------------------------------------------------
+/// Parallel map-reduce on random access ranges, running on the shared pool
+/// kParallelPool(). Every chunk is reduced into its own accumulator, and the
+/// accumulators are reduced in the order of the chunks - therefore the
+/// Reduce operation has to be associative, but not commutative.
+/// @param first iterator on the first element
+/// @param last iterator past the last element
+/// @param init the initial value of the reduction
+/// @param Reduce binary functor that combines two values of type T
+/// @param Transform functor to call with a reference on one element of the
+/// range, returning a value of type T
+/// @param Options count of threads and grain size
+/// @return the reduced value
+template<typename RandomIterator, typename T, typename ReduceFunc, typename TransformFunc>
+T kParallelTransformReduce(RandomIterator first, RandomIterator last,
+                           T init,
+                           ReduceFunc&& Reduce,
+                           TransformFunc&& Transform,
+                           const KParallelOptions& Options = KParallelOptions())
+//-----------------------------------------------------------------------------
+{
+	auto iSize = static_cast<std::size_t>(std::distance(first, last));
+
+	if (!iSize)
+	{
+		return init;
+	}
+
+	auto iThreads   = Options.GetThreads(iSize);
+	auto iGrainSize = Options.GetGrainSize(iSize, iThreads);
+	auto iChunks    = (iSize + iGrainSize - 1) / iGrainSize;
+
+	// one accumulator per chunk, each chunk has at least one element
+	std::vector<std::optional<T>> Accumulators(iChunks);
+
+	detail::ParallelRun(iChunks, iThreads, [&](std::size_t iChunk)
+	{
+		auto iStart = iChunk * iGrainSize;
+		auto iEnd   = std::min(iStart + iGrainSize, iSize);
+		auto it     = first + iStart;
+		auto ie     = first + iEnd;
+
+		T Accumulator = Transform(*it);
+
+		while (++it != ie)
+		{
+			Accumulator = Reduce(std::move(Accumulator), Transform(*it));
+		}
+
+		Accumulators[iChunk] = std::move(Accumulator);
+	});
+
+	for (auto& Accumulator : Accumulators)
+	{
+		init = Reduce(std::move(init), std::move(*Accumulator));
+	}
+
+	return init;
+
+} // kParallelTransformReduce
+
+//-----------------------------------------------------------------------------
+/// Parallel reduction on random access ranges, running on the shared pool
+/// kParallelPool(). The Reduce operation has to be associative, but not commutative.
+/// @param first iterator on the first element
+/// @param last iterator past the last element
+/// @param init the initial value of the reduction
+/// @param Reduce binary functor that combines two values of type T, defaults to std::plus
+/// @param Options count of threads and grain size
+/// @return the reduced value
+template<typename RandomIterator, typename T, typename ReduceFunc = std::plus<>>
+T kParallelReduce(RandomIterator first, RandomIterator last,
+                  T init,
+                  ReduceFunc&& Reduce = ReduceFunc(),
+                  const KParallelOptions& Options = KParallelOptions())
+//-----------------------------------------------------------------------------
+{
+	return kParallelTransformReduce(first, last, std::move(init), Reduce, [](const auto& value) -> T
+	{
+		return value;
+	}, Options);
+
+} // kParallelReduce
+
+//-----------------------------------------------------------------------------
+/// Parallel merge sort on random access ranges, running on the shared pool
+/// kParallelPool(). The range is split into one block per thread, the blocks
+/// are sorted with std::sort(), and then merged pairwise in parallel. Like
+/// std::sort(), the sort is not stable.
+/// @param first iterator on the first element
+/// @param last iterator past the last element
+/// @param Compare comparison functor, defaults to std::less
+/// @param Options count of threads, a grain size sets the minimum block size,
+/// default 10000 - smaller ranges are sorted single threaded
+template<typename RandomIterator, typename CompareFunc = std::less<>>
+void kParallelSort(RandomIterator first, RandomIterator last,
+                   CompareFunc&& Compare = CompareFunc(),
+                   const KParallelOptions& Options = KParallelOptions())
+//-----------------------------------------------------------------------------
+{
+	auto iSize      = static_cast<std::size_t>(std::distance(first, last));
+	auto iMinBlock  = Options.iGrainSize ? Options.iGrainSize : 10000;
+	auto iBlocks    = std::min(Options.GetThreads(iSize), (iSize + iMinBlock - 1) / iMinBlock);
+
+	if (iBlocks <= 1)
+	{
+		std::sort(first, last, Compare);
+		return;
+	}
+
+	// block boundaries, block i is [Bounds[i], Bounds[i+1])
+	std::vector<std::size_t> Bounds(iBlocks + 1);
+
+	for (std::size_t i = 0; i <= iBlocks; ++i)
+	{
+		Bounds[i] = iSize * i / iBlocks;
+	}
+
+	detail::ParallelRun(iBlocks, iBlocks, [&](std::size_t iBlock)
+	{
+		std::sort(first + Bounds[iBlock], first + Bounds[iBlock + 1], Compare);
+	});
+
+	// merge neighbouring blocks, doubling the width with each round
+	for (std::size_t iWidth = 1; iWidth < iBlocks; iWidth *= 2)
+	{
+		auto iMerges = (iBlocks + 2 * iWidth - 1) / (2 * iWidth);
+
+		detail::ParallelRun(iMerges, iMerges, [&](std::size_t iMerge)
+		{
+			auto iLeft   = iMerge * 2 * iWidth;
+			auto iMiddle = iLeft + iWidth;
+
+			if (iMiddle < iBlocks)
+			{
+				auto iRight = std::min(iMiddle + iWidth, iBlocks);
+
+				std::inplace_merge(first + Bounds[iLeft],
+				                   first + Bounds[iMiddle],
+				                   first + Bounds[iRight],
+				                   Compare);
+			}
+		});
+	}
+
+} // kParallelSort
+
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 /// Provides an execution barrier that only lets one of multiple equal ID
 /// values execute. All other instances with the same value have to wait until
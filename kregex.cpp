@@ -271,7 +271,7 @@ struct Loader
 	}
 };
 
-using cache_t = KSharedCache<KString, re2::RE2, Loader>;
+using cache_t = KShardedCache<KString, re2::RE2, Loader>;
 using regex_t = cache_t::value_type;
 
 } // end of namespace kregex
@@ -0,0 +1,331 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#include "kresolvercache.h"
+#include "klog.h"
+
+namespace dekaf2 {
+
+std::atomic<bool> KResolverCache::s_bEnabled { true };
+
+//-----------------------------------------------------------------------------
+KResolverCache::KResolverCache()
+//-----------------------------------------------------------------------------
+: KResolverCache(Config{})
+{
+} // ctor
+
+//-----------------------------------------------------------------------------
+KResolverCache::KResolverCache(Config config)
+//-----------------------------------------------------------------------------
+{
+	m_Storage.unique()->config = std::move(config);
+
+} // ctor
+
+//-----------------------------------------------------------------------------
+KResolverCache::~KResolverCache()
+//-----------------------------------------------------------------------------
+{
+	if (m_Refresher)
+	{
+		// do not wait for outstanding refreshes
+		m_Refresher->stop(true);
+	}
+
+} // dtor
+
+//-----------------------------------------------------------------------------
+KResolverCache& KResolverCache::GetInstance()
+//-----------------------------------------------------------------------------
+{
+	static KResolverCache s_Cache;
+	return s_Cache;
+
+} // GetInstance
+
+//-----------------------------------------------------------------------------
+KResolverCache::Endpoints KResolverCache::ResolveUncached(KStringView sHostname, KStringView sPort, boost::system::error_code& ec)
+//-----------------------------------------------------------------------------
+{
+	Endpoints Resolved;
+
+	boost::asio::io_service IOService;
+	boost::asio::ip::tcp::resolver Resolver(IOService);
+	boost::asio::ip::tcp::resolver::query query(KString(sHostname).c_str(), KString(sPort).c_str());
+	auto hosts = Resolver.resolve(query, ec);
+
+	if (!ec)
+	{
+#if (BOOST_VERSION < 106600)
+		auto it = hosts;
+		decltype(it) ie;
+#else
+		auto it = hosts.begin();
+		auto ie = hosts.end();
+#endif
+		for (; it != ie; ++it)
+		{
+			Resolved.push_back(it->endpoint());
+		}
+	}
+
+	return Resolved;
+
+} // ResolveUncached
+
+//-----------------------------------------------------------------------------
+KResolverCache::Endpoints KResolverCache::Update(const KString& sKey, KStringView sHostname, KStringView sPort, boost::system::error_code& ec, bool bIsRefresh)
+//-----------------------------------------------------------------------------
+{
+	auto Resolve  = m_Storage.shared()->config.Resolve;
+	auto Resolved = Resolve ? Resolve(sHostname, sPort, ec) : ResolveUncached(sHostname, sPort, ec);
+
+	auto Storage = m_Storage.unique();
+
+	auto tNow = Clock::now();
+
+	if (ec && bIsRefresh)
+	{
+		// a transient resolver error must not replace the addresses of a hot
+		// entry, which are very likely still valid - negative results are only
+		// cached for lookups that had nothing to return
+		auto it = Storage->Entries.find(sKey);
+
+		if (it != Storage->Entries.end() && !it->second.ec)
+		{
+			auto& Entry         = it->second;
+			Entry.bRefreshing   = false;
+			Entry.tRetryRefresh = tNow + Storage->config.NegativeTTL;
+			Entry.tExpires      = std::max(Entry.tExpires, Entry.tRetryRefresh);
+		}
+
+		return Resolved;
+	}
+
+	if (Storage->Entries.size() >= Storage->config.iMaxEntries && !Storage->Entries.count(sKey))
+	{
+		// first remove all expired entries
+		for (auto it = Storage->Entries.begin(); it != Storage->Entries.end();)
+		{
+			if (it->second.tExpires <= tNow)
+			{
+				it = Storage->Entries.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		if (Storage->Entries.size() >= Storage->config.iMaxEntries)
+		{
+			// then remove the entry that expires first
+			auto it = std::min_element(Storage->Entries.begin(), Storage->Entries.end(), [](const std::pair<const KString, Entry>& left, const std::pair<const KString, Entry>& right)
+			{
+				return left.second.tExpires < right.second.tExpires;
+			});
+
+			if (it != Storage->Entries.end())
+			{
+				Storage->Entries.erase(it);
+			}
+		}
+	}
+
+	if (Storage->config.iMaxEntries)
+	{
+		auto& Entry         = Storage->Entries[sKey];
+		Entry.Resolved      = Resolved;
+		Entry.ec            = ec;
+		Entry.tExpires      = tNow + (ec ? Storage->config.NegativeTTL : Storage->config.TTL);
+		Entry.tRetryRefresh = Clock::time_point();
+		Entry.bRefreshing   = false;
+	}
+
+	return Resolved;
+
+} // Update
+
+//-----------------------------------------------------------------------------
+void KResolverCache::Refresh(KString sKey, KString sHostname, KString sPort)
+//-----------------------------------------------------------------------------
+{
+	std::call_once(m_RefresherOnce, [this]()
+	{
+		m_Refresher = std::make_unique<KThreadPool>(1);
+	});
+
+	++ma_iRefreshes;
+
+	m_Refresher->push([this](KString sKey, KString sHostname, KString sPort)
+	{
+		boost::system::error_code ec;
+
+		Update(sKey, sHostname, sPort, ec, true);
+
+		kDebug(2, "refreshed {}:{}{}", sHostname, sPort, ec ? kFormat(" failed: {}", ec.message()) : KString{});
+
+	}, std::move(sKey), std::move(sHostname), std::move(sPort));
+
+} // Refresh
+
+//-----------------------------------------------------------------------------
+KResolverCache::Endpoints KResolverCache::Resolve(KStringView sHostname, KStringView sPort, boost::system::error_code& ec)
+//-----------------------------------------------------------------------------
+{
+	if (!IsEnabled())
+	{
+		return ResolveUncached(sHostname, sPort, ec);
+	}
+
+	KString sKey = sHostname;
+	sKey += ':';
+	sKey += sPort;
+
+	bool      bRefresh { false };
+	bool      bHit     { false };
+	Endpoints Resolved;
+
+	{
+		auto Storage = m_Storage.unique();
+
+		auto it = Storage->Entries.find(sKey);
+
+		if (it != Storage->Entries.end())
+		{
+			auto& Entry = it->second;
+			auto tNow   = Clock::now();
+
+			if (Entry.tExpires > tNow)
+			{
+				if (!Entry.ec && !Entry.bRefreshing && tNow >= Entry.tRetryRefresh && Entry.tExpires - tNow <= Storage->config.RefreshAhead)
+				{
+					// this is a hot entry, refresh it before it expires
+					Entry.bRefreshing = true;
+					bRefresh = true;
+				}
+
+				ec       = Entry.ec;
+				Resolved = Entry.Resolved;
+				bHit     = true;
+			}
+		}
+	}
+
+	if (bHit)
+	{
+		if (ec)
+		{
+			++ma_iNegativeHits;
+		}
+		else
+		{
+			++ma_iHits;
+		}
+
+		if (bRefresh)
+		{
+			Refresh(std::move(sKey), sHostname, sPort);
+		}
+
+		return Resolved;
+	}
+
+	++ma_iMisses;
+
+	return Update(sKey, sHostname, sPort, ec);
+
+} // Resolve
+
+//-----------------------------------------------------------------------------
+void KResolverCache::Remove(KStringView sHostname, KStringView sPort)
+//-----------------------------------------------------------------------------
+{
+	KString sKey = sHostname;
+	sKey += ':';
+	sKey += sPort;
+
+	m_Storage.unique()->Entries.erase(sKey);
+
+} // Remove
+
+//-----------------------------------------------------------------------------
+void KResolverCache::clear()
+//-----------------------------------------------------------------------------
+{
+	m_Storage.unique()->Entries.clear();
+
+} // clear
+
+//-----------------------------------------------------------------------------
+void KResolverCache::SetConfig(Config config)
+//-----------------------------------------------------------------------------
+{
+	m_Storage.unique()->config = std::move(config);
+
+} // SetConfig
+
+//-----------------------------------------------------------------------------
+KResolverCache::Config KResolverCache::GetConfig() const
+//-----------------------------------------------------------------------------
+{
+	return m_Storage.shared()->config;
+
+} // GetConfig
+
+//-----------------------------------------------------------------------------
+KResolverCache::Stats KResolverCache::GetStats() const
+//-----------------------------------------------------------------------------
+{
+	Stats stats;
+
+	stats.iEntries      = m_Storage.shared()->Entries.size();
+	stats.iHits         = ma_iHits;
+	stats.iNegativeHits = ma_iNegativeHits;
+	stats.iMisses       = ma_iMisses;
+	stats.iRefreshes    = ma_iRefreshes;
+
+	return stats;
+
+} // GetStats
+
+} // end of namespace dekaf2
@@ -0,0 +1,227 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#pragma once
+
+/// @file kresolvercache.h
+/// in-process cache for host name resolutions
+
+#include "bits/kasio.h"
+#include "kstring.h"
+#include "kstringview.h"
+#include "kduration.h"
+#include "kthreadsafe.h"
+#include "kthreadpool.h"
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+namespace dekaf2 {
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// Caches the results of host name resolutions for a configurable time, including
+/// failed resolutions (negative caching). Entries that are requested shortly before
+/// their expiry are refreshed in the background, so that hot host names never
+/// block on getaddrinfo() again - if such a refresh fails, the previous addresses
+/// are kept. The cache is used by all TCP and TLS connections
+/// and can be switched off process wide with SetEnabled(false).
+class DEKAF2_PUBLIC KResolverCache
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//------
+public:
+//------
+
+	using Endpoint  = boost::asio::ip::tcp::endpoint;
+	using Endpoints = std::vector<Endpoint>;
+	using Resolver  = std::function<Endpoints(KStringView sHostname, KStringView sPort, boost::system::error_code& ec)>;
+
+	struct Config
+	{
+		KDuration   TTL          { chrono::seconds(60) }; ///< time to keep a successful resolution
+		KDuration   NegativeTTL  { chrono::seconds(5)  }; ///< time to keep a failed resolution, and to wait before retrying a failed background refresh
+		KDuration   RefreshAhead { chrono::seconds(10) }; ///< refresh entries requested within this time before expiry in the background
+		std::size_t iMaxEntries  { 1000 };                ///< max number of cached host names
+		Resolver    Resolve;                              ///< the resolver to query, if not set ResolveUncached()
+
+	}; // Config
+
+	struct Stats
+	{
+		std::size_t iHits         { 0 }; ///< number of successful resolutions served from the cache
+		std::size_t iNegativeHits { 0 }; ///< number of failed resolutions served from the cache
+		std::size_t iMisses       { 0 }; ///< number of resolutions that had to query the system resolver
+		std::size_t iRefreshes    { 0 }; ///< number of background refreshes
+		std::size_t iEntries      { 0 }; ///< current number of cached host names
+
+	}; // Stats
+
+	//-----------------------------------------------------------------------------
+	/// construct a cache with the default configuration
+	KResolverCache();
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// construct a cache with the given configuration
+	KResolverCache(Config config);
+	//-----------------------------------------------------------------------------
+
+	KResolverCache(const KResolverCache&) = delete;
+	KResolverCache(KResolverCache&&) = delete;
+	KResolverCache& operator=(const KResolverCache&) = delete;
+	KResolverCache& operator=(KResolverCache&&) = delete;
+
+	//-----------------------------------------------------------------------------
+	~KResolverCache();
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// returns the process wide resolver cache
+	static KResolverCache& GetInstance();
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// switch the process wide use of the cache on or off - default is on
+	static void SetEnabled(bool bYesNo)
+	//-----------------------------------------------------------------------------
+	{
+		s_bEnabled = bYesNo;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// is the process wide use of the cache switched on?
+	static bool IsEnabled()
+	//-----------------------------------------------------------------------------
+	{
+		return s_bEnabled;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// resolve host name and port (or service name), from the cache if possible
+	/// @param sHostname the host name or IP address to resolve
+	/// @param sPort the port number or service name
+	/// @param ec receives the error code of the resolution
+	/// @return the resolved endpoints, empty on error
+	Endpoints Resolve(KStringView sHostname, KStringView sPort, boost::system::error_code& ec);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// resolve host name and port (or service name) with the system resolver, bypassing the cache
+	static Endpoints ResolveUncached(KStringView sHostname, KStringView sPort, boost::system::error_code& ec);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// remove one host name and port from the cache
+	void Remove(KStringView sHostname, KStringView sPort);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// remove all entries from the cache
+	void clear();
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// set a new configuration - existing entries keep their expiry time
+	void SetConfig(Config config);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// get the current configuration
+	Config GetConfig() const;
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// query cache statistics
+	Stats GetStats() const;
+	//-----------------------------------------------------------------------------
+
+//------
+private:
+//------
+
+	using Clock = KStopTime::Clock;
+
+	struct Entry
+	{
+		Endpoints                 Resolved;
+		boost::system::error_code ec;
+		Clock::time_point         tExpires;
+		// no background refresh before this time, after a failed refresh
+		Clock::time_point         tRetryRefresh;
+		bool                      bRefreshing { false };
+	};
+
+	struct Storage
+	{
+		std::unordered_map<KString, Entry> Entries;
+		Config config;
+	};
+
+	//-----------------------------------------------------------------------------
+	/// resolve and store the result - a failed background refresh keeps a valid entry
+	DEKAF2_PRIVATE
+	Endpoints Update(const KString& sKey, KStringView sHostname, KStringView sPort, boost::system::error_code& ec, bool bIsRefresh = false);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// start a background refresh
+	DEKAF2_PRIVATE
+	void Refresh(KString sKey, KString sHostname, KString sPort);
+	//-----------------------------------------------------------------------------
+
+	KThreadSafe<Storage>         m_Storage;
+	std::unique_ptr<KThreadPool> m_Refresher;
+	std::once_flag               m_RefresherOnce;
+
+	std::atomic<std::size_t> ma_iHits         { 0 };
+	std::atomic<std::size_t> ma_iNegativeHits { 0 };
+	std::atomic<std::size_t> ma_iMisses       { 0 };
+	std::atomic<std::size_t> ma_iRefreshes    { 0 };
+
+	static std::atomic<bool> s_bEnabled;
+
+}; // KResolverCache
+
+} // end of namespace dekaf2
@@ -458,4 +458,117 @@ KJSON KJsonRestClient::ThrowOrReturn(KHTTPError&& ec, KJSON&& retval)
 
 } // ThrowOrReturn
 
+//-----------------------------------------------------------------------------
+KRestFanOut::KRestFanOut(KURL URL, bool bVerifyCerts, uint16_t iMaxParallel)
+//-----------------------------------------------------------------------------
+: m_URL(std::move(URL))
+, m_bVerifyCerts(bVerifyCerts)
+, m_Workers(std::max(iMaxParallel, uint16_t(1)))
+{
+} // ctor
+
+//-----------------------------------------------------------------------------
+KRestFanOut& KRestFanOut::AddHeader(KHTTPHeader Header, KString sValue)
+//-----------------------------------------------------------------------------
+{
+	m_Headers.push_back({ std::move(Header), std::move(sValue) });
+	return *this;
+
+} // AddHeader
+
+//-----------------------------------------------------------------------------
+KRestFanOut::Response KRestFanOut::Run(const Request& request) const
+//-----------------------------------------------------------------------------
+{
+	KStopTime Timer;
+	Response response;
+
+	try
+	{
+		KRestClient Client(m_URL, m_bVerifyCerts);
+
+		Client.UseConnectionPool(m_ConnectionPool);
+		Client.SetTimeout(request.iTimeout > 0 ? request.iTimeout : m_iTimeout);
+		Client.SetError(response.Error);
+		Client.Verb(request.Verb);
+		Client.Path(request.sPath);
+
+		if (!request.Query.empty())
+		{
+			Client.SetQuery(request.Query);
+		}
+
+		for (const auto& Header : m_Headers)
+		{
+			Client.AddHeader(Header.first, Header.second);
+		}
+
+		for (const auto& Header : request.Headers)
+		{
+			Client.AddHeader(Header.first, Header.second);
+		}
+
+		KOutStringStream oss(response.sBody);
+		Client.Request(oss, request.sBody, request.Mime);
+		response.iStatusCode = Client.GetStatusCode();
+	}
+	catch (const std::exception& ex)
+	{
+		response.Error = KHTTPError { KHTTPError::H5xx_ERROR, ex.what() };
+	}
+
+	response.Duration = Timer.elapsed();
+
+	kDebug(2, "{} {}: HTTP-{} after {}", request.Verb.Serialize(), request.sPath, response.iStatusCode, response.Duration);
+
+	return response;
+
+} // Run
+
+//-----------------------------------------------------------------------------
+std::future<KRestFanOut::Response> KRestFanOut::Submit(Request request)
+//-----------------------------------------------------------------------------
+{
+	return m_Workers.push([this](const Request& request)
+	{
+		return Run(request);
+
+	}, std::move(request));
+
+} // Submit
+
+//-----------------------------------------------------------------------------
+std::vector<std::future<KRestFanOut::Response>> KRestFanOut::Submit(std::vector<Request> Requests)
+//-----------------------------------------------------------------------------
+{
+	std::vector<std::future<Response>> Futures;
+	Futures.reserve(Requests.size());
+
+	for (auto& request : Requests)
+	{
+		Futures.push_back(Submit(std::move(request)));
+	}
+
+	return Futures;
+
+} // Submit
+
+//-----------------------------------------------------------------------------
+std::vector<KRestFanOut::Response> KRestFanOut::Execute(std::vector<Request> Requests)
+//-----------------------------------------------------------------------------
+{
+	auto Futures = Submit(std::move(Requests));
+
+	std::vector<Response> Responses;
+	Responses.reserve(Futures.size());
+
+	for (auto& Future : Futures)
+	{
+		Responses.push_back(Future.get());
+	}
+
+	return Responses;
+
+} // Execute
+
 } // end of namespace dekaf2
@@ -49,6 +49,11 @@
 #include "kwebclient.h"
 #include "kjson.h"
 #include "khttperror.h"
+#include "kconnectionpool.h"
+#include "kthreadpool.h"
+#include "kduration.h"
+#include <future>
+#include <vector>
 
 namespace dekaf2 {
 
@@ -164,6 +169,7 @@ public:
 	using base::SetTimingCallback;
 	using base::SetServiceSummary;
 	using base::GetConnectedEndpoint;
+	using base::UseConnectionPool;
 
 //----------
 protected:
@@ -297,4 +303,88 @@ protected:
 
 }; // KJsonRestClient
 
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// Fan-out REST client: executes a batch of requests against one API concurrently
+/// and returns the responses in request order. The requests are run by a fixed
+/// number of worker threads (not one thread per request), and connections are
+/// reused through a KConnectionPool, so the latency of an aggregation of many
+/// upstream requests becomes roughly the max instead of the sum of the upstream
+/// latencies.
+class DEKAF2_PUBLIC KRestFanOut
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	using self = KRestFanOut;
+
+	/// one request of a batch
+	struct Request
+	{
+		KHTTPMethod Verb     { KHTTPMethod::GET };
+		KString     sPath;                ///< path of the request, appended to the path of the API URL
+		url::KQuery Query;                ///< additional query parms
+		KString     sBody;                ///< request body, if any
+		KMIME       Mime;                 ///< mime type of the request body
+		std::vector<std::pair<KHTTPHeader, KString>> Headers; ///< additional request headers
+		int         iTimeout { 0 };       ///< timeout in seconds for this request, 0 = use the default timeout
+
+	}; // Request
+
+	/// the outcome of one request of a batch
+	struct Response
+	{
+		KString     sBody;                ///< the response body
+		KHTTPError  Error;                ///< the error, if any
+		uint16_t    iStatusCode { 0 };    ///< the HTTP status code, 0 if no response was received
+		KDuration   Duration;             ///< the time it took to run this request
+
+		/// returns true if the request was successful
+		bool Good() const { return !Error && iStatusCode / 100 == 2; }
+
+	}; // Response
+
+	/// Construct with URL to connect to, including basic REST path and basic query parms.
+	/// @param URL the API URL
+	/// @param bVerifyCerts verify TLS certificates
+	/// @param iMaxParallel the maximum number of requests that are run in parallel
+	KRestFanOut (KURL URL, bool bVerifyCerts = false, uint16_t iMaxParallel = 16);
+
+	/// Set the default timeout in seconds for requests without an own timeout
+	self& SetTimeout (int iSeconds)      { m_iTimeout = iSeconds; return *this;                   }
+	/// Set the connection pool to use - per default, the process wide connection pool is used
+	self& SetConnectionPool (KConnectionPool& Pool) { m_ConnectionPool = &Pool; return *this;     }
+	/// Add a request header that is sent with all requests, like an authorization header
+	self& AddHeader (KHTTPHeader Header, KString sValue);
+
+	/// Submit one request for execution and return immediately.
+	/// @return a future for the response
+	std::future<Response> Submit (Request request);
+	/// Submit a batch of requests for execution and return immediately.
+	/// @return the futures for the responses, in the order of the requests
+	std::vector<std::future<Response>> Submit (std::vector<Request> Requests);
+	/// Execute a batch of requests concurrently and return after all of them finished.
+	/// Does not throw - check the error member of each response.
+	/// @return the responses, in the order of the requests
+	std::vector<Response> Execute (std::vector<Request> Requests);
+
+//----------
+private:
+//----------
+
+	DEKAF2_PRIVATE
+	Response Run (const Request& request) const;
+
+	KURL                                         m_URL;
+	std::vector<std::pair<KHTTPHeader, KString>> m_Headers;
+	KConnectionPool*                             m_ConnectionPool { &KConnectionPool::GetInstance() };
+	int                                          m_iTimeout       { 30 };
+	bool                                         m_bVerifyCerts   { false };
+	// declare last, it has to be destroyed first
+	KThreadPool                                  m_Workers;
+
+}; // KRestFanOut
+
 } // end of namespace dekaf2
@@ -48,8 +48,10 @@
 #include "klog.h"
 #include "dekaf2.h"
 #include "kexception.h"
+#include "kparallel.h"
 #include "bits/kron_utils.h"
 #include "croncpp.h"
+#include <algorithm>
 
 namespace dekaf2 {
 
@@ -478,6 +480,29 @@ bool            Kron::Scheduler::empty       ()
 Kron::SharedJob Kron::Scheduler::GetJob      (KUnixTime tNow)                           { return nullptr; }
 void            Kron::Scheduler::JobFinished (const SharedJob& Job)                     {                 }
 void            Kron::Scheduler::JobFailed   (const SharedJob& Job, KStringView sError) {                 }
+KUnixTime       Kron::Scheduler::NextExecution()                                  const { return INVALID_TIME; }
+
+//-----------------------------------------------------------------------------
+void Kron::Scheduler::WakeUp() const
+//-----------------------------------------------------------------------------
+{
+	std::lock_guard<std::mutex> Lock(m_WakeUpMutex);
+
+	if (m_WakeUp)
+	{
+		m_WakeUp();
+	}
+
+} // WakeUp
+
+//-----------------------------------------------------------------------------
+void Kron::Scheduler::SetWakeUp(std::function<void()> WakeUp)
+//-----------------------------------------------------------------------------
+{
+	std::lock_guard<std::mutex> Lock(m_WakeUpMutex);
+	m_WakeUp = std::move(WakeUp);
+
+} // SetWakeUp
 
 //-----------------------------------------------------------------------------
 bool  Kron::Scheduler::ModifyJob   (const SharedJob& Job)
@@ -536,6 +561,63 @@ std::size_t Kron::Scheduler::AddJobsFromCrontab(KStringView sCrontab, bool bHasS
 
 } // AddJobsFromCrontab
 
+//-----------------------------------------------------------------------------
+bool Kron::LocalScheduler::IsLater(const Entry& left, const Entry& right)
+//-----------------------------------------------------------------------------
+{
+	// jobs with the same execution time are returned in the order of their scheduling
+	return left.tNext > right.tNext || (left.tNext == right.tNext && left.iGeneration > right.iGeneration);
+
+} // LocalScheduler::IsLater
+
+//-----------------------------------------------------------------------------
+void Kron::LocalScheduler::Push(Schedule& Jobs, Entry& entry, KUnixTime tNext)
+//-----------------------------------------------------------------------------
+{
+	entry.tNext       = tNext;
+	entry.iGeneration = ++Jobs.iGeneration;
+
+	if (Jobs.Heap.size() > 2 * Jobs.Jobs.size() + 64)
+	{
+		// too many outdated entries - rebuild the heap from the job list
+		Jobs.Heap.clear();
+
+		for (const auto& it : Jobs.Jobs)
+		{
+			Jobs.Heap.push_back(it.second);
+		}
+
+		std::make_heap(Jobs.Heap.begin(), Jobs.Heap.end(), IsLater);
+	}
+	else
+	{
+		Jobs.Heap.push_back(entry);
+		std::push_heap(Jobs.Heap.begin(), Jobs.Heap.end(), IsLater);
+	}
+
+} // LocalScheduler::Push
+
+//-----------------------------------------------------------------------------
+void Kron::LocalScheduler::DropOutdated(Schedule& Jobs)
+//-----------------------------------------------------------------------------
+{
+	// keep the top of the heap valid, so that it always has the next execution time
+	while (!Jobs.Heap.empty())
+	{
+		const auto& Top = Jobs.Heap.front();
+		auto it = Jobs.Jobs.find(Top.Job->JobID());
+
+		if (it != Jobs.Jobs.end() && it->second.iGeneration == Top.iGeneration)
+		{
+			break;
+		}
+
+		std::pop_heap(Jobs.Heap.begin(), Jobs.Heap.end(), IsLater);
+		Jobs.Heap.pop_back();
+	}
+
+} // LocalScheduler::DropOutdated
+
 //-----------------------------------------------------------------------------
 bool Kron::LocalScheduler::AddJob(const std::shared_ptr<Job>& job)
 //-----------------------------------------------------------------------------
@@ -545,27 +627,35 @@ bool Kron::LocalScheduler::AddJob(const std::shared_ptr<Job>& job)
 	const auto JobID    = job->JobID();
 	const auto& JobName = job->Name();
 
-	// get a unique lock
-	auto Jobs = m_Jobs.unique();
+	bool bIsFirst;
 
-	// check for job ID
-	for (const auto& it : *Jobs)
 	{
-		const auto jj = it.second.get();
+		// get a unique lock
+		auto Jobs = m_Jobs.unique();
 
-		if (JobID   == jj->JobID() ||
-			JobName == jj->Name())
+		// check for job ID and name
+		if (Jobs->Jobs.find(JobID) != Jobs->Jobs.end() || Jobs->Names.find(JobName) != Jobs->Names.end())
 		{
-			kDebug(1, "job '()' is already part of the job list (with ID {} and name '{}')",
-				   JobName, jj->JobID(), jj->Name());
+			kDebug(1, "job '{}' is already part of the job list (with ID {})", JobName, JobID);
 			return false;
 		}
+
+		auto& entry = Jobs->Jobs.emplace(JobID, Entry { job, tNext, 0 }).first->second;
+		Jobs->Names.insert(JobName);
+		Push(Jobs.get(), entry, tNext);
+
+		bIsFirst = Jobs->Heap.front().Job == job;
 	}
 
-	Jobs->insert( { tNext, job } );
 	kDebug(1, "added '{}': '{}'\nnext execution: {}",
 		   job->Name(), job->Command(), kFormTimestamp(tNext));
 
+	if (bIsFirst)
+	{
+		// the Kron may sleep longer than until the execution of this job
+		WakeUp();
+	}
+
 	return true;
 
 } // LocalScheduler::AddJob
@@ -577,22 +667,22 @@ bool Kron::LocalScheduler::DeleteJob(Job::ID JobID)
 	// get a unique lock
 	auto Jobs = m_Jobs.unique();
 
-	// check for job ID
-	for (auto it = Jobs->begin(); it != Jobs->end(); ++it)
-	{
-		if (JobID == it->second.get()->JobID())
-		{
-			kDebug(2, "deleting job '{}' with ID {}", it->second->Name(), JobID);
-
-			Jobs->erase(it);
+	auto it = Jobs->Jobs.find(JobID);
 
-			return true;
-		}
+	if (it == Jobs->Jobs.end())
+	{
+		kDebug(2, "JobID not found: {}", JobID);
+		return false;
 	}
 
-	kDebug(2, "JobID not found: {}", JobID);
+	kDebug(2, "deleting job '{}' with ID {}", it->second.Job->Name(), JobID);
 
-	return false;
+	// the heap entry is dropped when it comes to the top
+	Jobs->Names.erase(it->second.Job->Name());
+	Jobs->Jobs.erase(it);
+	DropOutdated(Jobs.get());
+
+	return true;
 
 } // LocalScheduler::DeleteJob
 
@@ -602,47 +692,78 @@ Kron::SharedJob Kron::LocalScheduler::GetJob(KUnixTime tNow)
 {
 	auto Jobs = m_Jobs.unique();
 
-	if (Jobs->empty())
-	{
-		return nullptr;
-	}
-
-	// the job map is sorted by next execution time
-	if (Jobs->begin()->first > tNow)
+	// the top of the heap is always valid, and has the next execution time
+	if (Jobs->Heap.empty() || Jobs->Heap.front().tNext > tNow)
 	{
-		// a job in the future - abort pulling jobs here
+		// no job, or a job in the future - abort pulling jobs here
 		return nullptr;
 	}
 
-	auto job = Jobs->begin()->second;
+	auto job = Jobs->Heap.front().Job;
 
-	// we will remove the job, and insert it with the next execution time again
-	Jobs->erase(Jobs->begin());
+	std::pop_heap(Jobs->Heap.begin(), Jobs->Heap.end(), IsLater);
+	Jobs->Heap.pop_back();
 
+	// insert the job with its next execution time again
 	auto tNext = job->Next(tNow);
+	auto it    = Jobs->Jobs.find(job->JobID());
 
 	if (tNext != INVALID_TIME && tNext > tNow)
 	{
-		Jobs->insert( { tNext, job } );
+		Push(Jobs.get(), it->second, tNext);
+	}
+	else
+	{
+		Jobs->Names.erase(job->Name());
+		Jobs->Jobs.erase(it);
 	}
 
+	DropOutdated(Jobs.get());
+
 	return job;
 
 } // LocalScheduler::GetJob
 
+//-----------------------------------------------------------------------------
+KUnixTime Kron::LocalScheduler::NextExecution() const
+//-----------------------------------------------------------------------------
+{
+	auto Jobs = m_Jobs.shared();
+
+	return Jobs->Heap.empty() ? INVALID_TIME : Jobs->Heap.front().tNext;
+
+} // LocalScheduler::NextExecution
+
 //-----------------------------------------------------------------------------
 KJSON Kron::LocalScheduler::ListJobs() const
 //-----------------------------------------------------------------------------
 {
+	std::vector<Entry> Entries;
+
+	{
+		auto Jobs = m_Jobs.shared();
+
+		Entries.reserve(Jobs->Jobs.size());
+
+		for (const auto& it : Jobs->Jobs)
+		{
+			Entries.push_back(it.second);
+		}
+	}
+
+	// list the jobs sorted by next execution time
+	std::sort(Entries.begin(), Entries.end(), [](const Entry& left, const Entry& right)
+	{
+		return IsLater(right, left);
+	});
+
 	KJSON jobs;
 	jobs = KJSON::array();
 
-	auto Jobs = m_Jobs.shared();
-
-	for (const auto& job : *Jobs)
+	for (const auto& entry : Entries)
 	{
-		jobs.push_back(job.second->Print());
-		jobs.back()["tNext"] = job.first.to_time_t();
+		jobs.push_back(entry.Job->Print());
+		jobs.back()["tNext"] = entry.tNext.to_time_t();
 	}
 
 	return jobs;
@@ -653,7 +774,7 @@ KJSON Kron::LocalScheduler::ListJobs() const
 std::size_t Kron::LocalScheduler::size() const
 //-----------------------------------------------------------------------------
 {
-	return m_Jobs.shared()->size();
+	return m_Jobs.shared()->Jobs.size();
 
 }
 
@@ -661,13 +782,14 @@ std::size_t Kron::LocalScheduler::size() const
 bool Kron::LocalScheduler::empty() const
 //-----------------------------------------------------------------------------
 {
-	return m_Jobs.shared()->empty();
+	return m_Jobs.shared()->Jobs.empty();
 }
 
 //-----------------------------------------------------------------------------
-Kron::Kron(bool bAllowLaunches, KDuration CheckEvery, SharedScheduler Scheduler)
+Kron::Kron(bool bAllowLaunches, KDuration CheckEvery, SharedScheduler Scheduler, std::size_t iMaxParallelJobs)
 //-----------------------------------------------------------------------------
 : m_Scheduler(Scheduler)
+, m_iMaxParallelJobs(iMaxParallelJobs)
 {
 	if (!m_Scheduler)
 	{
@@ -678,6 +800,8 @@ Kron::Kron(bool bAllowLaunches, KDuration CheckEvery, SharedScheduler Scheduler)
 	{
 		kDebug(1, "starting");
 
+		m_Scheduler->SetWakeUp([this]() { WakeUp(); });
+
 		// start the time keeper
 		m_Chronos = std::make_unique<std::thread>(&Kron::Launcher, this, CheckEvery);
 	}
@@ -690,9 +814,12 @@ Kron::~Kron()
 {
 	if (m_Chronos)
 	{
+		m_Scheduler->SetWakeUp(nullptr);
+
 		kDebug(1, "stopping Chronos");
 		// tell the thread to stop
 		m_bStop = true;
+		WakeUp();
 		// and block until it is home
 		m_Chronos->join();
 	}
@@ -701,16 +828,38 @@ Kron::~Kron()
 
 } // dtor
 
+//-----------------------------------------------------------------------------
+void Kron::WakeUp()
+//-----------------------------------------------------------------------------
+{
+	{
+		std::lock_guard<std::mutex> Lock(m_WakeUpMutex);
+		m_bWokenUp = true;
+	}
+
+	m_WakeUp.notify_one();
+
+} // WakeUp
+
 //-----------------------------------------------------------------------------
 // returns number of newly started jobs
-std::size_t Kron::StartNewJobs()
+std::size_t Kron::StartNewJobs(KUnixTime tNow)
 //-----------------------------------------------------------------------------
 {
-	std::size_t iStarted { 0 };
+	struct DueJob
+	{
+		SharedJob Job;
+		bool      bStarted { false };
+		KString   sError;
+	};
 
-	auto tNow = Dekaf::getInstance().GetCurrentTime();
+	std::vector<DueJob> DueJobs;
+
+	auto iRunning = m_RunningJobs.shared()->size();
 
-	for (;m_bStop == false;)
+	// do not take more jobs from the scheduler than we may start - the others
+	// stay due until running jobs finished
+	while (m_bStop == false && (!m_iMaxParallelJobs || iRunning + DueJobs.size() < m_iMaxParallelJobs))
 	{
 		auto job = m_Scheduler->GetJob(tNow);
 
@@ -720,14 +869,41 @@ std::size_t Kron::StartNewJobs()
 			break;
 		}
 
-		if (job->Start())
+		DueJobs.push_back(DueJob { std::move(job), false, KString() });
+	}
+
+	if (DueJobs.empty())
+	{
+		return 0;
+	}
+
+	// starting a job forks a shell - start many due jobs in parallel
+	KParallelOptions Options;
+	Options.iGrainSize = 1;
+
+	kParallelForEach(DueJobs, [](DueJob& Due)
+	{
+		Due.bStarted = Due.Job->Start();
+
+		if (!Due.bStarted)
+		{
+			Due.sError = strerror(errno);
+		}
+
+	}, Options);
+
+	std::size_t iStarted { 0 };
+
+	for (auto& Due : DueJobs)
+	{
+		if (Due.bStarted)
 		{
-			m_RunningJobs.unique()->push_back(job);
+			m_RunningJobs.unique()->push_back(std::move(Due.Job));
 			++iStarted;
 		}
 		else
 		{
-			m_Scheduler->JobFailed(job, strerror(errno));
+			m_Scheduler->JobFailed(Due.Job, Due.sError);
 		}
 	}
 
@@ -754,7 +930,7 @@ std::size_t Kron::FinishWaitingJobs()
 			m_Scheduler->JobFinished(*job);
 
 			// remove from list
-			Jobs->erase(job);
+			job = Jobs->erase(job);
 		}
 		else
 		{
@@ -775,41 +951,25 @@ void Kron::Launcher(KDuration CheckEvery)
 		CheckEvery = std::chrono::seconds(1);
 	}
 
-	kDebug(1, "will check with interval of {} for jobs to start", kTranslateDuration(CheckEvery));
+	kDebug(1, "will sleep until the next job is due, or poll with interval of {} if not known",
+	       kTranslateDuration(CheckEvery));
 
-	std::size_t iFactor  { 1 };
-	std::size_t iRunning { 0 };
-
-	if (CheckEvery.milliseconds() > chrono::milliseconds(100))
-	{
-		// while jobs are running, we want to check for termination at
-		// least every 100 millisecods
-		iFactor = CheckEvery.milliseconds() / chrono::milliseconds(100);
+	// while jobs are running, we want to check for termination at
+	// least every 100 millisecods
+	const KDuration CheckRunning = std::chrono::milliseconds(100);
 
-		if (iFactor > 1)
-		{
-			kDebug(2, "will check {} times faster for terminated jobs", iFactor);
-		}
-	}
-
-	std::size_t iCountDown { iFactor };
+	std::size_t iRunning { 0 };
 
 	for(;;)
 	{
+		auto tNow = KUnixTime::now();
+
 		try
 		{
-			if (iRunning)
-			{
-				if (--iCountDown == 0)
-				{
-					iCountDown = iFactor;
-				}
-			}
-
-			if (!iRunning || iCountDown == iFactor)
+			if (!m_bStop)
 			{
 				// check for all new jobs to start
-				iRunning += StartNewJobs();
+				iRunning += StartNewJobs(tNow);
 			}
 
 			if (iRunning)
@@ -834,9 +994,31 @@ void Kron::Launcher(KDuration CheckEvery)
 			kUnknownException();
 		}
 
-		std::this_thread::sleep_for((iRunning && iFactor > 1)
-									? chrono::milliseconds(100)
-									: CheckEvery.duration());
+		// sleep until the next job is due, or until woken up for an earlier job
+		auto Sleep = CheckEvery;
+		auto tNext = m_Scheduler->NextExecution();
+
+		if (tNext != INVALID_TIME && tNext > tNow)
+		{
+			// this may be zero if the job became due right now
+			Sleep = std::max(KDuration(tNext - KUnixTime::now()), KDuration::zero());
+		}
+		// else we either poll, or we could not start all due jobs because of the
+		// limit of parallel jobs, and wait for running jobs to finish
+
+		if (iRunning && Sleep > CheckRunning)
+		{
+			Sleep = CheckRunning;
+		}
+
+		std::unique_lock<std::mutex> Lock(m_WakeUpMutex);
+
+		m_WakeUp.wait_for(Lock, Sleep.duration(), [this]()
+		{
+			return m_bWokenUp || m_bStop;
+		});
+
+		m_bWokenUp = false;
 	}
 
 } // Launcher
@@ -57,6 +57,10 @@
 #include <mutex>
 #include <map>
 #include <vector>
+#include <functional>
+#include <condition_variable>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace dekaf2 {
 
@@ -223,6 +227,9 @@ public:
 		/// Defaults to false
 		/// @return count of added jobs
 		virtual std::size_t AddJobsFromCrontab(KStringView sCrontab, bool bHasSeconds = false);
+		/// return the next execution time of all jobs - INVALID_TIME if there are no jobs, or if the
+		/// scheduler does not know it, in which case Kron polls GetJob() in its check interval
+		virtual KUnixTime NextExecution() const;
 
 	//----------
 	protected:
@@ -236,7 +243,19 @@ public:
 		virtual void JobFinished(const SharedJob& Job);
 		/// a Job failed to run and is returned to the scheduler
 		virtual void JobFailed(const SharedJob& Job, KStringView sError);
+		/// wake up the Kron that uses this scheduler, to check the next execution time again -
+		/// call it when a job was added that executes earlier than all others
+		void WakeUp() const;
 
+	//----------
+	private:
+	//----------
+
+		/// set by Kron to get woken up
+		void SetWakeUp(std::function<void()> WakeUp);
+
+		mutable std::mutex     m_WakeUpMutex;
+		std::function<void()>  m_WakeUp;
 
 	}; // Kron::Scheduler
 
@@ -260,6 +279,8 @@ public:
 		virtual std::size_t size() const override final;
 		/// any jobs?
 		virtual bool empty() const override final;
+		/// return the next execution time of all jobs, INVALID_TIME if there are no jobs
+		virtual KUnixTime NextExecution() const override final;
 
 	//----------
 	protected:
@@ -272,18 +293,47 @@ public:
 	private:
 	//----------
 
-		KThreadSafe<
-			KMultiMap<KUnixTime, SharedJob>
-		> m_Jobs;  // the Job list, sorted by next execution time
+		/// a job and its next execution time
+		struct Entry
+		{
+			SharedJob   Job;
+			KUnixTime   tNext;
+			std::size_t iGeneration;   ///< increases with each scheduling, to find outdated heap entries
+		};
+
+		/// all jobs, with a min heap on their next execution time - deleted or rescheduled jobs leave
+		/// outdated entries in the heap, which are dropped when they come to the top, or in a rebuild
+		struct Schedule
+		{
+			std::vector<Entry>                   Heap;
+			std::unordered_map<Job::ID, Entry>   Jobs;
+			std::unordered_set<KString>          Names;
+			std::size_t                          iGeneration { 0 };
+		};
+
+		DEKAF2_PRIVATE
+		static bool IsLater(const Entry& left, const Entry& right);
+		DEKAF2_PRIVATE
+		static void Push(Schedule& Jobs, Entry& entry, KUnixTime tNext);
+		DEKAF2_PRIVATE
+		static void DropOutdated(Schedule& Jobs);
+
+		KThreadSafe<Schedule> m_Jobs;
 
 	}; // Kron::LocalScheduler
 
 	using SharedScheduler = std::shared_ptr<Scheduler>;
 
 	/// ctor, takes a Scheduler (defaults to a LocalScheduler)
-	Kron(bool bAllowLaunches       = true,
-		 KDuration CheckEvery      = std::chrono::seconds(1),
-		 SharedScheduler Scheduler = std::make_shared<LocalScheduler>());
+	/// @param bAllowLaunches if false, no jobs are started
+	/// @param CheckEvery interval to poll schedulers that do not know their next execution time
+	/// @param Scheduler the Scheduler
+	/// @param iMaxParallelJobs max count of jobs running at the same time, 0 = unlimited - due jobs
+	/// beyond the limit stay with the scheduler until running jobs finished
+	Kron(bool bAllowLaunches         = true,
+		 KDuration CheckEvery        = std::chrono::seconds(1),
+		 SharedScheduler Scheduler   = std::make_shared<LocalScheduler>(),
+		 std::size_t iMaxParallelJobs = 0);
 	~Kron();
 
 	/// return the Scheduler object
@@ -297,16 +347,21 @@ public:
 protected:
 //----------
 
-	std::size_t StartNewJobs      ();
+	std::size_t StartNewJobs      (KUnixTime tNow);
 	std::size_t FinishWaitingJobs ();
 	void        Launcher          (KDuration CheckEvery);
+	void        WakeUp            ();
 
 	SharedScheduler               m_Scheduler;
 	KThreadSafe<
 		std::vector<SharedJob>
 	>                             m_RunningJobs;     // the currently running jobs
+	std::size_t                   m_iMaxParallelJobs { 0 };
 	std::unique_ptr<std::thread>  m_Chronos;         // the time keeper
 	std::atomic<bool>             m_bStop { false }; // syncronization with time keeper thread
+	std::mutex                    m_WakeUpMutex;
+	std::condition_variable       m_WakeUp;          // wakes the time keeper for new jobs or to stop
+	bool                          m_bWokenUp { false };
 
 }; // Kron
 
@@ -0,0 +1,687 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#include "ksharedmemorycache.h"
+#ifndef DEKAF2_IS_WINDOWS
+#include "bits/khash.h"
+#include "kformat.h"
+#include "klog.h"
+#include "ksystem.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <sys/stat.h>
+#include <signal.h>
+#include <unistd.h>
+
+namespace dekaf2 {
+
+namespace {
+
+constexpr std::uint32_t iMagic       = 0x4b534d43; // KSMC
+constexpr std::uint32_t iStateNew    = 0;
+constexpr std::uint32_t iStateInit   = 1;
+constexpr std::uint32_t iStateReady  = 2;
+constexpr std::size_t   iHeaderSize  = 64;
+constexpr std::size_t   iMaxRetries  = 1000;
+// readers treat a slot that stays locked for longer as a miss, its writer may have crashed
+constexpr std::size_t   iReadSpins   = 16;
+
+} // end of anonymous namespace
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// the first bytes of the segment, describing its geometry
+struct KSharedMemoryCache::Header
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	std::atomic<std::uint32_t> iState;
+	std::uint32_t              iMagic;
+	std::uint64_t              iSlots;
+	std::uint64_t              iMaxKeySize;
+	std::uint64_t              iMaxValueSize;
+
+}; // Header
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// the head of each slot, followed by MaxKeySize() bytes for the key and
+/// MaxValueSize() bytes for the value
+struct KSharedMemoryCache::Slot
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	// the version in the upper 32 bits, which is odd while a writer owns the slot,
+	// and the pid of that writer in the lower 32 bits
+	std::atomic<std::uint64_t> iState;
+	std::uint32_t              iKeySize;
+	std::uint32_t              iValueSize;
+	std::uint64_t              iHash;      // 0 for an empty slot
+	std::int64_t               iExpires;   // 0 if the value never expires
+	std::int64_t               iWritten;
+
+	char* Data() const { return const_cast<char*>(reinterpret_cast<const char*>(this + 1)); }
+
+}; // Slot
+
+static_assert(sizeof(std::atomic<std::uint64_t>) == sizeof(std::uint64_t), "atomics need to be address free");
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "atomics need to be lock free in shared memory");
+
+namespace {
+
+//-----------------------------------------------------------------------------
+constexpr bool IsLocked(std::uint64_t iState)
+//-----------------------------------------------------------------------------
+{
+	return (iState >> 32) & 1;
+
+} // IsLocked
+
+//-----------------------------------------------------------------------------
+constexpr pid_t GetOwner(std::uint64_t iState)
+//-----------------------------------------------------------------------------
+{
+	return static_cast<pid_t>(iState & 0xffffffff);
+
+} // GetOwner
+
+//-----------------------------------------------------------------------------
+constexpr std::uint64_t NextVersion(std::uint64_t iState, pid_t Owner = 0)
+//-----------------------------------------------------------------------------
+{
+	return (((iState >> 32) + 1) << 32) | static_cast<std::uint32_t>(Owner);
+
+} // NextVersion
+
+} // end of anonymous namespace
+
+namespace {
+
+//-----------------------------------------------------------------------------
+std::int64_t Now()
+//-----------------------------------------------------------------------------
+{
+	// the steady clock counts from boot on our platforms, and is therefore
+	// comparable between processes
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+} // Now
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+KSharedMemoryCache::KSharedMemoryCache(KStringView sPathname,
+                                       std::size_t iSlots,
+                                       std::size_t iMaxKeySize,
+                                       std::size_t iMaxValueSize,
+                                       bool        bForceCreation,
+                                       int         iMode)
+//-----------------------------------------------------------------------------
+: base(sPathname, SegmentSize(RoundUp(iSlots), iMaxKeySize, iMaxValueSize), bForceCreation, iMode)
+, m_iSlots(RoundUp(iSlots))
+, m_iMaxKeySize(iMaxKeySize)
+, m_iMaxValueSize(iMaxValueSize)
+, m_iSlotSize(SlotSize(iMaxKeySize, iMaxValueSize))
+{
+	Attach();
+
+} // ctor
+
+//-----------------------------------------------------------------------------
+std::size_t KSharedMemoryCache::RoundUp(std::size_t iSlots)
+//-----------------------------------------------------------------------------
+{
+	std::size_t iSize = iWindowSize;
+
+	while (iSize < iSlots)
+	{
+		iSize <<= 1;
+	}
+
+	return iSize;
+
+} // RoundUp
+
+//-----------------------------------------------------------------------------
+std::size_t KSharedMemoryCache::SlotSize(std::size_t iMaxKeySize, std::size_t iMaxValueSize)
+//-----------------------------------------------------------------------------
+{
+	// align the slots on cache lines
+	return (sizeof(Slot) + iMaxKeySize + iMaxValueSize + 63) & ~std::size_t(63);
+
+} // SlotSize
+
+//-----------------------------------------------------------------------------
+std::size_t KSharedMemoryCache::SegmentSize(std::size_t iSlots, std::size_t iMaxKeySize, std::size_t iMaxValueSize)
+//-----------------------------------------------------------------------------
+{
+	return iHeaderSize + iSlots * SlotSize(iMaxKeySize, iMaxValueSize);
+
+} // SegmentSize
+
+//-----------------------------------------------------------------------------
+std::uint64_t KSharedMemoryCache::HashKey(KStringView sKey)
+//-----------------------------------------------------------------------------
+{
+	// we need a hash that is stable between processes, and 0 marks empty slots
+	std::uint64_t iHash = kHash(sKey.data(), sKey.size());
+	return iHash ? iHash : 1;
+
+} // HashKey
+
+//-----------------------------------------------------------------------------
+bool KSharedMemoryCache::Attach()
+//-----------------------------------------------------------------------------
+{
+	static_assert(sizeof(Header) <= iHeaderSize, "header too large");
+
+	if (!base::is_open())
+	{
+		return false;
+	}
+
+	auto iSegmentSize = SegmentSize(m_iSlots, m_iMaxKeySize, m_iMaxValueSize);
+	auto pHeader      = static_cast<Header*>(base::get());
+
+	// another process may just be creating the segment - wait until it has its
+	// final size and the header is written
+	for (std::size_t iWait = 0; iWait < iMaxRetries; ++iWait)
+	{
+		struct stat StatBuf;
+
+		if (fstat(GetFileDescriptor(), &StatBuf) < 0)
+		{
+			return SetError(kFormat("fstat(): {}", KStringView(strerror(errno))));
+		}
+
+		if (static_cast<std::size_t>(StatBuf.st_size) >= iHeaderSize)
+		{
+			auto iState = pHeader->iState.load(std::memory_order_acquire);
+
+			if (iState == iStateReady)
+			{
+				if (pHeader->iMagic        != iMagic
+				 || pHeader->iSlots        != m_iSlots
+				 || pHeader->iMaxKeySize   != m_iMaxKeySize
+				 || pHeader->iMaxValueSize != m_iMaxValueSize
+				 || static_cast<std::size_t>(StatBuf.st_size) < iSegmentSize)
+				{
+					return SetError(kFormat("shared memory cache has a different geometry: {} slots, key size {}, value size {}",
+					                        pHeader->iSlots, pHeader->iMaxKeySize, pHeader->iMaxValueSize));
+				}
+
+				m_pHeader = pHeader;
+				m_pSlots  = static_cast<char*>(base::get()) + iHeaderSize;
+
+				return true;
+			}
+
+			if (iState == iStateNew
+			 && static_cast<std::size_t>(StatBuf.st_size) >= iSegmentSize
+			 && pHeader->iState.compare_exchange_strong(iState, iStateInit, std::memory_order_acquire))
+			{
+				// the slots are zero initialized by the system, which makes them empty
+				pHeader->iMagic        = iMagic;
+				pHeader->iSlots        = m_iSlots;
+				pHeader->iMaxKeySize   = m_iMaxKeySize;
+				pHeader->iMaxValueSize = m_iMaxValueSize;
+				pHeader->iState.store(iStateReady, std::memory_order_release);
+				continue;
+			}
+		}
+
+		kMilliSleep(1);
+	}
+
+	return SetError("timeout waiting for the initialization of the shared memory cache");
+
+} // Attach
+
+//-----------------------------------------------------------------------------
+KSharedMemoryCache::Slot& KSharedMemoryCache::GetSlot(std::size_t iSlot) const
+//-----------------------------------------------------------------------------
+{
+	return *reinterpret_cast<Slot*>(m_pSlots + (iSlot & (m_iSlots - 1)) * m_iSlotSize);
+
+} // GetSlot
+
+//-----------------------------------------------------------------------------
+std::size_t KSharedMemoryCache::FirstSlot(std::uint64_t iHash) const
+//-----------------------------------------------------------------------------
+{
+	return static_cast<std::size_t>(iHash ^ (iHash >> 32)) & (m_iSlots - 1);
+
+} // FirstSlot
+
+//-----------------------------------------------------------------------------
+bool KSharedMemoryCache::Read(const Slot& slot, std::uint64_t iHash, KStringView sKey, KString* sValue,
+                              std::uint64_t* piState, std::int64_t* piWritten) const
+//-----------------------------------------------------------------------------
+{
+	for (std::size_t iTry = 0; iTry < iReadSpins; ++iTry)
+	{
+		auto iState = slot.iState.load(std::memory_order_acquire);
+
+		if (IsLocked(iState))
+		{
+			// a writer owns the slot
+			std::this_thread::yield();
+			continue;
+		}
+
+		// all reads may see a half written slot - they are only trusted if the
+		// state did not change meanwhile
+		auto iExpires = slot.iExpires;
+		auto iWritten = slot.iWritten;
+
+		bool bFound = slot.iHash    == iHash
+		           && slot.iKeySize == sKey.size()
+		           && (!iExpires || iExpires > Now())
+		           && !std::memcmp(slot.Data(), sKey.data(), sKey.size());
+
+		if (bFound && sValue)
+		{
+			sValue->assign(slot.Data() + m_iMaxKeySize, std::min<std::size_t>(slot.iValueSize, m_iMaxValueSize));
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if (slot.iState.load(std::memory_order_relaxed) == iState)
+		{
+			if (piState)   *piState   = iState;
+			if (piWritten) *piWritten = iWritten;
+
+			return bFound;
+		}
+	}
+
+	return false;
+
+} // Read
+
+//-----------------------------------------------------------------------------
+bool KSharedMemoryCache::Lock(Slot& slot, std::uint64_t iState)
+//-----------------------------------------------------------------------------
+{
+	// only lock the slot if it is still in the state the caller has seen
+	if (IsLocked(iState) || !slot.iState.compare_exchange_strong(iState, NextVersion(iState, getpid()), std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	// do not let the following writes become visible before the locked state
+	std::atomic_thread_fence(std::memory_order_release);
+
+	return true;
+
+} // Lock
+
+//-----------------------------------------------------------------------------
+bool KSharedMemoryCache::Unlock(Slot& slot)
+//-----------------------------------------------------------------------------
+{
+	auto iState = slot.iState.load(std::memory_order_relaxed);
+
+	// only unlock if we still own the lock - if another process reclaimed it
+	// meanwhile, it also frees the slot
+	if (!IsLocked(iState) || GetOwner(iState) != getpid()
+	 || !slot.iState.compare_exchange_strong(iState, NextVersion(iState), std::memory_order_release))
+	{
+		kDebug(1, "lost the lock of a slot to process {}", GetOwner(iState));
+		return false;
+	}
+
+	return true;
+
+} // Unlock
+
+//-----------------------------------------------------------------------------
+bool KSharedMemoryCache::Reclaim(Slot& slot)
+//-----------------------------------------------------------------------------
+{
+	auto iState = slot.iState.load(std::memory_order_relaxed);
+
+	if (!IsLocked(iState))
+	{
+		return false;
+	}
+
+	auto Owner = GetOwner(iState);
+
+	if (Owner == getpid() || kill(Owner, 0) == 0 || errno != ESRCH)
+	{
+		// the writer is alive
+		return false;
+	}
+
+	// take over the lock of the crashed writer - as nobody else can unlock the slot
+	// meanwhile, the next version is not stored by anyone else
+	if (!slot.iState.compare_exchange_strong(iState, (iState & ~std::uint64_t(0xffffffff)) | static_cast<std::uint32_t>(getpid()), std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	kDebug(2, "unlocking slot of crashed writer {}", Owner);
+
+	return true;
+
+} // Reclaim
+
+//-----------------------------------------------------------------------------
+bool KSharedMemoryCache::Set(KStringView sKey, KStringView sValue, KDuration TimeToLive)
+//-----------------------------------------------------------------------------
+{
+	if (!is_open() || sKey.size() > m_iMaxKeySize || sValue.size() > m_iMaxValueSize)
+	{
+		return false;
+	}
+
+	auto iHash  = HashKey(sKey);
+	auto iFirst = FirstSlot(iHash);
+	auto iNow   = Now();
+
+	for (std::size_t iTry = 0; iTry < iMaxRetries; ++iTry)
+	{
+		// take the slot with this key, else the first free or expired slot,
+		// else the oldest one of the window - and remember the state in which
+		// we saw it, to not overwrite it if another writer changed it meanwhile
+		Slot*         pTarget { nullptr };
+		std::uint64_t iTargetState { 0 };
+		std::int64_t  iOldest { 0 };
+		bool          bFree { false };
+
+		for (std::size_t i = 0; i < iWindowSize; ++i)
+		{
+			auto& slot = GetSlot(iFirst + i);
+			std::uint64_t iState;
+
+			if (Read(slot, iHash, sKey, nullptr, &iState))
+			{
+				pTarget      = &slot;
+				iTargetState = iState;
+				break;
+			}
+
+			if (bFree)
+			{
+				continue;
+			}
+
+			iState = slot.iState.load(std::memory_order_acquire);
+
+			if (IsLocked(iState))
+			{
+				// a slot left locked by a crashed writer would be lost to the
+				// window - free it, its content may be half written
+				if (!Reclaim(slot))
+				{
+					continue;
+				}
+
+				slot.iHash = 0;
+				Unlock(slot);
+
+				iState = slot.iState.load(std::memory_order_acquire);
+
+				if (IsLocked(iState))
+				{
+					continue;
+				}
+			}
+
+			auto iWritten = slot.iWritten;
+
+			if (!slot.iHash || (slot.iExpires && slot.iExpires <= iNow))
+			{
+				pTarget      = &slot;
+				iTargetState = iState;
+				bFree        = true;
+			}
+			else if (!pTarget || iWritten < iOldest)
+			{
+				pTarget      = &slot;
+				iTargetState = iState;
+				iOldest      = iWritten;
+			}
+		}
+
+		if (!pTarget || !Lock(*pTarget, iTargetState))
+		{
+			// all slots are busy, or another writer was faster
+			std::this_thread::yield();
+			continue;
+		}
+
+		pTarget->iHash      = iHash;
+		pTarget->iKeySize   = static_cast<std::uint32_t>(sKey.size());
+		pTarget->iValueSize = static_cast<std::uint32_t>(sValue.size());
+		pTarget->iExpires   = TimeToLive > KDuration::zero() ? iNow + TimeToLive.duration().count() : 0;
+		pTarget->iWritten   = iNow;
+		std::memcpy(pTarget->Data(), sKey.data(), sKey.size());
+		std::memcpy(pTarget->Data() + m_iMaxKeySize, sValue.data(), sValue.size());
+
+		if (!Unlock(*pTarget))
+		{
+			// the value may be partially overwritten
+			return false;
+		}
+
+		// a concurrent writer may have stored the same key in another slot of the
+		// window - the older copy is removed, so that the last writer wins and at
+		// least one copy survives
+		for (std::size_t i = 0; i < iWindowSize; ++i)
+		{
+			auto& slot = GetSlot(iFirst + i);
+			std::uint64_t iState;
+			std::int64_t  iWritten;
+
+			if (&slot != pTarget
+			 && Read(slot, iHash, sKey, nullptr, &iState, &iWritten)
+			 && (iWritten < iNow || (iWritten == iNow && &slot > pTarget))
+			 && Lock(slot, iState))
+			{
+				slot.iHash = 0;
+				Unlock(slot);
+			}
+		}
+
+		return true;
+	}
+
+	return false;
+
+} // Set
+
+//-----------------------------------------------------------------------------
+bool KSharedMemoryCache::Get(KStringView sKey, KString& sValue) const
+//-----------------------------------------------------------------------------
+{
+	if (is_open() && sKey.size() <= m_iMaxKeySize)
+	{
+		auto iHash  = HashKey(sKey);
+		auto iFirst = FirstSlot(iHash);
+
+		for (std::size_t i = 0; i < iWindowSize; ++i)
+		{
+			if (Read(GetSlot(iFirst + i), iHash, sKey, &sValue))
+			{
+				return true;
+			}
+		}
+	}
+
+	sValue.clear();
+
+	return false;
+
+} // Get
+
+//-----------------------------------------------------------------------------
+KString KSharedMemoryCache::Get(KStringView sKey) const
+//-----------------------------------------------------------------------------
+{
+	KString sValue;
+	Get(sKey, sValue);
+	return sValue;
+
+} // Get
+
+//-----------------------------------------------------------------------------
+bool KSharedMemoryCache::Contains(KStringView sKey) const
+//-----------------------------------------------------------------------------
+{
+	if (is_open() && sKey.size() <= m_iMaxKeySize)
+	{
+		auto iHash  = HashKey(sKey);
+		auto iFirst = FirstSlot(iHash);
+
+		for (std::size_t i = 0; i < iWindowSize; ++i)
+		{
+			if (Read(GetSlot(iFirst + i), iHash, sKey, nullptr))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+
+} // Contains
+
+//-----------------------------------------------------------------------------
+bool KSharedMemoryCache::Erase(KStringView sKey)
+//-----------------------------------------------------------------------------
+{
+	bool bErased { false };
+
+	if (is_open() && sKey.size() <= m_iMaxKeySize)
+	{
+		auto iHash  = HashKey(sKey);
+		auto iFirst = FirstSlot(iHash);
+
+		for (std::size_t i = 0; i < iWindowSize; ++i)
+		{
+			auto& slot = GetSlot(iFirst + i);
+			std::uint64_t iState;
+
+			// retry if the slot changed between reading and locking it
+			for (std::size_t iTry = 0; iTry < iMaxRetries && Read(slot, iHash, sKey, nullptr, &iState); ++iTry)
+			{
+				if (Lock(slot, iState))
+				{
+					slot.iHash = 0;
+					Unlock(slot);
+					bErased = true;
+					break;
+				}
+			}
+		}
+	}
+
+	return bErased;
+
+} // Erase
+
+//-----------------------------------------------------------------------------
+void KSharedMemoryCache::Clear()
+//-----------------------------------------------------------------------------
+{
+	if (!is_open())
+	{
+		return;
+	}
+
+	for (std::size_t iSlot = 0; iSlot < m_iSlots; ++iSlot)
+	{
+		auto& slot = GetSlot(iSlot);
+		bool bLocked { false };
+
+		for (std::size_t iTry = 0; iTry < iMaxRetries && !bLocked; ++iTry)
+		{
+			bLocked = Lock(slot, slot.iState.load(std::memory_order_relaxed)) || Reclaim(slot);
+
+			if (!bLocked)
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		if (bLocked)
+		{
+			slot.iHash = 0;
+			Unlock(slot);
+		}
+		else
+		{
+			// a live writer holds the slot for a long time
+			kDebug(2, "cannot clear slot {}", iSlot);
+		}
+	}
+
+} // Clear
+
+//-----------------------------------------------------------------------------
+std::size_t KSharedMemoryCache::size() const
+//-----------------------------------------------------------------------------
+{
+	std::size_t iCount { 0 };
+
+	if (is_open())
+	{
+		auto iNow = Now();
+
+		for (std::size_t iSlot = 0; iSlot < m_iSlots; ++iSlot)
+		{
+			auto& slot = GetSlot(iSlot);
+
+			// locked slots are misses for readers, so do not count them either
+			if (!IsLocked(slot.iState.load(std::memory_order_acquire))
+			 && slot.iHash && (!slot.iExpires || slot.iExpires > iNow))
+			{
+				++iCount;
+			}
+		}
+	}
+
+	return iCount;
+
+} // size
+
+} // end of namespace dekaf2
+
+#endif // DEKAF2_IS_WINDOWS
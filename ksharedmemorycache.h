@@ -0,0 +1,184 @@
+/*
+//
+// DEKAF(tm): Lighter, Faster, Smarter (tm)
+//
+// Copyright (c) 2026, Ridgeware, Inc.
+//
+// +-------------------------------------------------------------------------+
+// | /\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\|
+// |/+---------------------------------------------------------------------+/|
+// |/|                                                                     |/|
+// |\|  ** THIS NOTICE MUST NOT BE REMOVED FROM THE SOURCE CODE MODULE **  |\|
+// |/|                                                                     |/|
+// |\|   OPEN SOURCE LICENSE                                               |\|
+// |/|                                                                     |/|
+// |\|   Permission is hereby granted, free of charge, to any person       |\|
+// |/|   obtaining a copy of this software and associated                  |/|
+// |\|   documentation files (the "Software"), to deal in the              |\|
+// |/|   Software without restriction, including without limitation        |/|
+// |\|   the rights to use, copy, modify, merge, publish,                  |\|
+// |/|   distribute, sublicense, and/or sell copies of the Software,       |/|
+// |\|   and to permit persons to whom the Software is furnished to        |\|
+// |/|   do so, subject to the following conditions:                       |/|
+// |\|                                                                     |\|
+// |/|   The above copyright notice and this permission notice shall       |/|
+// |\|   be included in all copies or substantial portions of the          |\|
+// |/|   Software.                                                         |/|
+// |\|                                                                     |\|
+// |/|   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY         |/|
+// |\|   KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE        |\|
+// |/|   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR           |/|
+// |\|   PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS        |\|
+// |/|   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR          |/|
+// |\|   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR        |\|
+// |/|   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE         |/|
+// |\|   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.            |\|
+// |/|                                                                     |/|
+// |/+---------------------------------------------------------------------+/|
+// |\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/\/ |
+// +-------------------------------------------------------------------------+
+*/
+
+#pragma once
+
+/// @file ksharedmemorycache.h
+/// fixed size key/value cache in shared memory, usable by all processes of a host
+
+#include "bits/kcppcompat.h"
+#ifndef DEKAF2_IS_WINDOWS
+#include "ksharedmemory.h"
+#include "kstringview.h"
+#include "kstring.h"
+#include "kduration.h"
+#include <atomic>
+#include <cstdint>
+
+namespace dekaf2 {
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// A fixed size, open addressing hash cache for byte string keys and values that lives
+/// in a shared memory segment, so that all processes of a host (e.g. the children of a
+/// preforking server) share one cache. The geometry (number of slots, maximum key and
+/// value sizes) is set by the process that first opens the segment, later processes have
+/// to request the same geometry.
+///
+/// Every slot carries a version counter that is used as a seqlock: readers never lock,
+/// they copy the slot and retry if the version changed meanwhile. Writers claim a slot by
+/// a compare and swap on its version, so no semaphore is needed. A key may only live in
+/// a small window of neighbouring slots - when the window is full, the oldest entry of it
+/// is overwritten.
+///
+/// If a process dies while writing a slot, that slot stays locked, and readers treat it
+/// as a miss after a few spins. Set() and Clear() recover slots whose writer process is gone.
+/// The owner of a lock is identified by its process ID, therefore all processes that use
+/// the cache have to share one PID namespace - containers that share /dev/shm but not
+/// their PID namespace would take the locks of live writers.
+class DEKAF2_PUBLIC KSharedMemoryCache : public detail::KSharedMemoryBase
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//------
+public:
+//------
+
+	using base = detail::KSharedMemoryBase;
+
+	/// the number of neighbouring slots a key can be stored in
+	static constexpr std::size_t iWindowSize = 8;
+
+	/// Opens/creates a shared memory cache.
+	/// @param sPathname path name (any valid path, does not have to exist, but should start
+	/// with a slash). Will be used as common identifier for the shared memory.
+	/// @param iSlots the number of slots, will be rounded up to the next power of two
+	/// @param iMaxKeySize the maximum size of a key
+	/// @param iMaxValueSize the maximum size of a value - with the default sizes a slot has 1 KB
+	/// @param bool bForceCreation if false, it is first tried to open an existing shared memory,
+	/// if true it is immediately tried to create one.
+	/// @param iMode access permissions as for any other file open
+	KSharedMemoryCache(KStringView sPathname,
+	                   std::size_t iSlots        = 4096,
+	                   std::size_t iMaxKeySize   = 64,
+	                   std::size_t iMaxValueSize = 920,
+	                   bool        bForceCreation = false,
+	                   int         iMode = DEKAF2_MODE_CREATE_FILE);
+
+	/// @return true if the shared memory is opened and has the requested geometry
+	bool is_open()  const { return m_pHeader; }
+	operator bool() const { return is_open(); }
+
+	/// store a value for a key, replacing an existing value
+	/// @param sKey the key, not longer than MaxKeySize()
+	/// @param sValue the value, not longer than MaxValueSize()
+	/// @param TimeToLive the time after which the value expires, zero for no expiry
+	/// @return false if the key or value are too large, or if no slot could be claimed
+	bool Set(KStringView sKey, KStringView sValue, KDuration TimeToLive = KDuration::zero());
+
+	/// read the value for a key
+	/// @param sKey the key
+	/// @param sValue receives the value
+	/// @return true if the key was found, false otherwise
+	bool Get(KStringView sKey, KString& sValue) const;
+
+	/// read the value for a key
+	/// @param sKey the key
+	/// @return the value, or an empty string if the key was not found
+	KString Get(KStringView sKey) const;
+
+	/// @return true if the key is in the cache
+	bool Contains(KStringView sKey) const;
+
+	/// remove a key from the cache
+	/// @return true if the key was found
+	bool Erase(KStringView sKey);
+
+	/// remove all keys from the cache, also unlocks slots of writers that crashed
+	void Clear();
+
+	/// @return the count of valid entries, without slots that are currently written - this walks all slots
+	std::size_t size() const;
+
+	/// @return the number of slots
+	std::size_t Slots()        const { return m_iSlots;        }
+	/// @return the maximum size of a key
+	std::size_t MaxKeySize()   const { return m_iMaxKeySize;   }
+	/// @return the maximum size of a value
+	std::size_t MaxValueSize() const { return m_iMaxValueSize; }
+
+//------
+private:
+//------
+
+	struct Header;
+	struct Slot;
+
+	static std::size_t RoundUp(std::size_t iSlots);
+	static std::size_t SlotSize(std::size_t iMaxKeySize, std::size_t iMaxValueSize);
+	static std::size_t SegmentSize(std::size_t iSlots, std::size_t iMaxKeySize, std::size_t iMaxValueSize);
+	static std::uint64_t HashKey(KStringView sKey);
+
+	bool        Attach();
+	Slot&       GetSlot(std::size_t iSlot) const;
+	std::size_t FirstSlot(std::uint64_t iHash) const;
+	/// reads the slot if it holds sKey - returns the state and write time of the slot
+	/// as seen while reading it, if requested
+	bool        Read(const Slot& slot, std::uint64_t iHash, KStringView sKey, KString* sValue,
+	                 std::uint64_t* piState = nullptr, std::int64_t* piWritten = nullptr) const;
+	/// locks the slot if it is still in iState
+	bool        Lock(Slot& slot, std::uint64_t iState);
+	/// unlocks the slot if this process still owns its lock
+	bool        Unlock(Slot& slot);
+	/// takes over the lock of a slot whose writer process died
+	bool        Reclaim(Slot& slot);
+
+	Header*     m_pHeader       { nullptr };
+	char*       m_pSlots        { nullptr };
+	std::size_t m_iSlots        { 0 };
+	std::size_t m_iMaxKeySize   { 0 };
+	std::size_t m_iMaxValueSize { 0 };
+	std::size_t m_iSlotSize     { 0 };
+
+}; // KSharedMemoryCache
+
+} // end of namespace dekaf2
+
+#endif // DEKAF2_IS_WINDOWS
@@ -1083,7 +1083,7 @@ private:
 		}
 	};
 
-	using DBCCache = KSharedCache<KString, KString, DBCLoader>;
+	using DBCCache = KShardedCache<KString, KString, DBCLoader>;
 
 	static DBCCache s_DBCCache;
 
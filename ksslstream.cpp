@@ -42,6 +42,8 @@
 #include "ksslstream.h"
 #include "klog.h"
 #include "kfrozen.h"
+#include "kresolvercache.h"
+#include "bits/kasioconnect.h"
 #include <openssl/opensslv.h>
 
 namespace dekaf2 {
@@ -625,24 +627,15 @@ bool KSSLIOStream::Connect(const KTCPEndPoint& Endpoint)
 
 	kDebug(2, "resolving domain {}", Endpoint.Domain.get());
 
-	boost::asio::ip::tcp::resolver Resolver(m_Stream.IOService);
-	boost::asio::ip::tcp::resolver::query query(Endpoint.Domain.get().c_str(), Endpoint.Port.Serialize().c_str());
-	auto hosts = Resolver.resolve(query, m_Stream.ec);
+	auto Endpoints = KResolverCache::GetInstance().Resolve(Endpoint.Domain.get(), Endpoint.Port.Serialize(), m_Stream.ec);
 
 	if (Good())
 	{
 		if (kWouldLog(2))
 		{
-#if (BOOST_VERSION < 106600)
-			auto it = hosts;
-			decltype(it) ie;
-#else
-			auto it = hosts.begin();
-			auto ie = hosts.end();
-#endif
-			for (; it != ie; ++it)
+			for (const auto& Resolved : Endpoints)
 			{
-				kDebug(2, "resolved to: {}", it->endpoint().address().to_string());
+				kDebug(2, "resolved to: {}", Resolved.address().to_string());
 			}
 		}
 
@@ -659,42 +652,269 @@ bool KSSLIOStream::Connect(const KTCPEndPoint& Endpoint)
 		// make sure client side SNI works..
 		SSL_set_tlsext_host_name(m_Stream.Socket.native_handle(), Endpoint.Domain.get().c_str());
 
-		boost::asio::async_connect(m_Stream.Socket.lowest_layer(),
-								   hosts,
-								   [&](const boost::system::error_code& ec,
-#if (BOOST_VERSION < 106600)
-                                       boost::asio::ip::tcp::resolver::iterator endpoint)
-#else
-                                       const boost::asio::ip::tcp::endpoint& endpoint)
+		kDebug(2, "trying to connect to endpoint {}", Endpoint.Serialize());
+
+		auto Connected = detail::kAsioConnect(m_Stream.IOService,
+		                                      m_Stream.Socket.next_layer(),
+		                                      Endpoints,
+		                                      chrono::seconds(m_Stream.iSecondsTimeout),
+		                                      m_Stream.ec);
+
+		if (Good())
+		{
+			m_Stream.sEndpoint.Format("{}:{}", Connected.address().to_string(), Connected.port());
+		}
+	}
+
+	if (!Good() || !m_Stream.Socket.lowest_layer().is_open())
+	{
+		kDebug(1, "{}: {}", Endpoint.Serialize(), Error());
+		return false;
+	}
+
+	kDebug(2, "connected to endpoint {}", Endpoint.Serialize());
+
+	return true;
+
+} // connect
+
+#if DEKAF2_HAS_COROUTINES
+//-----------------------------------------------------------------------------
+KTask<bool> KSSLIOStream::AsyncHandshake()
+//-----------------------------------------------------------------------------
+{
+	if (!m_Stream.bNeedHandshake)
+	{
+		co_return true;
+	}
+
+	m_Stream.bNeedHandshake = false;
+
+#ifndef DEKAF2_IS_WINDOWS
+	// the handshake output is small enough to never fill the send buffer of a
+	// fresh connection, therefore only reads can return would_block - and the
+	// ssl engine keeps its state until we try again
+	m_Stream.Socket.lowest_layer().non_blocking(true, m_Stream.ec);
 #endif
+
+	for (;;)
+	{
+		m_Stream.Socket.handshake(m_Stream.SSLContext.GetRole(), m_Stream.ec);
+
+		if (m_Stream.ec != boost::asio::error::would_block)
 		{
-			m_Stream.sEndpoint.Format("{}:{}",
-#if (BOOST_VERSION < 106600)
-									  endpoint->endpoint().address().to_string(),
-									  endpoint->endpoint().port());
-#else
-									  endpoint.address().to_string(),
-									  endpoint.port());
+			break;
+		}
+
+		if (!co_await KAwaitSocket(m_Stream.Socket.lowest_layer().native_handle(), KAwaitSocket::Read, chrono::seconds(m_Stream.iSecondsTimeout)))
+		{
+			m_Stream.ec = boost::asio::error::timed_out;
+			break;
+		}
+	}
+
+#ifndef DEKAF2_IS_WINDOWS
+	boost::system::error_code ignore;
+	m_Stream.Socket.lowest_layer().non_blocking(false, ignore);
 #endif
-			m_Stream.ec = ec;
-		});
+
+	if (!Good() || !m_Stream.Socket.lowest_layer().is_open())
+	{
+		kDebug(1, "TLS handshake failed with {}: {}", m_Stream.sEndpoint, Error());
+		co_return false;
+	}
+
+	kDebug(2, "TLS handshake successful with {}", m_Stream.sEndpoint);
+
+	co_return true;
+
+} // AsyncHandshake
+
+//-----------------------------------------------------------------------------
+KTask<bool> KSSLIOStream::AsyncConnect(KTCPEndPoint Endpoint)
+//-----------------------------------------------------------------------------
+{
+#ifdef DEKAF2_IS_WINDOWS
+	// we have no reactor on Windows
+	co_return Connect(Endpoint);
+#else
+	m_Stream.bNeedHandshake = true;
+
+	kDebug(2, "resolving domain {}", Endpoint.Domain.get());
+
+	auto Endpoints = KResolverCache::GetInstance().Resolve(Endpoint.Domain.get(), Endpoint.Port.Serialize(), m_Stream.ec);
+
+	if (Good())
+	{
+		if (m_Stream.SSLContext.GetVerify())
+		{
+			m_Stream.Socket.set_verify_mode(boost::asio::ssl::verify_peer
+										  | boost::asio::ssl::verify_fail_if_no_peer_cert);
+		}
+		else
+		{
+			m_Stream.Socket.set_verify_mode(boost::asio::ssl::verify_none);
+		}
+
+		// make sure client side SNI works..
+		SSL_set_tlsext_host_name(m_Stream.Socket.native_handle(), Endpoint.Domain.get().c_str());
 
 		kDebug(2, "trying to connect to endpoint {}", Endpoint.Serialize());
 
-		m_Stream.RunTimed();
+		auto Connected = co_await detail::kAsioConnectAsync(m_Stream.Socket.next_layer(),
+		                                                    std::move(Endpoints),
+		                                                    chrono::seconds(m_Stream.iSecondsTimeout),
+		                                                    m_Stream.ec);
+
+		if (Good())
+		{
+			m_Stream.sEndpoint.Format("{}:{}", Connected.address().to_string(), Connected.port());
+		}
 	}
 
 	if (!Good() || !m_Stream.Socket.lowest_layer().is_open())
 	{
 		kDebug(1, "{}: {}", Endpoint.Serialize(), Error());
-		return false;
+		co_return false;
 	}
 
 	kDebug(2, "connected to endpoint {}", Endpoint.Serialize());
 
-	return true;
+	co_return true;
+#endif
 
-} // connect
+} // AsyncConnect
+
+//-----------------------------------------------------------------------------
+KTask<std::size_t> KSSLIOStream::AsyncRead(void* sBuffer, std::size_t iCount)
+//-----------------------------------------------------------------------------
+{
+	if (!iCount)
+	{
+		co_return 0;
+	}
+
+	auto iBuffered = m_SSLStreamBuf.in_avail();
+
+	if (iBuffered > 0)
+	{
+		co_return static_cast<std::size_t>(m_SSLStreamBuf.sgetn(static_cast<char*>(sBuffer),
+		                                                        std::min(iBuffered, static_cast<std::streamsize>(iCount))));
+	}
+
+	if (!m_Stream.bManualHandshake)
+	{
+		if (!co_await AsyncHandshake())
+		{
+			co_return 0;
+		}
+	}
+
+	std::size_t iRead { 0 };
+
+#ifndef DEKAF2_IS_WINDOWS
+	// reads can be repeated after would_block, the ssl engine keeps
+	// partially received records
+	m_Stream.Socket.lowest_layer().non_blocking(true, m_Stream.ec);
+#endif
+
+	for (;;)
+	{
+		if (!m_Stream.bManualHandshake)
+		{
+			iRead = m_Stream.Socket.read_some(boost::asio::buffer(sBuffer, iCount), m_Stream.ec);
+		}
+		else
+		{
+			iRead = m_Stream.Socket.next_layer().read_some(boost::asio::buffer(sBuffer, iCount), m_Stream.ec);
+		}
+
+		if (m_Stream.ec != boost::asio::error::would_block)
+		{
+			break;
+		}
+
+		if (!co_await KAwaitSocket(m_Stream.Socket.lowest_layer().native_handle(), KAwaitSocket::Read, chrono::seconds(m_Stream.iSecondsTimeout)))
+		{
+			m_Stream.ec = boost::asio::error::timed_out;
+			break;
+		}
+	}
+
+#ifndef DEKAF2_IS_WINDOWS
+	boost::system::error_code ignore;
+	m_Stream.Socket.lowest_layer().non_blocking(false, ignore);
+#endif
+
+	if (iRead == 0 || !Good())
+	{
+		if (m_Stream.ec == boost::asio::error::eof)
+		{
+			kDebug(2, "input stream got closed by endpoint {}", m_Stream.sEndpoint);
+		}
+		else
+		{
+			kDebug(1, "cannot read from TLS stream with endpoint {}: {}", m_Stream.sEndpoint, Error());
+		}
+	}
+
+	co_return iRead;
+
+} // AsyncRead
+
+//-----------------------------------------------------------------------------
+KTask<std::size_t> KSSLIOStream::AsyncWrite(const void* sBuffer, std::size_t iCount)
+//-----------------------------------------------------------------------------
+{
+	flush();
+
+	if (!m_Stream.bManualHandshake)
+	{
+		if (!co_await AsyncHandshake())
+		{
+			co_return 0;
+		}
+	}
+
+	std::size_t iWrote { 0 };
+
+	while (iWrote < iCount)
+	{
+		// a TLS record that was only partially sent can not be continued,
+		// therefore we wait until the socket is writable, and write in
+		// blocking mode
+		if (!co_await KAwaitSocket(m_Stream.Socket.lowest_layer().native_handle(), KAwaitSocket::Write, chrono::seconds(m_Stream.iSecondsTimeout)))
+		{
+			m_Stream.ec = boost::asio::error::timed_out;
+			kDebug(1, "cannot write to TLS stream with endpoint {}: {}", m_Stream.sEndpoint, Error());
+			break;
+		}
+
+		std::size_t iWrotePart { 0 };
+		auto Buffer = boost::asio::buffer(static_cast<const char*>(sBuffer) + iWrote, iCount - iWrote);
+
+		if (!m_Stream.bManualHandshake)
+		{
+			iWrotePart = m_Stream.Socket.write_some(Buffer, m_Stream.ec);
+		}
+		else
+		{
+			iWrotePart = m_Stream.Socket.next_layer().write_some(Buffer, m_Stream.ec);
+		}
+
+		iWrote += iWrotePart;
+
+		if (iWrotePart == 0 || !Good())
+		{
+			kDebug(1, "cannot write to TLS stream with endpoint {}: {}", m_Stream.sEndpoint, Error());
+			break;
+		}
+	}
+
+	co_return iWrote;
+
+} // AsyncWrite
+#endif // DEKAF2_HAS_COROUTINES
 
 
 //-----------------------------------------------------------------------------
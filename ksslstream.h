@@ -45,6 +45,7 @@
 /// provides an implementation of std::iostreams supporting SSL/TLS
 
 #include "bits/kasio.h"
+#include "kcoroutine.h"
 #include "kstring.h"
 #include "kstream.h" // TODO remove
 #include "kstreambuf.h"
@@ -383,6 +384,40 @@ public:
 		return Connect(Endpoint);
 	}
 
+#if DEKAF2_HAS_COROUTINES
+	//-----------------------------------------------------------------------------
+	/// Connects a given server as a client from inside a coroutine. The coroutine
+	/// is suspended while the connection is pending, instead of blocking the thread.
+	/// @param Endpoint
+	/// KTCPEndPoint as the server to connect to - can be constructed from
+	/// a variety of inputs, like strings or KURL
+	/// @return true on success
+	KTask<bool> AsyncConnect(KTCPEndPoint Endpoint);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// Reads up to iCount bytes from inside a coroutine. The coroutine is suspended
+	/// until data arrives or the timeout expires. Starts the TLS handshake if it is
+	/// still due, like the first read of the std::istream interface. Data that was
+	/// already buffered by the std::istream interface is returned first.
+	/// @param sBuffer the buffer to read into - has to stay valid until the task finished
+	/// @param iCount the size of the buffer
+	/// @return the count of bytes read, 0 on end of stream, error or timeout
+	KTask<std::size_t> AsyncRead(void* sBuffer, std::size_t iCount);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// Writes iCount bytes from inside a coroutine. The coroutine is suspended while
+	/// the socket does not accept more data, each TLS record is then written in
+	/// blocking mode, as a partially written record could not be continued. Output
+	/// that is still buffered by the std::ostream interface is flushed first.
+	/// @param sBuffer the data to write - has to stay valid until the task finished
+	/// @param iCount the count of bytes to write
+	/// @return the count of bytes written, less than iCount on error or timeout
+	KTask<std::size_t> AsyncWrite(const void* sBuffer, std::size_t iCount);
+	//-----------------------------------------------------------------------------
+#endif
+
 	//-----------------------------------------------------------------------------
 	/// Disconnect the stream
 	bool Disconnect()
@@ -494,6 +529,14 @@ private:
 	static bool handshake(KAsioSSLStream<asiostream>* stream);
 	//-----------------------------------------------------------------------------
 
+#if DEKAF2_HAS_COROUTINES
+	//-----------------------------------------------------------------------------
+	/// the coroutine version of handshake()
+	DEKAF2_PRIVATE
+	KTask<bool> AsyncHandshake();
+	//-----------------------------------------------------------------------------
+#endif
+
 };
 
 
@@ -50,10 +50,12 @@
 #include "kinshell.h"
 #include "kutf8.h"             // for Windows API conversions
 #include "kexception.h"
+#include "kreader.h"
 #include <thread>
 #include <cstdlib>
 #include <ctime>
 #include <array>
+#include <algorithm>
 
 #ifdef DEKAF2_HAS_LIBPROC
 	#include <libproc.h>                       // for proc_pidpath()
@@ -970,6 +972,41 @@ uint16_t kGetCPU()
 
 } // kGetCPU
 
+//-----------------------------------------------------------------------------
+std::vector<uint16_t> kGetProcessCPU(pid_t forPid)
+//-----------------------------------------------------------------------------
+{
+	std::vector<uint16_t> CPUs;
+
+#ifdef DEKAF2_HAVE_SCHED_H
+
+	cpu_set_t cpuset;
+	CPU_ZERO(&cpuset);
+
+	if (sched_getaffinity(forPid, sizeof(cpuset), &cpuset) == -1)
+	{
+		kDebug(2, "sched_getaffinity: {}", strerror(errno));
+		return CPUs;
+	}
+
+	for (uint16_t j = 0; j < CPU_SETSIZE; ++j)
+	{
+		if (CPU_ISSET(j, &cpuset))
+		{
+			CPUs.push_back(j);
+		}
+	}
+
+#else
+
+	kDebug(2, "unsupported operating system");
+
+#endif
+
+	return CPUs;
+
+} // kGetProcessCPU
+
 //-----------------------------------------------------------------------------
 std::vector<uint16_t> kGetThreadCPU(const pthread_t& forThread)
 //-----------------------------------------------------------------------------
@@ -1049,19 +1086,19 @@ bool kSetProcessCPU(const std::vector<uint16_t>& CPUs, pid_t forPid)
 {
 #ifdef DEKAF2_HAVE_SCHED_H
 
-	const auto iCPUCount = kGetCPUCount();
 	cpu_set_t set;
 	CPU_ZERO(&set);
 
 	for (auto ID : CPUs)
 	{
-		if (ID < iCPUCount)
+		// CPU IDs need not be contiguous, so only check the size of the set
+		if (ID < CPU_SETSIZE)
 		{
 			CPU_SET(ID, &set);
 		}
 		else
 		{
-			kDebug(2, "ID {} exceeds max CPU ID {}", ID, iCPUCount);
+			kDebug(2, "ID {} exceeds max CPU ID {}", ID, CPU_SETSIZE - 1);
 		}
 	}
 
@@ -1087,19 +1124,19 @@ bool kSetThreadCPU(const std::vector<uint16_t>& CPUs, const pthread_t& forThread
 {
 #ifdef DEKAF2_HAVE_PTHREAD_H
 
-	const auto iCPUCount = kGetCPUCount();
 	cpu_set_t set;
 	CPU_ZERO(&set);
 
 	for (auto ID : CPUs)
 	{
-		if (ID < iCPUCount)
+		// CPU IDs need not be contiguous, so only check the size of the set
+		if (ID < CPU_SETSIZE)
 		{
 			CPU_SET(ID, &set);
 		}
 		else
 		{
-			kDebug(2, "ID {} exceeds max CPU ID {}", ID, iCPUCount);
+			kDebug(2, "ID {} exceeds max CPU ID {}", ID, CPU_SETSIZE - 1);
 		}
 	}
 
@@ -1153,6 +1190,125 @@ bool kSetThreadCPU(const std::vector<uint16_t>& CPUs)
 
 } // kSetThreadCPU
 
+namespace {
+
+//-----------------------------------------------------------------------------
+/// parse a Linux CPU or node list like "0-3,8,10-11"
+std::vector<uint16_t> ParseCPUList(KStringView sList)
+//-----------------------------------------------------------------------------
+{
+	std::vector<uint16_t> IDs;
+
+	for (auto sRange : sList.Split(","))
+	{
+		auto iDash = sRange.find('-');
+
+		if (iDash == KStringView::npos)
+		{
+			IDs.push_back(sRange.UInt16());
+		}
+		else
+		{
+			auto iFrom = sRange.Left(iDash).UInt16();
+			auto iTo   = sRange.Mid(iDash + 1).UInt16();
+
+			for (auto i = iFrom; i <= iTo; ++i)
+			{
+				IDs.push_back(i);
+			}
+		}
+	}
+
+	return IDs;
+
+} // ParseCPUList
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+const std::vector<uint16_t>& kGetNUMANodes()
+//-----------------------------------------------------------------------------
+{
+	static std::vector<uint16_t> Nodes = []()
+	{
+		std::vector<uint16_t> Nodes;
+
+#ifdef DEKAF2_IS_UNIX
+		// has_cpu leaves out nodes with memory only, like CXL memory or HBM
+		auto sNodes = kReadAll("/sys/devices/system/node/has_cpu");
+		sNodes.Trim();
+
+		if (!sNodes.empty())
+		{
+			Nodes = ParseCPUList(sNodes);
+		}
+		else
+		{
+			// older kernels do not have has_cpu
+			sNodes = kReadAll("/sys/devices/system/node/online");
+			sNodes.Trim();
+
+			for (auto iNode : ParseCPUList(sNodes))
+			{
+				auto sCPUs = kReadAll(kFormat("/sys/devices/system/node/node{}/cpulist", iNode));
+				sCPUs.Trim();
+
+				if (!sCPUs.empty())
+				{
+					Nodes.push_back(iNode);
+				}
+			}
+		}
+#endif
+		if (Nodes.empty())
+		{
+			Nodes.push_back(0);
+		}
+
+		return Nodes;
+	}();
+
+	return Nodes;
+
+} // kGetNUMANodes
+
+//-----------------------------------------------------------------------------
+uint16_t kGetNUMANodeCount()
+//-----------------------------------------------------------------------------
+{
+	return static_cast<uint16_t>(kGetNUMANodes().size());
+
+} // kGetNUMANodeCount
+
+//-----------------------------------------------------------------------------
+std::vector<uint16_t> kGetNUMANodeCPUs(uint16_t iNode)
+//-----------------------------------------------------------------------------
+{
+	std::vector<uint16_t> CPUs;
+
+#ifdef DEKAF2_IS_UNIX
+	auto sCPUs = kReadAll(kFormat("/sys/devices/system/node/node{}/cpulist", iNode));
+	sCPUs.Trim();
+
+	if (!sCPUs.empty())
+	{
+		return ParseCPUList(sCPUs);
+	}
+#endif
+
+	if (iNode == 0 && kGetNUMANodeCount() == 1)
+	{
+		// no topology information, return all CPUs
+		for (uint16_t i = 0, iCount = kGetCPUCount(); i < iCount; ++i)
+		{
+			CPUs.push_back(i);
+		}
+	}
+
+	return CPUs;
+
+} // kGetNUMANodeCPUs
+
 #ifdef DEKAF2_IS_WINDOWS
 
 struct rusage
@@ -250,6 +250,13 @@ uint16_t kGetCPU();
 DEKAF2_PUBLIC
 bool kSetProcessCPU(const std::vector<uint16_t>& CPUs, pid_t forPid = 0);
 
+/// get the CPU IDs on which the PROCESS may run - these need not be contiguous,
+/// e.g. with offline CPUs or inside a cpuset or container
+/// @param forPid the process ID that is requested, or 0 for the calling thread
+/// @return a vector of CPU IDs to run on, empty on unsupported systems
+DEKAF2_PUBLIC
+std::vector<uint16_t> kGetProcessCPU(pid_t forPid = 0);
+
 /// get the CPU IDs on which the THREAD shall run
 /// @param forThread the pthread_t that is requested
 /// @return a vector of CPU IDs to run on
@@ -287,6 +294,23 @@ bool kSetThreadCPU(const std::vector<uint16_t>& CPUs, std::thread& forThread);
 DEKAF2_PUBLIC
 bool kSetThreadCPU(const std::vector<uint16_t>& CPUs);
 
+/// Returns the IDs of the NUMA nodes that have CPUs - nodes with memory only are
+/// not listed, and the IDs need not be dense. Returns { 0 } if the system does not
+/// report a NUMA topology
+DEKAF2_PUBLIC
+const std::vector<uint16_t>& kGetNUMANodes();
+
+/// Returns count of NUMA nodes that have CPUs, 1 if the system does not report a NUMA topology
+DEKAF2_PUBLIC
+uint16_t kGetNUMANodeCount();
+
+/// get the CPU IDs of a NUMA node
+/// @param iNode the NUMA node, one of kGetNUMANodes()
+/// @return a vector of CPU IDs of the node - if the system does not report a NUMA
+/// topology, all CPUs for node 0
+DEKAF2_PUBLIC
+std::vector<uint16_t> kGetNUMANodeCPUs(uint16_t iNode);
+
 namespace detail {
 DEKAF2_PRIVATE
 std::size_t TicksFromRusage(int who);
@@ -80,6 +80,7 @@
 #include "kunixstream.h"
 #endif
 #include "klog.h"
+#include "ksystem.h"
 #include "kfilesystem.h"
 #include "dekaf2.h"
 #include "ksignals.h"
@@ -250,7 +251,7 @@ bool KTCPServer::IsPortAvailable(uint16_t iPort)
 } // IsPortAvailable
 
 //-----------------------------------------------------------------------------
-bool KTCPServer::TCPServer(bool ipv6)
+bool KTCPServer::TCPServer(bool ipv6, std::size_t iNode)
 //-----------------------------------------------------------------------------
 {
 	DEKAF2_TRY {
@@ -259,9 +260,37 @@ bool KTCPServer::TCPServer(bool ipv6)
 
 	kDebug(2, "opening listener on port {}", m_iPort);
 
+	// the pool that serves the sessions of this listener
+	KThreadPool& SessionPool = m_NodePools.empty() ? m_ThreadPool : *m_NodePools[iNode];
+
 	tcp::endpoint local_endpoint((ipv6) ? tcp::v6() : tcp::v4(), m_iPort);
-	auto acceptor = std::make_shared<tcp::acceptor>(m_asio, local_endpoint, true); // true means reuse_addr
-	m_TCPAcceptors.push_back(acceptor);
+	std::shared_ptr<tcp::acceptor> acceptor;
+
+	if (m_NodePools.empty())
+	{
+		acceptor = std::make_shared<tcp::acceptor>(m_asio, local_endpoint, true); // true means reuse_addr
+	}
+	else
+	{
+		// run this listener on the CPUs of its node
+		kSetThreadCPU(kGetNUMANodeCPUs(static_cast<uint16_t>(SessionPool.get_numa_node())));
+
+		// the listeners of all nodes bind to the same port, and the
+		// kernel spreads new connections over them
+		acceptor = std::make_shared<tcp::acceptor>(m_asio);
+		acceptor->open(local_endpoint.protocol());
+		acceptor->set_option(tcp::acceptor::reuse_address(true));
+#ifdef SO_REUSEPORT
+		acceptor->set_option(boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+#endif
+		acceptor->bind(local_endpoint);
+		acceptor->listen();
+	}
+
+	{
+		std::lock_guard<std::mutex> Lock(m_ListenerMutex);
+		m_TCPAcceptors.push_back(acceptor);
+	}
 
 	if (ipv6)
 	{
@@ -277,12 +306,13 @@ bool KTCPServer::TCPServer(bool ipv6)
 				// is not working, and blocking construction is requested)
 				if (!acceptor->is_open() && m_bBlock)
 				{
-					TCPServer(false);
+					TCPServer(false, iNode);
 				}
 				else
 				{
 					// else open v4 explicitly in another thread
-					m_Servers.push_back(std::make_unique<std::thread>(&KTCPServer::TCPServer, this, false));
+					std::lock_guard<std::mutex> Lock(m_ListenerMutex);
+					m_Servers.push_back(std::make_unique<std::thread>(&KTCPServer::TCPServer, this, false, iNode));
 					m_bHaveSeparatev4Thread = true;
 				}
 			}
@@ -343,12 +373,13 @@ bool KTCPServer::TCPServer(bool ipv6)
 
 #if defined(_MSC_VER) || !defined(DEKAF2_HAS_CPP_14)
 			// unfortunately MSC and C++11 does not know how to move a variable into a lambda scope
-			auto* Stream = stream.release();
-			m_ThreadPool.push([ this, Stream, remote_endpoint ]()
+			// - the stream is shared so that it is also closed when the
+			// thread pool drops the session after its deadline
+			std::shared_ptr<KSSLStream> moved_stream { stream.release() };
+			SessionPool.push(SessionPriority(to_string(remote_endpoint)), m_MaxSessionQueueTime, [ this, moved_stream, remote_endpoint ]()
 			{
-				std::unique_ptr<KSSLStream> moved_stream { Stream };
 #else
-			m_ThreadPool.push([ this, moved_stream = std::move(stream), remote_endpoint ]()
+			SessionPool.push(SessionPriority(to_string(remote_endpoint)), m_MaxSessionQueueTime, [ this, moved_stream = std::move(stream), remote_endpoint ]()
 			{
 #endif
 				RunSession(*moved_stream, to_string(remote_endpoint), moved_stream->GetTCPSocket().native_handle());
@@ -386,12 +417,13 @@ bool KTCPServer::TCPServer(bool ipv6)
 
 #if defined(_MSC_VER) || !defined(DEKAF2_HAS_CPP_14)
 			// unfortunately MSC and C++11 do not know how to move a variable into a lambda scope
-			auto* Stream = stream.release();
-			m_ThreadPool.push([ this, Stream, remote_endpoint ]()
+			// - the stream is shared so that it is also closed when the
+			// thread pool drops the session after its deadline
+			std::shared_ptr<KTCPStream> moved_stream { stream.release() };
+			SessionPool.push(SessionPriority(to_string(remote_endpoint)), m_MaxSessionQueueTime, [ this, moved_stream, remote_endpoint ]()
 			{
-				std::unique_ptr<KTCPStream> moved_stream { Stream };
 #else
-			m_ThreadPool.push([ this, moved_stream = std::move(stream), remote_endpoint ]()
+			SessionPool.push(SessionPriority(to_string(remote_endpoint)), m_MaxSessionQueueTime, [ this, moved_stream = std::move(stream), remote_endpoint ]()
 			{
 #endif
 				RunSession(*moved_stream, to_string(remote_endpoint), moved_stream->GetTCPSocket().native_handle());
@@ -473,12 +505,13 @@ bool KTCPServer::UnixServer()
 
 #if defined(_MSC_VER) || !defined(DEKAF2_HAS_CPP_14)
 			// unfortunately C++11 does not know how to move a variable into a lambda scope
-			auto* Stream = stream.release();
-			m_ThreadPool.push([ this, Stream ]()
+			// - the stream is shared so that it is also closed when the
+			// thread pool drops the session after its deadline
+			std::shared_ptr<KUnixStream> moved_stream { stream.release() };
+			m_ThreadPool.push(SessionPriority(m_sSocketFile), m_MaxSessionQueueTime, [ this, moved_stream ]()
 			{
-				std::unique_ptr<KUnixStream> moved_stream { Stream };
 #else
-			m_ThreadPool.push([ this, moved_stream = std::move(stream) ]()
+			m_ThreadPool.push(SessionPriority(m_sSocketFile), m_MaxSessionQueueTime, [ this, moved_stream = std::move(stream) ]()
 			{
 #endif
 				RunSession(*moved_stream, m_sSocketFile, moved_stream->GetUnixSocket().native_handle());
@@ -510,18 +543,73 @@ bool KTCPServer::UnixServer()
 KThreadPool::Diagnostics KTCPServer::GetDiagnostics() const
 //-----------------------------------------------------------------------------
 {
-	return m_ThreadPool.get_diagnostics();
+	if (m_NodePools.empty())
+	{
+		return m_ThreadPool.get_diagnostics();
+	}
+
+	KThreadPool::Diagnostics Diag;
+
+	for (const auto& NodeDiag : GetNodeDiagnostics())
+	{
+		Diag.iTotalThreads    += NodeDiag.iTotalThreads;
+		Diag.iIdleThreads     += NodeDiag.iIdleThreads;
+		Diag.iUsedThreads     += NodeDiag.iUsedThreads;
+		Diag.iTotalTasks      += NodeDiag.iTotalTasks;
+		Diag.iMaxWaitingTasks += NodeDiag.iMaxWaitingTasks;
+		Diag.iWaitingTasks    += NodeDiag.iWaitingTasks;
+		Diag.iExpiredTasks    += NodeDiag.iExpiredTasks;
+		Diag.ThreadCPUs.insert(Diag.ThreadCPUs.end(), NodeDiag.ThreadCPUs.begin(), NodeDiag.ThreadCPUs.end());
+	}
+
+	return Diag;
 
 } // GetDiagnostics
 
+//-----------------------------------------------------------------------------
+std::vector<KThreadPool::Diagnostics> KTCPServer::GetNodeDiagnostics() const
+//-----------------------------------------------------------------------------
+{
+	std::vector<KThreadPool::Diagnostics> Diags;
+
+	if (m_NodePools.empty())
+	{
+		Diags.push_back(m_ThreadPool.get_diagnostics());
+	}
+	else
+	{
+		for (const auto& Pool : m_NodePools)
+		{
+			Diags.push_back(Pool->get_diagnostics());
+		}
+	}
+
+	return Diags;
+
+} // GetNodeDiagnostics
+
 //-----------------------------------------------------------------------------
 void KTCPServer::RegisterShutdownCallback(KThreadPool::ShutdownCallback callback)
 //-----------------------------------------------------------------------------
 {
-	m_ThreadPool.register_shutdown_callback(std::move(callback));
+	for (auto& Pool : m_NodePools)
+	{
+		Pool->register_shutdown_callback(callback);
+	}
+
+	m_ThreadPool.register_shutdown_callback(callback);
+	m_ShutdownCallback = std::move(callback);
 
 } // RegisterShutdownCallback
 
+//-----------------------------------------------------------------------------
+KThreadPool::Priority KTCPServer::SessionPriority(KStringView sRemoteEndPoint)
+//-----------------------------------------------------------------------------
+{
+	return m_SessionPriority;
+
+} // SessionPriority
+
 //-----------------------------------------------------------------------------
 bool KTCPServer::LoadSSLCertificates(KStringViewZ sCert, KStringViewZ sKey, KStringView sPassword)
 //-----------------------------------------------------------------------------
@@ -596,6 +684,28 @@ bool KTCPServer::Start(uint16_t iTimeoutInSeconds, bool bBlock)
 		}
 	}
 
+	if (m_bNUMAListeners && m_iPort)
+	{
+		StartNodeListeners();
+	}
+	else if (!m_NodePools.empty())
+	{
+		// waits for running sessions
+		m_NodePools.clear();
+	}
+
+	if (m_NodePools.empty())
+	{
+		// the single pool is only started when there are no node pools
+		// that serve the connections
+		m_ThreadPool.resize(m_iMaxConnections ? m_iMaxConnections : std::thread::hardware_concurrency());
+	}
+	else
+	{
+		// waits for running sessions
+		m_ThreadPool.resize(0);
+	}
+
 	if (m_bBlock)
 	{
 #ifdef DEKAF2_HAS_UNIX_SOCKETS
@@ -627,6 +737,7 @@ bool KTCPServer::Start(uint16_t iTimeoutInSeconds, bool bBlock)
 		else
 #endif
 		{
+			std::lock_guard<std::mutex> Lock(m_ListenerMutex);
 			m_Servers.push_back(std::make_unique<std::thread>([this](std::promise<int>&& promise)
 			{
 				promise.set_value_at_thread_exit(0);
@@ -644,6 +755,65 @@ bool KTCPServer::Start(uint16_t iTimeoutInSeconds, bool bBlock)
 
 } // Start
 
+//-----------------------------------------------------------------------------
+std::vector<uint16_t> KTCPServer::ListenerNodes() const
+//-----------------------------------------------------------------------------
+{
+	return kGetNUMANodes();
+
+} // ListenerNodes
+
+//-----------------------------------------------------------------------------
+void KTCPServer::StartNodeListeners()
+//-----------------------------------------------------------------------------
+{
+	if (m_NodePools.empty())
+	{
+		for (auto iNode : ListenerNodes())
+		{
+			auto Pool = std::make_unique<KThreadPool>();
+
+			if (!Pool->bind_to_numa_node(iNode))
+			{
+				// a pool that does not run on its node would only add cross node
+				// traffic - this happens e.g. when a cpuset excludes the node's CPUs
+				kDebug(1, "cannot bind a pool to NUMA node {}, no listener for this node", iNode);
+				continue;
+			}
+
+			if (m_ShutdownCallback)
+			{
+				Pool->register_shutdown_callback(m_ShutdownCallback);
+			}
+
+			m_NodePools.push_back(std::move(Pool));
+		}
+
+		if (!m_NodePools.empty())
+		{
+			// split the connections over the pools that could be bound - the
+			// pools pin their threads when they start them
+			auto iThreads = std::max(m_iMaxConnections / m_NodePools.size(), std::size_t(1));
+
+			for (auto& Pool : m_NodePools)
+			{
+				Pool->resize(iThreads);
+			}
+
+			kDebug(2, "created {} node pools with {} threads each", m_NodePools.size(), iThreads);
+		}
+	}
+
+	// node 0 is started by the caller
+	std::lock_guard<std::mutex> Lock(m_ListenerMutex);
+
+	for (std::size_t iNode = 1; iNode < m_NodePools.size(); ++iNode)
+	{
+		m_Servers.push_back(std::make_unique<std::thread>(&KTCPServer::TCPServer, this, m_bStartIPv6, iNode));
+	}
+
+} // StartNodeListeners
+
 #ifdef DEKAF2_TCPSERVER_CONNECT_TO_STOP
 
 //-----------------------------------------------------------------------------
@@ -706,11 +876,20 @@ bool KTCPServer::Stop()
 
 	m_bQuit = true;
 
+	std::unique_lock<std::mutex> Lock(m_ListenerMutex);
+
 	for (auto& Acceptor : m_TCPAcceptors)
 	{
 		if (Acceptor && Acceptor->is_open())
 		{
 			boost::system::error_code ec;
+#ifndef DEKAF2_IS_WINDOWS
+			// close() does not wake a thread blocking in accept() on Linux, but
+			// shutdown() does - and with SO_REUSEPORT a connect would only wake
+			// one of the listeners on the port
+			kDebug(2, "shutting down TCP listener");
+			::shutdown(Acceptor->native_handle(), SHUT_RD);
+#endif
 			kDebug(2, "cancelling TCP listener");
 			Acceptor->cancel(ec);
 			if (ec)
@@ -727,6 +906,8 @@ bool KTCPServer::Stop()
 	}
 	m_TCPAcceptors.clear();
 
+	Lock.unlock();
+
 #ifdef DEKAF2_TCPSERVER_CONNECT_TO_STOP
 
 	kMilliSleep(10);
@@ -779,11 +960,15 @@ bool KTCPServer::Stop()
 
 #endif
 
-	for (auto& Server : m_Servers)
+	Lock.lock();
+	auto Servers = std::move(m_Servers);
+	m_Servers.clear();
+	Lock.unlock();
+
+	for (auto& Server : Servers)
 	{
 		Server->join();
 	}
-	m_Servers.clear();
 
 	kDebug(2, "listeners closed");
 
@@ -834,8 +1019,8 @@ bool KTCPServer::RegisterShutdownWithSignals(std::vector<int> Signals)
 //-----------------------------------------------------------------------------
 KTCPServer::KTCPServer(uint16_t iPort, bool bSSL, uint16_t iMaxConnections)
 //-----------------------------------------------------------------------------
-	: m_ThreadPool(iMaxConnections)
-	, m_iPort(iPort)
+	: m_iPort(iPort)
+	, m_iMaxConnections(iMaxConnections)
 	, m_bIsSSL(bSSL)
 {
 }
@@ -844,9 +1029,9 @@ KTCPServer::KTCPServer(uint16_t iPort, bool bSSL, uint16_t iMaxConnections)
 //-----------------------------------------------------------------------------
 KTCPServer::KTCPServer(KStringView sSocketFile, uint16_t iMaxConnections)
 //-----------------------------------------------------------------------------
-	: m_ThreadPool(iMaxConnections)
-	, m_sSocketFile(sSocketFile)
+	: m_sSocketFile(sSocketFile)
 	, m_iPort(0)
+	, m_iMaxConnections(iMaxConnections)
 {
 }
 #endif
@@ -222,16 +222,50 @@ public:
 	//-----------------------------------------------------------------------------
 
 	//-----------------------------------------------------------------------------
-	/// Return server diagnostics like idle threads, total requests, uptime
+	/// Return server diagnostics like idle threads, total requests, uptime - with
+	/// NUMA listeners, the sum of all node pools
 	KThreadPool::Diagnostics GetDiagnostics() const;
 	//-----------------------------------------------------------------------------
 
+	//-----------------------------------------------------------------------------
+	/// Return the diagnostics of each node pool when NUMA listeners are used, including
+	/// the CPU placement - else the diagnostics of the single thread pool
+	std::vector<KThreadPool::Diagnostics> GetNodeDiagnostics() const;
+	//-----------------------------------------------------------------------------
+
 	//-----------------------------------------------------------------------------
 	/// Shall we log the shutdown?
 	/// @param callback callback function called at each shutdown thread with some diagnostics
 	void RegisterShutdownCallback(KThreadPool::ShutdownCallback callback);
 	//-----------------------------------------------------------------------------
 
+	//-----------------------------------------------------------------------------
+	/// Set the scheduling of new connections in the thread pool
+	/// @param Priority the priority lane for new sessions, override SessionPriority() to
+	/// select it per connection
+	/// @param MaxQueueTime the max time a new connection waits for a free thread, after
+	/// which it is closed without being served - 0 = unlimited, the default
+	void SetSessionScheduling(KThreadPool::Priority Priority, KDuration MaxQueueTime = KDuration::zero())
+	//-----------------------------------------------------------------------------
+	{
+		m_SessionPriority     = Priority;
+		m_MaxSessionQueueTime = MaxQueueTime;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Open one TCP listener per NUMA node, with SO_REUSEPORT so that the kernel
+	/// spreads new connections over them. Each listener runs on the CPUs of its node
+	/// and serves its connections from a thread pool bound to the same node, with
+	/// iMaxConnections / count of listeners threads. Nodes whose CPUs the process may
+	/// not use get no listener. In blocking mode, the calling thread
+	/// becomes the listener of node 0 and is bound to its CPUs. Call before Start(),
+	/// has no effect for unix socket servers.
+	void SetNUMAListeners(bool bYesNo = true)
+	//-----------------------------------------------------------------------------
+	{
+		m_bNUMAListeners = bYesNo;
+	}
+
 	//-----------------------------------------------------------------------------
 	/// return the future once it is available (== once the server has terminated)
 	int GetResult();
@@ -273,6 +307,20 @@ protected:
 	virtual void Session(KStream& stream, KStringView sRemoteEndPoint, int iSocketFd);
 	//-----------------------------------------------------------------------------
 
+	//-----------------------------------------------------------------------------
+	/// Virtual hook to select the priority lane in the thread pool for a newly
+	/// accepted connection, e.g. to serve health checks from a load balancer
+	/// before bulk requests. Default returns the priority set with SetSessionScheduling().
+	virtual KThreadPool::Priority SessionPriority(KStringView sRemoteEndPoint);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// Virtual hook to select the NUMA nodes that get a listener with SetNUMAListeners(),
+	/// e.g. to leave a node to other services. A node may be listed more than once to
+	/// get more than one listener on it. Default returns kGetNUMANodes().
+	virtual std::vector<uint16_t> ListenerNodes() const;
+	//-----------------------------------------------------------------------------
+
 	//-----------------------------------------------------------------------------
 	/// Virtual hook that is called immediately after accepting a new stream.
 	/// Default does nothing. Could be used to set stream parameters. If
@@ -351,7 +399,14 @@ private:
 
 	//-----------------------------------------------------------------------------
 	DEKAF2_PRIVATE
-	bool TCPServer(bool ipv6);
+	bool TCPServer(bool ipv6, std::size_t iNode = 0);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// create the node pools for the NUMA listeners, and start the listeners
+	/// of the nodes > 0 - the listener of node 0 is started by the caller
+	DEKAF2_PRIVATE
+	void StartNodeListeners();
 	//-----------------------------------------------------------------------------
 
 #ifdef DEKAF2_HAS_UNIX_SOCKETS
@@ -383,9 +438,18 @@ private:
 #endif
 	std::mutex                                m_StartupMutex;
 	std::condition_variable                   m_StartedUp;
+	// protects m_Servers and m_TCPAcceptors, which are extended from
+	// the listener threads
+	std::mutex                                m_ListenerMutex;
 
 	std::vector<int>  m_RegisteredSignals;
+	// the thread pool of the sessions, only started without NUMA listeners
 	KThreadPool       m_ThreadPool;
+	// the thread pools of the NUMA listeners, one per node
+	std::vector<std::unique_ptr<KThreadPool>>
+	                  m_NodePools;
+	KThreadPool::ShutdownCallback
+	                  m_ShutdownCallback;
 #ifdef DEKAF2_HAS_UNIX_SOCKETS
 	KString           m_sSocketFile;
 #endif
@@ -396,15 +460,20 @@ private:
 	KString           m_sAllowedCipherSuites;
 	KString           m_sError;
 	std::future<int>  m_ResultAsFuture;
+	KDuration         m_MaxSessionQueueTime;
+	KThreadPool::Priority
+	                  m_SessionPriority       { KThreadPool::Priority::Normal };
 	std::atomic<int>  m_iStarted              {     0 };
 	uint16_t          m_iPort                 {     0 };
 	uint16_t          m_iTimeout              {    15 };
+	uint16_t          m_iMaxConnections       {    50 };
 	std::atomic<bool> m_bQuit                 { false };
 	bool              m_bBlock                {  true };
 	bool              m_bStartIPv4            {  true };
 	bool              m_bStartIPv6            {  true };
 	bool              m_bHaveSeparatev4Thread { false };
 	bool              m_bIsSSL                { false };
+	bool              m_bNUMAListeners        { false };
 
 }; // KTCPServer
 
@@ -43,6 +43,8 @@
 #include "ktcpstream.h"
 #include "klog.h"
 #include "kurl.h"
+#include "kresolvercache.h"
+#include "bits/kasioconnect.h"
 
 namespace dekaf2 {
 
@@ -168,50 +170,30 @@ bool KTCPIOStream::Connect(const KTCPEndPoint& Endpoint)
 {
 	kDebug(2, "resolving domain {}", Endpoint.Domain.get());
 
-	boost::asio::ip::tcp::resolver Resolver(m_Stream.IOService);
-	boost::asio::ip::tcp::resolver::query query(Endpoint.Domain.get().c_str(), Endpoint.Port.Serialize().c_str());
-	auto hosts = Resolver.resolve(query, m_Stream.ec);
+	auto Endpoints = KResolverCache::GetInstance().Resolve(Endpoint.Domain.get(), Endpoint.Port.Serialize(), m_Stream.ec);
 
 	if (Good())
 	{
 		if (kWouldLog(2))
 		{
-#if (BOOST_VERSION < 106600)
-			auto it = hosts;
-			decltype(it) ie;
-#else
-			auto it = hosts.begin();
-			auto ie = hosts.end();
-#endif
-			for (; it != ie; ++it)
+			for (const auto& Resolved : Endpoints)
 			{
-				kDebug(2, "resolved to: {}", it->endpoint().address().to_string());
+				kDebug(2, "resolved to: {}", Resolved.address().to_string());
 			}
 		}
 
-		boost::asio::async_connect(m_Stream.Socket.lowest_layer(),
-								   hosts,
-		                           [&](const boost::system::error_code& ec,
-#if (BOOST_VERSION < 106600)
-		                               boost::asio::ip::tcp::resolver::iterator endpoint)
-#else
-		                               const boost::asio::ip::tcp::endpoint& endpoint)
-#endif
-		{
-			m_Stream.sEndpoint.Format("{}:{}",
-#if (BOOST_VERSION < 106600)
-									  endpoint->endpoint().address().to_string(),
-									  endpoint->endpoint().port());
-#else
-									  endpoint.address().to_string(),
-									  endpoint.port());
-#endif
-			m_Stream.ec = ec;
-		});
-
 		kDebug(2, "trying to connect to endpoint {}", Endpoint.Serialize());
 
-		m_Stream.RunTimed();
+		auto Connected = detail::kAsioConnect(m_Stream.IOService,
+		                                      m_Stream.Socket,
+		                                      Endpoints,
+		                                      chrono::seconds(m_Stream.iSecondsTimeout),
+		                                      m_Stream.ec);
+
+		if (Good())
+		{
+			m_Stream.sEndpoint.Format("{}:{}", Connected.address().to_string(), Connected.port());
+		}
 	}
 
 	if (!Good() || !m_Stream.Socket.is_open())
@@ -226,6 +208,154 @@ bool KTCPIOStream::Connect(const KTCPEndPoint& Endpoint)
 
 } // connect
 
+#if DEKAF2_HAS_COROUTINES
+//-----------------------------------------------------------------------------
+KTask<bool> KTCPIOStream::AsyncConnect(KTCPEndPoint Endpoint)
+//-----------------------------------------------------------------------------
+{
+#ifdef DEKAF2_IS_WINDOWS
+	// we have no reactor on Windows
+	co_return Connect(Endpoint);
+#else
+	kDebug(2, "resolving domain {}", Endpoint.Domain.get());
+
+	auto Endpoints = KResolverCache::GetInstance().Resolve(Endpoint.Domain.get(), Endpoint.Port.Serialize(), m_Stream.ec);
+
+	if (Good())
+	{
+		kDebug(2, "trying to connect to endpoint {}", Endpoint.Serialize());
+
+		auto Connected = co_await detail::kAsioConnectAsync(m_Stream.Socket,
+		                                                    std::move(Endpoints),
+		                                                    chrono::seconds(m_Stream.iSecondsTimeout),
+		                                                    m_Stream.ec);
+
+		if (Good())
+		{
+			m_Stream.sEndpoint.Format("{}:{}", Connected.address().to_string(), Connected.port());
+		}
+	}
+
+	if (!Good() || !m_Stream.Socket.is_open())
+	{
+		kDebug(1, "{}: {}", Endpoint.Serialize(), Error());
+		co_return false;
+	}
+
+	kDebug(2, "connected to endpoint {}", Endpoint.Serialize());
+
+	co_return true;
+#endif
+
+} // AsyncConnect
+
+//-----------------------------------------------------------------------------
+KTask<std::size_t> KTCPIOStream::AsyncRead(void* sBuffer, std::size_t iCount)
+//-----------------------------------------------------------------------------
+{
+	if (!iCount)
+	{
+		co_return 0;
+	}
+
+	auto iBuffered = m_TCPStreamBuf.in_avail();
+
+	if (iBuffered > 0)
+	{
+		co_return static_cast<std::size_t>(m_TCPStreamBuf.sgetn(static_cast<char*>(sBuffer),
+		                                                        std::min(iBuffered, static_cast<std::streamsize>(iCount))));
+	}
+
+	std::size_t iRead { 0 };
+
+#ifndef DEKAF2_IS_WINDOWS
+	m_Stream.Socket.non_blocking(true, m_Stream.ec);
+#endif
+
+	for (;;)
+	{
+		iRead = m_Stream.Socket.read_some(boost::asio::buffer(sBuffer, iCount), m_Stream.ec);
+
+		if (m_Stream.ec != boost::asio::error::would_block)
+		{
+			break;
+		}
+
+		if (!co_await KAwaitSocket(m_Stream.Socket.native_handle(), KAwaitSocket::Read, chrono::seconds(m_Stream.iSecondsTimeout)))
+		{
+			m_Stream.ec = boost::asio::error::timed_out;
+			break;
+		}
+	}
+
+#ifndef DEKAF2_IS_WINDOWS
+	boost::system::error_code ignore;
+	m_Stream.Socket.non_blocking(false, ignore);
+#endif
+
+	if (iRead == 0 || !Good())
+	{
+		if (m_Stream.ec == boost::asio::error::eof)
+		{
+			kDebug(2, "input stream got closed by endpoint {}", m_Stream.sEndpoint);
+		}
+		else
+		{
+			kDebug(1, "cannot read from tcp stream with endpoint {}: {}", m_Stream.sEndpoint, Error());
+		}
+	}
+
+	co_return iRead;
+
+} // AsyncRead
+
+//-----------------------------------------------------------------------------
+KTask<std::size_t> KTCPIOStream::AsyncWrite(const void* sBuffer, std::size_t iCount)
+//-----------------------------------------------------------------------------
+{
+	flush();
+
+	std::size_t iWrote { 0 };
+
+#ifndef DEKAF2_IS_WINDOWS
+	m_Stream.Socket.non_blocking(true, m_Stream.ec);
+#endif
+
+	while (iWrote < iCount)
+	{
+		auto iWrotePart = m_Stream.Socket.write_some(boost::asio::buffer(static_cast<const char*>(sBuffer) + iWrote, iCount - iWrote), m_Stream.ec);
+
+		iWrote += iWrotePart;
+
+		if (m_Stream.ec == boost::asio::error::would_block)
+		{
+			if (!co_await KAwaitSocket(m_Stream.Socket.native_handle(), KAwaitSocket::Write, chrono::seconds(m_Stream.iSecondsTimeout)))
+			{
+				m_Stream.ec = boost::asio::error::timed_out;
+			}
+			else
+			{
+				continue;
+			}
+		}
+
+		if (iWrotePart == 0 || !Good())
+		{
+			kDebug(1, "cannot write to tcp stream with endpoint {}: {}", m_Stream.sEndpoint, Error());
+			break;
+		}
+	}
+
+#ifndef DEKAF2_IS_WINDOWS
+	boost::system::error_code ignore;
+	m_Stream.Socket.non_blocking(false, ignore);
+#endif
+
+	co_return iWrote;
+
+} // AsyncWrite
+#endif // DEKAF2_HAS_COROUTINES
+
 
 
 //-----------------------------------------------------------------------------
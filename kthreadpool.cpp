@@ -54,13 +54,20 @@
 #include "kthreadpool.h"
 #include "bits/kmake_unique.h"
 #include "klog.h"
+#include "ksystem.h"
+#include <algorithm>
 
 namespace dekaf2 {
 
+thread_local KThreadPool*              KThreadPool::s_current_pool  { nullptr };
+thread_local KThreadPool::WorkerQueue* KThreadPool::s_current_queue { nullptr };
+
 //-----------------------------------------------------------------------------
-KThreadPool::KThreadPool(std::size_t nThreads)
+KThreadPool::KThreadPool(std::size_t nThreads, Scheduling scheduling)
 //-----------------------------------------------------------------------------
+: m_scheduling(scheduling)
 {
+	create_rings();
 	resize(nThreads ? nThreads : std::thread::hardware_concurrency());
 
 } // ctor
@@ -73,6 +80,20 @@ KThreadPool::~KThreadPool()
 
 } // dtor
 
+//-----------------------------------------------------------------------------
+void KThreadPool::create_rings()
+//-----------------------------------------------------------------------------
+{
+	if (m_scheduling == Scheduling::SharedQueue)
+	{
+		for (auto& Ring : m_rings)
+		{
+			Ring = std::make_unique<TaskRing>(iRingSize);
+		}
+	}
+
+} // create_rings
+
 //-----------------------------------------------------------------------------
 std::size_t KThreadPool::size() const
 //-----------------------------------------------------------------------------
@@ -86,7 +107,12 @@ std::size_t KThreadPool::size() const
 std::size_t KThreadPool::n_queued() const
 //-----------------------------------------------------------------------------
 {
-	return m_queue.size(m_cond_mutex);
+	if (m_scheduling == Scheduling::WorkStealing)
+	{
+		return ma_iPending;
+	}
+
+	return ma_iQueued;
 
 } // n_queued
 
@@ -121,11 +147,30 @@ bool KThreadPool::resize(std::size_t nThreads)
 		{
 			m_abort[i] = std::make_shared<std::atomic<eAbort>>(eAbort::None);
 
-			if (!run_thread(i))
+			if (m_scheduling == Scheduling::WorkStealing)
+			{
+				std::lock_guard<std::mutex> qlock(m_worker_queues_mutex);
+				m_worker_queues.push_back(std::make_shared<WorkerQueue>());
+				++ma_iWorkerGeneration;
+			}
+
+			if (run_thread(i))
+			{
+				pin_thread(i);
+			}
+			else
 			{
 				// could not start thread - stop increasing thread count
 				m_threads.resize(i);
 				m_abort  .resize(i);
+
+				if (m_scheduling == Scheduling::WorkStealing)
+				{
+					std::lock_guard<std::mutex> qlock(m_worker_queues_mutex);
+					m_worker_queues.pop_back();
+					++ma_iWorkerGeneration;
+				}
+
 				return false;
 			}
 		}
@@ -153,6 +198,9 @@ bool KThreadPool::resize(std::size_t nThreads)
 		m_threads .resize(nThreads); // safe to delete because the threads are detached
 		m_abort   .resize(nThreads); // safe to delete because the threads have copies of shared_ptr of the flags, not originals
 
+		// with work stealing, the finishing threads remove their own deques, as
+		// they may still run a task that pushes new tasks
+
 		// This comes too early for most stopped threads, but we need to
 		// reset it as otherwise the count remains wrong forever. As we
 		// typically use this for the shutdown callback on destruction
@@ -168,8 +216,41 @@ bool KThreadPool::resize(std::size_t nThreads)
 void KThreadPool::clear()
 //-----------------------------------------------------------------------------
 {
+	if (m_scheduling == Scheduling::WorkStealing)
+	{
+		std::size_t iRemoved { 0 };
+
+		{
+			std::lock_guard<std::mutex> lock(m_cond_mutex);
+
+			Task task;
+
+			while (pop_injected_task(task, iLanes - 1))
+			{
+				++iRemoved;
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> qlock(m_worker_queues_mutex);
+
+			for (auto& queue : m_worker_queues)
+			{
+				iRemoved += queue->clear();
+			}
+		}
+
+		ma_iPending -= iRemoved;
+
+		return;
+	}
+
 	// empty the task queue
-	m_queue.clear(m_cond_mutex);
+	Task task;
+
+	while (pop_shared_task(task))
+	{
+	}
 
 } // clear
 
@@ -221,6 +302,7 @@ void KThreadPool::stop(bool bKill)
 	// we do not clear the task queue..
 	m_threads .clear();
 	m_abort   .clear();
+
 	ma_n_idle = 0;
 	ma_interrupt = false;
 	ma_iAlreadyStopped = 0;
@@ -235,6 +317,138 @@ bool KThreadPool::is_stopped()
 
 } // is_stopped
 
+//-----------------------------------------------------------------------------
+bool KThreadPool::pin_threads(std::vector<uint16_t> CPUs)
+//-----------------------------------------------------------------------------
+{
+	if (CPUs.empty())
+	{
+		std::unique_lock<std::recursive_mutex> lock(m_resize_mutex);
+		CPUs = get_unpinned_cpus();
+	}
+
+	std::vector<std::vector<uint16_t>> CPUSets;
+	CPUSets.reserve(CPUs.size());
+
+	for (auto iCPU : CPUs)
+	{
+		CPUSets.push_back({ iCPU });
+	}
+
+	return pin_threads(std::move(CPUSets));
+
+} // pin_threads
+
+//-----------------------------------------------------------------------------
+bool KThreadPool::pin_threads(std::vector<std::vector<uint16_t>> CPUSets)
+//-----------------------------------------------------------------------------
+{
+	std::unique_lock<std::recursive_mutex> lock(m_resize_mutex);
+
+	bool bUnpin = CPUSets.empty();
+
+	if (bUnpin)
+	{
+		// allow all running threads once more to run on the CPUs they
+		// had before the pinning
+		CPUSets.push_back(get_unpinned_cpus());
+	}
+	else if (m_unpinned_cpus.empty())
+	{
+		// save the mask of the process for the unpinning
+		m_unpinned_cpus = get_unpinned_cpus();
+	}
+
+	m_cpu_sets  = std::move(CPUSets);
+	m_iNUMANode = -1;
+
+	bool bSuccess = true;
+
+	for (std::size_t i = 0; i < m_threads.size(); ++i)
+	{
+		if (!pin_thread(i))
+		{
+			bSuccess = false;
+		}
+	}
+
+	if (bUnpin)
+	{
+		m_cpu_sets.clear();
+	}
+
+	return bSuccess;
+
+} // pin_threads
+
+//-----------------------------------------------------------------------------
+std::vector<uint16_t> KThreadPool::get_unpinned_cpus() const
+//-----------------------------------------------------------------------------
+{
+	if (!m_unpinned_cpus.empty())
+	{
+		return m_unpinned_cpus;
+	}
+
+	// the affinity mask of the process, which honors offline CPUs, cpusets
+	// and containers - the main thread has the process ID as its thread ID
+	auto CPUs = kGetProcessCPU(kGetPid());
+
+	if (CPUs.empty())
+	{
+		for (uint16_t i = 0, iCount = kGetCPUCount(); i < iCount; ++i)
+		{
+			CPUs.push_back(i);
+		}
+	}
+
+	return CPUs;
+
+} // get_unpinned_cpus
+
+//-----------------------------------------------------------------------------
+bool KThreadPool::bind_to_numa_node(uint16_t iNode)
+//-----------------------------------------------------------------------------
+{
+	auto CPUs = kGetNUMANodeCPUs(iNode);
+
+	if (CPUs.empty())
+	{
+		kDebug(1, "NUMA node {} has no CPUs", iNode);
+		return false;
+	}
+
+	std::unique_lock<std::recursive_mutex> lock(m_resize_mutex);
+
+	// all threads share the CPU set of the node
+	bool bSuccess = pin_threads(std::vector<std::vector<uint16_t>> { std::move(CPUs) });
+	m_iNUMANode = iNode;
+
+	return bSuccess;
+
+} // bind_to_numa_node
+
+//-----------------------------------------------------------------------------
+bool KThreadPool::pin_thread(std::size_t i)
+//-----------------------------------------------------------------------------
+{
+	if (m_cpu_sets.empty())
+	{
+		return true;
+	}
+
+	return kSetThreadCPU(m_cpu_sets[i % m_cpu_sets.size()], *m_threads[i]);
+
+} // pin_thread
+
+//-----------------------------------------------------------------------------
+KThreadPool* KThreadPool::get_current_pool()
+//-----------------------------------------------------------------------------
+{
+	return s_current_pool;
+
+} // get_current_pool
+
 //-----------------------------------------------------------------------------
 // each thread pops jobs from the queue until:
 //  - the queue is empty, then it waits (idle)
@@ -245,36 +459,42 @@ bool KThreadPool::run_thread(std::size_t i)
 	// a copy of the shared ptr to the abort
 	std::shared_ptr<std::atomic<eAbort>> abort_ptr(m_abort[i]);
 
+	if (m_scheduling == Scheduling::WorkStealing)
+	{
+		std::shared_ptr<WorkerQueue> own;
+
+		{
+			// resize() has just added the deque for this thread
+			std::lock_guard<std::mutex> qlock(m_worker_queues_mutex);
+			own = m_worker_queues.back();
+		}
+
+		try
+		{
+			// start stealing at the right neighbour, to spread the victims
+			m_threads[i] = std::make_unique<std::thread>(&KThreadPool::run_stealing_worker, this, std::move(abort_ptr), std::move(own), i + 1);
+			return true;
+		}
+		catch (const std::exception& ex)
+		{
+			kException(ex);
+		}
+
+		return false;
+	}
+
 	auto f = [this, abort_ptr]()
 	{
 		std::atomic<eAbort>& abort = *abort_ptr;
-		std::packaged_task<void()> _f;
-		std::unique_lock<std::mutex> lock(m_cond_mutex);
+		Task _f;
 
-		bool bMoreTasks = m_queue.pop(_f);
+		s_current_pool = this;
 
 		for (;;)
 		{
-			while (bMoreTasks) // if there is anything in the queue
+			while (pop_shared_task(_f)) // if there is anything in the queue
 			{
-				lock.unlock();
-
-				// increase total task counter
-				++ma_iTotalTasks;
-
-				// and run the task
-				try
-				{
-					(_f)();
-				}
-				catch (const std::exception& ex)
-				{
-					kException(ex);
-				}
-				catch (...)
-				{
-					kUnknownException();
-				}
+				run_task(_f);
 
 				if (abort != eAbort::None)
 				{
@@ -282,17 +502,10 @@ bool KThreadPool::run_thread(std::size_t i)
 
 					return; // return even if the queue is not empty yet
 				}
-
-				lock.lock();
-
-				bMoreTasks = m_queue.pop(_f);
 			}
 
 			if (ma_interrupt)
 			{
-				// unlock the cond mutex, the diagnostic output needs it, too
-				lock.unlock();
-
 				notify_thread_shutdown(false, abort);
 
 				return;
@@ -302,23 +515,24 @@ bool KThreadPool::run_thread(std::size_t i)
 			// that is the global flag to shut down after all tasks
 			// are completed
 
-			++ma_n_idle;
+			std::unique_lock<std::mutex> lock(m_cond_mutex);
 
-			m_cond_var.wait(lock, [this, &_f, &bMoreTasks, &abort]()
-			{
-				if (abort != eAbort::None || ma_interrupt)
-				{
-					return true;
-				}
+			++ma_n_idle;
 
-				bMoreTasks = m_queue.pop(_f);
+			// a pushing thread increments ma_iQueued before it checks
+			// ma_n_idle, and we increment ma_n_idle before we check
+			// ma_iQueued - so either we see the new task, or the pushing
+			// thread sees us waiting
+			std::atomic_thread_fence(std::memory_order_seq_cst);
 
-				return bMoreTasks;
+			m_cond_var.wait(lock, [this, &abort]()
+			{
+				return abort != eAbort::None || ma_interrupt || ma_iQueued > 0;
 			});
 
 			--ma_n_idle;
 
-			if (!bMoreTasks)
+			if (abort != eAbort::None)
 			{
 				// we stopped waiting because of a thread abort
 				// unlock the cond mutex, the diagnostic output needs it, too
@@ -346,24 +560,408 @@ bool KThreadPool::run_thread(std::size_t i)
 } // setup_thread
 
 //-----------------------------------------------------------------------------
-void KThreadPool::push_packaged_task(std::packaged_task<void()> task)
+// each worker pops tasks from its own deque (newest first), then from the
+// injection queue, then steals from the other workers' deques (oldest first),
+// until:
+//  - no task is queued anywhere, then it waits (idle)
+//  - no task was found and its abort flag is set, then it terminates
+void KThreadPool::run_stealing_worker(std::shared_ptr<std::atomic<eAbort>> abort_ptr,
+                                      std::shared_ptr<WorkerQueue> own,
+                                      std::size_t iNextVictim)
 //-----------------------------------------------------------------------------
 {
-	std::unique_lock<std::mutex> lock(m_cond_mutex);
+	std::atomic<eAbort>& abort = *abort_ptr;
+
+	s_current_pool  = this;
+	s_current_queue = own.get();
+
+	WorkerQueues victims;
+	std::size_t  iGeneration = std::size_t(-1);
+	Task         task;
+
+	for (;;)
+	{
+		if (abort == eAbort::None && find_stealing_task(*own, victims, iGeneration, iNextVictim, task))
+		{
+			run_task(task);
 
-	auto iWaiting = m_queue.push(std::move(task)) - 1;
+			if (abort != eAbort::None)
+			{
+				release_worker_queue(*own);
+				notify_thread_shutdown(false, abort);
+
+				return; // return even if there are more tasks
+			}
+
+			continue;
+		}
+
+		if (ma_interrupt && abort == eAbort::None)
+		{
+			// nothing left to do
+			release_worker_queue(*own);
+			notify_thread_shutdown(false, abort);
+
+			return;
+		}
+
+		// park this worker until new tasks arrive
+		std::unique_lock<std::mutex> lock(m_cond_mutex);
+
+		++ma_n_idle;
+
+		m_cond_var.wait(lock, [this, &abort]()
+		{
+			return abort != eAbort::None || ma_interrupt || ma_iPending > 0;
+		});
+
+		--ma_n_idle;
+
+		if (abort != eAbort::None)
+		{
+			// unlock the cond mutex, the diagnostic output needs it, too
+			lock.unlock();
+
+			release_worker_queue(*own);
+			notify_thread_shutdown(true, abort);
+
+			return;
+		}
+	}
 
+} // run_stealing_worker
+
+//-----------------------------------------------------------------------------
+bool KThreadPool::find_stealing_task(WorkerQueue& own,
+                                     WorkerQueues& victims,
+                                     std::size_t& iGeneration,
+                                     std::size_t& iNextVictim,
+                                     Task& task)
+//-----------------------------------------------------------------------------
+{
+	// high priority tasks come first, even before the own deque
+	if (ma_iInjectedHigh > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_cond_mutex);
+
+		if (pop_injected_task(task, static_cast<std::size_t>(Priority::High)))
+		{
+			--ma_iPending;
+			return true;
+		}
+	}
+
+	if (own.pop(task))
+	{
+		--ma_iPending;
+		return true;
+	}
+
+	if (ma_iInjected > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_cond_mutex);
+
+		if (pop_injected_task(task, static_cast<std::size_t>(Priority::Normal)))
+		{
+			--ma_iPending;
+			return true;
+		}
+	}
+
+	auto iCurrentGeneration = ma_iWorkerGeneration.load();
+
+	if (iCurrentGeneration != iGeneration)
+	{
+		// the pool was resized, get a fresh copy of the worker deques
+		std::lock_guard<std::mutex> qlock(m_worker_queues_mutex);
+		victims     = m_worker_queues;
+		iGeneration = iCurrentGeneration;
+	}
+
+	for (std::size_t i = 0, n = victims.size(); i < n; ++i)
+	{
+		auto& victim = victims[iNextVictim++ % n];
+
+		if (victim.get() != &own && victim->steal(task))
+		{
+			--ma_iPending;
+			return true;
+		}
+	}
+
+	// low priority tasks only run if nothing else is waiting
+	if (ma_iInjected > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_cond_mutex);
+
+		if (pop_injected_task(task, iLanes - 1))
+		{
+			--ma_iPending;
+			return true;
+		}
+	}
+
+	return false;
+
+} // find_stealing_task
+
+//-----------------------------------------------------------------------------
+bool KThreadPool::pop_injected_task(Task& task, std::size_t iMaxLane)
+//-----------------------------------------------------------------------------
+{
+	// m_cond_mutex is locked by the caller
+	if (!m_queue.pop(task, iMaxLane))
+	{
+		return false;
+	}
+
+	--ma_iInjected;
+
+	if (task.Lane == Priority::High)
+	{
+		--ma_iInjectedHigh;
+	}
+
+	return true;
+
+} // pop_injected_task
+
+//-----------------------------------------------------------------------------
+void KThreadPool::release_worker_queue(WorkerQueue& own)
+//-----------------------------------------------------------------------------
+{
+	s_current_pool  = nullptr;
+	s_current_queue = nullptr;
+
+	{
+		std::lock_guard<std::mutex> qlock(m_worker_queues_mutex);
+
+		auto it = std::find_if(m_worker_queues.begin(), m_worker_queues.end(), [&own](const std::shared_ptr<WorkerQueue>& queue)
+		{
+			return queue.get() == &own;
+		});
+
+		if (it != m_worker_queues.end())
+		{
+			m_worker_queues.erase(it);
+			++ma_iWorkerGeneration;
+		}
+	}
+
+	Task task;
+
+	std::lock_guard<std::mutex> lock(m_cond_mutex);
+
+	// keep the order of the tasks
+	while (own.steal(task))
+	{
+		auto iLane = static_cast<std::size_t>(task.Lane);
+		m_queue.push(std::move(task), iLane);
+		++ma_iInjected;
+	}
+
+} // release_worker_queue
+
+//-----------------------------------------------------------------------------
+void KThreadPool::update_max_waiting(std::size_t iWaiting)
+//-----------------------------------------------------------------------------
+{
 	if (iWaiting > ma_iMaxWaitingTasks)
 	{
 		ma_iMaxWaitingTasks = iWaiting;
 	}
 
-	lock.unlock();
+} // update_max_waiting
+
+//-----------------------------------------------------------------------------
+void KThreadPool::run_task(Task& task)
+//-----------------------------------------------------------------------------
+{
+	if (task.Deadline != Clock::time_point::max() && task.Deadline < Clock::now())
+	{
+		++ma_iExpiredTasks;
 
-	// notify in the unlocked state!
-	m_cond_var.notify_one();
+		// destroying the packaged task breaks the promise of its future
+		task.Run.reset();
 
-} // push_packaged_task
+		kDebug(2, "dropped task after its deadline passed");
+
+		if (m_expiry_callback)
+		{
+			try
+			{
+				m_expiry_callback(task.Lane);
+			}
+			catch (const std::exception& ex)
+			{
+				kException(ex);
+			}
+			catch (...)
+			{
+				kUnknownException();
+			}
+		}
+
+		return;
+	}
+
+	// increase total task counter
+	++ma_iTotalTasks;
+
+	// and run the task
+	try
+	{
+		task.Run();
+	}
+	catch (const std::exception& ex)
+	{
+		kException(ex);
+	}
+	catch (...)
+	{
+		kUnknownException();
+	}
+
+} // run_task
+
+//-----------------------------------------------------------------------------
+void KThreadPool::push_task(detail::threadpool::SmallTask task, Priority priority, KDuration MaxWait)
+//-----------------------------------------------------------------------------
+{
+	Task QueuedTask;
+
+	QueuedTask.Run  = std::move(task);
+	QueuedTask.Lane = priority;
+
+	if (MaxWait > KDuration::zero())
+	{
+		QueuedTask.Deadline = Clock::now() + MaxWait;
+	}
+
+	if (m_scheduling == Scheduling::WorkStealing)
+	{
+		return push_stealing_task(std::move(QueuedTask));
+	}
+
+	push_shared_task(std::move(QueuedTask));
+
+} // push_task
+
+//-----------------------------------------------------------------------------
+void KThreadPool::push_shared_task(Task task)
+//-----------------------------------------------------------------------------
+{
+	// count the task before it becomes visible, a worker
+	// decrements the counter right after taking it
+	update_max_waiting(ma_iQueued++);
+
+	auto iLane = static_cast<std::size_t>(task.Lane);
+
+	// once a lane spilled into the overflow queue, its tasks go there until it
+	// is drained - they would otherwise overtake the spilled tasks
+	if (ma_iOverflow[iLane] > 0 || !m_rings[iLane]->try_push(task))
+	{
+		// the ring is full - fall back to the unbounded, locked queue
+		std::lock_guard<std::mutex> lock(m_cond_mutex);
+		m_queue.push(std::move(task), iLane);
+		++ma_iOverflow[iLane];
+	}
+
+	// see the wait in run_thread()
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (ma_n_idle > 0)
+	{
+		{
+			// wait until the worker is really waiting
+			std::lock_guard<std::mutex> lock(m_cond_mutex);
+		}
+
+		// notify in the unlocked state!
+		m_cond_var.notify_one();
+	}
+
+} // push_shared_task
+
+//-----------------------------------------------------------------------------
+bool KThreadPool::pop_shared_task(Task& task)
+//-----------------------------------------------------------------------------
+{
+	if (!ma_iQueued)
+	{
+		return false;
+	}
+
+	for (std::size_t iLane = 0; iLane < iLanes; ++iLane)
+	{
+		if (m_rings[iLane]->try_pop(task))
+		{
+			--ma_iQueued;
+			return true;
+		}
+
+		// the ring tasks of a lane are older than its overflow tasks
+		if (ma_iOverflow[iLane] > 0)
+		{
+			std::lock_guard<std::mutex> lock(m_cond_mutex);
+
+			// pops from this or a higher lane
+			if (m_queue.pop(task, iLane))
+			{
+				--ma_iOverflow[static_cast<std::size_t>(task.Lane)];
+				--ma_iQueued;
+				return true;
+			}
+		}
+	}
+
+	return false;
+
+} // pop_shared_task
+
+//-----------------------------------------------------------------------------
+void KThreadPool::push_stealing_task(Task task)
+//-----------------------------------------------------------------------------
+{
+	// count the task before it becomes visible, a stealing worker
+	// decrements the counter right after taking it
+	update_max_waiting(ma_iPending++);
+
+	if (task.Lane == Priority::Normal && s_current_pool == this && s_current_queue)
+	{
+		// pushed from inside a task of this pool - keep it with this worker,
+		// without touching any shared lock
+		s_current_queue->push(std::move(task));
+	}
+	else
+	{
+		// tasks with another priority always go through the lanes of
+		// the injection queue
+		std::lock_guard<std::mutex> lock(m_cond_mutex);
+
+		if (task.Lane == Priority::High)
+		{
+			++ma_iInjectedHigh;
+		}
+
+		auto iLane = static_cast<std::size_t>(task.Lane);
+		m_queue.push(std::move(task), iLane);
+		++ma_iInjected;
+	}
+
+	// a parking worker increments ma_n_idle before checking ma_iPending
+	// under the cond mutex, so either it sees the new task, or we see it
+	if (ma_n_idle > 0)
+	{
+		{
+			// wait until the worker is really waiting
+			std::lock_guard<std::mutex> lock(m_cond_mutex);
+		}
+
+		m_cond_var.notify_one();
+	}
+
+} // push_stealing_task
 
 //-----------------------------------------------------------------------------
 KThreadPool::Diagnostics KThreadPool::get_diagnostics(bool bWasIdle) const
@@ -377,8 +975,21 @@ KThreadPool::Diagnostics KThreadPool::get_diagnostics(bool bWasIdle) const
 	Diag.iTotalTasks      = ma_iTotalTasks;
 	Diag.iMaxWaitingTasks = ma_iMaxWaitingTasks;
 	Diag.iWaitingTasks    = n_queued();
+	Diag.iExpiredTasks    = ma_iExpiredTasks;
 	Diag.bWasIdle         = bWasIdle;
 
+	std::unique_lock<std::recursive_mutex> lock(m_resize_mutex);
+
+	Diag.iNUMANode        = m_iNUMANode;
+
+	if (!m_cpu_sets.empty())
+	{
+		for (std::size_t i = 0; i < m_threads.size(); ++i)
+		{
+			Diag.ThreadCPUs.push_back(m_cpu_sets[i % m_cpu_sets.size()]);
+		}
+	}
+
 	return Diag;
 
 } // get_diagnostics
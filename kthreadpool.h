@@ -54,6 +54,7 @@
 #pragma once
 
 #include "bits/kcppcompat.h"
+#include "kduration.h"
 #include <functional>
 #include <thread>
 #include <atomic>
@@ -62,6 +63,11 @@
 #include <future>
 #include <mutex>
 #include <queue>
+#include <deque>
+#include <array>
+#include <cstddef>
+#include <new>
+#include <type_traits>
 
 /// @file kthreadpool.h
 /// thread pool to run user's tasks (all types of callables) with signature
@@ -73,8 +79,9 @@ namespace detail {
 namespace threadpool {
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
-/// move semantics queue implementation - helper type for thread pool
-template <typename T>
+/// move semantics queue implementation - helper type for thread pool. The
+/// queue has iLanes FIFO lanes, pop() serves lane 0 first.
+template <typename T, std::size_t iLanes = 1>
 class Queue
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 {
@@ -84,24 +91,31 @@ public:
 //------
 
 	//-----------------------------------------------------------------------------
-	size_t push(T&& value)
+	size_t push(T&& value, std::size_t iLane = 0)
 	//-----------------------------------------------------------------------------
 	{
-		m_queue.push(std::move(value));
-		return size();
+		m_queues[iLane].push(std::move(value));
+		return ++m_iSize;
 	}
 
 	//-----------------------------------------------------------------------------
-	bool pop(T& v)
+	/// pop from the first non-empty lane up to and including iMaxLane
+	bool pop(T& v, std::size_t iMaxLane = iLanes - 1)
 	//-----------------------------------------------------------------------------
 	{
-		if (m_queue.empty())
+		for (std::size_t iLane = 0; iLane <= iMaxLane; ++iLane)
 		{
-			return false;
+			auto& queue = m_queues[iLane];
+
+			if (!queue.empty())
+			{
+				v = std::move(queue.front());
+				queue.pop();
+				--m_iSize;
+				return true;
+			}
 		}
-		v = std::move(m_queue.front());
-		m_queue.pop();
-		return true;
+		return false;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -110,10 +124,14 @@ public:
 	{
 		std::unique_lock<std::mutex> lock(mutex);
 
-		while (!m_queue.empty())
+		for (auto& queue : m_queues)
 		{
-			m_queue.pop();
+			while (!queue.empty())
+			{
+				queue.pop();
+			}
 		}
+		m_iSize = 0;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -122,7 +140,7 @@ public:
 	{
 		std::unique_lock<std::mutex> lock(mutex);
 
-		return m_queue.empty();
+		return !m_iSize;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -142,13 +160,370 @@ private:
 	std::size_t size() const
 	//-----------------------------------------------------------------------------
 	{
-		return m_queue.size();
+		return m_iSize;
 	}
 
-	std::queue<T> m_queue;
+	std::array<std::queue<T>, iLanes> m_queues;
+	std::size_t                       m_iSize { 0 };
 
 }; // Queue
 
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// per worker task deque for the work stealing scheduler - the owning worker
+/// pushes and pops at the back, other workers steal from the front
+template <typename T>
+class StealingDeque
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//------
+public:
+//------
+
+	//-----------------------------------------------------------------------------
+	void push(T&& value)
+	//-----------------------------------------------------------------------------
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_deque.push_back(std::move(value));
+	}
+
+	//-----------------------------------------------------------------------------
+	/// pop the newest task - for the owning worker
+	bool pop(T& v)
+	//-----------------------------------------------------------------------------
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (m_deque.empty())
+		{
+			return false;
+		}
+		v = std::move(m_deque.back());
+		m_deque.pop_back();
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// pop the oldest task - for other workers
+	bool steal(T& v)
+	//-----------------------------------------------------------------------------
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (m_deque.empty())
+		{
+			return false;
+		}
+		v = std::move(m_deque.front());
+		m_deque.pop_front();
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// remove all tasks, returns count of removed tasks
+	std::size_t clear()
+	//-----------------------------------------------------------------------------
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto iSize = m_deque.size();
+		m_deque.clear();
+		return iSize;
+	}
+
+//------
+private:
+//------
+
+	std::mutex    m_mutex;
+	std::deque<T> m_deque;
+
+}; // StealingDeque
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// type erased, move only callable with signature void() - callables of up to
+/// iInlineSize bytes are stored inside the object, larger ones on the heap
+class SmallTask
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//------
+public:
+//------
+
+	/// callables up to this size do not allocate - a std::packaged_task fits
+	static constexpr std::size_t iInlineSize = 48;
+
+	//-----------------------------------------------------------------------------
+	SmallTask() = default;
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	template<typename Function,
+	         typename std::enable_if<!std::is_same<typename std::decay<Function>::type, SmallTask>::value, int>::type = 0>
+	SmallTask(Function&& f)
+	//-----------------------------------------------------------------------------
+	{
+		using F = typename std::decay<Function>::type;
+
+		if constexpr (IsInline<F>())
+		{
+			new (m_Storage) F(std::forward<Function>(f));
+			m_Ops = &s_InlineOps<F>;
+		}
+		else
+		{
+			*reinterpret_cast<F**>(m_Storage) = new F(std::forward<Function>(f));
+			m_Ops = &s_HeapOps<F>;
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	SmallTask(SmallTask&& other) noexcept
+	//-----------------------------------------------------------------------------
+	{
+		MoveFrom(other);
+	}
+
+	//-----------------------------------------------------------------------------
+	SmallTask& operator=(SmallTask&& other) noexcept
+	//-----------------------------------------------------------------------------
+	{
+		if (this != &other)
+		{
+			reset();
+			MoveFrom(other);
+		}
+		return *this;
+	}
+
+	SmallTask(const SmallTask&) = delete;
+	SmallTask& operator=(const SmallTask&) = delete;
+
+	//-----------------------------------------------------------------------------
+	~SmallTask()
+	//-----------------------------------------------------------------------------
+	{
+		reset();
+	}
+
+	//-----------------------------------------------------------------------------
+	/// call the stored callable
+	void operator()()
+	//-----------------------------------------------------------------------------
+	{
+		m_Ops->Invoke(m_Storage);
+	}
+
+	//-----------------------------------------------------------------------------
+	/// destroy the stored callable
+	void reset() noexcept
+	//-----------------------------------------------------------------------------
+	{
+		if (m_Ops)
+		{
+			m_Ops->Destroy(m_Storage);
+			m_Ops = nullptr;
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// returns true if a callable is stored
+	explicit operator bool() const noexcept
+	//-----------------------------------------------------------------------------
+	{
+		return m_Ops != nullptr;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// returns true if a callable of type F is stored without heap allocation
+	template<typename F>
+	static constexpr bool IsInline()
+	//-----------------------------------------------------------------------------
+	{
+		return sizeof(F) <= iInlineSize
+		    && alignof(F) <= alignof(std::max_align_t)
+		    && std::is_nothrow_move_constructible<F>::value;
+	}
+
+//------
+private:
+//------
+
+	struct Ops
+	{
+		void (*Invoke)  (void* Storage);
+		void (*Move)    (void* From, void* To) noexcept;
+		void (*Destroy) (void* Storage) noexcept;
+	};
+
+	template<typename F>
+	static constexpr Ops s_InlineOps
+	{
+		[](void* Storage) { (*static_cast<F*>(Storage))(); },
+		[](void* From, void* To) noexcept
+		{
+			new (To) F(std::move(*static_cast<F*>(From)));
+			static_cast<F*>(From)->~F();
+		},
+		[](void* Storage) noexcept { static_cast<F*>(Storage)->~F(); }
+	};
+
+	template<typename F>
+	static constexpr Ops s_HeapOps
+	{
+		[](void* Storage) { (**static_cast<F**>(Storage))(); },
+		[](void* From, void* To) noexcept { *static_cast<F**>(To) = *static_cast<F**>(From); },
+		[](void* Storage) noexcept { delete *static_cast<F**>(Storage); }
+	};
+
+	//-----------------------------------------------------------------------------
+	void MoveFrom(SmallTask& other) noexcept
+	//-----------------------------------------------------------------------------
+	{
+		if (other.m_Ops)
+		{
+			other.m_Ops->Move(other.m_Storage, m_Storage);
+			m_Ops = other.m_Ops;
+			other.m_Ops = nullptr;
+		}
+	}
+
+	alignas(std::max_align_t) unsigned char m_Storage[iInlineSize];
+	const Ops* m_Ops { nullptr };
+
+}; // SmallTask
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// bounded lock free multi producer / multi consumer ring - each slot carries
+/// a sequence number that tells producers and consumers whose turn it is
+template <typename T>
+class MPMCRing
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//------
+public:
+//------
+
+	//-----------------------------------------------------------------------------
+	/// construct with a capacity, which will be rounded up to the next power of two
+	explicit MPMCRing(std::size_t iCapacity)
+	//-----------------------------------------------------------------------------
+	{
+		std::size_t iSize = 2;
+
+		while (iSize < iCapacity)
+		{
+			iSize <<= 1;
+		}
+
+		m_Slots = std::make_unique<Slot[]>(iSize);
+		m_iMask = iSize - 1;
+
+		for (std::size_t i = 0; i < iSize; ++i)
+		{
+			m_Slots[i].iSequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// move value into the ring - value is left untouched if the ring is full
+	/// @return false if the ring is full
+	bool try_push(T& value)
+	//-----------------------------------------------------------------------------
+	{
+		auto iPos = m_iHead.load(std::memory_order_relaxed);
+
+		for (;;)
+		{
+			auto& slot  = m_Slots[iPos & m_iMask];
+			auto  iSeq  = slot.iSequence.load(std::memory_order_acquire);
+			auto  iDiff = static_cast<std::ptrdiff_t>(iSeq) - static_cast<std::ptrdiff_t>(iPos);
+
+			if (iDiff == 0)
+			{
+				if (m_iHead.compare_exchange_weak(iPos, iPos + 1, std::memory_order_relaxed))
+				{
+					slot.Value = std::move(value);
+					slot.iSequence.store(iPos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (iDiff < 0)
+			{
+				// the slot was not yet consumed after the last round
+				return false;
+			}
+			else
+			{
+				iPos = m_iHead.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// move the oldest value out of the ring
+	/// @return false if the ring is empty
+	bool try_pop(T& value)
+	//-----------------------------------------------------------------------------
+	{
+		auto iPos = m_iTail.load(std::memory_order_relaxed);
+
+		for (;;)
+		{
+			auto& slot  = m_Slots[iPos & m_iMask];
+			auto  iSeq  = slot.iSequence.load(std::memory_order_acquire);
+			auto  iDiff = static_cast<std::ptrdiff_t>(iSeq) - static_cast<std::ptrdiff_t>(iPos + 1);
+
+			if (iDiff == 0)
+			{
+				if (m_iTail.compare_exchange_weak(iPos, iPos + 1, std::memory_order_relaxed))
+				{
+					value = std::move(slot.Value);
+					slot.iSequence.store(iPos + m_iMask + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (iDiff < 0)
+			{
+				// the slot was not yet filled
+				return false;
+			}
+			else
+			{
+				iPos = m_iTail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	/// returns the capacity of the ring
+	std::size_t capacity() const
+	//-----------------------------------------------------------------------------
+	{
+		return m_iMask + 1;
+	}
+
+//------
+private:
+//------
+
+	struct Slot
+	{
+		std::atomic<std::size_t> iSequence { 0 };
+		T                        Value;
+	};
+
+	std::unique_ptr<Slot[]> m_Slots;
+	std::size_t             m_iMask { 0 };
+	// keep head and tail on separate cache lines
+	alignas(64) std::atomic<std::size_t> m_iHead { 0 };
+	alignas(64) std::atomic<std::size_t> m_iTail { 0 };
+
+}; // MPMCRing
+
 } // end of namespace threadpool
 } // end of namespace detail
 
@@ -164,10 +539,41 @@ class DEKAF2_PUBLIC KThreadPool
 public:
 //------
 
+	/// the scheduling strategy of the pool
+	enum class Scheduling
+	{
+		SharedQueue,  ///< all threads pop from one shared task queue (default)
+		WorkStealing  ///< each thread has its own task deque, tasks pushed from inside
+		              ///< the pool go into the deque of the pushing thread, tasks pushed
+		              ///< from outside into a global injection queue, idle threads steal
+		              ///< tasks from the other threads' deques
+	};
+
+	/// the priority lanes of the pool - a waiting task of a higher lane is
+	/// always started before any waiting task of a lower lane
+	enum class Priority
+	{
+		High,         ///< latency sensitive tasks, like health checks
+		Normal,       ///< the lane for all tasks pushed without priority
+		Low           ///< bulk tasks, only started if no other task waits
+	};
+
 	//-----------------------------------------------------------------------------
 	/// Construct an empty thread pool - it will not start unless you resize it!
-	KThreadPool() = default;
+	KThreadPool()
 	//-----------------------------------------------------------------------------
+	{
+		create_rings();
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Construct an empty thread pool with the given scheduling - it will not start unless you resize it!
+	explicit KThreadPool(Scheduling scheduling)
+	//-----------------------------------------------------------------------------
+	: m_scheduling(scheduling)
+	{
+		create_rings();
+	}
 
 	KThreadPool(const KThreadPool &) = delete;
 	KThreadPool(KThreadPool &&) = delete;
@@ -177,7 +583,9 @@ public:
 	//-----------------------------------------------------------------------------
 	/// Construct a thread pool with nThreads size - if nThreads == 0 starts as many
 	/// threads as CPU threads are available
-	KThreadPool(std::size_t nThreads);
+	/// @param nThreads number of threads
+	/// @param scheduling the scheduling strategy, default is Scheduling::SharedQueue
+	KThreadPool(std::size_t nThreads, Scheduling scheduling = Scheduling::SharedQueue);
 	//-----------------------------------------------------------------------------
 
 	//-----------------------------------------------------------------------------
@@ -193,7 +601,11 @@ public:
 		std::size_t iTotalTasks      { 0 }; ///< total number of serviced tasks
 		std::size_t iMaxWaitingTasks { 0 }; ///< max size of wait queue since last resize
 		std::size_t iWaitingTasks    { 0 }; ///< current number of tasks in wait queue
+		std::size_t iExpiredTasks    { 0 }; ///< total number of tasks dropped after their deadline
+		int         iNUMANode        { -1 }; ///< the NUMA node the pool is bound to, or -1
 		bool        bWasIdle         { false };
+		std::vector<std::vector<uint16_t>>
+		            ThreadCPUs;             ///< the CPU IDs each thread is pinned to, empty if not pinned
 
 	}; // Diagnostics
 
@@ -213,6 +625,61 @@ public:
 		m_shutdown_callback = callback;
 	}
 
+	using ExpiryCallback = std::function<void(Priority)>;
+
+	//-----------------------------------------------------------------------------
+	/// Shall we be informed about tasks that were dropped because their deadline
+	/// passed before a thread became available?
+	/// @param callback callback function called with the priority of each dropped task,
+	/// from the thread that would have run it
+	void register_expiry_callback(ExpiryCallback callback)
+	//-----------------------------------------------------------------------------
+	{
+		m_expiry_callback = callback;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Get the scheduling strategy of the pool
+	Scheduling get_scheduling() const
+	//-----------------------------------------------------------------------------
+	{
+		return m_scheduling;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Pin the threads of the pool round robin to single CPUs - thread 0 to CPUs[0],
+	/// thread 1 to CPUs[1], and so on. Applies to running threads and to threads
+	/// started later.
+	/// @param CPUs the CPU IDs to pin to, if empty all CPUs the process may run on
+	/// @return false if not all threads could be pinned, e.g. on unsupported systems
+	bool pin_threads(std::vector<uint16_t> CPUs = {});
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// Pin thread i of the pool to the CPU set CPUSets[i % CPUSets.size()]. Applies
+	/// to running threads and to threads started later.
+	/// @param CPUSets the CPU sets to pin to, if empty the pinning is removed and
+	/// all threads may run on all CPUs again
+	/// @return false if not all threads could be pinned, e.g. on unsupported systems
+	bool pin_threads(std::vector<std::vector<uint16_t>> CPUSets);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// Bind all threads of the pool to the CPUs of a NUMA node, so that the memory
+	/// the tasks allocate is node local. Create one pool per node to serve all nodes.
+	/// @param iNode the NUMA node, one of kGetNUMANodes()
+	/// @return false if the node has no CPUs, or not all threads could be bound
+	bool bind_to_numa_node(uint16_t iNode);
+	//-----------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------
+	/// Get the NUMA node the pool was bound to, or -1
+	int get_numa_node() const
+	//-----------------------------------------------------------------------------
+	{
+		return m_iNUMANode;
+	}
+
 	//-----------------------------------------------------------------------------
 	/// Get the total number of threads in the pool
 	std::size_t size() const;
@@ -261,6 +728,11 @@ public:
 	bool is_stopped();
 	//-----------------------------------------------------------------------------
 
+	//-----------------------------------------------------------------------------
+	/// @return the pool the calling thread is a worker of, or nullptr if it is none
+	static KThreadPool* get_current_pool();
+	//-----------------------------------------------------------------------------
+
 	//-----------------------------------------------------------------------------
 	/// Push a class member function for asynchronous execution with arbitrary args. Receive result in returned future,
 	/// or ignore..
@@ -277,7 +749,7 @@ public:
 
 		auto future = task.get_future();
 
-		push_packaged_task(std::move(task));
+		push_task(std::move(task));
 
 		return future;
 	}
@@ -300,11 +772,7 @@ public:
 
 		auto future = InnerTask.get_future();
 
-		auto task = std::packaged_task<void()>(
-			std::move(InnerTask)
-		);
-
-		push_packaged_task(std::move(task));
+		push_task(std::move(InnerTask));
 
 		return future;
 	}
@@ -325,7 +793,7 @@ public:
 
 		auto future = task.get_future();
 
-		push_packaged_task(std::move(task));
+		push_task(std::move(task));
 
 		return future;
 	}
@@ -348,11 +816,43 @@ public:
 
 		auto future = InnerTask.get_future();
 
-		auto task = std::packaged_task<void()>(
-			std::move(InnerTask)
+		push_task(std::move(InnerTask));
+
+		return future;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Push a callable, or a class member function followed by its object, with arbitrary args
+	/// into the lane of the given priority. Receive result in returned future, or ignore..
+	template<typename Function, typename... Args>
+	auto push(Priority priority, Function&& f, Args&&... args)
+	-> std::future<decltype(std::bind(std::forward<Function>(f), std::forward<Args>(args)...)())>
+	//-----------------------------------------------------------------------------
+	{
+		return push(priority, KDuration::zero(), std::forward<Function>(f), std::forward<Args>(args)...);
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Push a callable, or a class member function followed by its object, with arbitrary args
+	/// into the lane of the given priority, with a deadline. If no thread started the task within
+	/// MaxWait, it is dropped without being run, the expiry callback is called, and the returned
+	/// future throws a std::future_error with std::future_errc::broken_promise.
+	/// @param priority the priority lane for the task
+	/// @param MaxWait the max time the task may wait in the queue, 0 for no deadline
+	template<typename Function, typename... Args>
+	auto push(Priority priority, KDuration MaxWait, Function&& f, Args&&... args)
+	-> std::future<decltype(std::bind(std::forward<Function>(f), std::forward<Args>(args)...)())>
+	//-----------------------------------------------------------------------------
+	{
+		using FutureType = decltype(std::bind(std::forward<Function>(f), std::forward<Args>(args)...)());
+
+		auto InnerTask = std::packaged_task<FutureType()>(
+			std::bind(std::forward<Function>(f), std::forward<Args>(args)...)
 		);
 
-		push_packaged_task(std::move(task));
+		auto future = InnerTask.get_future();
+
+		push_task(std::move(InnerTask), priority, MaxWait);
 
 		return future;
 	}
@@ -368,32 +868,131 @@ private:
 		Stop
 	};
 
+	using Clock = KStopTime::Clock;
+
+	/// a waiting task, with its lane and deadline
+	struct Task
+	{
+		detail::threadpool::SmallTask Run;
+		Clock::time_point          Deadline { Clock::time_point::max() };
+		Priority                   Lane     { Priority::Normal };
+	};
+
+	static constexpr std::size_t iLanes = static_cast<std::size_t>(Priority::Low) + 1;
+	/// the capacity of the lock free ring of each lane of the shared queue
+	static constexpr std::size_t iRingSize = 512;
+
+	using TaskRing = detail::threadpool::MPMCRing<Task>;
+
+	using WorkerQueue = detail::threadpool::StealingDeque<Task>;
+	using WorkerQueues = std::vector<std::shared_ptr<WorkerQueue>>;
+
+	DEKAF2_PRIVATE
+	void push_task(detail::threadpool::SmallTask task,
+	               Priority priority = Priority::Normal,
+	               KDuration MaxWait = KDuration::zero());
+
+	/// push into the lock free rings of the shared queue, or into the
+	/// locked overflow queue if the ring of the lane is full, or if the
+	/// lane has tasks in the overflow queue - this keeps the FIFO order
+	DEKAF2_PRIVATE
+	void push_shared_task(Task task);
+
+	/// pop from the rings or the overflow queue, highest lane first
+	DEKAF2_PRIVATE
+	bool pop_shared_task(Task& task);
+
+	/// create the rings for the shared queue scheduler
+	DEKAF2_PRIVATE
+	void create_rings();
+
 	DEKAF2_PRIVATE
-	void push_packaged_task(std::packaged_task<void()> task);
+	void push_stealing_task(Task task);
 
 	/// start one thread
 	/// @return false if thread could not be started
 	DEKAF2_PRIVATE
 	bool run_thread( size_t i );
 
+	/// the worker loop for the work stealing scheduler
+	DEKAF2_PRIVATE
+	void run_stealing_worker(std::shared_ptr<std::atomic<eAbort>> abort_ptr, std::shared_ptr<WorkerQueue> own, std::size_t iStartVictim);
+
+	/// find a task in the own deque, the injection queue or the other workers' deques
+	DEKAF2_PRIVATE
+	bool find_stealing_task(WorkerQueue& own, WorkerQueues& victims, std::size_t& iGeneration, std::size_t& iNextVictim, Task& task);
+
+	/// move the remaining tasks of a finishing worker into the injection queue
+	DEKAF2_PRIVATE
+	void release_worker_queue(WorkerQueue& own);
+
+	DEKAF2_PRIVATE
+	void update_max_waiting(std::size_t iWaiting);
+
+	/// returns the CPUs the threads may run on when not pinned - call with locked m_resize_mutex
+	DEKAF2_PRIVATE
+	std::vector<uint16_t> get_unpinned_cpus() const;
+
+	/// pin thread i to its CPU set, if any - call with locked m_resize_mutex
+	DEKAF2_PRIVATE
+	bool pin_thread(std::size_t i);
+
+	/// run the task, or drop it if its deadline has passed
+	DEKAF2_PRIVATE
+	void run_task(Task& task);
+
+	/// pop from the injection queue, up to and including iMaxLane
+	DEKAF2_PRIVATE
+	bool pop_injected_task(Task& task, std::size_t iMaxLane);
+
 	DEKAF2_PRIVATE
 	void notify_thread_shutdown(bool bWasIdle, eAbort abort);
 
+	// the pool and the deque of the current thread, if it is a work stealing worker
+	static thread_local KThreadPool*       s_current_pool;
+	static thread_local WorkerQueue*       s_current_queue;
+
 	std::vector<std::unique_ptr<std::thread>>             m_threads;
 	std::vector<std::shared_ptr<std::atomic<eAbort>>>     m_abort;
-	detail::threadpool::Queue<std::packaged_task<void()>> m_queue;
+	// the lock free rings of the shared queue scheduler, one per lane
+	std::array<std::unique_ptr<TaskRing>, iLanes>         m_rings;
+	// shared queue: the overflow queue when a ring is full - work stealing:
+	// the injection queue
+	detail::threadpool::Queue<Task, iLanes>               m_queue;
+	// the deques of all running work stealing threads, including those
+	// that are finishing after a resize
+	WorkerQueues                                          m_worker_queues;
+	// the CPU sets the threads are pinned to, round robin
+	std::vector<std::vector<uint16_t>>                    m_cpu_sets;
+	// the affinity mask of the process before the first pinning
+	std::vector<uint16_t>                                 m_unpinned_cpus;
 
 	std::atomic<std::size_t> ma_iTotalTasks              { 0 };
 	std::atomic<std::size_t> ma_iMaxWaitingTasks         { 0 };
 	std::atomic<std::size_t> ma_n_idle                   { 0 };
 	std::atomic<std::size_t> ma_iAlreadyStopped          { 0 };
 	std::atomic<std::size_t> ma_iDetachedThreadsToFinish { 0 };
+	std::atomic<std::size_t> ma_iExpiredTasks            { 0 };
+	// shared queue: count of all queued tasks, and of tasks in the overflow queue per lane
+	std::atomic<std::size_t> ma_iQueued                  { 0 };
+	std::array<std::atomic<std::size_t>, iLanes> ma_iOverflow {};
+	// work stealing: count of all queued tasks, of tasks in the injection
+	// queue, of high priority tasks in the injection queue, and the
+	// generation of m_worker_queues
+	std::atomic<std::size_t> ma_iPending                 { 0 };
+	std::atomic<std::size_t> ma_iInjected                { 0 };
+	std::atomic<std::size_t> ma_iInjectedHigh            { 0 };
+	std::atomic<std::size_t> ma_iWorkerGeneration        { 0 };
 	std::atomic<bool>        ma_interrupt                { false };
 
 	mutable std::recursive_mutex m_resize_mutex;
 	mutable std::mutex       m_cond_mutex;
+	mutable std::mutex       m_worker_queues_mutex;
 	std::condition_variable  m_cond_var;
 	ShutdownCallback         m_shutdown_callback;
+	ExpiryCallback           m_expiry_callback;
+	Scheduling               m_scheduling { Scheduling::SharedQueue };
+	int                      m_iNUMANode  { -1 };
 
 }; // KThreadPool
 
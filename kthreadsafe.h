@@ -47,10 +47,28 @@
 
 #include "bits/kcppcompat.h"
 #include "bits/ktemplate.h"
+#include "bits/kepochreclaim.h"
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <type_traits>
 
 namespace dekaf2 {
 
+/// Policy for KThreadSafe for read mostly data: readers access an immutable snapshot
+/// without writing to shared memory, writers copy the object, modify the copy, and
+/// publish it when their accessor goes out of scope. Replaced snapshots are deleted
+/// once no reader can see them anymore. Writers are serialized.
+struct KRCUPolicy {};
+
+/// Policy for KThreadSafe for small trivially copyable types: readers get a copy of
+/// the object which is retried until no writer interfered, writers are serialized
+/// and store their modified copy when their accessor goes out of scope.
+struct KSeqLockPolicy {};
+
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 /// Template for generic threadsafe sharing for non-atomic types
 template<class T, class MutexType = std::shared_mutex>
@@ -208,5 +226,431 @@ private:
 
 }; // KThreadSafe
 
+namespace detail {
+namespace threadsafe {
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// holds the writer lock and the private copy of a writer - base class
+/// of the unique accessors of the RCU and seqlock policies, constructed
+/// before the reference proxy
+template<class T, class Storage>
+class WriterCopy
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+protected:
+//----------
+
+	WriterCopy(std::mutex& Mutex, const Storage& Shared)
+	: m_Lock(Mutex)
+	, m_Copy(Shared.Load())
+	{
+	}
+
+	std::unique_lock<std::mutex> m_Lock;
+	std::unique_ptr<T>           m_Copy;
+
+}; // WriterCopy
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// holds the snapshot of a seqlock reader - base class of the shared accessor
+/// of the seqlock policy, constructed before the reference proxy
+template<class T>
+class ReaderCopy
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+protected:
+//----------
+
+	ReaderCopy(T Value)
+	: m_Copy(std::move(Value))
+	{
+	}
+
+	T m_Copy;
+
+}; // ReaderCopy
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// atomic pointer on the current snapshot of the RCU policy
+template<class T>
+class RCUStorage
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	template<class... Args>
+	RCUStorage(Args&&... args)
+	: m_pShared(new T(std::forward<Args>(args)...))
+	{
+	}
+
+	~RCUStorage()
+	{
+		delete m_pShared.load(std::memory_order_relaxed);
+	}
+
+	RCUStorage(const RCUStorage&) = delete;
+	RCUStorage& operator=(const RCUStorage&) = delete;
+
+	/// get the current snapshot - only call inside a read section
+	const T& Get() const
+	{
+		return *m_pShared.load(std::memory_order_acquire);
+	}
+
+	/// copy the current snapshot - only call while holding the writer lock
+	std::unique_ptr<T> Load() const
+	{
+		return std::make_unique<T>(*m_pShared.load(std::memory_order_relaxed));
+	}
+
+	/// publish a new snapshot - only call while holding the writer lock
+	void Store(std::unique_ptr<T> Object)
+	{
+		auto pOld = m_pShared.exchange(Object.release(), std::memory_order_acq_rel);
+		KEpochReclaimer::Retire(pOld);
+	}
+
+//----------
+private:
+//----------
+
+	std::atomic<T*> m_pShared;
+
+}; // RCUStorage
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// sequence counted storage of the seqlock policy - the object is kept in
+/// atomic words, so that racing reads are well defined and only discarded
+template<class T>
+class SeqLockStorage
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+	static_assert(std::is_trivially_copyable<T>::value && std::is_default_constructible<T>::value,
+	              "KSeqLockPolicy needs a trivially copyable and default constructible type");
+
+//----------
+public:
+//----------
+
+	template<class... Args>
+	SeqLockStorage(Args&&... args)
+	{
+		Write(T(std::forward<Args>(args)...));
+	}
+
+	SeqLockStorage(const SeqLockStorage&) = delete;
+	SeqLockStorage& operator=(const SeqLockStorage&) = delete;
+
+	/// get a consistent copy of the object - retries while a writer is active
+	T Get() const
+	{
+		Words Copy;
+
+		for (;;)
+		{
+			auto iSequence = m_iSequence.load(std::memory_order_acquire);
+
+			if ((iSequence & 1) == 0)
+			{
+				for (std::size_t i = 0; i < iWords; ++i)
+				{
+					Copy[i] = m_Words[i].load(std::memory_order_relaxed);
+				}
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+
+				if (m_iSequence.load(std::memory_order_relaxed) == iSequence)
+				{
+					break;
+				}
+			}
+
+			std::this_thread::yield();
+		}
+
+		T Object;
+		std::memcpy(static_cast<void*>(&Object), Copy.data(), sizeof(T));
+		return Object;
+	}
+
+	/// copy the object - only call while holding the writer lock
+	std::unique_ptr<T> Load() const
+	{
+		return std::make_unique<T>(Get());
+	}
+
+	/// store a new value - only call while holding the writer lock
+	void Store(std::unique_ptr<T> Object)
+	{
+		Write(*Object);
+	}
+
+//----------
+private:
+//----------
+
+	static constexpr std::size_t iWords = (sizeof(T) + sizeof(std::size_t) - 1) / sizeof(std::size_t);
+	using Words = std::array<std::size_t, iWords>;
+
+	void Write(const T& Object)
+	{
+		Words Copy {};
+		std::memcpy(Copy.data(), &Object, sizeof(T));
+
+		auto iSequence = m_iSequence.load(std::memory_order_relaxed);
+		m_iSequence.store(iSequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		for (std::size_t i = 0; i < iWords; ++i)
+		{
+			m_Words[i].store(Copy[i], std::memory_order_relaxed);
+		}
+
+		m_iSequence.store(iSequence + 2, std::memory_order_release);
+	}
+
+	std::atomic<std::size_t>                      m_iSequence { 0 };
+	std::array<std::atomic<std::size_t>, iWords>  m_Words {};
+
+}; // SeqLockStorage
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// common implementation of KThreadSafe for the lock free reader policies
+template<class T, class Storage, bool bSnapshotRead>
+class LockFreeReaders
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//----------
+public:
+//----------
+
+	using self_type = LockFreeReaders;
+
+	//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	/// helper type for unique access on a private copy, which is published
+	/// when the accessor goes out of scope
+	class UniqueLocked : private WriterCopy<T, Storage>, public detail::ReferenceProxy<T>
+	//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	{
+
+	//----------
+	public:
+	//----------
+
+		UniqueLocked(LockFreeReaders& Parent)
+		: WriterCopy<T, Storage>(Parent.m_WriteMutex, Parent.m_Shared)
+		, detail::ReferenceProxy<T>(*this->m_Copy)
+		, m_Parent(Parent)
+		{
+		}
+
+		~UniqueLocked()
+		{
+			m_Parent.m_Shared.Store(std::move(this->m_Copy));
+		}
+
+		UniqueLocked(const UniqueLocked&) = delete;
+		UniqueLocked& operator=(const UniqueLocked&) = delete;
+
+	//----------
+	private:
+	//----------
+
+		LockFreeReaders& m_Parent;
+
+	}; // UniqueLocked
+
+	//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	/// helper type for read access on the snapshot of an RCU object, which
+	/// stays valid for the lifetime of the accessor
+	class RCUShared : private KEpochReclaimer::Guard, public detail::ConstReferenceProxy<T>
+	//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	{
+
+	//----------
+	public:
+	//----------
+
+		RCUShared(const LockFreeReaders& Parent)
+		: detail::ConstReferenceProxy<T>(Parent.m_Shared.Get()) // the guard is constructed first
+		{
+		}
+
+	}; // RCUShared
+
+	//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	/// helper type for read access on a consistent copy of a seqlock object
+	class SeqLockShared : private ReaderCopy<T>, public detail::ConstReferenceProxy<T>
+	//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+	{
+
+	//----------
+	public:
+	//----------
+
+		SeqLockShared(const LockFreeReaders& Parent)
+		: ReaderCopy<T>(Parent.m_Shared.Get())
+		, detail::ConstReferenceProxy<T>(this->m_Copy)
+		{
+		}
+
+		SeqLockShared(const SeqLockShared&) = delete;
+		SeqLockShared& operator=(const SeqLockShared&) = delete;
+
+	}; // SeqLockShared
+
+	using SharedLocked = typename std::conditional<bSnapshotRead, SeqLockShared, RCUShared>::type;
+
+	//-----------------------------------------------------------------------------
+	LockFreeReaders(const LockFreeReaders& other)
+	//-----------------------------------------------------------------------------
+	: m_Shared(other.shared().get())
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	LockFreeReaders(LockFreeReaders&& other) noexcept
+	//-----------------------------------------------------------------------------
+	: m_Shared(std::move(other.unique().get()))
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	LockFreeReaders& operator=(const LockFreeReaders& other)
+	//-----------------------------------------------------------------------------
+	{
+		if (this != &other)
+		{
+			reset(other.shared().get());
+		}
+		return *this;
+	}
+
+	//-----------------------------------------------------------------------------
+	LockFreeReaders& operator=(LockFreeReaders&& other) noexcept
+	//-----------------------------------------------------------------------------
+	{
+		if (this != &other)
+		{
+			reset(std::move(other.unique().get()));
+		}
+		return *this;
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Construction with any arguments the shared type permits. Is also the default constructor.
+	template<class... Args,
+		typename std::enable_if<
+			sizeof...(Args) != 1, int
+		>::type = 0
+	>
+	LockFreeReaders(Args&&... args)
+	//-----------------------------------------------------------------------------
+	: m_Shared(std::forward<Args>(args)...)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Construction of the shared type with any single argument.
+	template<class Arg,
+		typename std::enable_if<
+			!std::is_base_of<
+				self_type, typename std::decay<Arg>::type
+			>::value, int
+		>::type = 0
+	>
+	LockFreeReaders(Arg&& arg)
+	//-----------------------------------------------------------------------------
+	: m_Shared(std::forward<Arg>(arg))
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Reset shared type by constructing a new one, either default constructed or with parameters
+	template<class... Args>
+	void reset(Args&&... args)
+	//-----------------------------------------------------------------------------
+	{
+		auto NewObject = std::make_unique<T>(std::forward<Args>(args)...);
+		std::lock_guard<std::mutex> Lock(m_WriteMutex);
+		m_Shared.Store(std::move(NewObject));
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Get an accessor on a private copy of the shared type (good for reading and writing) -
+	/// the modified copy replaces the shared object when the accessor goes out of scope
+	UniqueLocked unique()
+	//-----------------------------------------------------------------------------
+	{
+		return UniqueLocked(*this);
+	}
+
+	//-----------------------------------------------------------------------------
+	/// Get an accessor on the shared type for reading, which never blocks and does not
+	/// write to shared memory
+	SharedLocked shared() const
+	//-----------------------------------------------------------------------------
+	{
+		return SharedLocked(*this);
+	}
+
+//----------
+private:
+//----------
+
+	Storage            m_Shared;
+	mutable std::mutex m_WriteMutex;
+
+}; // LockFreeReaders
+
+} // end of namespace threadsafe
+} // end of namespace detail
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// KThreadSafe with read-copy-update: reads are wait free and see a stable
+/// snapshot for the lifetime of the shared() accessor, writes through unique()
+/// modify a copy that is published when the accessor goes out of scope
+template<class T>
+class KThreadSafe<T, KRCUPolicy> : public detail::threadsafe::LockFreeReaders<T, detail::threadsafe::RCUStorage<T>, false>
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	using base_type = detail::threadsafe::LockFreeReaders<T, detail::threadsafe::RCUStorage<T>, false>;
+
+//----------
+public:
+//----------
+
+	using base_type::base_type;
+
+}; // KThreadSafe<T, KRCUPolicy>
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+/// KThreadSafe with a sequence lock for small trivially copyable types: the
+/// shared() accessor holds a consistent copy, writes through unique() modify
+/// a copy that is stored when the accessor goes out of scope
+template<class T>
+class KThreadSafe<T, KSeqLockPolicy> : public detail::threadsafe::LockFreeReaders<T, detail::threadsafe::SeqLockStorage<T>, true>
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+	using base_type = detail::threadsafe::LockFreeReaders<T, detail::threadsafe::SeqLockStorage<T>, true>;
+
+//----------
+public:
+//----------
+
+	using base_type::base_type;
+
+}; // KThreadSafe<T, KSeqLockPolicy>
+
 } // of namespace dekaf2
 
@@ -43,15 +43,31 @@
 #include "ktimer.h"
 #include "dekaf2.h"
 #include "klog.h"
+#include "kthreadpool.h"
+#include <algorithm>
+#include <limits>
 
 namespace dekaf2 {
 
 //---------------------------------------------------------------------------
-KTimer::KTimer(Interval Granularity)
+KTimer::KTimer(Interval Granularity, std::size_t iDispatchThreads)
 //---------------------------------------------------------------------------
+: m_tStart(std::chrono::steady_clock::now())
+, m_Granularity(std::max(Granularity, Interval(std::chrono::microseconds(1))))
+, m_iDispatchThreads(std::max(iDispatchThreads, std::size_t(1)))
 {
-	m_bShutdown = std::make_shared<std::atomic<bool>>(false);
-	m_tTiming   = std::make_shared<std::thread>(&KTimer::TimingLoop, this, Granularity);
+	m_tTiming = std::make_unique<std::thread>(&KTimer::TimingLoop, this);
+
+} // ctor
+
+//---------------------------------------------------------------------------
+KTimer::KTimer(Interval Granularity, KThreadPool& DispatchPool)
+//---------------------------------------------------------------------------
+: m_tStart(std::chrono::steady_clock::now())
+, m_Granularity(std::max(Granularity, Interval(std::chrono::microseconds(1))))
+, m_DispatchPool(&DispatchPool)
+{
+	m_tTiming = std::make_unique<std::thread>(&KTimer::TimingLoop, this);
 
 } // ctor
 
@@ -59,27 +75,89 @@ KTimer::KTimer(Interval Granularity)
 KTimer::~KTimer()
 //---------------------------------------------------------------------------
 {
-	// signal the thread to shutdown
-	*m_bShutdown = true;
+	{
+		// signal the thread to shutdown
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_bShutdown = true;
+	}
 
-	if (m_tTiming)
+	m_WakeUp.notify_all();
+
+	// the timer thread does not sleep longer than until the next tick,
+	// and is woken up immediately, so we can always join it
+	if (m_tTiming && m_tTiming->joinable())
+	{
+		m_tTiming->join();
+		kDebug(2, "joined timer thread");
+	}
+
+	if (m_OwnPool)
 	{
 		if (!m_bDestructWithJoin)
 		{
-			// detach the thread, we do not want to wait until it has joined
-			m_tTiming->detach();
-			kDebug(2, "detached timer thread");
-		}
-		else
-		{
-			// wait until thread has finished
-			m_tTiming->join();
-			kDebug(2, "joined timer thread");
+			// drop callbacks that did not yet start
+			m_OwnPool->clear();
 		}
+
+		// wait for the running callbacks
+		m_OwnPool.reset();
 	}
 
 } // dtor
 
+//---------------------------------------------------------------------------
+uint64_t KTimer::GetCurrentTick() const
+//---------------------------------------------------------------------------
+{
+	return (std::chrono::steady_clock::now() - m_tStart) / m_Granularity;
+
+} // GetCurrentTick
+
+//---------------------------------------------------------------------------
+uint64_t KTimer::ToTick(Timepoint tp) const
+//---------------------------------------------------------------------------
+{
+	// convert into the steady clock, which is not affected by changes of the system time
+	auto Offset = std::chrono::steady_clock::now() - m_tStart + (tp - Clock::now());
+
+	if (Offset.count() <= 0)
+	{
+		return 0;
+	}
+
+	// round up to the next tick, timers never fire early
+	return (Offset + m_Granularity - std::chrono::steady_clock::duration(1)) / m_Granularity;
+
+} // ToTick
+
+//---------------------------------------------------------------------------
+void KTimer::Schedule(Slot& From, Slot::iterator it)
+//---------------------------------------------------------------------------
+{
+	// timers that expire at the current tick, or expired already, go into the
+	// slot of the current tick, which is dispatched next
+	auto iTick  = std::max(it->iTick, m_iCurrentTick);
+	auto iDelta = iTick - m_iCurrentTick;
+	std::size_t iLevel = 0;
+
+	while (iLevel < iLevels - 1 && iDelta >= (uint64_t(1) << (iLevelBits * (iLevel + 1))))
+	{
+		++iLevel;
+	}
+
+	if (iLevel == iLevels - 1)
+	{
+		// park timers beyond the range of the wheel in the last slot they can reach
+		iTick = std::min(iTick, m_iCurrentTick + (uint64_t(1) << (iLevelBits * iLevels)) - 1);
+	}
+
+	auto& To = m_Wheel[iLevel][(iTick >> (iLevelBits * iLevel)) & (iSlots - 1)];
+
+	To.splice(To.end(), From, it);
+	it->pSlot = &To;
+
+} // Schedule
+
 //---------------------------------------------------------------------------
 KTimer::ID_t KTimer::AddTimer(Timer timer)
 //---------------------------------------------------------------------------
@@ -89,19 +167,45 @@ KTimer::ID_t KTimer::AddTimer(Timer timer)
 		timer.ID = GetNextID();
 	}
 
-	auto Timers = m_Timers.unique();
+	auto ID = timer.ID;
+	Slot NewTimer;
+	NewTimer.push_back(std::move(timer));
 
-	auto ret = Timers->emplace(timer.ID, std::move(timer));
+	bool bWakeUp;
 
-	if (ret.second)
 	{
-		return ret.first->second.ID;
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+
+		bWakeUp = m_Timers.empty();
+
+		if (bWakeUp)
+		{
+			// the timer thread does not advance the wheel while it is empty
+			m_iCurrentTick = std::max(m_iCurrentTick, GetCurrentTick());
+		}
+
+		auto it = NewTimer.begin();
+		// the current tick has already been dispatched
+		it->iTick = std::max(ToTick(it->ExpiresAt), m_iCurrentTick + 1);
+
+		if (!m_Timers.emplace(ID, it).second)
+		{
+			return INVALID;
+		}
+
+		Schedule(NewTimer, it);
+
+		// wake the timer thread up if it sleeps beyond the new expiration
+		bWakeUp |= it->iTick < m_iWakeUpTick;
 	}
-	else
+
+	if (bWakeUp)
 	{
-		return INVALID;
+		m_WakeUp.notify_all();
 	}
 
+	return ID;
+
 } // AddTimer
 
 //---------------------------------------------------------------------------
@@ -208,81 +312,173 @@ void KTimer::SleepUntil(time_t tp)
 bool KTimer::Cancel(ID_t ID)
 //---------------------------------------------------------------------------
 {
-	auto Timers = m_Timers.unique();
+	std::lock_guard<std::mutex> Lock(m_Mutex);
 
-	auto it = Timers->find(ID);
+	auto it = m_Timers.find(ID);
 
-	if (it == Timers->end())
+	if (it == m_Timers.end())
 	{
 		// ID not known for this KTimer
 		return false;
 	}
 
-	Timers->erase(it);
+	it->second->pSlot->erase(it->second);
+	m_Timers.erase(it);
 
 	return true;
 
 } // Cancel
 
 //---------------------------------------------------------------------------
-void KTimer::TimingLoop(Interval Granularity)
+uint64_t KTimer::GetNextEventTick() const
+//---------------------------------------------------------------------------
+{
+	auto iNext = std::numeric_limits<uint64_t>::max();
+
+	// the first expiring timer in the lowest level
+	for (uint64_t iTick = m_iCurrentTick + 1; iTick <= m_iCurrentTick + iSlots; ++iTick)
+	{
+		if (!m_Wheel[0][iTick & (iSlots - 1)].empty())
+		{
+			iNext = iTick;
+			break;
+		}
+	}
+
+	// the next cascade of the lowest upper level that holds timers - cascades
+	// of higher levels happen at the same ticks
+	for (std::size_t iLevel = 1; iLevel < iLevels; ++iLevel)
+	{
+		auto& Level = m_Wheel[iLevel];
+
+		if (std::any_of(Level.begin(), Level.end(), [](const Slot& slot) { return !slot.empty(); }))
+		{
+			auto iShift = iLevelBits * iLevel;
+			iNext = std::min(iNext, ((m_iCurrentTick >> iShift) + 1) << iShift);
+			break;
+		}
+	}
+
+	return iNext;
+
+} // GetNextEventTick
+
+//---------------------------------------------------------------------------
+void KTimer::ProcessTick()
+//---------------------------------------------------------------------------
+{
+	++m_iCurrentTick;
+
+	// cascade the timers of the upper levels whose slot starts at this tick
+	for (std::size_t iLevel = 1; iLevel < iLevels; ++iLevel)
+	{
+		auto iShift = iLevelBits * iLevel;
+
+		if (m_iCurrentTick & ((uint64_t(1) << iShift) - 1))
+		{
+			break;
+		}
+
+		auto& Cascade = m_Wheel[iLevel][(m_iCurrentTick >> iShift) & (iSlots - 1)];
+
+		while (!Cascade.empty())
+		{
+			Schedule(Cascade, Cascade.begin());
+		}
+	}
+
+	auto& Current = m_Wheel[0][m_iCurrentTick & (iSlots - 1)];
+
+	if (Current.empty())
+	{
+		return;
+	}
+
+	// take the expired timers out of the wheel, as repeating timers are
+	// scheduled again
+	Slot Expired;
+	Expired.splice(Expired.end(), Current);
+
+	auto now = Clock::now();
+
+	while (!Expired.empty())
+	{
+		auto it = Expired.begin();
+		auto& Timer = *it;
+
+		if ((Timer.Flags & TIMET) == TIMET)
+		{
+			// call the callback with a time_t value
+			m_DispatchPool->push(Timer.CBT, ToTimeT(now));
+		}
+		else
+		{
+			// call the callback with a time_point value
+			m_DispatchPool->push(Timer.CB, now);
+		}
+
+		if ((Timer.Flags & ONCE) == ONCE)
+		{
+			// remove this timer
+			m_Timers.erase(Timer.ID);
+			Expired.erase(it);
+		}
+		else
+		{
+			// calculate next expiration, without catching up on missed ones
+			auto iInterval = std::max(uint64_t((Timer.IVal + m_Granularity - Interval(1)) / m_Granularity), uint64_t(1));
+			Timer.iTick    = std::max(Timer.iTick + iInterval, m_iCurrentTick + 1);
+			Schedule(Expired, it);
+		}
+	}
+
+} // ProcessTick
+
+//---------------------------------------------------------------------------
+void KTimer::TimingLoop()
 //---------------------------------------------------------------------------
 {
 	// make sure we do not catch signals in this thread (this can happen if
 	// the signal handler thread had not been started at init of dekaf2)
 	kBlockAllSignals();
 
-	// create a copy of the class variable, as this is a shared_ptr,
-	// both instances will point to the same bool
-	auto bShutdown(m_bShutdown);
+	if (!m_DispatchPool)
+	{
+		// start the pool from this thread, so that it inherits the blocked signals
+		m_OwnPool      = std::make_unique<KThreadPool>(m_iDispatchThreads);
+		m_DispatchPool = m_OwnPool.get();
+	}
 
 	kDebug(2, "new timer thread started");
 
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+
 	for (;;)
 	{
-		std::this_thread::sleep_for(Granularity);
-
-		if (*bShutdown || Dekaf::IsShutDown())
+		if (m_bShutdown || Dekaf::IsShutDown())
 		{
 			// exit this thread.. parent class is gone
 			return;
 		}
 
-		auto now = Clock::now();
+		if (m_Timers.empty())
+		{
+			// sleep until a timer is added
+			m_WakeUp.wait(Lock);
+			continue;
+		}
 
-		auto Timers = m_Timers.unique();
+		auto iNow = GetCurrentTick();
 
-		// check all timers for their expiration date
-		for (auto& it : Timers.get())
+		while (m_iCurrentTick < iNow && !m_Timers.empty())
 		{
-			auto& Timer = it.second;
-
-			if (Timer.ExpiresAt < now)
-			{
-				if ((Timer.Flags & TIMET) == TIMET)
-				{
-					// call the thread with a time_t value
-					std::thread thread(Timer.CBT, ToTimeT(now));
-					thread.detach();
-				}
-				else
-				{
-					// call the thread with a time_point value
-					std::thread thread(Timer.CB, now);
-					thread.detach();
-				}
-				if ((Timer.Flags & ONCE) == ONCE)
-				{
-					// remove this timer
-					Timers->erase(Timer.ID);
-				}
-				else
-				{
-					// calculate next expiration
-					Timer.ExpiresAt = now + Timer.IVal;
-				}
-			}
+			// skip the ticks without events
+			m_iCurrentTick = std::min(GetNextEventTick(), iNow) - 1;
+			ProcessTick();
 		}
+
+		m_iWakeUpTick = m_Timers.empty() ? m_iCurrentTick + 1 : GetNextEventTick();
+		m_WakeUp.wait_until(Lock, m_tStart + m_Granularity * static_cast<Interval::rep>(m_iWakeUpTick));
 	}
 
 } // TimingLoop
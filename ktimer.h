@@ -49,6 +49,9 @@
 #include <atomic>
 #include <unordered_map>
 #include <mutex>
+#include <condition_variable>
+#include <array>
+#include <list>
 #include "bits/kcppcompat.h"
 #include "kthreadsafe.h"
 
@@ -57,12 +60,16 @@
 
 namespace dekaf2 {
 
+class KThreadPool;
+
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 /// KTimer can be used to call functions both repeatedly after a fixed
 /// time interval or once after expiration of a time interval, or at
-/// a fixed time point. Granularity is low (1 second), it is intended for
-/// cleanup purposes or similar repetitive tasks, not high precision
-/// timing.
+/// a fixed time point. The granularity is set at construction (default
+/// 1 second) and may go down to microseconds. Timers are kept in a
+/// hierarchical timing wheel, so that adding and cancelling a timer is
+/// O(1), also with many thousands of timers. Expired callbacks are run
+/// in a thread pool, not in the timer thread.
 class DEKAF2_PUBLIC KTimer
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 {
@@ -81,7 +88,18 @@ public:
 	static constexpr ID_t INVALID { 0 };
 
 	//---------------------------------------------------------------------------
-	KTimer(Interval Granularity = std::chrono::seconds(1));
+	/// construct a timer with its own thread pool to run the callbacks
+	/// @param Granularity the tick of the timing wheel - timers fire at the first tick at or after their expiration
+	/// @param iDispatchThreads count of threads that run the callbacks
+	KTimer(Interval Granularity = std::chrono::seconds(1), std::size_t iDispatchThreads = 2);
+	//---------------------------------------------------------------------------
+
+	//---------------------------------------------------------------------------
+	/// construct a timer that runs the callbacks in an existing thread pool, which
+	/// has to outlive the timer
+	/// @param Granularity the tick of the timing wheel - timers fire at the first tick at or after their expiration
+	/// @param DispatchPool the thread pool that runs the callbacks
+	KTimer(Interval Granularity, KThreadPool& DispatchPool);
 	//---------------------------------------------------------------------------
 
 	//---------------------------------------------------------------------------
@@ -105,7 +123,7 @@ public:
 	//---------------------------------------------------------------------------
 
 	//---------------------------------------------------------------------------
-	/// nonblocking: calls cb every interval in a separate thread.
+	/// nonblocking: calls cb every interval in the dispatch thread pool.
 	/// A return other than INVALID is a handle that can be used
 	/// to remove the callback (cancel the timer)
 	ID_t CallEvery(Interval intv, Callback CB);
@@ -129,7 +147,7 @@ public:
 	//---------------------------------------------------------------------------
 
 	//---------------------------------------------------------------------------
-	/// nonblocking: calls cb every interval in a separate thread
+	/// nonblocking: calls cb every interval in the dispatch thread pool
 	/// A return other than INVALID is a handle that can be used
 	/// to remove the callback (cancel the timer)
 	ID_t CallEvery(time_t intv, CallbackTimeT CBT);
@@ -256,7 +274,8 @@ public:
 	}
 
 	//---------------------------------------------------------------------------
-	/// If called, the KTimer object will wait for its timer thread to terminate before leaving the constructor
+	/// If called, the KTimer object will also run callbacks that are already queued in its own thread pool
+	/// before leaving the destructor - otherwise they are dropped, and only running callbacks are waited for
 	void DestructWithJoin()
 	//---------------------------------------------------------------------------
 	{
@@ -289,7 +308,7 @@ private:
 
 	//---------------------------------------------------------------------------
 	DEKAF2_PRIVATE
-	void TimingLoop(Interval Granularity);
+	void TimingLoop();
 	//---------------------------------------------------------------------------
 
 	struct Timer;
@@ -301,12 +320,33 @@ private:
 
 	//---------------------------------------------------------------------------
 	DEKAF2_PRIVATE
-	static void StartCallback();
+	static ID_t GetNextID();
+	//---------------------------------------------------------------------------
+
+	//---------------------------------------------------------------------------
+	/// the tick count of the steady clock at this moment
+	DEKAF2_PRIVATE
+	uint64_t GetCurrentTick() const;
 	//---------------------------------------------------------------------------
 
 	//---------------------------------------------------------------------------
+	/// the first tick at or after the time point
 	DEKAF2_PRIVATE
-	static ID_t GetNextID();
+	uint64_t ToTick(Timepoint tp) const;
+	//---------------------------------------------------------------------------
+
+	//---------------------------------------------------------------------------
+	/// the next tick at which a timer expires or a slot cascades - ticks in between
+	/// need no processing - needs the lock
+	DEKAF2_PRIVATE
+	uint64_t GetNextEventTick() const;
+	//---------------------------------------------------------------------------
+
+	//---------------------------------------------------------------------------
+	/// advance the wheel by one tick, cascade timers from the upper levels and
+	/// dispatch the expired ones - needs the lock
+	DEKAF2_PRIVATE
+	void ProcessTick();
 	//---------------------------------------------------------------------------
 
 	enum FLAGS
@@ -320,20 +360,46 @@ private:
 	struct Timer
 	//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 	{
-		ID_t          ID    { INVALID          };
-		Timepoint     ExpiresAt;
-		Interval      IVal  { Interval::zero() };
-		Callback      CB    { nullptr          };
-		CallbackTimeT CBT   { nullptr          };
-		uint8_t       Flags { NONE             };
+		ID_t               ID    { INVALID          };
+		Timepoint          ExpiresAt;
+		Interval           IVal  { Interval::zero() };
+		Callback           CB    { nullptr          };
+		CallbackTimeT      CBT   { nullptr          };
+		uint8_t            Flags { NONE             };
+		uint64_t           iTick { 0                }; // the expiration tick
+		std::list<Timer>*  pSlot { nullptr          }; // the wheel slot this timer is in
 	};
 
-	std::shared_ptr<std::thread>       m_tTiming;
-	std::shared_ptr<std::atomic<bool>> m_bShutdown;
-	bool                               m_bDestructWithJoin { false };
+	using Slot = std::list<Timer>;
 
-	using map_t = std::unordered_map<ID_t, Timer>;
-	KThreadSafe<map_t>                 m_Timers;
+	//---------------------------------------------------------------------------
+	/// move a timer into the wheel slot for its expiration tick - needs the lock
+	DEKAF2_PRIVATE
+	void Schedule(Slot& From, Slot::iterator it);
+	//---------------------------------------------------------------------------
+
+	// 4 levels with 256 slots each cover 2^32 ticks - timers further away are
+	// parked in the top level and scheduled again when that slot cascades
+	static constexpr std::size_t iLevelBits = 8;
+	static constexpr std::size_t iSlots     = 1 << iLevelBits;
+	static constexpr std::size_t iLevels    = 4;
+
+	using Wheel = std::array<std::array<Slot, iSlots>, iLevels>;
+
+	std::chrono::steady_clock::time_point     m_tStart;
+	Interval                                  m_Granularity;
+	std::size_t                               m_iDispatchThreads { 0 };
+	std::unique_ptr<KThreadPool>              m_OwnPool;
+	KThreadPool*                              m_DispatchPool { nullptr };
+	std::unique_ptr<std::thread>              m_tTiming;
+	std::mutex                                m_Mutex;
+	std::condition_variable                   m_WakeUp;
+	Wheel                                     m_Wheel;
+	std::unordered_map<ID_t, Slot::iterator>  m_Timers;
+	uint64_t                                  m_iCurrentTick { 0 };
+	uint64_t                                  m_iWakeUpTick { 0 };
+	bool                                      m_bShutdown { false };
+	bool                                      m_bDestructWithJoin { false };
 
 }; // KTimer
 
@@ -43,6 +43,17 @@
 #include "khttperror.h"
 #include "kduration.h"
 #include "kstringutils.h"
+#include "kstreambuf.h"
+#include "kwriter.h"
+#include "kfilesystem.h"
+#include "kparallel.h"
+#include <vector>
+#include <mutex>
+#ifndef DEKAF2_IS_WINDOWS
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <cerrno>
+#endif
 
 namespace dekaf2 {
 
@@ -131,6 +142,10 @@ bool KWebClient::HttpRequest (KOutStream& OutStream, KURL HostURL, KURL RequestU
 		{
 			ConnectTime.halt();
 
+			// a connection borrowed from the connection pool may as well
+			// have been closed by the other end in the meantime
+			bReuseConnection = bReuseConnection || ConnectedFromPool();
+
 			if (Resource(RequestURL, RequestMethod))
 			{
 				if (m_bAcceptCookies)
@@ -319,6 +334,248 @@ KString KWebClient::HttpRequest (KURL URL, KHTTPMethod RequestMethod/* = KHTTPMe
 
 } // HttpRequest
 
+//-----------------------------------------------------------------------------
+bool KWebClient::Download(KURL URL, KStringViewZ sOutfile, uint16_t iParallel, std::size_t iMinPartSize)
+//-----------------------------------------------------------------------------
+{
+#ifndef DEKAF2_IS_WINDOWS
+	// the parts need their own copy of the authenticator
+	if (iParallel > 1 && (!GetAuthenticator() || GetAuthenticator()->Clone()))
+	{
+		iMinPartSize = std::max<std::size_t>(iMinPartSize, 1);
+
+		// check if the server supports byte ranges, and get the content size
+		if (Head(URL))
+		{
+			auto iSize     = Response.ContentLength();
+			bool bRanges   = Response.Headers.Get(KHTTPHeader::ACCEPT_RANGES).ToLowerASCII().contains("bytes");
+			// ranges apply to the encoded content
+			bool bEncoded  = !Response.Headers.Get(KHTTPHeader::CONTENT_ENCODING).empty();
+			// the validator makes sure that all ranges come from the same version
+			// of the content - weak etags are not allowed for If-Range
+			KString sValidator = Response.Headers.Get(KHTTPHeader::ETAG);
+
+			if (sValidator.empty() || sValidator.starts_with("W/"))
+			{
+				sValidator = Response.Headers.Get(KHTTPHeader::LAST_MODIFIED);
+			}
+
+			if (bRanges && !bEncoded && !sValidator.empty() && iSize > 0 && static_cast<std::size_t>(iSize) >= 2 * iMinPartSize)
+			{
+				if (DownloadRanges(URL, sOutfile, iSize, iParallel, iMinPartSize, sValidator))
+				{
+					return true;
+				}
+
+				// a failed part may have many reasons, like a server that limits the
+				// connections per client, or a content that changed meanwhile
+				kDebug(1, "parallel download failed, retrying with a single stream");
+			}
+
+			kDebug(2, "no parallel download: ranges: {}, encoded: {}, validator: {}, size: {}", bRanges, bEncoded, sValidator, iSize);
+		}
+	}
+#endif
+
+	KOutFile File(sOutfile);
+
+	if (!File.is_open())
+	{
+		return SetError(kFormat("cannot open file: {}", sOutfile));
+	}
+
+	HttpRequest(File, std::move(URL), KHTTPMethod::GET, {}, {});
+
+	return HttpSuccess();
+
+} // Download
+
+#ifndef DEKAF2_IS_WINDOWS
+
+namespace {
+
+//-----------------------------------------------------------------------------
+/// the target of one byte range
+struct FileRange
+//-----------------------------------------------------------------------------
+{
+	int         fd         { -1 };
+	off_t       iOffset    { 0 };
+	std::size_t iRemaining { 0 };
+	bool        bError     { false };
+};
+
+//-----------------------------------------------------------------------------
+/// KOutStreamBuf writer that writes at the current position of a FileRange
+std::streamsize FileRangeWriter(const void* sBuffer, std::streamsize iCount, void* CustomPointer)
+//-----------------------------------------------------------------------------
+{
+	auto& Range = *static_cast<FileRange*>(CustomPointer);
+
+	if (static_cast<std::size_t>(iCount) > Range.iRemaining)
+	{
+		// the server sent more than we asked for
+		Range.bError = true;
+		iCount = Range.iRemaining;
+	}
+
+	std::streamsize iWritten { 0 };
+
+	while (iWritten < iCount)
+	{
+		auto iResult = ::pwrite(Range.fd, static_cast<const char*>(sBuffer) + iWritten, iCount - iWritten, Range.iOffset);
+
+		if (iResult < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			Range.bError = true;
+			break;
+		}
+
+		iWritten         += iResult;
+		Range.iOffset    += iResult;
+		Range.iRemaining -= iResult;
+	}
+
+	return iWritten;
+
+} // FileRangeWriter
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+bool KWebClient::DownloadRanges(const KURL& URL, KStringViewZ sOutfile, std::size_t iSize, uint16_t iParallel, std::size_t iMinPartSize, KStringView sValidator)
+//-----------------------------------------------------------------------------
+{
+	int fd = ::open(sOutfile.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, DEKAF2_MODE_CREATE_FILE);
+
+	if (fd < 0)
+	{
+		return SetError(kFormat("cannot open file: {}: {}", sOutfile, strerror(errno)));
+	}
+
+	// preallocate the file, so that the ranges can be written in any order
+#ifdef DEKAF2_IS_OSX
+	int iError = ::ftruncate(fd, iSize) ? errno : 0;
+#else
+	int iError = ::posix_fallocate(fd, 0, iSize);
+#endif
+
+	if (iError)
+	{
+		::close(fd);
+		kRemoveFile(sOutfile);
+		return SetError(kFormat("cannot allocate {} bytes for file: {}: {}", iSize, sOutfile, strerror(iError)));
+	}
+
+	std::size_t iParts    = std::min<std::size_t>(iParallel, iSize / iMinPartSize);
+	std::size_t iPartSize = iSize / iParts;
+
+	std::vector<FileRange> Ranges(iParts);
+
+	for (std::size_t i = 0; i < iParts; ++i)
+	{
+		Ranges[i].fd         = fd;
+		Ranges[i].iOffset    = i * iPartSize;
+		Ranges[i].iRemaining = (i + 1 == iParts) ? iSize - i * iPartSize : iPartSize;
+	}
+
+	kDebug(2, "downloading {} bytes in {} ranges from {}", iSize, iParts, URL.Serialize());
+
+	std::mutex ErrorMutex;
+	KString    sError;
+
+	{
+		KRunThreads Threads;
+
+		for (auto& Range : Ranges)
+		{
+			Threads.CreateOne([&](FileRange& Range)
+			{
+				auto iFirst = Range.iOffset;
+				auto iLast  = Range.iOffset + Range.iRemaining - 1;
+
+				KWebClient Part(GetVerifyCerts());
+				Part.SetTimeout(GetTimeout());
+				Part.UseConnectionPool(GetConnectionPool());
+				Part.AllowRedirects(m_iMaxRedirects);
+				Part.AcceptCookies(m_bAcceptCookies);
+				Part.m_Cookies = m_Cookies;
+
+				if (GetAuthenticator())
+				{
+					Part.Authentication(GetAuthenticator()->Clone());
+				}
+
+				// copy the headers set by the caller, but not those that are set per request
+				for (const auto& Header : Request.Headers)
+				{
+					if (Header.first != KHTTPHeader::HOST              &&
+					    Header.first != KHTTPHeader::COOKIE            &&
+					    Header.first != KHTTPHeader::AUTHORIZATION     &&
+					    Header.first != KHTTPHeader::CONTENT_LENGTH    &&
+					    Header.first != KHTTPHeader::CONTENT_TYPE      &&
+					    Header.first != KHTTPHeader::TRANSFER_ENCODING &&
+					    Header.first != KHTTPHeader::PROXY_CONNECTION  &&
+					    Header.first != KHTTPHeader::ACCEPT_ENCODING)
+					{
+						Part.AddHeader(Header.first, Header.second);
+					}
+				}
+
+				// we need the unencoded content for the ranges
+				Part.RequestCompression(false);
+				Part.AddHeader(KHTTPHeader::RANGE, kFormat("bytes={}-{}", iFirst, iLast));
+				// if the content changed since the HEAD request, the server answers
+				// with the full content and status 200, which fails the download
+				Part.AddHeader(KHTTPHeader::IF_RANGE, sValidator);
+
+				KOutStreamBuf StreamBuf(&FileRangeWriter, &Range);
+				std::ostream ostream(&StreamBuf);
+				KOutStream Out(ostream);
+
+				Part.HttpRequest(Out, URL, KHTTPMethod::GET, {}, {});
+
+				if (Part.GetStatusCode() != KHTTPError::H2xx_PARTIAL_CONTENT || Range.bError || Range.iRemaining)
+				{
+					std::lock_guard<std::mutex> Lock(ErrorMutex);
+
+					if (sError.empty())
+					{
+						sError = kFormat("range {}-{} failed with HTTP-{}: {}", iFirst, iLast, Part.GetStatusCode(), Part.Error());
+					}
+				}
+
+			}, std::ref(Range));
+		}
+
+		// the threads join at destruction of KRunThreads
+	}
+
+	if (::close(fd) && sError.empty())
+	{
+		sError = kFormat("cannot close file: {}: {}", sOutfile, strerror(errno));
+	}
+
+	if (!sError.empty())
+	{
+		// the preallocated file has the full size, with gaps for the failed
+		// ranges - do not leave it behind looking like a complete download
+		kRemoveFile(sOutfile);
+		kDebug(1, sError);
+		return SetError(std::move(sError));
+	}
+
+	return true;
+
+} // DownloadRanges
+
+#endif // DEKAF2_IS_WINDOWS
+
 //-----------------------------------------------------------------------------
 KString kHTTPGet(KURL URL)
 //-----------------------------------------------------------------------------
@@ -161,6 +161,22 @@ public:
 		return HttpRequest (std::move(URL), KHTTPMethod::PATCH, svRequestBody, MIME);
 	}
 
+	//-----------------------------------------------------------------------------
+	/// Download URL into a file. If the server accepts byte range requests, sends an
+	/// ETag or Last-Modified header, and the content is at least twice the minimum part
+	/// size, the file is preallocated and the content is fetched with up to iParallel
+	/// concurrent range requests, each writing directly at its offset in the file. The
+	/// range requests carry the headers, cookies and authentication of this client.
+	/// Otherwise, or if one of the ranges fails, the content is fetched with one single
+	/// request.
+	/// @param URL the URL to download
+	/// @param sOutfile the file to write into - will be overwritten
+	/// @param iParallel the maximum count of concurrent range requests
+	/// @param iMinPartSize the minimum size of one range, at least 1
+	/// @return true on success
+	bool Download(KURL URL, KStringViewZ sOutfile, uint16_t iParallel = 4, std::size_t iMinPartSize = 1024 * 1024);
+	//-----------------------------------------------------------------------------
+
 	//-----------------------------------------------------------------------------
 	/// Set count of allowed redirects (default 3, 0 disables)
 	self& AllowRedirects(uint16_t iMaxRedirects = 3)
@@ -221,6 +237,12 @@ public:
 protected:
 //------
 
+	//-----------------------------------------------------------------------------
+	/// download iSize bytes of URL with concurrent range requests into sOutfile
+	DEKAF2_PRIVATE
+	bool DownloadRanges(const KURL& URL, KStringViewZ sOutfile, std::size_t iSize, uint16_t iParallel, std::size_t iMinPartSize, KStringView sValidator);
+	//-----------------------------------------------------------------------------
+
 	KCookies         m_Cookies;
 	TimingCallback_t m_TimingCallback { nullptr };
 	KDuration        m_iWarnIfOverMilliseconds { 0 };
@@ -0,0 +1,103 @@
+#include "catch.hpp"
+
+#include <dekaf2/bits/kasioconnect.h>
+#include <dekaf2/kduration.h>
+
+#ifndef DEKAF2_IS_WINDOWS
+
+using namespace dekaf2;
+
+TEST_CASE("KAsioConnect")
+{
+	using tcp = boost::asio::ip::tcp;
+
+	boost::asio::io_service IOService;
+
+	// a listening socket on an ephemeral port of the loopback interface
+	tcp::acceptor Acceptor(IOService, tcp::endpoint(boost::asio::ip::address::from_string("127.0.0.1"), 0));
+	auto iPort = Acceptor.local_endpoint().port();
+
+	// a port on the loopback interface where nobody listens
+	tcp::acceptor Closed(IOService, tcp::endpoint(boost::asio::ip::address::from_string("127.0.0.1"), 0));
+	auto iClosedPort = Closed.local_endpoint().port();
+	Closed.close();
+
+	SECTION("single")
+	{
+		tcp::socket Socket(IOService);
+		boost::system::error_code ec;
+
+		auto Connected = detail::kAsioConnect(IOService, Socket, { tcp::endpoint(boost::asio::ip::address::from_string("127.0.0.1"), iPort) }, chrono::seconds(2), ec);
+
+		CHECK ( !ec );
+		CHECK ( Socket.is_open() );
+		CHECK ( Connected.port() == iPort );
+	}
+
+	SECTION("failing first")
+	{
+		tcp::socket Socket(IOService);
+		boost::system::error_code ec;
+
+		std::vector<tcp::endpoint> Endpoints;
+		Endpoints.push_back(tcp::endpoint(boost::asio::ip::address::from_string("127.0.0.1"), iClosedPort));
+		Endpoints.push_back(tcp::endpoint(boost::asio::ip::address::from_string("127.0.0.1"), iPort));
+
+		KStopTime Timer;
+		auto Connected = detail::kAsioConnect(IOService, Socket, Endpoints, chrono::seconds(2), ec, chrono::seconds(1));
+
+		CHECK ( !ec );
+		CHECK ( Socket.is_open() );
+		CHECK ( Connected.port() == iPort );
+		// a refused connection has to trigger the next attempt immediately
+		CHECK ( Timer.elapsed() < chrono::milliseconds(900) );
+	}
+
+	SECTION("blackholed first")
+	{
+		tcp::socket Socket(IOService);
+		boost::system::error_code ec;
+
+		// 192.0.2.0/24 is reserved for documentation and should never answer
+		std::vector<tcp::endpoint> Endpoints;
+		Endpoints.push_back(tcp::endpoint(boost::asio::ip::address::from_string("192.0.2.1"), iPort));
+		Endpoints.push_back(tcp::endpoint(boost::asio::ip::address::from_string("127.0.0.1"), iPort));
+
+		KStopTime Timer;
+		auto Connected = detail::kAsioConnect(IOService, Socket, Endpoints, chrono::seconds(5), ec, chrono::milliseconds(100));
+
+		CHECK ( !ec );
+		CHECK ( Socket.is_open() );
+		CHECK ( Connected.address().to_string() == "127.0.0.1" );
+		CHECK ( Timer.elapsed() < chrono::seconds(2) );
+	}
+
+	SECTION("all failing")
+	{
+		tcp::socket Socket(IOService);
+		boost::system::error_code ec;
+
+		auto Connected = detail::kAsioConnect(IOService, Socket, { tcp::endpoint(boost::asio::ip::address::from_string("127.0.0.1"), iClosedPort) }, chrono::seconds(2), ec);
+
+		CHECK ( ec );
+		CHECK ( !Socket.is_open() );
+
+		ec.clear();
+		Connected = detail::kAsioConnect(IOService, Socket, {}, chrono::seconds(2), ec);
+		CHECK ( ec );
+	}
+
+	SECTION("timeout")
+	{
+		tcp::socket Socket(IOService);
+		boost::system::error_code ec;
+
+		KStopTime Timer;
+		detail::kAsioConnect(IOService, Socket, { tcp::endpoint(boost::asio::ip::address::from_string("192.0.2.1"), iPort) }, chrono::milliseconds(300), ec);
+
+		CHECK ( ec );
+		CHECK ( Timer.elapsed() < chrono::seconds(2) );
+	}
+}
+
+#endif // of DEKAF2_IS_WINDOWS
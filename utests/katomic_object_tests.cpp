@@ -0,0 +1,152 @@
+#include "catch.hpp"
+
+#include <dekaf2/katomic_object.h>
+#include <dekaf2/kstring.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace dekaf2;
+
+namespace {
+
+std::atomic<int> iLiveObjects { 0 };
+
+struct Versioned
+{
+	Versioned(std::size_t iVersion = 0)
+	: Values(64, iVersion)
+	{
+		++iLiveObjects;
+	}
+
+	~Versioned()
+	{
+		// make use after free visible
+		std::fill(Values.begin(), Values.end(), std::size_t(-1));
+		--iLiveObjects;
+	}
+
+	bool IsConsistent() const
+	{
+		return std::all_of(Values.begin(), Values.end(), [this](std::size_t i) { return i == Values.front(); })
+		    && Values.front() != std::size_t(-1);
+	}
+
+	std::vector<std::size_t> Values;
+};
+
+} // end of anonymous namespace
+
+TEST_CASE("KAtomicObject")
+{
+	SECTION("basics")
+	{
+		KAtomicObject<KString> String("hello");
+
+		CHECK ( String.getRef() == "hello" );
+		CHECK ( *String.get() == "hello" );
+		CHECK ( *String.read() == "hello" );
+		CHECK ( String.read()->size() == 5 );
+
+		String.reset("world");
+		CHECK ( String.getRef() == "world" );
+		CHECK ( *String.read() == "world" );
+
+		String.reset();
+		CHECK ( String.read()->empty() );
+	}
+
+	SECTION("read guards")
+	{
+		detail::KEpochReclaimer::Collect();
+		iLiveObjects = 0;
+
+		{
+			KAtomicObject<Versioned> Object(1);
+			CHECK ( iLiveObjects == 1 );
+
+			{
+				auto Guard = Object.read();
+
+				for (std::size_t i = 2; i < 10; ++i)
+				{
+					Object.reset(i);
+				}
+
+				// all versions retired while the guard is held wait for it
+				CHECK ( iLiveObjects == 9 );
+				CHECK ( detail::KEpochReclaimer::Pending() == 7 );
+				CHECK ( Guard->Values.front() == 1 );
+				CHECK ( Guard->IsConsistent() );
+
+				// nested guards
+				auto Guard2 = Object.read();
+				CHECK ( Guard2->Values.front() == 9 );
+			}
+
+			// leaving does not always collect
+			CHECK ( detail::KEpochReclaimer::Collect() == 0 );
+			CHECK ( iLiveObjects == 2 );
+
+			// without readers, replaced objects are deleted by the next but one reset
+			Object.reset(10);
+			Object.reset(11);
+			CHECK ( iLiveObjects == 2 );
+		}
+
+		CHECK ( iLiveObjects == 0 );
+	}
+
+	SECTION("concurrent updates")
+	{
+		detail::KEpochReclaimer::Collect();
+		iLiveObjects = 0;
+
+		{
+			KAtomicObject<Versioned> Object(1);
+			std::atomic<bool> bStop { false };
+			std::atomic<std::size_t> iInconsistent { 0 };
+			std::atomic<std::size_t> iReads { 0 };
+			std::vector<std::thread> Readers;
+
+			for (int t = 0; t < 3; ++t)
+			{
+				Readers.emplace_back([&]()
+				{
+					while (!bStop)
+					{
+						auto Guard = Object.read();
+
+						if (!Guard->IsConsistent())
+						{
+							++iInconsistent;
+						}
+
+						++iReads;
+					}
+				});
+			}
+
+			for (std::size_t i = 2; i < 20000; ++i)
+			{
+				Object.reset(i);
+			}
+
+			bStop = true;
+
+			for (auto& Reader : Readers)
+			{
+				Reader.join();
+			}
+
+			CHECK ( iInconsistent == 0 );
+			CHECK ( iReads > 0 );
+			CHECK ( detail::KEpochReclaimer::Collect() == 0 );
+			CHECK ( iLiveObjects == 2 );
+		}
+
+		CHECK ( iLiveObjects == 0 );
+	}
+}
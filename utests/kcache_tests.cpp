@@ -206,3 +206,586 @@ TEST_CASE("KSharedCache")
 		MyCache.clear();
 	}
 }
+
+TEST_CASE("KShardedCache")
+{
+	SECTION("Growth")
+	{
+		KShardedCache<KString, KString, Loader> MyCache;
+
+		auto iOrigSize = MyCache.GetMaxSize();
+		MyCache.clear();
+		MyCache.SetMaxSize(3);
+
+		CHECK ( MyCache.size() == 0 );
+		CHECK ( *MyCache.Get("abcdefg") == "gfedcba"  );
+		CHECK ( *MyCache.Get("abccefg") == "gfeccba"  );
+		CHECK ( *MyCache.Get("bbcdefg") == "gfedcbb"  );
+		CHECK ( *MyCache.Get("abcdefg") == "gfedcba"  );
+		CHECK ( *MyCache.Get("1234567") == "7654321"  );
+		CHECK ( MyCache.size() == 3 );
+		MyCache.SetMaxSize(5);
+		CHECK ( *MyCache.Get("abccefg") == "gfeccba"  );
+		CHECK ( *MyCache.Get("7654321") == "1234567"  );
+		CHECK ( MyCache.size() == 4 );
+		CHECK ( *MyCache.Find("7654321") == "1234567"  );
+		CHECK ( MyCache.Erase(KString("7654321")) == true  );
+		CHECK ( MyCache.Erase(KString("7654321")) == false );
+		CHECK ( MyCache.Find("7654321")->empty() );
+		CHECK ( MyCache.size() == 3 );
+
+		MyCache.SetMaxSize(iOrigSize);
+		MyCache.clear();
+		CHECK ( MyCache.size() == 0 );
+		CHECK ( MyCache.empty() == true );
+	}
+
+	SECTION("Shrink")
+	{
+		KShardedCache<KString, KString, Loader> MyCache(3);
+
+		CHECK ( MyCache.size() == 0 );
+		CHECK ( *MyCache.Get("abcdefg") == "gfedcba"  );
+		CHECK ( *MyCache.Get("abccefg") == "gfeccba"  );
+		CHECK ( *MyCache.Get("bbcdefg") == "gfedcbb"  );
+		CHECK ( MyCache.size() == 3 );
+		MyCache.SetMaxSize(2);
+		CHECK ( MyCache.size() == 2 );
+		CHECK ( *MyCache.Get("1234567") == "7654321"  );
+		CHECK ( MyCache.size() == 2 );
+		MyCache.SetMaxSize(0);
+		CHECK ( MyCache.empty() );
+	}
+
+	SECTION("CLOCK")
+	{
+		// with one shard the eviction order is deterministic
+		KShardedCache<KString, KString, Loader> MyCache(3, 1);
+
+		CHECK ( MyCache.Shards() == 1 );
+		MyCache.Get("a");
+		MyCache.Get("b");
+		MyCache.Get("c");
+		// a gets a second chance
+		MyCache.Find("a");
+		MyCache.Get("d");
+		CHECK ( MyCache.size() == 3 );
+		CHECK ( *MyCache.Find("a") == "a" );
+		CHECK (  MyCache.Find("b")->empty() );
+		CHECK ( *MyCache.Find("c") == "c" );
+		CHECK ( *MyCache.Find("d") == "d" );
+		// all referenced now: the hand clears all bits and evicts where it started
+		MyCache.Get("e");
+		CHECK ( MyCache.size() == 3 );
+		CHECK ( MyCache.Find("c")->empty() );
+
+		KShardedCache<KString, KString, Loader> Other(100, 5);
+		CHECK ( Other.Shards() == 8 );
+		CHECK ( *Other.Set("key", "value") == "value" );
+		// existing keys are not replaced
+		CHECK ( *Other.Set("key", "other") == "value" );
+		CHECK ( *Other.Get("key") == "value" );
+		CHECK ( Other.size() == 1 );
+	}
+
+	SECTION("MT with overflow")
+	{
+		KShardedCache<KString, KString, Loader> MyCache(50);
+
+		std::atomic<uint32_t> iErrors { 0 };
+
+		KRunThreads(20).Create([&iErrors,&MyCache]()
+		{
+			for (int i = 0; i < 2000; ++i)
+			{
+				auto sKey = kFormat("key{}", i % 200);
+				auto sValue = sKey;
+				std::reverse(sValue.begin(), sValue.end());
+
+				if (*MyCache.Get(sKey) != sValue) { ++iErrors; }
+			}
+		});
+
+		CHECK ( iErrors == 0 );
+		CHECK ( MyCache.size() == 50 );
+
+		MyCache.clear();
+		CHECK ( MyCache.empty() );
+	}
+}
+
+namespace {
+
+template<class Policy>
+void PolicyBasics()
+{
+	KCache<KString, KString, Loader, Policy> MyCache(3);
+
+	CHECK ( MyCache.size() == 0 );
+	CHECK ( MyCache.Get("abcdefg") == "gfedcba"  );
+	CHECK ( MyCache.Get("abccefg") == "gfeccba"  );
+	CHECK ( MyCache.Get("bbcdefg") == "gfedcbb"  );
+	CHECK ( MyCache.Get("abcdefg") == "gfedcba"  );
+	CHECK ( MyCache.Get("1234567") == "7654321"  );
+	CHECK ( MyCache.size() == 3 );
+	CHECK ( MyCache.Find("1234567") != nullptr );
+	CHECK ( MyCache.Erase("1234567") == true  );
+	CHECK ( MyCache.Erase("1234567") == false );
+	CHECK ( MyCache.Find("1234567") == nullptr );
+	CHECK ( MyCache.size() == 2 );
+	MyCache.SetMaxSize(200);
+
+	for (int i = 0; i < 1000; ++i)
+	{
+		auto sKey = kFormat("{}", i);
+		auto sValue = sKey;
+		std::reverse(sValue.begin(), sValue.end());
+		CHECK ( MyCache.Get(sKey) == sValue );
+	}
+
+	CHECK ( MyCache.size() == 200 );
+	MyCache.SetMaxSize(1);
+	CHECK ( MyCache.size() == 1 );
+	MyCache.clear();
+	CHECK ( MyCache.empty() );
+	CHECK ( MyCache.Get("abcdefg") == "gfedcba"  );
+	CHECK ( MyCache.size() == 1 );
+}
+
+template<class Policy>
+std::size_t HotKeysAfterScan()
+{
+	KCache<KString, KString, Loader, Policy> MyCache(100);
+
+	// 50 hot keys, accessed repeatedly
+	for (int iRound = 0; iRound < 5; ++iRound)
+	{
+		for (int i = 0; i < 50; ++i)
+		{
+			MyCache.Get(kFormat("hot{}", i));
+		}
+	}
+
+	// a scan of keys that are accessed only once
+	for (int i = 0; i < 1000; ++i)
+	{
+		MyCache.Get(kFormat("scan{}", i));
+	}
+
+	std::size_t iHot { 0 };
+
+	for (int i = 0; i < 50; ++i)
+	{
+		if (MyCache.Find(kFormat("hot{}", i)))
+		{
+			++iHot;
+		}
+	}
+
+	return iHot;
+}
+
+} // end of anonymous namespace
+
+TEST_CASE("KCache policies")
+{
+	SECTION("basics")
+	{
+		PolicyBasics<KLRUPolicy>();
+		PolicyBasics<KClockPolicy>();
+		PolicyBasics<KSievePolicy>();
+		PolicyBasics<KTinyLFUPolicy>();
+	}
+
+	SECTION("SIEVE order")
+	{
+		KCache<KString, KString, Loader, KSievePolicy> MyCache(3);
+
+		MyCache.Get("a");
+		MyCache.Get("b");
+		MyCache.Get("c");
+		// the hand starts at the oldest element, a, which gets a second chance
+		MyCache.Find("a");
+		MyCache.Get("d");
+		CHECK ( MyCache.Find("a") != nullptr );
+		CHECK ( MyCache.Find("b") == nullptr );
+		CHECK ( MyCache.Find("c") != nullptr );
+		CHECK ( MyCache.Find("d") != nullptr );
+		// all accessed: the hand continues at c, clears all bits, and stops at c
+		MyCache.Get("e");
+		CHECK ( MyCache.Find("c") == nullptr );
+		CHECK ( MyCache.size() == 3 );
+	}
+
+	SECTION("scan resistance")
+	{
+		CHECK ( HotKeysAfterScan<KLRUPolicy>()     ==  0 );
+		CHECK ( HotKeysAfterScan<KTinyLFUPolicy>() >= 45 );
+	}
+
+	SECTION("shared")
+	{
+		KSharedCache<KString, KString, Loader, KTinyLFUPolicy> MyCache(10);
+
+		std::atomic<uint32_t> iErrors { 0 };
+
+		KRunThreads(20).Create([&iErrors,&MyCache]()
+		{
+			for (int i = 0; i < 500; ++i)
+			{
+				if (*MyCache.Get("abcdefg") != "gfedcba") { ++iErrors; }
+				auto sKey = kFormat("{}", i);
+				auto sValue = sKey;
+				std::reverse(sValue.begin(), sValue.end());
+
+				if (*MyCache.Get(sKey) != sValue) { ++iErrors; }
+			}
+		});
+
+		CHECK ( iErrors == 0 );
+		CHECK ( MyCache.size() == 10 );
+	}
+}
+
+TEST_CASE("KCache expiry and cost")
+{
+	SECTION("time to live")
+	{
+		// the checks before the sleep have to run within the time to live
+		KCache<KString, KString, Loader> MyCache(10, chrono::milliseconds(500));
+
+		CHECK ( MyCache.GetTimeToLive() == chrono::milliseconds(500) );
+		MyCache.Set("abc", "value");
+		MyCache.Set("forever", "value", chrono::hours(1));
+		CHECK ( MyCache.Get("abc") == "value" );
+		CHECK ( MyCache.Find("abc") != nullptr );
+		CHECK ( MyCache.size() == 2 );
+
+		kMilliSleep(600);
+
+		// lazy expiry on access
+		CHECK ( MyCache.size() == 2 );
+		CHECK ( MyCache.Find("abc") == nullptr );
+		CHECK ( MyCache.size() == 1 );
+		// and reload
+		CHECK ( MyCache.Get("abc") == "cba" );
+		CHECK ( MyCache.Get("forever") == "value" );
+
+		MyCache.Set("short1", "value");
+		MyCache.Set("short2", "value");
+		kMilliSleep(600);
+		CHECK ( MyCache.EraseExpired() == 3 );
+		CHECK ( MyCache.size() == 1 );
+		CHECK ( MyCache.Find("forever") != nullptr );
+	}
+
+	SECTION("set after expiry")
+	{
+		KCache<KString, KString, Loader> MyCache(10, chrono::milliseconds(500));
+
+		MyCache.Set("abc", "old");
+		kMilliSleep(600);
+
+		// the expired entry is not yet purged, but has to be replaced
+		CHECK ( MyCache.size() == 1 );
+		CHECK ( MyCache.Set("abc", "new") == "new" );
+		auto* pValue = MyCache.Find("abc");
+		CHECK ( pValue != nullptr );
+
+		if (pValue)
+		{
+			CHECK ( *pValue == "new" );
+		}
+
+		CHECK ( MyCache.size() == 1 );
+	}
+
+	SECTION("cost")
+	{
+		KCache<KString, KString, Loader, KSievePolicy> MyCache;
+
+		MyCache.SetCostFunction([](const KString& sKey, const KString& sValue)
+		{
+			return sKey.size() + sValue.size();
+		});
+
+		MyCache.SetMaxCost(100);
+		CHECK ( MyCache.GetMaxCost() == 100 );
+
+		for (int i = 0; i < 10; ++i)
+		{
+			MyCache.Set(kFormat("{:02}", i), KString(28, 'x'));
+		}
+
+		CHECK ( MyCache.size() == 3 );
+		CHECK ( MyCache.GetCost() == 90 );
+		CHECK ( MyCache.Erase("09") );
+		CHECK ( MyCache.GetCost() == 60 );
+		// existing keys are not replaced, and do not count twice
+		MyCache.Set("08", KString(50, 'y'));
+		CHECK ( MyCache.GetCost() == 60 );
+
+		// a single element larger than the limit is kept
+		MyCache.Set("big", KString(200, 'z'));
+		CHECK ( MyCache.size() == 1 );
+		CHECK ( MyCache.GetCost() == 203 );
+		CHECK ( MyCache.Find("big") != nullptr );
+
+		MyCache.Set("small", "");
+		CHECK ( MyCache.size() == 1 );
+		CHECK ( MyCache.GetCost() == 5 );
+
+		MyCache.SetMaxCost(4);
+		CHECK ( MyCache.empty() );
+		CHECK ( MyCache.GetCost() == 0 );
+
+		MyCache.SetMaxCost(0);
+		MyCache.Get("abcdefg");
+		MyCache.Get("1234567");
+		CHECK ( MyCache.GetCost() == 28 );
+		MyCache.clear();
+		CHECK ( MyCache.GetCost() == 0 );
+	}
+
+	SECTION("cost with LRU")
+	{
+		KCache<KString, KString, Loader> MyCache(100);
+
+		MyCache.SetCostFunction([](const KString& sKey, const KString& sValue)
+		{
+			return sValue.size();
+		});
+
+		MyCache.SetMaxCost(30);
+		MyCache.Get("aaaaaaaaaa");
+		MyCache.Get("bbbbbbbbbb");
+		MyCache.Get("cccccccccc");
+		MyCache.Get("aaaaaaaaaa");
+		MyCache.Get("dddddddddd");
+		CHECK ( MyCache.size() == 3 );
+		CHECK ( MyCache.Find("bbbbbbbbbb") == nullptr );
+		CHECK ( MyCache.Find("aaaaaaaaaa") != nullptr );
+		CHECK ( MyCache.GetCost() == 30 );
+		// the count limit also releases the cost
+		MyCache.SetMaxSize(1);
+		CHECK ( MyCache.GetCost() == 10 );
+	}
+
+	SECTION("sweeper")
+	{
+		KSharedCache<KString, KString, Loader> MyCache(10, chrono::milliseconds(20));
+
+		MyCache.SetCostFunction([](const KString& sKey, const KSharedRef<KString, true>& sValue)
+		{
+			return sValue->size();
+		});
+
+		MyCache.Get("abc");
+		MyCache.Get("def");
+		MyCache.Set("ghi", "value", chrono::hours(1));
+		CHECK ( MyCache.size() == 3 );
+		CHECK ( MyCache.GetCost() == 11 );
+
+		MyCache.StartSweeper(chrono::milliseconds(10));
+
+		for (int i = 0; i < 100 && MyCache.size() > 1; ++i)
+		{
+			kMilliSleep(10);
+		}
+
+		MyCache.StopSweeper();
+
+		CHECK ( MyCache.size() == 1 );
+		CHECK ( MyCache.GetCost() == 5 );
+		CHECK ( *MyCache.Get("ghi") == "value" );
+	}
+}
+
+namespace {
+
+std::atomic<int> iSlowLoads { 0 };
+
+struct SlowLoader
+{
+	KString operator()(const KString& sKey)
+	{
+		auto iLoad = ++iSlowLoads;
+		kMilliSleep(100);
+
+		if (sKey == "bad")
+		{
+			throw std::runtime_error("cannot load");
+		}
+
+		return kFormat("{}:{}", sKey, iLoad);
+	}
+};
+
+std::atomic<int>  iGatedLoads   { 0 };
+std::atomic<int>  iRunningLoads { 0 };
+std::atomic<int>  iMaxRunning   { 0 };
+std::atomic<bool> bGateOpen     { true };
+
+// waits until the gate is open, so that the tests do not depend on timing
+struct GatedLoader
+{
+	KString operator()(const KString& sKey)
+	{
+		auto iLoad    = ++iGatedLoads;
+		auto iRunning = ++iRunningLoads;
+
+		for (auto iMax = iMaxRunning.load(); iRunning > iMax && !iMaxRunning.compare_exchange_weak(iMax, iRunning);)
+		{
+		}
+
+		// do not wait forever should a test fail
+		for (int i = 0; i < 1000 && !bGateOpen; ++i)
+		{
+			kMilliSleep(10);
+		}
+
+		--iRunningLoads;
+
+		return kFormat("{}:{}", sKey, iLoad);
+	}
+};
+
+//-----------------------------------------------------------------------------
+template<class Predicate>
+bool WaitFor(Predicate Done)
+//-----------------------------------------------------------------------------
+{
+	for (int i = 0; i < 1000; ++i)
+	{
+		if (Done())
+		{
+			return true;
+		}
+
+		kMilliSleep(10);
+	}
+
+	return false;
+}
+
+template<class Cache>
+void Coalescing()
+{
+	Cache MyCache(10);
+
+	iSlowLoads = 0;
+	std::atomic<int> iErrors { 0 };
+	std::atomic<int> iExceptions { 0 };
+
+	KRunThreads(10).Create([&]()
+	{
+		if (*MyCache.Get("key") != "key:1") { ++iErrors; }
+	});
+
+	CHECK ( iErrors    == 0 );
+	CHECK ( iSlowLoads == 1 );
+
+	KRunThreads(10).Create([&]()
+	{
+		try
+		{
+			MyCache.Get("bad");
+			++iErrors;
+		}
+		catch (const std::runtime_error&)
+		{
+			++iExceptions;
+		}
+	});
+
+	CHECK ( iErrors     ==  0 );
+	CHECK ( iExceptions == 10 );
+	// all threads may have run one after the other, but at least some were coalesced
+	CHECK ( iSlowLoads   < 11 );
+	CHECK ( MyCache.size() == 1 );
+
+	// a failed load is retried
+	auto iLoads = iSlowLoads.load();
+	CHECK_THROWS_AS ( MyCache.Get("bad"), const std::runtime_error& );
+	CHECK ( iSlowLoads == iLoads + 1 );
+}
+
+} // end of anonymous namespace
+
+TEST_CASE("KCache loads")
+{
+	SECTION("single flight")
+	{
+		Coalescing<KSharedCache <KString, KString, SlowLoader>>();
+		Coalescing<KShardedCache<KString, KString, SlowLoader>>();
+	}
+
+	SECTION("stale while revalidate")
+	{
+		iGatedLoads   = 0;
+		iMaxRunning   = 0;
+		bGateOpen     = true;
+
+		{
+			// all values expire right away
+			KSharedCache<KString, KString, GatedLoader> MyCache(20, chrono::milliseconds(1));
+
+			MyCache.SetStaleWhileRevalidate(chrono::hours(1));
+			CHECK ( MyCache.GetStaleWhileRevalidate() == chrono::hours(1) );
+
+			CHECK ( *MyCache.Get("key") == "key:1" );
+			kMilliSleep(10);
+
+			// the stale value is returned while the reload waits at the gate
+			bGateOpen = false;
+			CHECK ( *MyCache.Get("key") == "key:1" );
+			CHECK ( *MyCache.Get("key") == "key:1" );
+			CHECK ( WaitFor([]() { return iGatedLoads == 2; }) );
+			CHECK ( *MyCache.Get("key") == "key:1" );
+			CHECK ( iGatedLoads == 2 );
+
+			bGateOpen = true;
+			KString sValue;
+			CHECK ( WaitFor([&]() { sValue = *MyCache.Get("key"); return sValue != "key:1"; }) );
+			CHECK ( sValue == "key:2" );
+
+			// too old values are loaded in the foreground
+			MyCache.SetStaleWhileRevalidate(chrono::milliseconds(1));
+			sValue = *MyCache.Get("other");
+			kMilliSleep(10);
+			CHECK ( *MyCache.Get("other") != sValue );
+			MyCache.SetStaleWhileRevalidate(chrono::hours(1));
+
+			// the count of background loads is bounded
+			for (int i = 0; i < 10; ++i)
+			{
+				MyCache.Get(kFormat("many{}", i));
+			}
+
+			kMilliSleep(10);
+			CHECK ( WaitFor([]() { return iRunningLoads == 0; }) );
+			iMaxRunning = 0;
+			bGateOpen   = false;
+
+			for (int i = 0; i < 10; ++i)
+			{
+				CHECK ( *MyCache.Get(kFormat("many{}", i)) != "" );
+			}
+
+			CHECK ( WaitFor([]() { return iRunningLoads == decltype(MyCache)::MAX_BACKGROUND_LOADS; }) );
+			bGateOpen = true;
+			CHECK ( WaitFor([]() { return iRunningLoads == 0; }) );
+			CHECK ( iMaxRunning == decltype(MyCache)::MAX_BACKGROUND_LOADS );
+
+			// the destructor waits for background loads
+			kMilliSleep(10);
+			bGateOpen = false;
+			CHECK ( *MyCache.Get("key") != "" );
+			CHECK ( WaitFor([]() { return iRunningLoads == 1; }) );
+
+			std::thread([]() { kMilliSleep(50); bGateOpen = true; }).detach();
+		}
+
+		CHECK ( iRunningLoads == 0 );
+	}
+}
@@ -0,0 +1,157 @@
+#include "catch.hpp"
+
+#include <dekaf2/kconnectionpool.h>
+#include <dekaf2/kwebclient.h>
+#include <dekaf2/krest.h>
+
+#ifndef DEKAF2_IS_WINDOWS
+
+using namespace dekaf2;
+
+namespace {
+
+void pool_test_echo(KRESTServer& REST)
+{
+	REST.SetRawOutput(REST.GetRequestBody());
+	REST.SetStatus(200);
+}
+
+} // end of anonymous namespace
+
+TEST_CASE("KConnectionPool") {
+
+	SECTION("CreateKey")
+	{
+		CHECK ( KConnectionPool::CreateKey("http://www.example.com/path")           == "tcp:www.example.com:80"             );
+		CHECK ( KConnectionPool::CreateKey("http://www.example.com:8080/path")      == "tcp:www.example.com:8080"           );
+		CHECK ( KConnectionPool::CreateKey("https://www.example.com/path")          == "tls:www.example.com:443:noverify"   );
+		CHECK ( KConnectionPool::CreateKey("https://www.example.com/path", false, true)
+		                                                                            == "tls:www.example.com:443:verify"     );
+		CHECK ( KConnectionPool::CreateKey("http://www.example.com/path", true)     == "tls:www.example.com:80:noverify"    );
+	}
+
+	SECTION("reuse")
+	{
+		constexpr KRESTRoutes::FunctionTable RTable[]
+		{
+			{ "POST", false, "/echo", pool_test_echo, KRESTRoute::PLAIN },
+		};
+
+		KRESTRoutes Routes;
+		Routes.AddFunctionTable(RTable);
+
+		KREST::Options Options;
+		Options.Type      = KREST::HTTP;
+		Options.iPort     = 7655;
+		Options.bPollForDisconnect = false;
+		Options.bBlocking = false;
+
+		KREST REST;
+		REST.Execute(Options, Routes);
+
+		KConnectionPool Pool;
+
+		for (int iCount = 0; iCount < 3; ++iCount)
+		{
+			KWebClient HTTP;
+			HTTP.UseConnectionPool(&Pool);
+			auto sRet = HTTP.Post("http://127.0.0.1:7655/echo", "some body", KMIME::TEXT_PLAIN);
+			CHECK ( sRet == "some body" );
+			CHECK ( HTTP.GetStatusCode() == 200 );
+		}
+
+		auto Stats = Pool.GetStats();
+		CHECK ( Stats.iCreated  == 1 );
+		CHECK ( Stats.iReused   == 2 );
+		CHECK ( Stats.iReturned == 3 );
+		CHECK ( Stats.iIdle     == 1 );
+		CHECK ( Stats.iHosts    == 1 );
+
+		{
+			// a client that does not consume the response must not return
+			// the connection
+			KHTTPClient HTTP;
+			HTTP.UseConnectionPool(&Pool);
+			CHECK ( HTTP.Connect("http://127.0.0.1:7655") );
+			CHECK ( HTTP.Resource("http://127.0.0.1:7655/echo", KHTTPMethod::POST) );
+			CHECK ( HTTP.SendRequest("some body") );
+		}
+
+		Stats = Pool.GetStats();
+		CHECK ( Stats.iReused   == 3 );
+		CHECK ( Stats.iReturned == 3 );
+		CHECK ( Stats.iIdle     == 0 );
+
+		{
+			// two concurrent clients need two connections
+			KWebClient HTTP1;
+			KWebClient HTTP2;
+			HTTP1.UseConnectionPool(&Pool);
+			HTTP2.UseConnectionPool(&Pool);
+			CHECK ( HTTP1.Post("http://127.0.0.1:7655/echo", "body 1", KMIME::TEXT_PLAIN) == "body 1" );
+			CHECK ( HTTP2.Post("http://127.0.0.1:7655/echo", "body 2", KMIME::TEXT_PLAIN) == "body 2" );
+		}
+
+		Stats = Pool.GetStats();
+		CHECK ( Stats.iCreated  == 3 );
+		CHECK ( Stats.iIdle     == 2 );
+
+		Pool.clear();
+		CHECK ( Pool.GetStats().iIdle == 0 );
+	}
+
+	SECTION("limits")
+	{
+		constexpr KRESTRoutes::FunctionTable RTable[]
+		{
+			{ "POST", false, "/echo", pool_test_echo, KRESTRoute::PLAIN },
+		};
+
+		KRESTRoutes Routes;
+		Routes.AddFunctionTable(RTable);
+
+		KREST::Options Options;
+		Options.Type      = KREST::HTTP;
+		Options.iPort     = 7656;
+		Options.bPollForDisconnect = false;
+		Options.bBlocking = false;
+
+		KREST REST;
+		REST.Execute(Options, Routes);
+
+		KConnectionPool::Config Config;
+		Config.iMaxIdlePerHost = 2;
+		Config.IdleTimeout     = chrono::milliseconds(200);
+
+		KConnectionPool Pool(Config);
+
+		KURL URL("http://127.0.0.1:7656");
+		auto sKey = KConnectionPool::CreateKey(URL);
+
+		for (int iCount = 0; iCount < 3; ++iCount)
+		{
+			auto Connection = Pool.Create(URL);
+			CHECK ( Connection->Good() );
+			CHECK ( Pool.Return(sKey, std::move(Connection)) );
+		}
+
+		auto Stats = Pool.GetStats();
+		CHECK ( Stats.iCreated  == 3 );
+		CHECK ( Stats.iReturned == 3 );
+		CHECK ( Stats.iRejected == 1 );
+		CHECK ( Stats.iIdle     == 2 );
+
+		kMilliSleep(300);
+
+		CHECK ( Pool.Borrow(sKey) == nullptr );
+
+		Stats = Pool.GetStats();
+		CHECK ( Stats.iExpired == 2 );
+		CHECK ( Stats.iIdle    == 0 );
+		CHECK ( Stats.iHosts   == 0 );
+
+		CHECK ( Pool.Return(sKey, nullptr) == false );
+	}
+}
+
+#endif // DEKAF2_IS_WINDOWS
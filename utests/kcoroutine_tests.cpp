@@ -0,0 +1,187 @@
+#include "catch.hpp"
+
+#include <dekaf2/kcoroutine.h>
+
+#if DEKAF2_HAS_COROUTINES
+
+#include <dekaf2/ktcpserver.h>
+#include <dekaf2/ktcpstream.h>
+#include <dekaf2/kthreadpool.h>
+#include <dekaf2/kstring.h>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace dekaf2;
+
+namespace {
+
+class KEchoServer : public KTCPServer
+{
+
+public:
+
+	using KTCPServer::KTCPServer;
+
+protected:
+
+	virtual KString Request(KStringRef& qstr, Parameters& parameters) override
+	{
+		if (qstr == "silence")
+		{
+			// do not answer
+			return KString{};
+		}
+		return qstr + "\n";
+	}
+
+};
+
+KTask<int> Add(int a, int b)
+{
+	co_return a + b;
+}
+
+KTask<int> AddThree(int a, int b, int c)
+{
+	auto iSum = co_await Add(a, b);
+	co_return co_await Add(iSum, c);
+}
+
+int iSideEffect { 0 };
+
+KTask<> SetSideEffect(int i)
+{
+	iSideEffect = i;
+	co_return;
+}
+
+KTask<int> Thrower()
+{
+	co_await SetSideEffect(1);
+	throw std::runtime_error("bad");
+	co_return 0;
+}
+
+KTask<std::thread::id> ThreadOf(KThreadPool& Pool)
+{
+	co_await kResumeOn(Pool);
+	co_return std::this_thread::get_id();
+}
+
+KTask<KString> Echo(KString sLine)
+{
+	KTCPIOStream Stream;
+
+	if (!co_await Stream.AsyncConnect(KTCPEndPoint("127.0.0.1:7681")))
+	{
+		co_return KString{};
+	}
+
+	sLine += '\n';
+
+	if (co_await Stream.AsyncWrite(sLine.data(), sLine.size()) != sLine.size())
+	{
+		co_return KString{};
+	}
+
+	KString sReceived;
+	char Buffer[64];
+
+	while (!sReceived.ends_with('\n'))
+	{
+		auto iRead = co_await Stream.AsyncRead(Buffer, sizeof(Buffer));
+
+		if (!iRead)
+		{
+			break;
+		}
+
+		sReceived.append(Buffer, iRead);
+	}
+
+	sReceived.remove_suffix(1);
+
+	co_return sReceived;
+}
+
+KTask<KString> ReadSilence()
+{
+	KTCPIOStream Stream;
+	Stream.Timeout(1);
+
+	if (!co_await Stream.AsyncConnect(KTCPEndPoint("127.0.0.1:7681")))
+	{
+		co_return "cannot connect";
+	}
+
+	KStringView sLine = "silence\n";
+	co_await Stream.AsyncWrite(sLine.data(), sLine.size());
+
+	char Buffer[64];
+
+	if (co_await Stream.AsyncRead(Buffer, sizeof(Buffer)) != 0)
+	{
+		co_return "unexpected data";
+	}
+
+	co_return Stream.Error();
+}
+
+} // end of anonymous namespace
+
+TEST_CASE("KCoroutine")
+{
+	SECTION("tasks")
+	{
+		KThreadPool Pool(2);
+
+		CHECK ( kCoSpawn(Pool, AddThree(1, 2, 3)).get() == 6 );
+
+		iSideEffect = 0;
+		kCoSpawn(Pool, SetSideEffect(42)).get();
+		CHECK ( iSideEffect == 42 );
+
+		CHECK_THROWS_AS ( kCoSpawn(Pool, Thrower()).get(), const std::runtime_error& );
+		CHECK ( iSideEffect == 1 );
+
+		KThreadPool Other(1);
+		auto OtherID = Other.push([]() { return std::this_thread::get_id(); }).get();
+		CHECK ( kCoSpawn(Pool, ThreadOf(Other)).get() == OtherID );
+
+		KTask<int> Task;
+		CHECK ( Task.IsValid() == false );
+		Task = Add(1, 1);
+		CHECK ( Task.IsValid() == true  );
+		CHECK ( Task.IsDone()  == false );
+	}
+
+	SECTION("tcp streams")
+	{
+		KEchoServer Server(7681, false, 100);
+		Server.Start(2, false);
+
+		// many more connections than threads
+		KThreadPool Pool(2);
+		std::vector<std::future<KString>> Futures;
+
+		for (int i = 0; i < 40; ++i)
+		{
+			Futures.push_back(kCoSpawn(Pool, Echo(kFormat("hello {}", i))));
+		}
+
+		for (int i = 0; i < 40; ++i)
+		{
+			CHECK ( Futures[i].get() == kFormat("hello {}", i) );
+		}
+
+		auto sError = kCoSpawn(Pool, ReadSilence()).get();
+		CHECK ( sError.empty() == false );
+		CHECK ( sError != "cannot connect"  );
+		CHECK ( sError != "unexpected data" );
+
+		Server.Stop();
+	}
+}
+
+#endif // DEKAF2_HAS_COROUTINES
@@ -2,9 +2,121 @@
 
 #include <dekaf2/klog.h>
 #include <dekaf2/kstring.h>
+#include <dekaf2/bits/klogwriter.h>
+#include <dekaf2/bits/klogserializer.h>
+#include <dekaf2/bits/klogbinary.h>
+#include <dekaf2/kduration.h>
+#include <dekaf2/kfilesystem.h>
+#include <dekaf2/kreader.h>
+#include <dekaf2/ksystem.h>
+#include <dekaf2/ktcpserver.h>
+#include <dekaf2/krest.h>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 using namespace dekaf2;
 
+namespace klogtest {
+
+// outside of the global namespace, as the generic format_as() for enums would
+// take precedence over the formatter
+enum class Color { Red };
+
+} // end of namespace klogtest
+
+namespace fmt
+{
+
+template <>
+struct formatter<klogtest::Color> : formatter<string_view>
+{
+	template <typename FormatContext>
+	auto format(const klogtest::Color& Color, FormatContext& ctx) const
+	{
+		return formatter<string_view>::format("red", ctx);
+	}
+};
+
+} // end of namespace fmt
+
+namespace {
+
+void LogFromStackBuffer()
+{
+	// this buffer is gone when the deferred record gets formatted
+	const char sFormat[40] = "stack buffer {}";
+	kDebug(2, sFormat, 45);
+}
+
+class SlowStringWriter : public KLogStringWriter
+{
+public:
+
+	SlowStringWriter(KStringRef& sOut) : KLogStringWriter(sOut) {}
+
+	virtual bool Write(int iLevel, bool bIsMultiline, KStringViewZ sOut) override
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		return KLogStringWriter::Write(iLevel, bIsMultiline, sOut);
+	}
+
+}; // SlowStringWriter
+
+#if defined(DEKAF2_KLOG_WITH_TCP) && !defined(DEKAF2_IS_WINDOWS)
+
+// a loopback log collector
+class LogCollector : public KTCPServer
+{
+public:
+
+	LogCollector(uint16_t iPort) : KTCPServer(iPort, false, 5) {}
+
+	bool WaitFor(std::size_t iLines)
+	{
+		for (int iRound = 0; iRound < 200; ++iRound)
+		{
+			{
+				std::lock_guard<std::mutex> Lock(m_Mutex);
+
+				if (m_Lines.size() >= iLines)
+				{
+					return true;
+				}
+			}
+
+			kMilliSleep(10);
+		}
+
+		return false;
+	}
+
+	std::vector<KString> GetLines()
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		return m_Lines;
+	}
+
+protected:
+
+	KString Request(KStringRef& sLine, Parameters& parameters) override
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_Lines.push_back(sLine);
+		return {};
+	}
+
+private:
+
+	std::mutex m_Mutex;
+	std::vector<KString> m_Lines;
+
+}; // LogCollector
+
+#endif
+
+} // end of anonymous namespace
+
 int neverBeCalled()
 {
 	static int iCallCount = 0;
@@ -24,4 +136,489 @@ TEST_CASE("KLog") {
 	{
 		CHECK ( KLog::getInstance().GetName().empty() == false );
 	}
+
+	SECTION("Async")
+	{
+		auto& Log      = KLog::getInstance();
+		auto iOldLevel = Log.GetLevel();
+		KString sOldLog = Log.GetDebugLog();
+		KString sOut;
+
+		Log.SetLevel(1);
+		Log.SetWriter(std::make_unique<KLogStringWriter>(sOut));
+		Log.SetSerializer(KLog::Serializer::TTY);
+		Log.SetAsync(true, 1024, KLog::AsyncOverflow::BLOCK);
+		CHECK ( Log.GetAsync() );
+
+		std::vector<std::thread> Threads;
+
+		for (int iThread = 0; iThread < 4; ++iThread)
+		{
+			Threads.emplace_back([iThread]()
+			{
+				for (int i = 0; i < 500; ++i)
+				{
+					kDebug(1, "async thread {} record {}", iThread, i);
+				}
+			});
+		}
+
+		for (auto& Thread : Threads)
+		{
+			Thread.join();
+		}
+
+		Log.Flush();
+
+		std::size_t iRecords { 0 };
+
+		for (auto sLine : sOut.Split("\n"))
+		{
+			if (sLine.contains("async thread")) ++iRecords;
+		}
+
+		CHECK ( iRecords == 2000 );
+		CHECK ( sOut.contains("async thread 3 record 499") );
+		CHECK ( Log.GetDroppedRecords() == 0 );
+
+		// now overflow a small buffer
+		sOut.clear();
+		Log.SetWriter(std::make_unique<SlowStringWriter>(sOut));
+		Log.SetAsync(true, 4, KLog::AsyncOverflow::DROP_AND_REPORT);
+
+		std::thread([]()
+		{
+			for (int i = 0; i < 100; ++i)
+			{
+				kDebug(1, "dropping record {}", i);
+			}
+		}).join();
+
+		Log.Flush();
+		CHECK ( Log.GetDroppedRecords() > 0 );
+		CHECK ( sOut.contains("dropped") );
+
+		Log.SetAsync(false);
+		CHECK ( Log.GetAsync() == false );
+
+		// reopen the original log
+		Log.SetDebugLog(sOldLog == KLog::STDERR ? KLog::STDOUT : KLog::STDERR);
+		Log.SetDebugLog(sOldLog);
+		Log.SetLevel(iOldLevel);
+	}
+
+	SECTION("Binary args")
+	{
+		static_assert(KLogBinaryArgs::IsEncodable<int, KString, double, bool, char, const char*>(), "encodable");
+		static_assert(!KLogBinaryArgs::IsEncodable<int, std::vector<int>>(), "not encodable");
+
+		KString sArgs;
+		KStringView sView { "view" };
+		KLogBinaryArgs::Encode(sArgs, 42, KString("str"), 1.5, true, 'x', "lit", -7L, 255U, sView);
+
+		CHECK ( KLogBinaryArgs::Format("{} {} {} {} {} {} {} {:x} {}", sArgs) == "42 str 1.5 true x lit -7 ff view" );
+		CHECK ( KLogBinaryArgs::Format("{1}-{0}", sArgs) == "str-42" );
+		CHECK ( KLogBinaryArgs::Format("[{:>5}] {{}} [{:<4}]", sArgs) == "[   42] {} [str ]" );
+		CHECK ( KLogBinaryArgs::Format("{9}", sArgs) == "{9}" );
+		CHECK ( KLogBinaryArgs::Format("{}", "damaged") == "{} [damaged arguments]" );
+
+		// floats keep their own precision
+		sArgs.clear();
+		KLogBinaryArgs::Encode(sArgs, 0.1f, 0.1);
+		CHECK ( KLogBinaryArgs::Format("{} {}", sArgs) == "0.1 0.1" );
+
+		// enums may have their own formatter
+		static_assert(!KLogBinaryArgs::IsEncodable<klogtest::Color>(), "not encodable");
+		static_assert(!KLogBinaryArgs::IsEncodable<std::errc>(), "not encodable");
+	}
+
+	SECTION("Deferred formatting")
+	{
+		auto& Log      = KLog::getInstance();
+		auto iOldLevel = Log.GetLevel();
+		KString sOldLog = Log.GetDebugLog();
+		KString sOut;
+
+		Log.SetLevel(2);
+		Log.SetWriter(std::make_unique<KLogStringWriter>(sOut));
+		Log.SetSerializer(KLog::Serializer::TTY);
+		Log.SetAsync(true, 1024, KLog::AsyncOverflow::BLOCK);
+		Log.SetDeferredFormatting(true);
+		CHECK ( Log.GetDeferredFormatting() );
+
+		KString sRuntimeFormat = "runtime {}";
+		kDebug(2, "deferred {} and {:.2f}", 42, 3.14159);
+		kDebug(2, sRuntimeFormat, 43);
+		kDebug(2, "not encodable {}", std::chrono::seconds(5));
+		kDebug(2, "float {}", 0.1f);
+		kDebug(2, "enum {}", klogtest::Color::Red);
+		LogFromStackBuffer();
+		Log.Flush();
+
+		CHECK ( sOut.contains("deferred 42 and 3.14") );
+		CHECK ( sOut.contains("runtime 43") );
+		CHECK ( sOut.contains("not encodable 5s") );
+		CHECK ( sOut.contains("float 0.1\n") );
+		CHECK ( sOut.contains("enum red") );
+		CHECK ( sOut.contains("stack buffer 45\n") );
+
+		// now into a binary log
+		KTempDir TempDir;
+		KString sBinaryLog = kFormat("{}/test.klogbin", TempDir.Name());
+		CHECK ( Log.SetBinaryLog(sBinaryLog) );
+		sOut.clear();
+
+		for (int i = 0; i < 3; ++i)
+		{
+			kDebug(2, "binary record {} of {}", i, "three");
+		}
+		kDebug(2, sRuntimeFormat, 44);
+
+		Log.Flush();
+		CHECK ( Log.SetBinaryLog("") );
+		CHECK ( sOut.empty() );
+
+		KLogBinaryFileReader Reader(sBinaryLog);
+		CHECK ( Reader.Good() );
+
+		std::vector<KString> Messages;
+		KLogBinaryFileReader::Entry Entry;
+
+		while (Reader.Next(Entry))
+		{
+			CHECK ( Entry.iLevel == 2 );
+			CHECK ( Entry.sFunction.empty() == false );
+			Messages.push_back(Entry.sMessage);
+		}
+
+		CHECK ( Messages.size() == 4 );
+
+		if (Messages.size() == 4)
+		{
+			CHECK ( Messages[0] == "binary record 0 of three" );
+			CHECK ( Messages[2] == "binary record 2 of three" );
+			CHECK ( Messages[3] == "runtime 44" );
+		}
+
+		// more records than the ring buffer holds, so that its slots get
+		// reused with alternating format strings
+		KString sWrapLog = kFormat("{}/wrap.klogbin", TempDir.Name());
+		CHECK ( Log.SetBinaryLog(sWrapLog) );
+
+		constexpr int iWrapRecords = 3 * 1024 + 1;
+
+		for (int i = 0; i < iWrapRecords; ++i)
+		{
+			if (i % 2)
+			{
+				kDebug(2, "odd {}", i);
+			}
+			else
+			{
+				kDebug(2, "even {} {}", i, "x");
+			}
+		}
+
+		Log.Flush();
+		CHECK ( Log.SetBinaryLog("") );
+
+		KLogBinaryFileReader WrapReader(sWrapLog);
+		CHECK ( WrapReader.Good() );
+
+		int iRecord { 0 };
+		int iWrong  { 0 };
+
+		while (WrapReader.Next(Entry))
+		{
+			auto sExpected = (iRecord % 2) ? kFormat("odd {}", iRecord) : kFormat("even {} x", iRecord);
+
+			if (Entry.sMessage != sExpected)
+			{
+				++iWrong;
+			}
+
+			++iRecord;
+		}
+
+		CHECK ( iRecord == iWrapRecords );
+		CHECK ( iWrong  == 0 );
+
+		Log.SetDeferredFormatting(false);
+		Log.SetAsync(false);
+
+		// reopen the original log
+		Log.SetDebugLog(sOldLog == KLog::STDERR ? KLog::STDOUT : KLog::STDERR);
+		Log.SetDebugLog(sOldLog);
+		Log.SetLevel(iOldLevel);
+	}
+
+	SECTION("Rate limit")
+	{
+		auto& Log = KLog::getInstance();
+		KString sOldLog = Log.GetDebugLog();
+		KString sOut;
+
+		Log.SetWriter(std::make_unique<KLogStringWriter>(sOut));
+		Log.SetSerializer(KLog::Serializer::TTY);
+		// a long interval, so that the timer does not interfere
+		Log.SetRateLimit(3, 0, std::chrono::hours(1));
+
+		auto CountLines = [&sOut](KStringView sSearch)
+		{
+			std::size_t iCount { 0 };
+
+			for (auto sLine : sOut.Split("\n"))
+			{
+				if (sLine.contains(sSearch)) ++iCount;
+			}
+
+			return iCount;
+		};
+
+		for (int i = 0; i < 10; ++i)
+		{
+			kWarning("limited warning {}", i);
+		}
+
+		CHECK ( CountLines("limited warning") == 3 );
+		CHECK ( CountLines("suppressed") == 0 );
+
+		Log.EndRateLimitInterval();
+		CHECK ( CountLines("suppressed 7 log messages") == 1 );
+		CHECK ( sOut.contains("klog_tests.cpp:") );
+
+		kWarning("limited warning {}", 10);
+		CHECK ( CountLines("limited warning") == 4 );
+
+		sOut.clear();
+		Log.EndRateLimitInterval();
+		Log.SetRateLimit(2, 4, std::chrono::hours(1));
+
+		for (int i = 0; i < 20; ++i)
+		{
+			kWarning("sampled warning {}", i);
+		}
+
+		CHECK ( CountLines("sampled warning") == 6 );
+		CHECK ( sOut.contains("sampled warning 5") );
+		CHECK ( sOut.contains("sampled warning 17") );
+
+		Log.SetRateLimit(0);
+		CHECK ( CountLines("suppressed 14 log messages") == 1 );
+
+		for (int i = 0; i < 5; ++i)
+		{
+			kWarning("unlimited warning {}", i);
+		}
+
+		CHECK ( CountLines("unlimited warning") == 5 );
+
+		// reopen the original log
+		Log.SetDebugLog(sOldLog == KLog::STDERR ? KLog::STDOUT : KLog::STDERR);
+		Log.SetDebugLog(sOldLog);
+	}
+
+#if defined(DEKAF2_KLOG_WITH_TCP) && !defined(DEKAF2_IS_WINDOWS)
+	SECTION("Batched network shipping")
+	{
+		KTempDir TempDir;
+
+		KLogBatchShipper::Options Options;
+		Options.MaxDelay   = std::chrono::milliseconds(50);
+		Options.sSpillFile = kFormat("{}/tcp.spill", TempDir.Name());
+
+		// time triggered batches
+		{
+			LogCollector Collector(7661);
+			Collector.Start(5, false);
+
+			KLogTCPWriter Writer("127.0.0.1:7661", Options);
+
+			for (int i = 0; i < 100; ++i)
+			{
+				CHECK ( Writer.Write(1, false, kFormat("tcp record {}", i)) );
+			}
+
+			CHECK ( Collector.WaitFor(100) );
+			auto Lines = Collector.GetLines();
+			REQUIRE ( Lines.size() == 100 );
+			CHECK ( Lines.front() == "tcp record 0"  );
+			CHECK ( Lines.back()  == "tcp record 99" );
+		}
+
+		// size triggered batches
+		{
+			LogCollector Collector(7662);
+			Collector.Start(5, false);
+
+			auto SizeOptions = Options;
+			SizeOptions.MaxDelay      = std::chrono::hours(1);
+			SizeOptions.iMaxBatchSize = 100;
+
+			KLogTCPWriter Writer("127.0.0.1:7662", SizeOptions);
+
+			for (int i = 0; i < 10; ++i)
+			{
+				Writer.Write(1, false, kFormat("size triggered record {}", i));
+			}
+
+			// the batch limit is reached after 5 records, therefore
+			// at least those are shipped without a flush
+			CHECK ( Collector.WaitFor(5) );
+			CHECK ( Writer.Flush() );
+			CHECK ( Collector.WaitFor(10) );
+			CHECK ( Collector.GetLines().size() == 10 );
+		}
+
+		// spill when the collector is not reachable
+		{
+			KLogTCPWriter Writer("127.0.0.1:7663", Options);
+
+			for (int i = 0; i < 10; ++i)
+			{
+				Writer.Write(1, false, kFormat("spilled record {}", i));
+			}
+
+			CHECK ( Writer.Flush() == false );
+			CHECK ( kFileExists(Options.sSpillFile) );
+			CHECK ( kReadAll(Options.sSpillFile).starts_with("spilled record 0\nspilled record 1\n") );
+
+			LogCollector Collector(7663);
+			Collector.Start(5, false);
+
+			Writer.Write(1, false, "after the spill");
+			CHECK ( Writer.Flush() );
+			CHECK ( Collector.WaitFor(11) );
+
+			auto Lines = Collector.GetLines();
+			REQUIRE ( Lines.size() == 11 );
+			CHECK ( Lines[0]  == "spilled record 0" );
+			CHECK ( Lines[9]  == "spilled record 9" );
+			CHECK ( Lines[10] == "after the spill"  );
+			CHECK ( kFileExists(Options.sSpillFile) == false );
+			CHECK ( Writer.GetDropped() == 0 );
+		}
+
+		// only the records that were not shipped are spilled
+		{
+			auto PartOptions = Options;
+			PartOptions.sSpillFile = kFormat("{}/part.spill", TempDir.Name());
+
+			// ships the first record of each batch only
+			KLogBatchShipper Shipper("part", [](KStringView sBatch) -> std::size_t
+			{
+				return sBatch.find('\n') + 1;
+			}, PartOptions);
+
+			Shipper.Add("record 0");
+			Shipper.Add("record 1");
+			Shipper.Add("record 2");
+
+			CHECK ( Shipper.Flush() == false );
+			CHECK ( kReadAll(PartOptions.sSpillFile) == "record 1\nrecord 2\n" );
+		}
+
+		// the default spill file is per process
+		{
+			KLogBatchShipper Shipper("127.0.0.1:7663", [](KStringView sBatch) { return sBatch.size(); }, KLogBatchShipper::Options{});
+			CHECK ( Shipper.GetSpillFile().ends_with(kFormat("-{}.spill", kGetPid())) );
+		}
+
+		// Flush() does not wait longer than the flush timeout
+		{
+			auto SlowOptions = Options;
+			SlowOptions.FlushTimeout = std::chrono::milliseconds(20);
+
+			KLogBatchShipper Shipper("slow", [](KStringView sBatch)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(500));
+				return sBatch.size();
+			}, SlowOptions);
+
+			Shipper.Add("slow record");
+
+			KStopTime Timer;
+			CHECK ( Shipper.Flush() == false );
+			CHECK ( Timer.elapsed() < std::chrono::milliseconds(400) );
+		}
+
+		// HTTP with compressed JSON arrays
+		{
+			static std::mutex s_Mutex;
+			static std::vector<KString> s_Bodies;
+			static KString s_sEncoding;
+			static KString s_sMIME;
+
+			KRESTRoutes::FunctionTable RTable[]
+			{
+				{ "POST", false, "/log", [](KRESTServer& REST)
+					{
+						std::lock_guard<std::mutex> Lock(s_Mutex);
+						s_Bodies.push_back(REST.GetRequestBody());
+						s_sEncoding = REST.Request.Headers.Get(KHTTPHeader::CONTENT_ENCODING);
+						s_sMIME     = REST.Request.Headers.Get(KHTTPHeader::CONTENT_TYPE);
+						REST.SetStatus(200);
+					}, KRESTRoute::PLAIN },
+			};
+
+			KRESTRoutes Routes;
+			Routes.AddFunctionTable(RTable);
+
+			KREST::Options RESTOptions;
+			RESTOptions.Type      = KREST::HTTP;
+			RESTOptions.iPort     = 7664;
+			RESTOptions.bPollForDisconnect = false;
+			RESTOptions.bBlocking = false;
+
+			KREST Server;
+			CHECK ( Server.Execute(RESTOptions, Routes) );
+			CHECK ( Server.Error().empty() );
+
+			auto HTTPOptions = Options;
+			HTTPOptions.sSpillFile = kFormat("{}/http.spill", TempDir.Name());
+
+			// text records that look like JSON are not framed as JSON
+			{
+				KLogHTTPWriter Writer("http://127.0.0.1:7664/log", "gzip", HTTPOptions);
+				Writer.Write(1, false, "{not json}");
+				CHECK ( Writer.Flush() );
+
+				std::lock_guard<std::mutex> Lock(s_Mutex);
+				REQUIRE ( s_Bodies.size() == 1 );
+				CHECK ( s_Bodies.front() == "{not json}\n" );
+				CHECK ( s_sMIME.starts_with("text/plain") );
+				s_Bodies.clear();
+			}
+
+			KLogHTTPWriter Writer("http://127.0.0.1:7664/log", "gzip", HTTPOptions);
+			Writer.SetJSONRecords(true);
+
+			for (int i = 0; i < 20; ++i)
+			{
+				Writer.Write(1, false, kFormat(R"({{"record":{}}})", i));
+			}
+
+			CHECK ( Writer.Flush() );
+
+			std::lock_guard<std::mutex> Lock(s_Mutex);
+			CHECK ( s_sMIME.starts_with("application/json") );
+
+			std::size_t iRecords = 0;
+
+			for (const auto& sBody : s_Bodies)
+			{
+				auto json = kjson::Parse(sBody);
+				REQUIRE ( json.is_array() );
+
+				for (const auto& Record : json)
+				{
+					CHECK ( Record["record"] == iRecords++ );
+				}
+			}
+
+			CHECK ( iRecords == 20 );
+			CHECK ( s_sEncoding == "gzip" );
+		}
+	}
+#endif
 }
@@ -4,6 +4,12 @@
 #include <dekaf2/kstring.h>
 #include <dekaf2/ksystem.h>
 #include <dekaf2/kbar.h>
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
 
 using namespace dekaf2;
 
@@ -63,5 +69,170 @@ TEST_CASE("KParallel")
 		}, 0, KBAR());
 	}
 
-}
+	SECTION("kParallelForEach chunked")
+	{
+		struct CountingPrinter
+		{
+			void Start  (std::size_t iMax)       { iStart = iMax; }
+			void Move   (std::size_t iDelta = 1) { iMoved += iDelta; }
+			void Finish ()                       { bFinished = true; }
+
+			std::size_t iStart    { 0 };
+			std::size_t iMoved    { 0 };
+			bool        bFinished { false };
+		};
+
+		for (auto Mode : { KParallelOptions::Dynamic, KParallelOptions::Static })
+		{
+			for (std::size_t iGrainSize : { 0, 1, 7, 1000, 200000 })
+			{
+				std::vector<std::size_t> vec(100003, 0);
+
+				KParallelOptions Options;
+				Options.iMaxThreads = 8;
+				Options.iGrainSize  = iGrainSize;
+				Options.Mode        = Mode;
+
+				CountingPrinter Printer;
+
+				kParallelForEach(vec, [](std::size_t& value)
+				{
+					++value;
+
+				}, Options, Printer);
+
+				CHECK ( std::count(vec.begin(), vec.end(), 1) == vec.size() );
+				CHECK ( Printer.iStart == vec.size() );
+				CHECK ( Printer.iMoved == vec.size() );
+				CHECK ( Printer.bFinished );
+			}
+		}
+
+		// not random access
+		std::list<int> list(1000, 0);
+		std::atomic<int> iSum { 0 };
+
+		KParallelOptions Options;
+		Options.iGrainSize = 10;
+
+		kParallelForEach(list.begin(), list.end(), [&iSum](int& value)
+		{
+			value = 1;
+			++iSum;
+
+		}, Options);
+
+		CHECK ( iSum == 1000 );
+		CHECK ( std::count(list.begin(), list.end(), 1) == 1000 );
+
+		KParallelOptions Auto;
+		Auto.iMaxThreads = 4;
+		CHECK ( Auto.GetThreads(2) == 2 );
+		CHECK ( Auto.GetThreads(1000) == 4 );
+		CHECK ( Auto.GetGrainSize(3200, 4) == 100 );
+		Auto.Mode = KParallelOptions::Static;
+		CHECK ( Auto.GetGrainSize(3201, 4) == 801 );
+		Auto.iGrainSize = 500;
+		CHECK ( Auto.GetThreads(1000) == 2 );
+	}
+
+	SECTION("parallel algorithms")
+	{
+		KParallelOptions Options;
+		Options.iMaxThreads = 8;
+		Options.iGrainSize  = 1000;
+
+		std::vector<uint64_t> vec(100003);
+		std::iota(vec.begin(), vec.end(), 0);
+
+		std::vector<uint64_t> squares(vec.size());
+		auto it = kParallelTransform(vec.begin(), vec.end(), squares.begin(), [](uint64_t i)
+		{
+			return i * i;
+
+		}, Options);
+
+		CHECK ( it == squares.end() );
+		CHECK ( squares[0]      == 0 );
+		CHECK ( squares[1000]   == 1000000 );
+		CHECK ( squares.back()  == uint64_t(100002) * 100002 );
+
+		CHECK ( kParallelReduce(vec.begin(), vec.end(), uint64_t(0)) == uint64_t(100002) * 100003 / 2 );
+		CHECK ( kParallelReduce(vec.begin(), vec.end(), uint64_t(0), std::plus<>(), Options) == uint64_t(100002) * 100003 / 2 );
+
+		// reduction order is kept
+		std::vector<KString> Letters;
+
+		for (int i = 0; i < 5000; ++i)
+		{
+			Letters.push_back(KString(1, 'a' + i % 26));
+		}
+
+		KString sExpected;
+
+		for (const auto& sLetter : Letters)
+		{
+			sExpected += sLetter;
+		}
+
+		Options.iGrainSize = 7;
+		CHECK ( kParallelReduce(Letters.begin(), Letters.end(), KString(">"), std::plus<>(), Options) == ">" + sExpected );
+
+		auto iLength = kParallelTransformReduce(Letters.begin(), Letters.end(), std::size_t(0), std::plus<>(), [](const KString& sLetter)
+		{
+			return sLetter.size();
+
+		}, Options);
+
+		CHECK ( iLength == 5000 );
+
+		// nested calls from inside the pool
+		std::vector<uint64_t> Sums(50);
+
+		kParallelTransform(Sums.begin(), Sums.end(), Sums.begin(), [&vec](uint64_t)
+		{
+			KParallelOptions Options;
+			Options.iMaxThreads = 4;
+			Options.iGrainSize  = 100;
+			return kParallelReduce(vec.begin(), vec.end(), uint64_t(0), std::plus<>(), Options);
+
+		}, Options);
 
+		CHECK ( std::count(Sums.begin(), Sums.end(), uint64_t(100002) * 100003 / 2) == 50 );
+
+		// exceptions are rethrown in the calling thread
+		CHECK_THROWS_AS ( kParallelTransform(vec.begin(), vec.end(), squares.begin(), [](uint64_t i) -> uint64_t
+		{
+			if (i == 5000) throw std::runtime_error("bad");
+			return i;
+
+		}, Options), const std::runtime_error& );
+
+		// sort
+		std::vector<uint32_t> Random(123457);
+		uint32_t iSeed = 4711;
+
+		for (auto& i : Random)
+		{
+			iSeed = iSeed * 1103515245 + 12345;
+			i = iSeed >> 8;
+		}
+
+		auto Sorted = Random;
+		std::sort(Sorted.begin(), Sorted.end());
+
+		Options.iGrainSize = 1000;
+		kParallelSort(Random.begin(), Random.end(), std::less<>(), Options);
+		CHECK ( Random == Sorted );
+
+		kParallelSort(Random.begin(), Random.end(), std::greater<>(), Options);
+		CHECK ( std::is_sorted(Random.begin(), Random.end(), std::greater<>()) );
+
+		kParallelSort(Random.begin(), Random.end());
+		CHECK ( Random == Sorted );
+
+		std::vector<int> Empty;
+		kParallelSort(Empty.begin(), Empty.end());
+		CHECK ( kParallelReduce(Empty.begin(), Empty.end(), 42) == 42 );
+	}
+}
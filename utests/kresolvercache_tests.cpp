@@ -0,0 +1,166 @@
+#include "catch.hpp"
+
+#include <dekaf2/kresolvercache.h>
+#include <dekaf2/ksystem.h>
+
+using namespace dekaf2;
+
+TEST_CASE("KResolverCache")
+{
+	SECTION("numeric")
+	{
+		KResolverCache Cache;
+		boost::system::error_code ec;
+
+		auto Endpoints = Cache.Resolve("127.0.0.1", "80", ec);
+		CHECK ( !ec );
+		REQUIRE ( Endpoints.size() == 1 );
+		CHECK ( Endpoints.front().address().to_string() == "127.0.0.1" );
+		CHECK ( Endpoints.front().port() == 80 );
+
+		auto Stats = Cache.GetStats();
+		CHECK ( Stats.iMisses  == 1 );
+		CHECK ( Stats.iHits    == 0 );
+		CHECK ( Stats.iEntries == 1 );
+
+		Endpoints = Cache.Resolve("127.0.0.1", "80", ec);
+		CHECK ( !ec );
+		REQUIRE ( Endpoints.size() == 1 );
+		CHECK ( Endpoints.front().port() == 80 );
+
+		Endpoints = Cache.Resolve("127.0.0.1", "443", ec);
+		CHECK ( !ec );
+		REQUIRE ( Endpoints.size() == 1 );
+		CHECK ( Endpoints.front().port() == 443 );
+
+		Stats = Cache.GetStats();
+		CHECK ( Stats.iMisses  == 2 );
+		CHECK ( Stats.iHits    == 1 );
+		CHECK ( Stats.iEntries == 2 );
+
+		Cache.Remove("127.0.0.1", "80");
+		CHECK ( Cache.GetStats().iEntries == 1 );
+		Cache.clear();
+		CHECK ( Cache.GetStats().iEntries == 0 );
+	}
+
+	SECTION("negative")
+	{
+		KResolverCache Cache;
+		boost::system::error_code ec;
+
+		auto Endpoints = Cache.Resolve("this.name.does.not.exist.invalid", "80", ec);
+		CHECK ( ec );
+		CHECK ( Endpoints.empty() );
+
+		ec = boost::system::error_code();
+		Endpoints = Cache.Resolve("this.name.does.not.exist.invalid", "80", ec);
+		CHECK ( ec );
+		CHECK ( Endpoints.empty() );
+
+		auto Stats = Cache.GetStats();
+		CHECK ( Stats.iMisses       == 1 );
+		CHECK ( Stats.iNegativeHits == 1 );
+	}
+
+	SECTION("expiry")
+	{
+		KResolverCache::Config Config;
+		Config.TTL          = chrono::milliseconds(100);
+		Config.RefreshAhead = chrono::milliseconds(0);
+		Config.iMaxEntries  = 2;
+		KResolverCache Cache(Config);
+		boost::system::error_code ec;
+
+		Cache.Resolve("127.0.0.1", "1", ec);
+		Cache.Resolve("127.0.0.1", "2", ec);
+		Cache.Resolve("127.0.0.1", "3", ec);
+		CHECK ( Cache.GetStats().iEntries == 2 );
+		CHECK ( Cache.GetStats().iMisses  == 3 );
+
+		kMilliSleep(150);
+
+		Cache.Resolve("127.0.0.1", "3", ec);
+		CHECK ( !ec );
+		CHECK ( Cache.GetStats().iMisses  == 4 );
+	}
+
+	SECTION("refresh")
+	{
+		KResolverCache::Config Config;
+		Config.TTL          = chrono::seconds(10);
+		Config.RefreshAhead = chrono::seconds(10);
+		KResolverCache Cache(Config);
+		boost::system::error_code ec;
+
+		Cache.Resolve("127.0.0.1", "80", ec);
+		Cache.Resolve("127.0.0.1", "80", ec);
+		CHECK ( !ec );
+		CHECK ( Cache.GetStats().iHits      == 1 );
+		CHECK ( Cache.GetStats().iRefreshes == 1 );
+	}
+
+	SECTION("failed refresh")
+	{
+		std::atomic<bool> bFail     { false };
+		std::atomic<int>  iResolves { 0 };
+
+		KResolverCache::Config Config;
+		Config.TTL          = chrono::seconds(10);
+		Config.RefreshAhead = chrono::seconds(10);
+		Config.Resolve      = [&](KStringView sHostname, KStringView sPort, boost::system::error_code& ec)
+		{
+			++iResolves;
+
+			if (bFail)
+			{
+				ec = boost::asio::error::host_not_found_try_again;
+				return KResolverCache::Endpoints{};
+			}
+
+			return KResolverCache::ResolveUncached(sHostname, sPort, ec);
+		};
+
+		KResolverCache Cache(Config);
+		boost::system::error_code ec;
+
+		Cache.Resolve("127.0.0.1", "80", ec);
+		CHECK ( !ec );
+
+		// the background refresh fails
+		bFail = true;
+		Cache.Resolve("127.0.0.1", "80", ec);
+		CHECK ( Cache.GetStats().iRefreshes == 1 );
+
+		for (int i = 0; i < 100 && iResolves < 2; ++i)
+		{
+			kMilliSleep(10);
+		}
+
+		CHECK ( iResolves == 2 );
+		// let the refresh store its result
+		kMilliSleep(50);
+
+		// the previous addresses are still served, and the refresh is not
+		// retried before the negative TTL passed
+		auto Endpoints = Cache.Resolve("127.0.0.1", "80", ec);
+		CHECK ( !ec );
+		CHECK ( Endpoints.size() == 1 );
+		CHECK ( Cache.GetStats().iRefreshes    == 1 );
+		CHECK ( Cache.GetStats().iNegativeHits == 0 );
+	}
+
+	SECTION("disabled")
+	{
+		KResolverCache Cache;
+		boost::system::error_code ec;
+
+		KResolverCache::SetEnabled(false);
+		auto Endpoints = Cache.Resolve("127.0.0.1", "80", ec);
+		KResolverCache::SetEnabled(true);
+
+		CHECK ( !ec );
+		CHECK ( Endpoints.size() == 1 );
+		CHECK ( Cache.GetStats().iEntries == 0 );
+	}
+}
@@ -63,6 +63,13 @@ void rest_patch(KRESTServer& REST)
 	}
 }
 
+void rest_slow(KRESTServer& REST)
+{
+	kMilliSleep(300);
+	REST.SetRawOutput(REST.GetQueryParm(":NAME"));
+	REST.SetStatus(KHTTPError::H2xx_OK);
+}
+
 } // end of anonymous namespace
 
 TEST_CASE("KRESTCLIENT")
@@ -247,6 +254,67 @@ TEST_CASE("KRESTCLIENT")
 		CHECK ( kjson::GetStringRef(oResponse, "message") == "unknown user" );
 
 	}
+
+	SECTION("FanOut")
+	{
+		KREST::Options Options;
+		Options.Type = KREST::HTTP;
+		Options.iPort = 6781;
+		Options.iTimeout = 5;
+		Options.bBlocking = false;
+
+		KRESTRoutes::FunctionTable RTable[]
+		{
+			{ "GET",   false, "/slow/:NAME",         rest_slow     },
+		};
+
+		KRESTRoutes Routes;
+		Routes.AddFunctionTable(RTable);
+
+		KREST Server;
+		CHECK( Server.Execute(Options, Routes) );
+
+		KConnectionPool Pool;
+		KRestFanOut FanOut("http://localhost:6781/", false, 4);
+		FanOut.SetConnectionPool(Pool);
+
+		std::vector<KRestFanOut::Request> Requests;
+
+		for (auto sName : { "one", "two", "three", "four" })
+		{
+			KRestFanOut::Request Request;
+			Request.sPath = kFormat("slow/{}", sName);
+			Requests.push_back(std::move(Request));
+		}
+
+		KRestFanOut::Request Request;
+		Request.sPath = "unknown";
+		Requests.push_back(std::move(Request));
+
+		KStopTime Timer;
+		auto Responses = FanOut.Execute(Requests);
+		auto Duration  = Timer.elapsed();
+
+		REQUIRE ( Responses.size() == 5 );
+		CHECK   ( Responses[0].Good() );
+		CHECK   ( Responses[0].sBody == "one"   );
+		CHECK   ( Responses[1].sBody == "two"   );
+		CHECK   ( Responses[2].sBody == "three" );
+		CHECK   ( Responses[3].sBody == "four"  );
+		CHECK   ( Responses[3].iStatusCode == 200 );
+		CHECK   ( Responses[4].Good() == false );
+		CHECK   ( Responses[4].iStatusCode == 404 );
+		CHECK   ( Responses[4].Error.value() == 404 );
+		// sequential execution would take at least 1200 ms
+		CHECK   ( Duration < chrono::milliseconds(1000) );
+
+		// now run again, this time from the pooled connections
+		Requests.pop_back();
+		auto Futures = FanOut.Submit(Requests);
+		REQUIRE ( Futures.size() == 4 );
+		CHECK   ( Futures[1].get().sBody == "two" );
+		CHECK   ( Pool.GetStats().iReused > 0 );
+	}
 }
 
 #endif // of DEKAF2_IS_WINDOWS
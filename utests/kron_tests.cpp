@@ -66,6 +66,12 @@ void check_cron_conv(kron::stringview_t expr)
 
 KTempDir TempDir;
 
+class TestScheduler : public Kron::LocalScheduler
+{
+public:
+	using Kron::LocalScheduler::GetJob;
+};
+
 } // end of anonymous namespace
 
 TEST_CASE("KRON")
@@ -485,8 +491,131 @@ TEST_CASE("KRON")
 		CHECK ( Next.Format() == kFormTimestamp(next) );
 	}
 
+	SECTION("KRON scheduler")
+	{
+		TestScheduler Scheduler;
+		auto tBase = KUnixTime::from_time_t(2000000000);
+
+		CHECK ( Scheduler.NextExecution() == Kron::INVALID_TIME );
+
+		for (int i = 0; i < 1000; ++i)
+		{
+			CHECK ( Scheduler.AddJob(Kron::Job::Create(kFormat("job-{}", i), tBase + chrono::seconds(i * 7919 % 1000), "true")) );
+		}
+
+		CHECK ( Scheduler.size() == 1000 );
+		CHECK ( Scheduler.NextExecution() == tBase );
+		CHECK ( Scheduler.AddJob(Kron::Job::Create("job-5", tBase, "true")) == false );
+		CHECK ( Scheduler.GetJob(tBase - chrono::seconds(1)) == nullptr );
+
+		// delete all jobs with an even execution time
+		for (int i = 0; i < 1000; ++i)
+		{
+			if ((i * 7919 % 1000) % 2 == 0)
+			{
+				CHECK ( Scheduler.DeleteJob(KString(kFormat("job-{}", i)).Hash()) );
+			}
+		}
+
+		CHECK ( Scheduler.DeleteJob(KString("job-0").Hash()) == false );
+		CHECK ( Scheduler.size() == 500 );
+		CHECK ( Scheduler.NextExecution() == tBase + chrono::seconds(1) );
+
+		auto jList = Scheduler.ListJobs();
+		CHECK ( jList.size() == 500 );
+		CHECK ( jList.front()["tNext"] == KUnixTime(tBase + chrono::seconds(1)).to_time_t() );
+		CHECK ( jList.back ()["tNext"] == KUnixTime(tBase + chrono::seconds(999)).to_time_t() );
+
+		// the jobs come in the order of their execution time
+		std::size_t iCount { 0 };
+		KUnixTime tLast = tBase;
+
+		for (;;)
+		{
+			auto job = Scheduler.GetJob(tBase + chrono::seconds(2000));
+
+			if (!job)
+			{
+				break;
+			}
+
+			auto tNext = job->Next();
+			CHECK ( tNext > tLast );
+			tLast = tNext;
+			++iCount;
+		}
+
+		CHECK ( iCount == 500 );
+		CHECK ( Scheduler.empty() );
+		CHECK ( Scheduler.NextExecution() == Kron::INVALID_TIME );
+
+		// repeating jobs get rescheduled
+		CHECK ( Scheduler.AddJob(Kron::Job::Create("repeat", "* * * * * * true", true)) );
+		auto tNext = Scheduler.NextExecution();
+		CHECK ( Scheduler.GetJob(tNext) != nullptr );
+		CHECK ( Scheduler.NextExecution() == tNext + chrono::seconds(1) );
+		CHECK ( Scheduler.GetJob(tNext) == nullptr );
+		CHECK ( Scheduler.size() == 1 );
+	}
+
 #ifndef DEKAF2_IS_WINDOWS
 
+	SECTION("KRON wake up")
+	{
+		// the check interval is far longer than the test
+		Kron Cron(true, std::chrono::minutes(10));
+		KString sFilename = kFormat("{}{}wakeup.txt", TempDir.Name(), kDirSep);
+		Cron.Scheduler().AddJob(Kron::Job::Create("WakeUp", KUnixTime::now() + chrono::seconds(1), kFormat("echo awake > {}", sFilename)));
+
+		KString sContent;
+
+		for (int i = 0; i < 40; ++i)
+		{
+			kMilliSleep(100);
+			sContent = kReadAll(sFilename);
+
+			if (!sContent.empty())
+			{
+				break;
+			}
+		}
+
+		CHECK ( sContent.Trim() == "awake" );
+	}
+
+	SECTION("KRON parallel limit")
+	{
+		Kron Cron(true, std::chrono::milliseconds(10), std::make_shared<Kron::LocalScheduler>(), 2);
+		auto tNow = KUnixTime::now() - chrono::seconds(1);
+
+		for (int i = 0; i < 6; ++i)
+		{
+			Cron.Scheduler().AddJob(Kron::Job::Create(kFormat("Limited-{}", i), tNow, kFormat("sleep 0.2; echo {} > {}{}limited-{}.txt", i, TempDir.Name(), kDirSep, i)));
+		}
+
+		std::size_t iMaxRunning { 0 };
+		std::size_t iDone { 0 };
+
+		for (int i = 0; i < 100 && iDone < 6; ++i)
+		{
+			kMilliSleep(20);
+			iMaxRunning = std::max(iMaxRunning, Cron.ListRunningJobs().size());
+			iDone = 0;
+
+			for (int j = 0; j < 6; ++j)
+			{
+				if (kFileExists(kFormat("{}{}limited-{}.txt", TempDir.Name(), kDirSep, j)))
+				{
+					++iDone;
+				}
+			}
+		}
+
+		CHECK ( iDone == 6 );
+		CHECK ( iMaxRunning <= 2 );
+		CHECK ( Cron.Scheduler().empty() );
+	}
+
 	SECTION("KRON 1")
 	{
 		Kron Cron(true, std::chrono::milliseconds(10));
@@ -0,0 +1,281 @@
+#include "catch.hpp"
+
+#ifndef DEKAF2_IS_WINDOWS
+
+#include <dekaf2/ksharedmemorycache.h>
+#include <dekaf2/ksystem.h>
+#include <dekaf2/kformat.h>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace dekaf2;
+
+namespace {
+
+// gives raw access on the segment of a cache, to fake a crashed writer
+class RawSegment : public detail::KSharedMemoryBase
+{
+public:
+
+	RawSegment(KStringView sPathname, std::size_t iSize)
+	: detail::KSharedMemoryBase(sPathname, iSize)
+	{
+	}
+
+	char* data() const { return static_cast<char*>(get()); }
+
+};
+
+// returns the state word of the slot that holds sKey, assuming the layout of
+// 64 bytes header, 40 bytes slot head, key at offset 40
+std::atomic<std::uint64_t>* FindSlotState(const RawSegment& Segment, std::size_t iSlots, std::size_t iSlotSize, KStringView sKey)
+{
+	for (std::size_t i = 0; i < iSlots; ++i)
+	{
+		auto pSlot = Segment.data() + 64 + i * iSlotSize;
+
+		if (!std::memcmp(pSlot + 40, sKey.data(), sKey.size()))
+		{
+			return reinterpret_cast<std::atomic<std::uint64_t>*>(pSlot);
+		}
+	}
+
+	return nullptr;
+}
+
+// returns the pid of a process that has terminated
+pid_t DeadPid()
+{
+	auto pid = fork();
+
+	if (pid == 0)
+	{
+		_exit(0);
+	}
+
+	waitpid(pid, nullptr, 0);
+
+	return pid;
+}
+
+} // end of anonymous namespace
+
+TEST_CASE("KSharedMemoryCache")
+{
+	SECTION("basics")
+	{
+		KSharedMemoryCache Cache("/dekaf2-utest-shmcache-1", 100, 16, 100, true);
+		CHECK ( Cache.is_open() );
+		CHECK ( Cache.Error().empty() );
+		CHECK ( Cache.Slots()        == 128 );
+		CHECK ( Cache.MaxKeySize()   ==  16 );
+		CHECK ( Cache.MaxValueSize() == 100 );
+		CHECK ( Cache.size()         ==   0 );
+
+		CHECK ( Cache.Set("key1", "value1") );
+		CHECK ( Cache.Set("key2", "value2") );
+		CHECK ( Cache.Set("key3", "")       );
+		CHECK ( Cache.size() == 3 );
+
+		KString sValue;
+		CHECK ( Cache.Get("key1", sValue) );
+		CHECK ( sValue == "value1" );
+		CHECK ( Cache.Get("key2") == "value2" );
+		CHECK ( Cache.Get("key3", sValue) );
+		CHECK ( sValue.empty() );
+		CHECK ( Cache.Get("key4", sValue) == false );
+		CHECK ( Cache.Contains("key2") );
+		CHECK ( Cache.Contains("key4") == false );
+
+		CHECK ( Cache.Set("key1", "another value") );
+		CHECK ( Cache.Get("key1") == "another value" );
+		CHECK ( Cache.size() == 3 );
+
+		CHECK ( Cache.Set("a key that is too long", "value") == false );
+		CHECK ( Cache.Set("key5", KString(101, 'x')) == false );
+		CHECK ( Cache.Set("key5", KString(100, 'x')) );
+		CHECK ( Cache.Get("key5") == KString(100, 'x') );
+
+		CHECK ( Cache.Erase("key2") );
+		CHECK ( Cache.Erase("key2") == false );
+		CHECK ( Cache.Contains("key2") == false );
+		CHECK ( Cache.size() == 3 );
+
+		Cache.Clear();
+		CHECK ( Cache.size() == 0 );
+		CHECK ( Cache.Contains("key1") == false );
+	}
+
+	SECTION("expiry and eviction")
+	{
+		KSharedMemoryCache Cache("/dekaf2-utest-shmcache-2", 8, 16, 16, true);
+		CHECK ( Cache.is_open() );
+
+		CHECK ( Cache.Set("short", "lived", chrono::milliseconds(20)) );
+		CHECK ( Cache.Get("short") == "lived" );
+		kMilliSleep(40);
+		CHECK ( Cache.Contains("short") == false );
+		CHECK ( Cache.size() == 0 );
+
+		// more keys than slots - the oldest are overwritten
+		for (int i = 0; i < 100; ++i)
+		{
+			CHECK ( Cache.Set(kFormat("key{}", i), kFormat("value{}", i)) );
+		}
+
+		CHECK ( Cache.size() == 8 );
+
+		for (int i = 92; i < 100; ++i)
+		{
+			CHECK ( Cache.Get(kFormat("key{}", i)) == kFormat("value{}", i) );
+		}
+	}
+
+	SECTION("crashed writers")
+	{
+		KSharedMemoryCache Cache("/dekaf2-utest-shmcache-5", 8, 16, 16, true);
+		CHECK ( Cache.is_open() );
+		CHECK ( Cache.Set("crashed", "value") );
+		CHECK ( Cache.Set("alive",   "value") );
+
+		RawSegment Segment("/dekaf2-utest-shmcache-5", 64 + 8 * 128);
+		CHECK ( Segment.is_open() );
+
+		auto pCrashed = FindSlotState(Segment, 8, 128, "crashed");
+		auto pAlive   = FindSlotState(Segment, 8, 128, "alive");
+		REQUIRE ( pCrashed != nullptr );
+		REQUIRE ( pAlive   != nullptr );
+
+		// lock the slots like a writer would: odd version, and its pid
+		auto iCrashedState = pCrashed->load();
+		auto iAliveState   = pAlive->load();
+		pCrashed->store(((iCrashedState >> 32) + 1) << 32 | static_cast<std::uint32_t>(DeadPid()));
+		pAlive  ->store(((iAliveState   >> 32) + 1) << 32 | static_cast<std::uint32_t>(getpid()));
+
+		// locked slots are treated as misses, and do not block
+		KStopTime Stop;
+
+		for (int i = 0; i < 100; ++i)
+		{
+			CHECK ( Cache.Contains("crashed") == false );
+		}
+
+		CHECK ( Stop.elapsed() < chrono::seconds(1) );
+
+		// the key can be stored again, and only the slot of the dead writer is recovered
+		CHECK ( Cache.Set("crashed", "new value") );
+		CHECK ( Cache.Get("crashed") == "new value" );
+		CHECK ( ((pCrashed->load() >> 32) & 1) == 0 );
+		CHECK ( ((pAlive  ->load() >> 32) & 1) == 1 );
+		CHECK ( Cache.size() == 1 );
+
+		// a window full of slots of dead writers does not block Set
+		auto iDeadPid = static_cast<std::uint32_t>(DeadPid());
+
+		for (std::size_t i = 0; i < 8; ++i)
+		{
+			auto pState = reinterpret_cast<std::atomic<std::uint64_t>*>(Segment.data() + 64 + i * 128);
+
+			if (pState != pAlive)
+			{
+				pState->store(((pState->load() >> 32) | 1) << 32 | iDeadPid);
+			}
+		}
+
+		CHECK ( Cache.size() == 0 );
+		CHECK ( Cache.Set("other", "value") );
+		CHECK ( Cache.Get("other") == "value" );
+		CHECK ( Cache.size() == 1 );
+		CHECK ( ((pAlive  ->load() >> 32) & 1) == 1 );
+
+		// let the live writer finish
+		pAlive->store(((pAlive->load() >> 32) + 1) << 32);
+		Cache.Clear();
+		CHECK ( Cache.size() == 0 );
+	}
+
+	SECTION("shared")
+	{
+		KSharedMemoryCache Cache1("/dekaf2-utest-shmcache-3", 1000, 32, 200, true);
+		CHECK ( Cache1.is_open() );
+
+		// a second mapping of the same segment, as another process would have it
+		KSharedMemoryCache Cache2("/dekaf2-utest-shmcache-3", 1000, 32, 200);
+		CHECK ( Cache2.is_open() );
+
+		CHECK ( Cache1.Set("key", "value") );
+		CHECK ( Cache2.Get("key") == "value" );
+		CHECK ( Cache2.Set("key", "other value") );
+		CHECK ( Cache1.Get("key") == "other value" );
+
+		KSharedMemoryCache Cache3("/dekaf2-utest-shmcache-3", 1000, 32, 100);
+		CHECK ( Cache3.is_open() == false );
+		CHECK ( Cache3.Error().empty() == false );
+		CHECK ( Cache3.Set("key", "value") == false );
+	}
+
+	SECTION("concurrent")
+	{
+		KSharedMemoryCache Writer("/dekaf2-utest-shmcache-4", 64, 16, 512, true);
+		CHECK ( Writer.is_open() );
+
+		std::atomic<bool>        bStop { false };
+		std::atomic<std::size_t> iTorn { 0 };
+		std::atomic<std::size_t> iHits { 0 };
+		std::vector<std::thread> Threads;
+
+		for (int t = 0; t < 4; ++t)
+		{
+			Threads.emplace_back([&, t]()
+			{
+				KSharedMemoryCache Cache("/dekaf2-utest-shmcache-4", 64, 16, 512);
+
+				if (!Cache.is_open())
+				{
+					++iTorn;
+					return;
+				}
+
+				KString sValue;
+
+				for (std::size_t i = 0; !bStop; ++i)
+				{
+					auto sKey = kFormat("key{}", i % 100);
+
+					if (t < 2)
+					{
+						// values consist of one repeated character
+						Cache.Set(sKey, KString(1 + i % 512, 'a' + i % 26));
+					}
+					else if (Cache.Get(sKey, sValue))
+					{
+						++iHits;
+
+						if (sValue.empty() || sValue.find_first_not_of(sValue.front()) != KString::npos)
+						{
+							++iTorn;
+						}
+					}
+				}
+			});
+		}
+
+		kMilliSleep(500);
+		bStop = true;
+
+		for (auto& Thread : Threads)
+		{
+			Thread.join();
+		}
+
+		CHECK ( iTorn == 0 );
+		CHECK ( iHits  > 0 );
+		CHECK ( Writer.size() <= 64 );
+	}
+}
+
+#endif // DEKAF2_IS_WINDOWS
@@ -282,6 +282,39 @@ TEST_CASE("KSystem")
 		}
 	}
 
+	SECTION("GetProcessCPU")
+	{
+		auto CPUs = kGetProcessCPU();
+#ifdef __linux__
+		CHECK ( CPUs.empty() == false );
+		// the CPU we run on is one of the allowed
+		CHECK ( std::find(CPUs.begin(), CPUs.end(), kGetCPU()) != CPUs.end() );
+#endif
+		CHECK ( std::is_sorted(CPUs.begin(), CPUs.end()) );
+	}
+
+	SECTION("NUMA")
+	{
+		auto iNodes = kGetNUMANodeCount();
+		CHECK ( iNodes > 0 );
+
+		const auto& Nodes = kGetNUMANodes();
+		REQUIRE ( Nodes.size() == iNodes );
+
+		std::size_t iCPUs { 0 };
+
+		for (auto iNode : Nodes)
+		{
+			// memory only nodes are not listed
+			auto CPUs = kGetNUMANodeCPUs(iNode);
+			CHECK ( CPUs.empty() == false );
+			iCPUs += CPUs.size();
+		}
+
+		CHECK ( iCPUs <= kGetCPUCount() );
+		CHECK ( kGetNUMANodeCPUs(Nodes.back() + 1).empty() );
+	}
+
 	SECTION("IsInsideDataSegment")
 	{
 		CHECK ( kIsInsideDataSegment("I am a static string literal stored in the data segment") == true );
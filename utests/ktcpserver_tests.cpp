@@ -1,11 +1,135 @@
 #include "catch.hpp"
 
 #include <dekaf2/ktcpserver.h>
+#include <dekaf2/ktcpclient.h>
 #include <dekaf2/ksystem.h>
 #include <thread>
 
 using namespace dekaf2;
 
+namespace {
+
+class KLineEchoServer : public KTCPServer
+{
+
+public:
+
+	using KTCPServer::KTCPServer;
+
+protected:
+
+	virtual KString Request(KStringRef& qstr, Parameters& parameters) override
+	{
+		return qstr + "\n";
+	}
+
+};
+
+// opens more than one listener on a single node host
+class KMultiListenerServer : public KLineEchoServer
+{
+
+public:
+
+	using KLineEchoServer::KLineEchoServer;
+
+protected:
+
+	virtual std::vector<uint16_t> ListenerNodes() const override
+	{
+		auto iNode = kGetNUMANodes().front();
+		return { iNode, iNode, iNode };
+	}
+
+};
+
+} // end of anonymous namespace
+
+TEST_CASE("KTCPServer NUMA listeners")
+{
+	KLineEchoServer Server(7682, false, 8);
+	Server.v4_Only();
+	Server.SetNUMAListeners();
+	Server.Start(2, false);
+
+	auto iNodes = kGetNUMANodeCount();
+
+	for (int i = 0; i < 10; ++i)
+	{
+		KTCPClient Client("127.0.0.1:7682", 2);
+		Client.WriteLine(kFormat("hello {}", i)).Flush();
+		REQUIRE ( Client.KOutStream::Good() );
+		KString sLine;
+		CHECK ( Client.ReadLine(sLine) );
+		CHECK ( sLine == kFormat("hello {}", i) );
+	}
+
+	auto Nodes = Server.GetNodeDiagnostics();
+	CHECK ( Nodes.size() == iNodes );
+
+	if (Nodes.size() == iNodes)
+	{
+		for (uint16_t iNode = 0; iNode < iNodes; ++iNode)
+		{
+			CHECK ( Nodes[iNode].iTotalThreads == std::max(8 / iNodes, 1) );
+
+			CHECK ( Nodes[iNode].iNUMANode == kGetNUMANodes()[iNode] );
+
+			if (!Nodes[iNode].ThreadCPUs.empty())
+			{
+				CHECK ( Nodes[iNode].ThreadCPUs.front() == kGetNUMANodeCPUs(kGetNUMANodes()[iNode]) );
+			}
+		}
+	}
+
+	// the last session may still be closing
+	for (int i = 0; i < 100 && Server.GetDiagnostics().iTotalTasks < 10; ++i)
+	{
+		kMilliSleep(10);
+	}
+
+	CHECK ( Server.GetDiagnostics().iTotalTasks == 10 );
+
+	Server.Stop();
+}
+
+TEST_CASE("KTCPServer multiple listeners")
+{
+	KMultiListenerServer Server(7683, false, 8);
+	Server.v4_Only();
+	Server.SetNUMAListeners();
+	CHECK ( Server.Start(2, false) );
+
+	for (int i = 0; i < 10; ++i)
+	{
+		KTCPClient Client("127.0.0.1:7683", 2);
+		Client.WriteLine(kFormat("hello {}", i)).Flush();
+		REQUIRE ( Client.KOutStream::Good() );
+		KString sLine;
+		CHECK ( Client.ReadLine(sLine) );
+		CHECK ( sLine == kFormat("hello {}", i) );
+	}
+
+	auto Nodes = Server.GetNodeDiagnostics();
+
+	// the pools could not be bound if a cpuset excludes the CPUs of the node
+	if (!Nodes.empty())
+	{
+		CHECK ( Nodes.size() == 3 );
+
+		for (const auto& Node : Nodes)
+		{
+			CHECK ( Node.iTotalThreads == 8 / 3 );
+		}
+	}
+
+	// all listeners on the port have to be woken up
+	KStopTime Stop;
+	CHECK ( Server.Stop() );
+	CHECK ( Stop.elapsed() < chrono::seconds(5) );
+	CHECK ( Server.IsRunning() == false );
+}
+
 // This test works, but somehow the signal gets the catch framework into
 // a bad state so that other tests spuriously fail when this test is run.
 // Therefore it is in general disabled, except when we want to explicitly
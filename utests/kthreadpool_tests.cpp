@@ -2,6 +2,13 @@
 
 #include <dekaf2/kthreadpool.h>
 #include <dekaf2/kstring.h>
+#include <dekaf2/ksystem.h>
+#include <algorithm>
+#include <array>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 using namespace dekaf2;
 
@@ -99,4 +106,414 @@ TEST_CASE("KThreadPool")
 		Queue.clear();
 		CHECK ( Queue.n_queued() == 0 );
 	}
+
+	SECTION("work stealing")
+	{
+		KThreadPool Queue(4, KThreadPool::Scheduling::WorkStealing);
+
+		CHECK ( Queue.get_scheduling() == KThreadPool::Scheduling::WorkStealing );
+		CHECK ( Queue.size() == 4 );
+
+		std::atomic<int> iCounter { 0 };
+
+		// tasks pushed from outside go into the injection queue,
+		// tasks pushed from inside into the worker's own deque
+		std::vector<std::future<void>> Futures;
+
+		for (int i = 0; i < 100; ++i)
+		{
+			Futures.push_back(Queue.push([&Queue, &iCounter]()
+			{
+				for (int j = 0; j < 10; ++j)
+				{
+					Queue.push([&iCounter]()
+					{
+						++iCounter;
+					});
+				}
+				++iCounter;
+			}));
+		}
+
+		for (auto& Future : Futures)
+		{
+			CHECK ( Future.wait_for(std::chrono::seconds(5)) == std::future_status::ready );
+		}
+
+		for (int i = 0; i < 500 && iCounter < 1100; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+
+		CHECK ( iCounter == 1100 );
+
+		auto future = Queue.push([](int i) { return i * 2; }, 21);
+		CHECK ( future.get() == 42 );
+
+		auto Diag = Queue.get_diagnostics();
+		CHECK ( Diag.iTotalTasks   == 1101 );
+		CHECK ( Diag.iTotalThreads == 4 );
+		CHECK ( Diag.iWaitingTasks == 0 );
+
+		CHECK ( Queue.resize(2) );
+		CHECK ( Queue.size() == 2 );
+		CHECK ( Queue.resize(6) );
+		CHECK ( Queue.size() == 6 );
+
+		iCounter = 0;
+
+		for (int i = 0; i < 1000; ++i)
+		{
+			Queue.push([&iCounter]()
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				++iCounter;
+			});
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		Queue.stop(true);
+
+		CHECK ( Queue.is_stopped() );
+		CHECK ( Queue.n_queued() > 0 );
+		CHECK ( iCounter < 1000 );
+
+		// the remaining tasks run after a restart
+		CHECK ( Queue.resize(8) );
+		Queue.stop(false);
+		CHECK ( iCounter == 1000 );
+		CHECK ( Queue.n_queued() == 0 );
+
+		Queue.resize(1);
+		Queue.clear();
+		CHECK ( Queue.n_queued() == 0 );
+	}
+
+	SECTION("priorities and deadlines")
+	{
+		for (auto Scheduling : { KThreadPool::Scheduling::SharedQueue, KThreadPool::Scheduling::WorkStealing })
+		{
+			KThreadPool Queue(1, Scheduling);
+
+			std::atomic<int> iExpired { 0 };
+
+			Queue.register_expiry_callback([&iExpired](KThreadPool::Priority Priority)
+			{
+				if (Priority == KThreadPool::Priority::Low)
+				{
+					++iExpired;
+				}
+			});
+
+			// block the only thread until all tasks are queued
+			std::promise<void> Release;
+			auto Blocker = Release.get_future().share();
+			auto Blocked = Queue.push([Blocker]() { Blocker.wait(); });
+
+			std::mutex Mutex;
+			std::vector<int> Order;
+
+			auto Record = [&Mutex, &Order](int i)
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				Order.push_back(i);
+			};
+
+			auto f1 = Queue.push(KThreadPool::Priority::Low,    Record, 3);
+			auto f2 = Queue.push(KThreadPool::Priority::Normal, Record, 2);
+			auto f3 = Queue.push(KThreadPool::Priority::High,   Record, 1);
+			auto f4 = Queue.push(KThreadPool::Priority::Normal, Record, 2);
+			auto f5 = Queue.push(KThreadPool::Priority::High,   Record, 1);
+			// this one expires before the thread gets free
+			auto f6 = Queue.push(KThreadPool::Priority::Low, std::chrono::milliseconds(1), Record, 4);
+			// and this one has plenty of time left
+			auto f7 = Queue.push(KThreadPool::Priority::Low, std::chrono::minutes(5), [](int i) { return i * 2; }, 21);
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			Release.set_value();
+
+			f1.get();
+			f2.get();
+			f3.get();
+			f4.get();
+			f5.get();
+			CHECK_THROWS_AS ( f6.get(), const std::future_error& );
+			CHECK ( f7.get() == 42 );
+
+			CHECK ( Order == std::vector<int>({ 1, 1, 2, 2, 3 }) );
+			CHECK ( iExpired == 1 );
+
+			auto Diag = Queue.get_diagnostics();
+			CHECK ( Diag.iExpiredTasks == 1 );
+			CHECK ( Diag.iTotalTasks   == 7 );
+		}
+	}
+
+	SECTION("cpu placement")
+	{
+		KThreadPool Queue(3);
+
+		auto Diag = Queue.get_diagnostics();
+		CHECK ( Diag.iNUMANode == -1 );
+		CHECK ( Diag.ThreadCPUs.empty() );
+
+		// the CPUs need not be contiguous, and the process may be restricted
+		// to some of them
+		auto Allowed = kGetProcessCPU(kGetPid());
+
+		if (!Allowed.empty() && Queue.pin_threads())
+		{
+			Diag = Queue.get_diagnostics();
+			CHECK ( Diag.ThreadCPUs.size() == 3 );
+
+			if (Diag.ThreadCPUs.size() == 3)
+			{
+				CHECK ( Diag.ThreadCPUs[0] == std::vector<uint16_t>({ Allowed[0] }) );
+				CHECK ( Diag.ThreadCPUs[1] == std::vector<uint16_t>({ Allowed[1 % Allowed.size()] }) );
+			}
+
+			// a task sees the pinning of its thread
+			auto CPUs = Queue.push([]() { return kGetThreadCPU(); }).get();
+			CHECK ( CPUs.size() == 1 );
+
+			// new threads are pinned, too
+			CHECK ( Queue.resize(5) );
+			CHECK ( Queue.get_diagnostics().ThreadCPUs.size() == 5 );
+
+			CHECK ( Queue.pin_threads(std::vector<std::vector<uint16_t>>{}) );
+			CHECK ( Queue.get_diagnostics().ThreadCPUs.empty() );
+			CHECK ( Queue.push([]() { return kGetThreadCPU(); }).get() == Allowed );
+		}
+
+		if (Queue.bind_to_numa_node(0))
+		{
+			Diag = Queue.get_diagnostics();
+			CHECK ( Diag.iNUMANode == 0 );
+			CHECK ( Diag.ThreadCPUs.size() == Queue.size() );
+
+			if (!Diag.ThreadCPUs.empty())
+			{
+				CHECK ( Diag.ThreadCPUs.front() == kGetNUMANodeCPUs(0) );
+			}
+		}
+
+		CHECK ( Queue.bind_to_numa_node(kGetNUMANodes().back() + 1) == false );
+	}
+
+	SECTION("task queue")
+	{
+		// more tasks than the rings can take, pushed before the threads start
+		KThreadPool Queue(KThreadPool::Scheduling::SharedQueue);
+
+		std::mutex Mutex;
+		std::vector<int> Order;
+		std::vector<std::future<void>> Futures;
+
+		for (int i = 0; i < 3000; ++i)
+		{
+			Futures.push_back(Queue.push(KThreadPool::Priority::Low, [&Mutex, &Order]()
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				Order.push_back(2);
+			}));
+		}
+
+		for (int i = 0; i < 1000; ++i)
+		{
+			Futures.push_back(Queue.push(KThreadPool::Priority::High, [&Mutex, &Order]()
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				Order.push_back(0);
+			}));
+		}
+
+		CHECK ( Queue.n_queued() == 4000 );
+		CHECK ( Queue.get_diagnostics().iMaxWaitingTasks == 3999 );
+
+		CHECK ( Queue.resize(1) );
+
+		for (auto& Future : Futures)
+		{
+			Future.get();
+		}
+
+		CHECK ( Order.size() == 4000 );
+		CHECK ( std::is_sorted(Order.begin(), Order.end()) );
+		CHECK ( Queue.n_queued() == 0 );
+
+		// lambdas with large captures
+		std::array<char, 200> Large {};
+		Large[199] = 'x';
+		CHECK ( Queue.push([Large]() { return Large[199]; }).get() == 'x' );
+
+		Queue.stop();
+		Queue.push([]() {});
+		Queue.push([]() {});
+		CHECK ( Queue.n_queued() == 2 );
+		Queue.clear();
+		CHECK ( Queue.n_queued() == 0 );
+	}
+
+	SECTION("task order after overflow")
+	{
+		KThreadPool Queue(1);
+
+		std::atomic<int> iRunning { -1 };
+		std::atomic<int> iGo      { -1 };
+		std::vector<int> Order; // only accessed by the one thread of the pool
+		std::vector<std::future<void>> Futures;
+
+		auto Push = [&](int i)
+		{
+			Futures.push_back(Queue.push([&iRunning, &iGo, &Order, i]()
+			{
+				// the first two tasks wait for the test
+				if (i < 2)
+				{
+					iRunning = i;
+
+					while (iGo < i)
+					{
+						std::this_thread::yield();
+					}
+				}
+
+				Order.push_back(i);
+			}));
+		};
+
+		Push(0);
+
+		while (iRunning < 0)
+		{
+			std::this_thread::yield();
+		}
+
+		// fill the ring and spill into the overflow queue
+		for (int i = 1; i <= 600; ++i)
+		{
+			Push(i);
+		}
+
+		// task 1 frees a slot in the ring
+		iGo = 0;
+
+		while (iRunning < 1)
+		{
+			std::this_thread::yield();
+		}
+
+		// this task must not overtake the spilled tasks
+		Push(601);
+		iGo = 1;
+
+		for (auto& Future : Futures)
+		{
+			Future.get();
+		}
+
+		CHECK ( Order.size() == 602 );
+		CHECK ( std::is_sorted(Order.begin(), Order.end()) );
+	}
+
+	SECTION("SmallTask")
+	{
+		using detail::threadpool::SmallTask;
+
+		int iCalled { 0 };
+		std::array<int, 100> Large {};
+
+		CHECK ( SmallTask::IsInline<std::packaged_task<int()>>() );
+		CHECK ( SmallTask::IsInline<decltype(Large)>() == false );
+
+		SmallTask Small([&iCalled]() { ++iCalled; });
+		SmallTask Big([&iCalled, Large]() { iCalled += Large.size(); });
+		CHECK ( static_cast<bool>(Small) );
+
+		SmallTask Moved(std::move(Small));
+		CHECK ( static_cast<bool>(Small) == false );
+		Moved();
+		CHECK ( iCalled == 1 );
+
+		Moved = std::move(Big);
+		Moved();
+		CHECK ( iCalled == 101 );
+
+		auto Shared = std::make_shared<int>(42);
+		{
+			SmallTask Holder([Shared]() {});
+			CHECK ( Shared.use_count() == 2 );
+			Holder.reset();
+			CHECK ( Shared.use_count() == 1 );
+		}
+	}
+
+	SECTION("MPMCRing")
+	{
+		detail::threadpool::MPMCRing<std::size_t> Ring(100);
+
+		CHECK ( Ring.capacity() == 128 );
+
+		std::size_t i;
+
+		for (i = 0; i < Ring.capacity(); ++i)
+		{
+			CHECK ( Ring.try_push(i) );
+		}
+
+		CHECK ( Ring.try_push(i) == false );
+		CHECK ( Ring.try_pop(i) );
+		CHECK ( i == 0 );
+
+		while (Ring.try_pop(i)) {}
+		CHECK ( i == 127 );
+
+		// concurrent producers and consumers
+		constexpr std::size_t iPerThread = 20000;
+		std::atomic<std::size_t> iSum { 0 };
+		std::atomic<std::size_t> iCount { 0 };
+		std::vector<std::thread> Threads;
+
+		for (int t = 0; t < 3; ++t)
+		{
+			Threads.emplace_back([&Ring]()
+			{
+				for (std::size_t i = 1; i <= iPerThread; ++i)
+				{
+					auto v = i;
+
+					while (!Ring.try_push(v))
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+
+			Threads.emplace_back([&Ring, &iSum, &iCount]()
+			{
+				std::size_t v;
+
+				while (iCount < 3 * iPerThread)
+				{
+					if (Ring.try_pop(v))
+					{
+						iSum += v;
+						++iCount;
+					}
+					else
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+
+		for (auto& Thread : Threads)
+		{
+			Thread.join();
+		}
+
+		CHECK ( iCount == 3 * iPerThread );
+		CHECK ( iSum == 3 * iPerThread * (iPerThread + 1) / 2 );
+	}
 }
@@ -4,6 +4,9 @@
 #include <dekaf2/kstring.h>
 #include <map>
 #include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 using namespace dekaf2;
 
@@ -64,3 +67,145 @@ TEST_CASE("KThreadSafe")
 
 	CHECK ( Array[1] == 2 );
 }
+
+namespace {
+
+struct Triple
+{
+	uint64_t a { 0 };
+	uint64_t b { 0 };
+	uint64_t c { 0 };
+};
+
+template<class Policy>
+std::size_t ConcurrentInconsistencies()
+{
+	KThreadSafe<Triple, Policy> Shared;
+	std::atomic<bool> bStop { false };
+	std::atomic<std::size_t> iInconsistent { 0 };
+	std::vector<std::thread> Readers;
+
+	for (int t = 0; t < 3; ++t)
+	{
+		Readers.emplace_back([&]()
+		{
+			while (!bStop)
+			{
+				auto Value = Shared.shared();
+
+				if (Value->a != Value->b || Value->b != Value->c)
+				{
+					++iInconsistent;
+				}
+			}
+		});
+	}
+
+	for (uint64_t i = 1; i <= 20000; ++i)
+	{
+		auto Value = Shared.unique();
+		Value->a = i;
+		Value->b = i;
+		Value->c = i;
+	}
+
+	bStop = true;
+
+	for (auto& Reader : Readers)
+	{
+		Reader.join();
+	}
+
+	if (Shared.shared()->c != 20000)
+	{
+		++iInconsistent;
+	}
+
+	return iInconsistent;
+}
+
+} // end of anonymous namespace
+
+TEST_CASE("KThreadSafe policies")
+{
+	SECTION("RCU")
+	{
+		KThreadSafe<KString, KRCUPolicy> String1;
+		String1.unique().get() = "content1";
+		CHECK ( String1.shared().get() == "content1" );
+
+		KThreadSafe<KString, KRCUPolicy> String2(std::move(String1));
+
+		CHECK ( String1.shared().get() == "" );
+		CHECK ( String2.shared().get() == "content1" );
+
+		auto String3 = String2;
+
+		CHECK ( String2.shared().get() == "content1" );
+		CHECK ( String3.shared().get() == "content1" );
+
+		KThreadSafe<KString, KRCUPolicy> String4;
+		String4 = std::move(String3);
+
+		CHECK ( String3.shared().get() == "" );
+		CHECK ( String4.shared().get() == "content1" );
+
+		String4.reset("content2");
+		CHECK ( String4.shared().get() == "content2" );
+
+		KThreadSafe<std::map<KString, KString>, KRCUPolicy> Map1;
+		Map1.unique()["Key1"] = "Value1";
+
+		CHECK ( Map1.shared()["Key1"] == "Value1" );
+
+		{
+			// readers keep their snapshot
+			auto Snapshot = Map1.shared();
+
+			{
+				auto map = Map1.unique();
+				map["Key1"] = "NewValue1";
+				map["Key2"] = "Value2";
+
+				CHECK ( map["Key1"] == "NewValue1" );
+				// not yet published
+				CHECK ( Map1.shared()["Key1"] == "Value1" );
+			}
+
+			CHECK ( Snapshot["Key1"] == "Value1" );
+			CHECK ( Snapshot->size() == 1 );
+			CHECK ( Map1.shared()["Key1"] == "NewValue1" );
+			CHECK ( Map1.shared()->size() == 2 );
+		}
+
+		CHECK ( ConcurrentInconsistencies<KRCUPolicy>() == 0 );
+	}
+
+	SECTION("SeqLock")
+	{
+		KThreadSafe<std::array<int, 10>, KSeqLockPolicy> Array1;
+		Array1.unique()[1] = 1;
+
+		CHECK ( Array1.shared()[1] == 1 );
+
+		{
+			auto Array = Array1.unique();
+			Array[1] = 2;
+
+			CHECK ( Array[1] == 2 );
+			CHECK ( Array1.shared()[1] == 1 );
+		}
+
+		CHECK ( Array1.shared()[1] == 2 );
+
+		auto Array2 = Array1;
+		CHECK ( Array2.shared()[1] == 2 );
+
+		KThreadSafe<Triple, KSeqLockPolicy> Value(Triple { 1, 2, 3 });
+		CHECK ( Value.shared()->b == 2 );
+		Value.reset();
+		CHECK ( Value.shared()->c == 0 );
+
+		CHECK ( ConcurrentInconsistencies<KSeqLockPolicy>() == 0 );
+	}
+}
@@ -5,6 +5,11 @@
 #include <dekaf2/ksystem.h>
 #include <dekaf2/klog.h>
 #include <dekaf2/dekaf2.h>
+#include <dekaf2/kthreadpool.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 using namespace dekaf2;
 
@@ -30,4 +35,122 @@ TEST_CASE("KTimer")
 		CHECK ( iCalled >= 2 );
 		CHECK ( iCalled <= 11 );
 	}
+
+	SECTION("many short timers")
+	{
+		KTimer Timer(std::chrono::microseconds(200));
+
+		std::atomic<std::size_t> iFired { 0 };
+		std::atomic<std::size_t> iEarly { 0 };
+		std::vector<KTimer::ID_t> IDs;
+
+		auto Start = KTimer::Clock::now();
+
+		for (int i = 0; i < 2000; ++i)
+		{
+			auto Expiry = Start + std::chrono::milliseconds(i % 50 + 1);
+
+			IDs.push_back(Timer.CallOnce(Expiry, [&iFired, &iEarly, Expiry](KTimer::Timepoint tp)
+			{
+				if (tp + std::chrono::milliseconds(1) < Expiry)
+				{
+					++iEarly;
+				}
+				++iFired;
+			}));
+		}
+
+		CHECK ( std::count(IDs.begin(), IDs.end(), KTimer::INVALID) == 0 );
+
+		std::size_t iCancelled { 0 };
+
+		for (std::size_t i = 1; i < IDs.size(); i += 2)
+		{
+			if (Timer.Cancel(IDs[i]))
+			{
+				++iCancelled;
+			}
+		}
+
+		// some may have fired already on a slow machine
+		CHECK ( iCancelled > 0 );
+
+		for (int i = 0; i < 200 && iFired < IDs.size() - iCancelled; ++i)
+		{
+			kMilliSleep(10);
+		}
+
+		kMilliSleep(60);
+
+		CHECK ( iFired == IDs.size() - iCancelled );
+		CHECK ( iEarly == 0 );
+		CHECK ( Timer.Cancel(IDs[0]) == false );
+	}
+
+	SECTION("far timers")
+	{
+		// the wheel covers 256 ticks on its lowest level, and 65536 on the next,
+		// so these timers need one and two cascades
+		KTimer Timer(std::chrono::microseconds(10));
+
+		std::atomic<int>  iOrder { 0 };
+		std::atomic<int>  iNear  { 0 };
+		std::atomic<int>  iFar   { 0 };
+		std::atomic<bool> bEarly { false };
+
+		auto Start = KTimer::Clock::now();
+
+		Timer.CallOnce(Start + std::chrono::milliseconds(700), [&](KTimer::Timepoint tp)
+		{
+			if (tp + std::chrono::milliseconds(1) < Start + std::chrono::milliseconds(700))
+			{
+				bEarly = true;
+			}
+
+			iFar = ++iOrder;
+		});
+
+		Timer.CallOnce(Start + std::chrono::milliseconds(5), [&](KTimer::Timepoint tp)
+		{
+			if (tp + std::chrono::milliseconds(1) < Start + std::chrono::milliseconds(5))
+			{
+				bEarly = true;
+			}
+
+			iNear = ++iOrder;
+		});
+
+		for (int i = 0; i < 300 && !iFar; ++i)
+		{
+			kMilliSleep(10);
+		}
+
+		CHECK ( iNear  == 1 );
+		CHECK ( iFar   == 2 );
+		CHECK ( bEarly == false );
+	}
+
+	SECTION("external pool")
+	{
+		KThreadPool Pool(1);
+		auto PoolThread = Pool.push([]() { return std::this_thread::get_id(); }).get();
+
+		KTimer Timer(std::chrono::milliseconds(1), Pool);
+		std::atomic<bool> bFired { false };
+		std::thread::id CallbackThread;
+
+		Timer.CallOnce(KTimer::Clock::now() + std::chrono::milliseconds(5), [&](KTimer::Timepoint)
+		{
+			CallbackThread = std::this_thread::get_id();
+			bFired = true;
+		});
+
+		for (int i = 0; i < 200 && !bFired; ++i)
+		{
+			kMilliSleep(5);
+		}
+
+		CHECK ( bFired );
+		CHECK ( CallbackThread == PoolThread );
+	}
 }
@@ -83,6 +83,111 @@ protected:
 	int m_iTimeout { 0 };
 };
 
+class KRangeServer : public KTCPServer
+{
+
+public:
+
+	using KTCPServer::KTCPServer;
+
+	KString           m_sContent;
+	KString           m_sETag          { "\"v1\"" };
+	// the etag the content has when the ranges get requested
+	KString           m_sRangeETag     { "\"v1\"" };
+	std::atomic<int>  m_iRangeRequests { 0 };
+	std::atomic<int>  m_iAuthorized    { 0 };
+	std::atomic<int>  m_iCustomHeaders { 0 };
+	// the count of the next range requests that fail
+	std::atomic<int>  m_iFailRanges    { 0 };
+	bool              m_bAcceptRanges  { true };
+	// fail all GET requests
+	bool              m_bFailGet       { false };
+
+protected:
+
+	virtual void Session(KStream& stream, KStringView sRemoteEndPoint, int iSocketFd) override
+	{
+		stream.SetReaderRightTrim("\r\n");
+
+		KString sLine;
+
+		while (stream.ReadLine(sLine))
+		{
+			auto sMethod = sLine.substr(0, sLine.find(' '));
+			KString sRange;
+			KString sIfRange;
+			bool    bAuthorized { false };
+			bool    bCustom     { false };
+
+			while (stream.ReadLine(sLine) && !sLine.empty())
+			{
+				auto sLower = sLine.ToLowerASCII();
+
+				if (sLower.starts_with("range: bytes="))
+				{
+					sRange = sLine.substr(13);
+				}
+				else if (sLower.starts_with("if-range: "))
+				{
+					sIfRange = sLine.substr(10);
+				}
+				else if (sLower.starts_with("authorization: basic "))
+				{
+					bAuthorized = true;
+				}
+				else if (sLower == "x-token: secret")
+				{
+					bCustom = true;
+				}
+			}
+
+			KStringView sBody = m_sContent;
+			KString     sHeaders;
+			int         iStatus = 200;
+
+			if (!m_sETag.empty())
+			{
+				sHeaders += kFormat("ETag: {}\r\n", sMethod == "HEAD" ? m_sETag : m_sRangeETag);
+			}
+
+			if (m_bAcceptRanges)
+			{
+				sHeaders += "Accept-Ranges: bytes\r\n";
+			}
+
+			if (sMethod != "HEAD" && (m_bFailGet || (!sRange.empty() && m_iFailRanges-- > 0)))
+			{
+				sBody   = "failed";
+				iStatus = 500;
+			}
+			else if (m_bAcceptRanges)
+			{
+				// a changed content is sent in full
+				if (!sRange.empty() && (sIfRange.empty() || sIfRange == m_sRangeETag))
+				{
+					if (bAuthorized) ++m_iAuthorized;
+					if (bCustom)     ++m_iCustomHeaders;
+					auto iFirst = sRange.substr(0, sRange.find('-')).UInt64();
+					auto iLast  = sRange.substr(sRange.find('-') + 1).UInt64();
+					sBody       = sBody.substr(iFirst, iLast - iFirst + 1);
+					iStatus     = 206;
+					sHeaders   += kFormat("Content-Range: bytes {}-{}/{}\r\n", iFirst, iLast, m_sContent.size());
+					++m_iRangeRequests;
+				}
+			}
+
+			stream.Write(kFormat("HTTP/1.1 {} OK\r\n{}Content-Length: {}\r\n\r\n", iStatus, sHeaders, sBody.size()));
+
+			if (sMethod != "HEAD")
+			{
+				stream.Write(sBody);
+			}
+
+			stream.Flush();
+		}
+	}
+};
+
 } // end of anonymous namespace
 
 TEST_CASE("KWebClient") {
@@ -262,6 +367,87 @@ TEST_CASE("KWebClient") {
 		sRet.clear();
 	}
 
+	SECTION("download")
+	{
+		KRangeServer server(7657, false, 10);
+
+		for (int i = 0; i < 20000; ++i)
+		{
+			server.m_sContent += kFormat("{:>9}\n", i);
+		}
+
+		server.Start(30, false);
+
+		KTempDir TempDir;
+		auto sFile = kFormat("{}/download", TempDir.Name());
+
+		KWebClient HTTP;
+		CHECK( HTTP.Download("http://127.0.0.1:7657/file", sFile, 4, 10000) );
+		CHECK( server.m_iRangeRequests == 4 );
+		CHECK( kReadAll(sFile) == server.m_sContent );
+
+		// too small for a parallel download
+		server.m_iRangeRequests = 0;
+		CHECK( HTTP.Download("http://127.0.0.1:7657/file", sFile, 4, 1000000) );
+		CHECK( server.m_iRangeRequests == 0 );
+		CHECK( kReadAll(sFile) == server.m_sContent );
+
+		// a minimum part size of 0 is treated as 1
+		server.m_iRangeRequests = 0;
+		CHECK( HTTP.Download("http://127.0.0.1:7657/file", sFile, 4, 0) );
+		CHECK( server.m_iRangeRequests == 4 );
+		CHECK( kReadAll(sFile) == server.m_sContent );
+
+		// the ranges carry the headers and the authentication of the client
+		{
+			KWebClient Auth;
+			Auth.BasicAuthentication("user", "pass");
+			Auth.AddHeader("X-Token", "secret");
+			server.m_iRangeRequests = 0;
+			CHECK( Auth.Download("http://127.0.0.1:7657/file", sFile, 4, 10000) );
+			CHECK( server.m_iRangeRequests == 4 );
+			CHECK( server.m_iAuthorized    == 4 );
+			CHECK( server.m_iCustomHeaders == 4 );
+			CHECK( kReadAll(sFile) == server.m_sContent );
+		}
+
+		// the content changed after the HEAD request, the ranges fail, and the
+		// content is fetched with a single request
+		server.m_iRangeRequests = 0;
+		server.m_sRangeETag = "\"v2\"";
+		CHECK( HTTP.Download("http://127.0.0.1:7657/file", sFile, 4, 10000) );
+		CHECK( server.m_iRangeRequests == 0 );
+		CHECK( kReadAll(sFile) == server.m_sContent );
+		server.m_sRangeETag = server.m_sETag;
+
+		// one failing range
+		server.m_iRangeRequests = 0;
+		server.m_iFailRanges    = 1;
+		CHECK( HTTP.Download("http://127.0.0.1:7657/file", sFile, 4, 10000) );
+		CHECK( server.m_iRangeRequests == 3 );
+		CHECK( kReadAll(sFile) == server.m_sContent );
+		server.m_iFailRanges    = 0;
+
+		// all requests fail - no full size file is left behind
+		server.m_bFailGet = true;
+		CHECK_FALSE( HTTP.Download("http://127.0.0.1:7657/file", sFile, 4, 10000) );
+		CHECK( kFileSize(sFile) != static_cast<std::size_t>(server.m_sContent.size()) );
+		server.m_bFailGet = false;
+
+		// no validator
+		server.m_iRangeRequests = 0;
+		server.m_sETag.clear();
+		CHECK( HTTP.Download("http://127.0.0.1:7657/file", sFile, 4, 10000) );
+		CHECK( server.m_iRangeRequests == 0 );
+		CHECK( kReadAll(sFile) == server.m_sContent );
+		server.m_sETag = server.m_sRangeETag;
+
+		// no range support
+		server.m_bAcceptRanges = false;
+		CHECK( HTTP.Download("http://127.0.0.1:7657/file", sFile, 4, 10000) );
+		CHECK( server.m_iRangeRequests == 0 );
+		CHECK( kReadAll(sFile) == server.m_sContent );
+	}
 }
 
 #endif // !Windows